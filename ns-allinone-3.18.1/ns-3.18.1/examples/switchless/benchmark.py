@@ -0,0 +1,149 @@
+#!/usr/bin/python
+
+# Runs the switchless-benchmark matrix (topologies x sizes x workloads) and
+# appends one JSON object per run to a results file, or compares two such
+# files run by run.
+#
+# Runs are sequential so they do not compete for cores or memory bandwidth.
+# Every result is tagged with a label, by default the current git commit,
+# so results of different commits can be kept in the same file.
+#
+# Usage: ./examples/switchless/benchmark.py [--nodes 256,1024] [--output benchmark.jsonl]
+#        ./examples/switchless/benchmark.py --workloads all-to-all --schedulers Map,Heap,List,Calendar,Ladder
+#        ./examples/switchless/benchmark.py --compare base.jsonl new.jsonl
+# (run from the ns-3 top level directory)
+
+import argparse
+import glob
+import json
+import os
+import subprocess
+import sys
+import time
+
+TOPOLOGIES = ["fattree", "hierarchical", "cube", "cube-dimordered", "mesh-dimordered"]
+NODES = [256, 1024, 4096, 16384]
+WORKLOADS = ["all-to-all", "neighbor"]
+SCHEDULERS = ["Map"]
+
+# Metrics shown by --compare, and whether higher is better
+COMPARED = [("build_ms", False), ("routing_ms", False), ("run_ms", False),
+            ("events_per_second", True), ("packets_per_second", True),
+            ("peak_rss_kb", False), ("bytes_per_node", False), ("bytes_per_pending_event", False)]
+
+def findBinary ():
+    for profile in ["optimized", "release", "debug"]:
+        matches = glob.glob(os.path.join("build", "examples", "switchless", "ns*-switchless-benchmark-" + profile))
+        if matches:
+            return os.path.abspath(matches[0])
+    return None
+
+def gitLabel ():
+    try:
+        return subprocess.check_output(["git", "rev-parse", "--short", "HEAD"], stderr=open(os.devnull, "w")).strip()
+    except (OSError, subprocess.CalledProcessError):
+        return ""
+
+def caseKey (result):
+    return (result["topology"], result["hosts"], result["workload"], result.get("l4", ""),
+            result.get("scheduler", "ns3::MapScheduler"))
+
+def runCase (binary, env, args, timeout):
+    command = [binary] + args
+    if timeout > 0:
+        command = ["timeout", str(timeout)] + command
+    process = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, env=env)
+    output = process.communicate()[0]
+    if process.returncode == 0:
+        for line in reversed(output.splitlines()):
+            if line.startswith("{"):
+                return json.loads(line), "ok"
+    return None, "timeout" if process.returncode == 124 else "failed(%d)" % process.returncode
+
+def runMatrix (options):
+    binary = findBinary()
+    if binary is None:
+        print "switchless-benchmark binary not found, run ./waf build from the ns-3 directory first"
+        sys.exit(1)
+    env = dict(os.environ)
+    libraryPath = os.path.abspath("build")
+    if env.get("LD_LIBRARY_PATH"):
+        libraryPath += ":" + env["LD_LIBRARY_PATH"]
+    env["LD_LIBRARY_PATH"] = libraryPath
+
+    label = options.label if options.label is not None else gitLabel()
+    cases = [(topology, int(nodes), workload, "ns3::%sScheduler" % scheduler)
+             for nodes in options.nodes.split(",")
+             for topology in options.topologies.split(",")
+             for workload in options.workloads.split(",")
+             for scheduler in options.schedulers.split(",")]
+    outputFile = open(options.output, "a")
+    for index, (topology, nodes, workload, scheduler) in enumerate(cases):
+        args = ["--topology=" + topology, "--nodes=%d" % nodes, "--workload=" + workload,
+                "--l4=" + options.l4, "--scheduler=" + scheduler, "--label=" + label] + options.args
+        start = time.time()
+        result, status = runCase(binary, env, args, options.timeout)
+        if result is None:
+            result = {"label": label, "topology": topology, "hosts": nodes, "workload": workload, "l4": options.l4,
+                      "scheduler": scheduler}
+        result["status"] = status
+        outputFile.write(json.dumps(result, sort_keys=True) + "\n")
+        outputFile.flush()
+        print "[%d/%d] %s %d %s %s: %s in %.1fs" % (index + 1, len(cases), topology, nodes, workload, scheduler,
+                                                  status, time.time() - start)
+        sys.stdout.flush()
+    outputFile.close()
+    print "Appended %d results to %s" % (len(cases), options.output)
+
+def loadResults (filename):
+    # The last ok result of every case wins
+    results = {}
+    for line in open(filename):
+        line = line.strip()
+        if line:
+            result = json.loads(line)
+            if result.get("status", "ok") == "ok":
+                results[caseKey(result)] = result
+    return results
+
+def compare (baseFilename, newFilename):
+    base = loadResults(baseFilename)
+    new = loadResults(newFilename)
+    print "%-16s %6s %-10s %-24s %s" % ("topology", "hosts", "workload", "scheduler",
+                                        " ".join("%24s" % metric for metric, higher in COMPARED))
+    for key in sorted(set(base) & set(new)):
+        cells = []
+        for metric, higher in COMPARED:
+            old = float(base[key].get(metric, 0))
+            now = float(new[key].get(metric, 0))
+            if old > 0:
+                cells.append("%24s" % ("%.4g -> %.4g (%+.1f%%)" % (old, now, 100.0 * (now - old) / old)))
+            else:
+                cells.append("%24s" % ("%.4g -> %.4g" % (old, now)))
+        print "%-16s %6d %-10s %-24s %s" % (key[0], key[1], key[2], key[4], " ".join(cells))
+    missing = sorted(set(base) ^ set(new))
+    if missing:
+        print "Only in one of the files: " + ", ".join("%s/%d/%s/%s" % (key[:3] + key[4:]) for key in missing)
+
+def main ():
+    parser = argparse.ArgumentParser(description="Run the switchless simulator benchmark matrix")
+    parser.add_argument("--topologies", default=",".join(TOPOLOGIES), help="Comma separated topologies")
+    parser.add_argument("--nodes", default=",".join(str(n) for n in NODES), help="Comma separated host counts")
+    parser.add_argument("--workloads", default=",".join(WORKLOADS), help="Comma separated workloads")
+    parser.add_argument("--schedulers", default=",".join(SCHEDULERS),
+                        help="Comma separated event schedulers, e.g. Map,Heap,List,Calendar,Ladder")
+    parser.add_argument("--l4", default="udp", help="udp or tcp")
+    parser.add_argument("--label", default=None, help="Label of the results (default: git commit)")
+    parser.add_argument("--timeout", type=int, default=3600, help="Seconds per run, 0 for none")
+    parser.add_argument("--output", default="benchmark.jsonl", help="Results file, appended to")
+    parser.add_argument("--compare", nargs=2, metavar=("BASE", "NEW"), help="Compare two results files")
+    parser.add_argument("args", nargs="*", help="Extra switchless-benchmark arguments, after --")
+    options = parser.parse_args()
+
+    if options.compare:
+        compare(options.compare[0], options.compare[1])
+    else:
+        runMatrix(options)
+
+if __name__ == "__main__":
+    main()
@@ -6,9 +6,21 @@
 
 #include "data-center-app.h"
 
+#ifdef NS3_MPI
+#include <mpi.h>
+#endif
+
 NS_LOG_COMPONENT_DEFINE ("DataCenterApp");
 NS_OBJECT_ENSURE_REGISTERED (DataCenterApp);
 
+LatencyHistogram DataCenterApp::s_latencyHistogram;
+uint64_t DataCenterApp::s_rxBytes = 0;
+int64_t DataCenterApp::s_firstTxTime = INT64_MAX;
+int64_t DataCenterApp::s_lastRxTime = 0;
+std::vector<DataCenterApp::LoadStepStatistics> DataCenterApp::s_loadStepStatistics;
+std::vector<double> DataCenterApp::s_loads;
+int64_t DataCenterApp::s_loadStepDuration = 0;
+
 void
 DataCenterApp::copySendParams (SendParams& src, SendParams& dst)
 {
@@ -22,6 +34,8 @@ DataCenterApp::copySendParams (SendParams& src, SendParams& dst)
     dst.m_minSendInterval = src.m_minSendInterval;
     dst.m_packetSize = src.m_packetSize;
     dst.m_nIterations = src.m_nIterations;
+    dst.m_injectionRate = src.m_injectionRate;
+    dst.m_interArrival = src.m_interArrival;
 }
 
 DataCenterApp::DataCenterApp ()
@@ -34,8 +48,17 @@ DataCenterApp::DataCenterApp ()
     m_responseCount (0),
     m_sendInfos (),
     m_socketIndexMap (),
+    m_addressIndexMap (),
     m_rxSocket (),
-    m_acceptSocketMap ()
+    m_acceptSocketMap (),
+    m_trace (0),
+    m_segmentSize (0),
+    m_rxPending (),
+    m_latencyHistogram (),
+    m_rxBytes (0),
+    m_firstTxTime (INT64_MAX),
+    m_lastRxTime (0),
+    m_loadStepStatistics ()
 {
     NS_LOG_FUNCTION (this);
     // Default sending parameters
@@ -48,6 +71,8 @@ DataCenterApp::DataCenterApp ()
     m_sendParams.m_minSendInterval = MilliSeconds (0.0);
     m_sendParams.m_packetSize = 1024;
     m_sendParams.m_nIterations = 0;
+    m_sendParams.m_injectionRate = DataRate (0);
+    m_sendParams.m_interArrival = 0;
 }
 
 DataCenterApp::~DataCenterApp ()
@@ -84,6 +109,13 @@ DataCenterApp::Setup (SendParams& sendingParams, uint32_t nodeId, NETWORK_STACK
         return false;
     }
 
+    if (sendingParams.m_sending && sendingParams.m_sendPattern == OPEN_LOOP &&
+        (sendingParams.m_interArrival == 0 || sendingParams.m_injectionRate.GetBitRate () == 0))
+    {
+        NS_LOG_ERROR ("Open-loop sending needs an injection rate and inter-arrival times");
+        return false;
+    }
+
     m_stack = stack;
     copySendParams(sendingParams, m_sendParams);
 
@@ -98,6 +130,172 @@ DataCenterApp::Setup (SendParams& sendingParams, uint32_t nodeId, NETWORK_STACK
     return true;
 }
 
+void
+DataCenterApp::SetTrace (DCAppTraceWriter* trace)
+{
+    NS_LOG_FUNCTION (this << trace);
+    m_trace = trace;
+}
+
+void
+DataCenterApp::SetSegmentSize (uint32_t segmentSize)
+{
+    NS_LOG_FUNCTION (this << segmentSize);
+    m_segmentSize = segmentSize;
+}
+
+void
+DataCenterApp::DoDispose (void)
+{
+    NS_LOG_FUNCTION (this);
+
+    s_latencyHistogram.Merge (m_latencyHistogram);
+    s_rxBytes += m_rxBytes;
+    if (m_firstTxTime < s_firstTxTime)
+        s_firstTxTime = m_firstTxTime;
+    if (m_lastRxTime > s_lastRxTime)
+        s_lastRxTime = m_lastRxTime;
+    m_latencyHistogram.Reset ();
+    m_rxBytes = 0;
+    if (s_loadStepStatistics.size () < m_loadStepStatistics.size ())
+        s_loadStepStatistics.resize (m_loadStepStatistics.size ());
+    for (uint32_t i = 0; i < m_loadStepStatistics.size (); i++)
+    {
+        s_loadStepStatistics[i].m_latencyHistogram.Merge (m_loadStepStatistics[i].m_latencyHistogram);
+        s_loadStepStatistics[i].m_txBytes += m_loadStepStatistics[i].m_txBytes;
+        s_loadStepStatistics[i].m_rxBytes += m_loadStepStatistics[i].m_rxBytes;
+    }
+    m_loadStepStatistics.clear ();
+    m_sendParams.m_interArrival = 0;
+
+    Application::DoDispose ();
+}
+
+const LatencyHistogram&
+DataCenterApp::GetGlobalLatencyHistogram (void)
+{
+    return s_latencyHistogram;
+}
+
+uint64_t
+DataCenterApp::GetGlobalRxBytes (void)
+{
+    return s_rxBytes;
+}
+
+double
+DataCenterApp::GetGlobalSeconds (void)
+{
+    if (s_latencyHistogram.GetCount () > 0 && s_lastRxTime > s_firstTxTime)
+        return (s_lastRxTime - s_firstTxTime) / 1e9;
+    return 0.0;
+}
+
+void
+DataCenterApp::PrintGlobalStatistics (std::ostream& os)
+{
+    os << "Latency: ";
+    s_latencyHistogram.Print (os);
+    os << "\n";
+
+    // Throughput over the span from the first send to the last receive
+    double seconds = GetGlobalSeconds ();
+    os << "Throughput: " << s_rxBytes << " bytes in " << seconds << " s";
+    if (seconds > 0.0)
+        os << " (" << s_rxBytes * 8.0 / seconds / 1e9 << " Gbps, " <<
+              s_latencyHistogram.GetCount () / seconds << " packets/s)";
+    os << "\n";
+}
+
+void
+DataCenterApp::AllReduceGlobalStatistics (void)
+{
+#ifdef NS3_MPI
+    s_latencyHistogram.AllReduce ();
+    MPI_Allreduce (MPI_IN_PLACE, &s_rxBytes, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce (MPI_IN_PLACE, &s_firstTxTime, 1, MPI_INT64_T, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce (MPI_IN_PLACE, &s_lastRxTime, 1, MPI_INT64_T, MPI_MAX, MPI_COMM_WORLD);
+    // Ranks whose apps saw fewer load steps have fewer entries
+    uint64_t nSteps = s_loadStepStatistics.size ();
+    MPI_Allreduce (MPI_IN_PLACE, &nSteps, 1, MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
+    s_loadStepStatistics.resize (nSteps);
+    for (uint32_t i = 0; i < nSteps; i++)
+    {
+        s_loadStepStatistics[i].m_latencyHistogram.AllReduce ();
+        MPI_Allreduce (MPI_IN_PLACE, &s_loadStepStatistics[i].m_txBytes, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+        MPI_Allreduce (MPI_IN_PLACE, &s_loadStepStatistics[i].m_rxBytes, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    }
+#endif
+}
+
+void
+DataCenterApp::SetLoadSteps (const std::vector<double>& loads, Time duration)
+{
+    s_loads = loads;
+    s_loadStepDuration = duration.GetNanoSeconds ();
+}
+
+uint32_t
+DataCenterApp::GetNLoadSteps (void)
+{
+    return s_loads.size ();
+}
+
+uint32_t
+DataCenterApp::GetLoadStep (int64_t time)
+{
+    if (s_loads.empty () || time < 0)
+        return s_loads.size ();
+    return std::min<int64_t> (time / s_loadStepDuration, s_loads.size ());
+}
+
+DataCenterApp::LoadStepStatistics&
+DataCenterApp::GetLoadStepStatistics (uint32_t step)
+{
+    if (m_loadStepStatistics.empty ())
+    {
+        m_loadStepStatistics.resize (s_loads.size ());
+        for (uint32_t i = 0; i < m_loadStepStatistics.size (); i++)
+            m_loadStepStatistics[i].m_txBytes = m_loadStepStatistics[i].m_rxBytes = 0;
+    }
+    return m_loadStepStatistics[step];
+}
+
+void
+DataCenterApp::PrintLoadSteps (std::ostream& os, DataRate linkRate, uint32_t nSenders)
+{
+    double seconds = s_loadStepDuration / 1e9;
+    for (uint32_t i = 0; i < s_loads.size (); i++)
+    {
+        LoadStepStatistics empty;
+        empty.m_txBytes = empty.m_rxBytes = 0;
+        const LoadStepStatistics& step = i < s_loadStepStatistics.size () ? s_loadStepStatistics[i] : empty;
+        // Per sender, as a fraction of the link rate
+        double offered = step.m_txBytes * 8.0 / seconds / nSenders / linkRate.GetBitRate ();
+        double accepted = step.m_rxBytes * 8.0 / seconds / nSenders / linkRate.GetBitRate ();
+        os << "Load " << s_loads[i] * 100 << "%: offered " << offered * 100 << "% accepted " <<
+              accepted * 100 << "% (" << accepted * linkRate.GetBitRate () / 1e9 << " Gbps per sender), latency: ";
+        step.m_latencyHistogram.Print (os);
+        os << "\n";
+    }
+}
+
+void
+DataCenterApp::TraceEvent (DCAppTraceWriter::EVENT event, const DCAppHeader& hdr, const Address& peer,
+                           uint32_t size)
+{
+    DCAppTraceRecord record;
+    record.m_txTime = hdr.GetTimeStamp ().GetNanoSeconds ();
+    record.m_rxTime = (event == DCAppTraceWriter::RX) ? Simulator::Now ().GetNanoSeconds () : -1;
+    record.m_node = GetNode ()->GetId ();
+    record.m_peer = DCAppTraceWriter::PackAddress (peer);
+    record.m_size = size;
+    record.m_sequenceNumber = hdr.GetSequenceNumber ();
+    record.m_event = event;
+    record.m_packetType = hdr.GetPacketType ();
+    m_trace->Write (record);
+}
+
 void
 DataCenterApp::InitSendInfo (SendInfo& sendInfo, Address address, Ptr<Socket> socket)
 {
@@ -114,6 +312,29 @@ DataCenterApp::InitReceiveInfo (ReceiveInfo& receiveInfo)
     receiveInfo.m_bytesReceived = 0;
 }
 
+void
+DataCenterApp::SetupTcpSocket (Ptr<Socket> socket)
+{
+    NS_LOG_FUNCTION (this << socket);
+    if (m_segmentSize == 0)
+    {
+        socket->SetAttribute ("SegmentSize", UintegerValue(m_sendParams.m_packetSize+11));
+        return;
+    }
+    socket->SetAttribute ("SegmentSize", UintegerValue (m_segmentSize));
+    // Room for a few whole messages
+    UintegerValue sndBufSize;
+    socket->GetAttribute ("SndBufSize", sndBufSize);
+    uint32_t messageSize = m_sendParams.m_packetSize + DCAppHeader ().GetSerializedSize ();
+    socket->SetAttribute ("SndBufSize", UintegerValue (std::max<uint64_t> (sndBufSize.Get (), 4 * messageSize)));
+}
+
+bool
+DataCenterApp::IsStream (void) const
+{
+    return m_segmentSize > 0 && (m_stack == TCP_IP_STACK || m_stack == TCP_DO_STACK);
+}
+
 void 
 DataCenterApp::SetupRXSocket (void)
 {
@@ -136,7 +357,7 @@ DataCenterApp::SetupRXSocket (void)
         case TCP_IP_STACK:
         {
             m_rxSocket = Socket::CreateSocket (GetNode (), TcpSocketFactory::GetTypeId ());
-            m_rxSocket->SetAttribute ("SegmentSize", UintegerValue(m_sendParams.m_packetSize+11));
+            SetupTcpSocket (m_rxSocket);
             //m_rxSocket->SetAttribute ("SndBufSize", UintegerValue(16384));
             //m_rxSocket->SetAttribute ("RcvBufSize", UintegerValue(16384));
             //m_rxSocket->SetAttribute ("SegmentSize", UintegerValue(16384));
@@ -161,7 +382,7 @@ DataCenterApp::SetupRXSocket (void)
         case TCP_DO_STACK:
         {
             m_rxSocket = Socket::CreateSocket (GetNode (), DoTcpSocketFactory::GetTypeId ());
-            m_rxSocket->SetAttribute ("SegmentSize", UintegerValue(m_sendParams.m_packetSize+11));
+            SetupTcpSocket (m_rxSocket);
             //m_rxSocket->SetAttribute ("SndBufSize", UintegerValue(16384));
             //m_rxSocket->SetAttribute ("RcvBufSize", UintegerValue(16384));
             //m_rxSocket->SetAttribute ("SegmentSize", UintegerValue(16384));
@@ -171,6 +392,14 @@ DataCenterApp::SetupRXSocket (void)
             m_rxSocket->Listen ();
             break;
         }
+        case HOMA_DO_STACK:
+        {
+            // Requests, responses and data all go through this socket
+            m_rxSocket = Socket::CreateSocket (GetNode (), DoHomaSocketFactory::GetTypeId ());
+            Address local (DimensionOrderedSocketAddress (DimensionOrderedAddress::GetAny (), PORT));
+            m_rxSocket->Bind (local);
+            break;
+        }
         default:
             NS_LOG_ERROR ("Invalid network stack specified, did you call DataCenterApp::Setup()??");
             return;
@@ -209,7 +438,7 @@ DataCenterApp::SetupTXSocket (uint32_t sendParamsNodeIndex)
         case TCP_IP_STACK:
         {
             socket = Socket::CreateSocket (GetNode (), TcpSocketFactory::GetTypeId ());
-            socket->SetAttribute ("SegmentSize", UintegerValue(m_sendParams.m_packetSize+11));
+            SetupTcpSocket (socket);
             //socket->SetAttribute ("SndBufSize", UintegerValue(16384));
             //socket->SetAttribute ("RcvBufSize", UintegerValue(16384));
             //socket->SetAttribute ("SegmentSize", UintegerValue(16384));
@@ -237,7 +466,7 @@ DataCenterApp::SetupTXSocket (uint32_t sendParamsNodeIndex)
         case TCP_DO_STACK:
         {
             socket = Socket::CreateSocket (GetNode (), DoTcpSocketFactory::GetTypeId ());
-            socket->SetAttribute ("SegmentSize", UintegerValue(m_sendParams.m_packetSize+11));
+            SetupTcpSocket (socket);
             //socket->SetAttribute ("SndBufSize", UintegerValue(16384));
             //socket->SetAttribute ("RcvBufSize", UintegerValue(16384));
             //socket->SetAttribute ("SegmentSize", UintegerValue(16384));
@@ -248,6 +477,16 @@ DataCenterApp::SetupTXSocket (uint32_t sendParamsNodeIndex)
             socket->Connect (nodeAddress);
             break;
         }
+        case HOMA_DO_STACK:
+        {
+            // Connectionless, no socket per receiver
+            DimensionOrderedAddress addr = DimensionOrderedAddress::ConvertFrom (m_sendParams.m_nodes[sendParamsNodeIndex]);
+            SendInfo sendInfo;
+            InitSendInfo (sendInfo, m_sendParams.m_nodes[sendParamsNodeIndex], m_rxSocket);
+            m_sendInfos.push_back (sendInfo);
+            m_addressIndexMap[addr] = m_sendInfos.size() - 1;
+            return;
+        }
         default:
             NS_LOG_ERROR ("Invalid network stack specified, did you call DataCenterApp::Setup()??");
             return;
@@ -301,17 +540,20 @@ DataCenterApp::StopApplication (void)
         if (m_sendInfos[i].m_event.IsRunning ())
             Simulator::Cancel (m_sendInfos[i].m_event);
 
-        m_sendInfos[i].m_socket->Close ();
+        if (m_sendInfos[i].m_socket != m_rxSocket)
+            m_sendInfos[i].m_socket->Close ();
         m_sendInfos[i].m_socket = NULL;
     }
     m_sendInfos.clear ();
     m_socketIndexMap.clear();
+    m_addressIndexMap.clear();
 
     // Close accepted sockets
     std::map<Ptr<Socket>, ReceiveInfo>::iterator it;
     for (it = m_acceptSocketMap.begin (); it != m_acceptSocketMap.end (); it++)
         it->first->Close ();
     m_acceptSocketMap.clear();
+    m_rxPending.clear ();
    
     // Close socket for receiving
     m_rxSocket->Close();
@@ -399,6 +641,9 @@ DataCenterApp::KickOffSending (void)
             }   
             break;
         }
+        case OPEN_LOOP:
+            ScheduleOpenLoopSend ();
+            break;
         default:
             NS_LOG_ERROR ("Invalid send pattern specified");
             break;
@@ -511,115 +756,178 @@ DataCenterApp::HandleRead (Ptr<Socket> socket)
             NS_LOG_INFO ("Got Here");
             break;
         }
+        else if (!IsStream ())
+        {
+            HandleMessage (socket, packet, from);
+        }
         else
         {
-            // Log received packet
+            // Cut the whole messages out of the byte stream, requests and
+            // data carry the packet size, responses only the header
+            Ptr<Packet>& pending = m_rxPending[socket];
+            if (pending)
+                pending->AddAtEnd (packet);
+            else
+                pending = packet;
             DCAppHeader hdr;
-            packet->RemoveHeader (hdr);
-            uint16_t currentSeqNum = hdr.GetSequenceNumber ();
-            uint32_t bytesReceived = packet->GetSize ();
-            m_acceptSocketMap[socket].m_packetsReceived++;
-            m_acceptSocketMap[socket].m_bytesReceived += bytesReceived;
-
-            if (InetSocketAddress::IsMatchingType (from))
-            {
-                NS_LOG_INFO ("Node " << GetNode ()->GetId () << " RX:\n" <<
-                             "    Source: " << InetSocketAddress::ConvertFrom (from).GetIpv4 () << "\n" <<
-                             "    Destination: " << GetNode ()->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ()
-                                    << "\n" <<
-                             "    Packet Size: " << bytesReceived << " bytes\n" <<
-                             "    Packet Type: " << DCAppHeader::PacketTypeToString (hdr.GetPacketType ()) 
-                                << "\n"
-                             "    Sequence Number: " << currentSeqNum << "\n" << 
-                             "    UID: " << packet->GetUid () << "\n" <<
-                             "    TXTime: " << hdr.GetTimeStamp () << "\n" <<
-                             "    RXTime: " << Simulator::Now() << "\n" <<
-                             "    Delay: " << Simulator::Now() - hdr.GetTimeStamp () << "\n" <<
-                             "    Packets Received: " << m_acceptSocketMap[socket].m_packetsReceived << "\n" <<
-                             "    Bytes Received: " << m_acceptSocketMap[socket].m_bytesReceived);
-                NS_LOG_DEBUG ("   " <<  GetNode ()->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ()  <<
-                              "\t  Got " << DCAppHeader::PacketTypeToString (hdr.GetPacketType ()) << 
-                              " from  \t" << InetSocketAddress::ConvertFrom (from).GetIpv4 () <<
-                              "   \t Time \t" << Simulator::Now() << " Delay : "
-                              << Simulator::Now() - hdr.GetTimeStamp ());  
-            }
-            else if (DimensionOrderedSocketAddress::IsMatchingType (from))
+            while (pending->GetSize () >= hdr.GetSerializedSize ())
             {
-                // Determine destination
-                Ptr<DimensionOrdered> dimOrdered = GetNode ()->GetObject<DimensionOrdered> ();
-                DimensionOrderedAddress dst = dimOrdered->GetAddress (DimensionOrdered::X_POS).GetLocal ();
-                if (dst == DimensionOrderedAddress::GetZero ())
-                    dst = dimOrdered->GetAddress (DimensionOrdered::X_NEG).GetLocal ();
-                if (dst == DimensionOrderedAddress::GetZero ())
-                    dst = dimOrdered->GetAddress (DimensionOrdered::Y_POS).GetLocal ();
-                if (dst == DimensionOrderedAddress::GetZero ())
-                    dst = dimOrdered->GetAddress (DimensionOrdered::Y_NEG).GetLocal ();
-                if (dst == DimensionOrderedAddress::GetZero ())
-                    dst = dimOrdered->GetAddress (DimensionOrdered::Z_POS).GetLocal ();
-                if (dst == DimensionOrderedAddress::GetZero ())
-                    dst = dimOrdered->GetAddress (DimensionOrdered::Z_NEG).GetLocal ();
-                NS_ASSERT (dst != DimensionOrderedAddress::GetZero ());
-
-                NS_LOG_INFO ("Node " << GetNode ()->GetId () << " RX:\n" <<
-                             "    Source: " << DimensionOrderedSocketAddress::ConvertFrom (from)
-                                                    .GetDimensionOrderedAddress () << "\n" <<
-                             "    Destination: " << dst << "\n" <<
-                             "    Packet Size: " << bytesReceived << " bytes\n" <<
-                             "    Packet Type: " << DCAppHeader::PacketTypeToString (hdr.GetPacketType ()) 
-                                << "\n"
-                             "    Sequence Number: " << currentSeqNum << "\n" <<
-                             "    UID: " << packet->GetUid () << "\n" <<
-                             "    TXTime: " << hdr.GetTimeStamp () << "\n" <<
-                             "    RXTime: " << Simulator::Now() << "\n" <<
-                             "    Delay: " << Simulator::Now() - hdr.GetTimeStamp () << "\n" <<
-                             "    Packets Received: " << m_acceptSocketMap[socket].m_packetsReceived << "\n" <<
-                             "    Bytes Received: " << m_acceptSocketMap[socket].m_bytesReceived);
-                NS_LOG_DEBUG ("   " <<  dst  <<
-                              "\t  Got " << DCAppHeader::PacketTypeToString (hdr.GetPacketType ()) <<
-                              " from  \t" << DimensionOrderedSocketAddress::ConvertFrom (from)
-                                                .GetDimensionOrderedAddress () <<
-                              "   \t Time \t" << Simulator::Now() << " Delay : "
-                              << Simulator::Now() - hdr.GetTimeStamp ()); 
+                pending->PeekHeader (hdr);
+                uint32_t size = hdr.GetSerializedSize ();
+                if (hdr.GetPacketType () != DCAppHeader::RESPONSE)
+                    size += m_sendParams.m_packetSize;
+                if (pending->GetSize () < size)
+                    break;
+                HandleMessage (socket, pending->CreateFragment (0, size), from);
+                pending->RemoveAtStart (size);
             }
+        }
+    }
+}
+
+void
+DataCenterApp::HandleMessage (Ptr<Socket> socket, Ptr<Packet> packet, Address& from)
+{
+    NS_LOG_FUNCTION (this << socket << packet);
+
+    // Log received packet
+    DCAppHeader hdr;
+    packet->RemoveHeader (hdr);
+    uint16_t currentSeqNum = hdr.GetSequenceNumber ();
+    uint32_t bytesReceived = packet->GetSize ();
+    m_acceptSocketMap[socket].m_packetsReceived++;
+    m_acceptSocketMap[socket].m_bytesReceived += bytesReceived;
+    int64_t txTime = hdr.GetTimeStamp ().GetNanoSeconds ();
+    m_lastRxTime = Simulator::Now ().GetNanoSeconds ();
+    m_latencyHistogram.Add (m_lastRxTime - txTime);
+    m_rxBytes += bytesReceived;
+    if (txTime < m_firstTxTime)
+        m_firstTxTime = txTime;
+    if (GetNLoadSteps () > 0)
+    {
+        uint32_t txStep = GetLoadStep (txTime);
+        uint32_t rxStep = GetLoadStep (m_lastRxTime);
+        if (txStep < GetNLoadSteps ())
+            GetLoadStepStatistics (txStep).m_latencyHistogram.Add (m_lastRxTime - txTime);
+        if (rxStep < GetNLoadSteps ())
+            GetLoadStepStatistics (rxStep).m_rxBytes += bytesReceived;
+    }
+    if (m_trace)
+        TraceEvent (DCAppTraceWriter::RX, hdr, from, bytesReceived);
 
-            // Do something with the packet depending on the type
-            switch (hdr.GetPacketType ())
+    if (InetSocketAddress::IsMatchingType (from))
+    {
+        NS_LOG_INFO ("Node " << GetNode ()->GetId () << " RX:\n" <<
+                     "    Source: " << InetSocketAddress::ConvertFrom (from).GetIpv4 () << "\n" <<
+                     "    Destination: " << GetNode ()->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ()
+                            << "\n" <<
+                     "    Packet Size: " << bytesReceived << " bytes\n" <<
+                     "    Packet Type: " << DCAppHeader::PacketTypeToString (hdr.GetPacketType ()) 
+                        << "\n"
+                     "    Sequence Number: " << currentSeqNum << "\n" << 
+                     "    UID: " << packet->GetUid () << "\n" <<
+                     "    TXTime: " << hdr.GetTimeStamp () << "\n" <<
+                     "    RXTime: " << Simulator::Now() << "\n" <<
+                     "    Delay: " << Simulator::Now() - hdr.GetTimeStamp () << "\n" <<
+                     "    Packets Received: " << m_acceptSocketMap[socket].m_packetsReceived << "\n" <<
+                     "    Bytes Received: " << m_acceptSocketMap[socket].m_bytesReceived);
+        NS_LOG_DEBUG ("   " <<  GetNode ()->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ()  <<
+                      "\t  Got " << DCAppHeader::PacketTypeToString (hdr.GetPacketType ()) << 
+                      " from  \t" << InetSocketAddress::ConvertFrom (from).GetIpv4 () <<
+                      "   \t Time \t" << Simulator::Now() << " Delay : "
+                      << Simulator::Now() - hdr.GetTimeStamp ());  
+    }
+    else if (DimensionOrderedSocketAddress::IsMatchingType (from))
+    {
+        // Determine destination
+        Ptr<DimensionOrdered> dimOrdered = GetNode ()->GetObject<DimensionOrdered> ();
+        DimensionOrderedAddress dst = dimOrdered->GetAddress (DimensionOrdered::X_POS).GetLocal ();
+        if (dst == DimensionOrderedAddress::GetZero ())
+            dst = dimOrdered->GetAddress (DimensionOrdered::X_NEG).GetLocal ();
+        if (dst == DimensionOrderedAddress::GetZero ())
+            dst = dimOrdered->GetAddress (DimensionOrdered::Y_POS).GetLocal ();
+        if (dst == DimensionOrderedAddress::GetZero ())
+            dst = dimOrdered->GetAddress (DimensionOrdered::Y_NEG).GetLocal ();
+        if (dst == DimensionOrderedAddress::GetZero ())
+            dst = dimOrdered->GetAddress (DimensionOrdered::Z_POS).GetLocal ();
+        if (dst == DimensionOrderedAddress::GetZero ())
+            dst = dimOrdered->GetAddress (DimensionOrdered::Z_NEG).GetLocal ();
+        NS_ASSERT (dst != DimensionOrderedAddress::GetZero ());
+
+        NS_LOG_INFO ("Node " << GetNode ()->GetId () << " RX:\n" <<
+                     "    Source: " << DimensionOrderedSocketAddress::ConvertFrom (from)
+                                            .GetDimensionOrderedAddress () << "\n" <<
+                     "    Destination: " << dst << "\n" <<
+                     "    Packet Size: " << bytesReceived << " bytes\n" <<
+                     "    Packet Type: " << DCAppHeader::PacketTypeToString (hdr.GetPacketType ()) 
+                        << "\n"
+                     "    Sequence Number: " << currentSeqNum << "\n" <<
+                     "    UID: " << packet->GetUid () << "\n" <<
+                     "    TXTime: " << hdr.GetTimeStamp () << "\n" <<
+                     "    RXTime: " << Simulator::Now() << "\n" <<
+                     "    Delay: " << Simulator::Now() - hdr.GetTimeStamp () << "\n" <<
+                     "    Packets Received: " << m_acceptSocketMap[socket].m_packetsReceived << "\n" <<
+                     "    Bytes Received: " << m_acceptSocketMap[socket].m_bytesReceived);
+        NS_LOG_DEBUG ("   " <<  dst  <<
+                      "\t  Got " << DCAppHeader::PacketTypeToString (hdr.GetPacketType ()) <<
+                      " from  \t" << DimensionOrderedSocketAddress::ConvertFrom (from)
+                                        .GetDimensionOrderedAddress () <<
+                      "   \t Time \t" << Simulator::Now() << " Delay : "
+                      << Simulator::Now() - hdr.GetTimeStamp ()); 
+    }
+
+    // Do something with the packet depending on the type
+    switch (hdr.GetPacketType ())
+    {
+        case DCAppHeader::REQUEST:
+            SendResponsePacket (socket, from, currentSeqNum);
+            break;
+        case DCAppHeader::RESPONSE:
+            switch (m_sendParams.m_sendPattern)
             {
-                case DCAppHeader::REQUEST:
-                    SendResponsePacket (socket, from, currentSeqNum);
+                case FIXED_INTERVAL:
+                case RANDOM_INTERVAL:
+                    // Increment response count
+                    m_responseCount++;
+                    // If we received all responses, can schedule another iteration
+                    if (m_responseCount == m_sendParams.m_nReceivers)
+                    {
+                        m_responseCount = 0;
+                        // If there is still an iteration, schedule a new bulk send
+                        if (m_iterationCount < m_sendParams.m_nIterations)
+                            BulkScheduleSend();
+                    }
                     break;
-                case DCAppHeader::RESPONSE:
-                    switch (m_sendParams.m_sendPattern)
+                case FIXED_SPORADIC:
+                case RANDOM_SPORADIC:
+                {
+                    // The receiver is known by its socket, or by its address
+                    // if all go through one
+                    uint32_t index;
+                    if (m_stack == HOMA_DO_STACK)
                     {
-                        case FIXED_INTERVAL:
-                        case RANDOM_INTERVAL:
-                            // Increment response count
-                            m_responseCount++;
-                            // If we received all responses, can schedule another iteration
-                            if (m_responseCount == m_sendParams.m_nReceivers)
-                            {
-                                m_responseCount = 0;
-                                // If there is still an iteration, schedule a new bulk send
-                                if (m_iterationCount < m_sendParams.m_nIterations)
-                                    BulkScheduleSend();
-                            }
-                            break;
-                        case FIXED_SPORADIC:
-                        case RANDOM_SPORADIC:
-                            NS_ASSERT (m_socketIndexMap[socket] >= 0);
-                            // If there are still packets to send, schedule one
-                            if (m_totalPacketsSent < (m_sendParams.m_nIterations * m_sendParams.m_nReceivers))
-                                ScheduleSend(m_socketIndexMap[socket]);
-                            break;
-                        case SEND_PATTERN_INVALID:
-                            break;
+                        DimensionOrderedAddress addr = DimensionOrderedSocketAddress::ConvertFrom (from)
+                                                        .GetDimensionOrderedAddress ();
+                        NS_ASSERT (m_addressIndexMap.find (addr) != m_addressIndexMap.end ());
+                        index = m_addressIndexMap[addr];
                     }
+                    else
+                        index = m_socketIndexMap[socket];
+                    // If there are still packets to send, schedule one
+                    if (m_totalPacketsSent < (m_sendParams.m_nIterations * m_sendParams.m_nReceivers))
+                        ScheduleSend(index);
                     break;
-                default:
-                    NS_LOG_ERROR ("Received packet with invalid type");
+                }
+                case OPEN_LOOP:
+                case SEND_PATTERN_INVALID:
                     break;
             }
-        }
+            break;
+        case DCAppHeader::DATA:
+            break;
+        default:
+            NS_LOG_ERROR ("Received packet with invalid type");
+            break;
     }
 }
 
@@ -718,18 +1026,30 @@ DataCenterApp::DoSendPacket (SendInfo& sendInfo)
         return;
     }
 
-    // Create a header with sequence number and time
+    // Create a header with sequence number and time,
+    // open-loop packets are not answered
     DCAppHeader hdr;
-    hdr.SetPacketType (DCAppHeader::REQUEST);
+    hdr.SetPacketType (m_sendParams.m_sendPattern == OPEN_LOOP ? DCAppHeader::DATA : DCAppHeader::REQUEST);
     hdr.SetSequenceNumber (sendInfo.m_packetsSent);
 
     // Create packet and add header
     Ptr<Packet> packet = Create<Packet> (m_sendParams.m_packetSize);
     packet->AddHeader (hdr);
-    sendInfo.m_socket->Send (packet);
+    if (m_stack == HOMA_DO_STACK)
+    {
+        DimensionOrderedAddress addr = DimensionOrderedAddress::ConvertFrom (sendInfo.m_address);
+        sendInfo.m_socket->SendTo (packet, 0, DimensionOrderedSocketAddress (addr, PORT));
+    }
+    else
+        sendInfo.m_socket->Send (packet);
     sendInfo.m_packetsSent++;
     sendInfo.m_bytesSent += m_sendParams.m_packetSize;
     m_totalPacketsSent++;
+    uint32_t step = GetLoadStep (hdr.GetTimeStamp ().GetNanoSeconds ());
+    if (step < GetNLoadSteps ())
+        GetLoadStepStatistics (step).m_txBytes += m_sendParams.m_packetSize;
+    if (m_trace)
+        TraceEvent (DCAppTraceWriter::TX, hdr, sendInfo.m_address, m_sendParams.m_packetSize);
 
     if (Ipv4Address::IsMatchingType (sendInfo.m_address))
     {
@@ -875,6 +1195,49 @@ DataCenterApp::ScheduleSend (uint32_t index)
     }
 }
 
+void
+DataCenterApp::ScheduleOpenLoopSend ()
+{
+    NS_LOG_FUNCTION (this);
+
+    if (!m_running)
+        return;
+
+    // Without load steps send as many packets as the sporadic patterns
+    double load = 1.0;
+    int64_t now = Simulator::Now ().GetNanoSeconds ();
+    if (GetNLoadSteps () > 0)
+    {
+        uint32_t step = GetLoadStep (now);
+        if (step == GetNLoadSteps ())
+            return;
+        load = s_loads[step];
+        // Idle until the next step
+        if (load <= 0.0)
+        {
+            m_sendInfos[0].m_event = Simulator::Schedule (NanoSeconds ((step + 1) * s_loadStepDuration - now),
+                                                          &DataCenterApp::ScheduleOpenLoopSend, this);
+            return;
+        }
+    }
+    else if (m_totalPacketsSent >= (m_sendParams.m_nIterations * m_sendParams.m_nReceivers))
+        return;
+
+    double meanInterval = m_sendParams.m_packetSize * 8.0 / (m_sendParams.m_injectionRate.GetBitRate () * load);
+    Time interval = Seconds (meanInterval * m_sendParams.m_interArrival->GetValue ());
+    // Just use send event for 0th send info since there is one event at a time
+    m_sendInfos[0].m_event = Simulator::Schedule (interval, &DataCenterApp::OpenLoopSendPacket, this);
+}
+
+void
+DataCenterApp::OpenLoopSendPacket ()
+{
+    NS_LOG_FUNCTION (this);
+
+    DoSendPacket (m_sendInfos[SelectRandomReceiver ()]);
+    ScheduleOpenLoopSend ();
+}
+
 void 
 DataCenterApp::SendResponsePacket (Ptr<Socket> socket, Address& to, uint16_t sequenceNumber)
 {
@@ -889,6 +1252,8 @@ DataCenterApp::SendResponsePacket (Ptr<Socket> socket, Address& to, uint16_t seq
     Ptr<Packet> packet = Create<Packet> (0);
     packet->AddHeader (hdr);
     socket->SendTo (packet, 0, to);
+    if (m_trace)
+        TraceEvent (DCAppTraceWriter::TX, hdr, to, 0);
    
     if (InetSocketAddress::IsMatchingType (to))
     { 
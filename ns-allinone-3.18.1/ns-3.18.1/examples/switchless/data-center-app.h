@@ -20,6 +20,8 @@
 // Switchless Includes
 #include "ns3/switchless-module.h"
 #include "dc-app-header.h"
+#include "dc-app-trace.h"
+#include "latency-histogram.h"
 
 using namespace ns3;
 
@@ -36,14 +38,17 @@ public:
         RANDOM_SUBSET
     } RECEIVERS;
     // The pattern in which packets will be sent,
-    // at fixed intervals or at random intervals
+    // at fixed intervals or at random intervals.
+    // OPEN_LOOP sends to random receivers at the injection rate,
+    // whether or not earlier packets have arrived
     typedef enum SEND_PATTERN_ENUM
     {
         SEND_PATTERN_INVALID = 0,
         FIXED_INTERVAL,
         RANDOM_INTERVAL,
         FIXED_SPORADIC,
-        RANDOM_SPORADIC
+        RANDOM_SPORADIC,
+        OPEN_LOOP
     } SEND_PATTERN;
 
     // Enumeration to specify the stack to use
@@ -53,7 +58,8 @@ public:
         UDP_IP_STACK,
         TCP_IP_STACK,
         UDP_DO_STACK,
-        TCP_DO_STACK
+        TCP_DO_STACK,
+        HOMA_DO_STACK
     } NETWORK_STACK;
     // Struct to hold all sending parameters
     typedef struct  SendParamsStruct
@@ -68,6 +74,10 @@ public:
         Time                                    m_minSendInterval;
         uint32_t                                m_packetSize;
         uint32_t                                m_nIterations;
+        // OPEN_LOOP only: payload bits per second, and the inter-arrival
+        // times in units of the mean interval at that rate (mean 1)
+        DataRate                                m_injectionRate;
+        Ptr<RandomVariableStream>               m_interArrival;
     } SendParams;
     static void copySendParams(SendParams& src, SendParams& dst);
 
@@ -78,6 +88,32 @@ public:
 
     // Function to setup app
     bool Setup (SendParams& sendingParams, uint32_t nodeId, NETWORK_STACK stack, bool debug);  
+    // Record every sent and received packet to a binary trace
+    void SetTrace (DCAppTraceWriter* trace);
+    // Send the messages of the TCP stacks as a byte stream in segments of
+    // this size, instead of one segment per message. Every app must use the
+    // same packet size, the receivers cut the messages out of the stream
+    void SetSegmentSize (uint32_t segmentSize);
+
+    // Latency and throughput of all apps, merged as each app is disposed
+    static const LatencyHistogram& GetGlobalLatencyHistogram (void);
+    static uint64_t GetGlobalRxBytes (void);
+    // From the first send to the last receive
+    static double GetGlobalSeconds (void);
+    static void PrintGlobalStatistics (std::ostream& os);
+    // Combine the global and load step statistics of all MPI ranks, on
+    // every rank
+    static void AllReduceGlobalStatistics (void);
+
+    // Step the injection rate of the OPEN_LOOP apps through these fractions
+    // of it, each for the given duration from time 0, and stop sending after
+    // the last one. Latency is accounted to the step a packet was sent in,
+    // received bytes to the step they arrived in
+    static void SetLoadSteps (const std::vector<double>& loads, Time duration);
+    // Offered and accepted throughput and latency of every step, per sender
+    static void PrintLoadSteps (std::ostream& os, DataRate linkRate, uint32_t nSenders);
+protected:
+    virtual void DoDispose (void);
 private:
     // Constants
     static const uint16_t PORT = 8080;
@@ -104,6 +140,10 @@ private:
 
     void SetupRXSocket (void);
     void SetupTXSocket (uint32_t sendParamsNodeIndex);
+    // Segment and send buffer size of a TCP socket
+    void SetupTcpSocket (Ptr<Socket> socket);
+    // Whether messages are cut from a byte stream on receipt
+    bool IsStream (void) const;
 
     // Overridden methods called when app starts and stops
     virtual void StartApplication (void);
@@ -116,6 +156,7 @@ private:
     bool HandleConnectionRequest (Ptr<Socket> socket, const Address& from);
     void HandleAccept (Ptr<Socket> socket, const Address& from);
     void HandleRead (Ptr<Socket> socket);
+    void HandleMessage (Ptr<Socket> socket, Ptr<Packet> packet, Address& from);
     void HandleClose (Ptr<Socket> socket);
     void HandleError (Ptr<Socket> socket);
     void HandleConnectionSucceeded (Ptr<Socket> socket);
@@ -132,12 +173,32 @@ private:
     // Send response packet
     void SendResponsePacket (Ptr<Socket> socket, Address& to, uint16_t sequenceNumber);
     
+    // Write a packet record to the trace, if any
+    void TraceEvent (DCAppTraceWriter::EVENT event, const DCAppHeader& hdr, const Address& peer,
+                     uint32_t size);
+
     // Select random receivers
     void SelectRandomReceiverSubset (std::unordered_set<uint32_t>& subset); 
     uint32_t SelectRandomReceiver ();
     // Select a random interval
     Time SelectRandomInterval ();
 
+    // Open-loop sending, independent of the responses
+    void ScheduleOpenLoopSend ();
+    void OpenLoopSendPacket ();
+    // Index of the load step at a time, GetNLoadSteps () if none
+    static uint32_t GetLoadStep (int64_t time);
+    static uint32_t GetNLoadSteps (void);
+
+    // Statistics of one load step, times in nanoseconds
+    typedef struct LoadStepStatisticsStruct
+    {
+        LatencyHistogram    m_latencyHistogram;
+        uint64_t            m_txBytes;
+        uint64_t            m_rxBytes;
+    } LoadStepStatistics;
+    LoadStepStatistics& GetLoadStepStatistics (uint32_t step);
+
     SendParams                          m_sendParams;
     bool                                m_setup;
     bool                                m_running;
@@ -147,8 +208,33 @@ private:
     uint32_t                            m_responseCount;
     std::vector<SendInfo>               m_sendInfos;
     std::map<Ptr<Socket>, uint32_t>     m_socketIndexMap;
+    // Send info index by receiver, for the stacks sending all from one socket
+    std::map<DimensionOrderedAddress, uint32_t> m_addressIndexMap;
     Ptr<Socket>                         m_rxSocket;
     std::map<Ptr<Socket>, ReceiveInfo>  m_acceptSocketMap;
+    DCAppTraceWriter*                   m_trace;
+    uint32_t                            m_segmentSize;
+    // Received bytes of the next message on every stream socket
+    std::map<Ptr<Socket>, Ptr<Packet> > m_rxPending;
+
+    // Per node receive statistics, times in nanoseconds
+    LatencyHistogram                    m_latencyHistogram;
+    uint64_t                            m_rxBytes;
+    int64_t                             m_firstTxTime;
+    int64_t                             m_lastRxTime;
+    // Sized on first use, only when there are load steps
+    std::vector<LoadStepStatistics>     m_loadStepStatistics;
+
+    // Receive statistics of all disposed apps
+    static LatencyHistogram             s_latencyHistogram;
+    static uint64_t                     s_rxBytes;
+    static int64_t                      s_firstTxTime;
+    static int64_t                      s_lastRxTime;
+    static std::vector<LoadStepStatistics> s_loadStepStatistics;
+
+    // Load steps shared by all apps
+    static std::vector<double>          s_loads;
+    static int64_t                      s_loadStepDuration;
 };
 
 #endif
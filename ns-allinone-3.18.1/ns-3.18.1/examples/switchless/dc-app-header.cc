@@ -20,6 +20,8 @@ DCAppHeader::PacketTypeToString (PACKET_TYPE packetType)
             return "Request";
         case RESPONSE:
             return "Response";
+        case DATA:
+            return "Data";
         default:
             return "Invalid Packet Type";
     }
@@ -26,7 +26,9 @@ public:
     {
         PACKET_TYPE_INVALID = 0,
         REQUEST,
-        RESPONSE
+        RESPONSE,
+        // Open-loop traffic, not answered with a response
+        DATA
     } PACKET_TYPE;
     static std::string PacketTypeToString (PACKET_TYPE packetType);
 
@@ -42,13 +44,14 @@ public:
     PACKET_TYPE GetPacketType () const;
     uint16_t GetSequenceNumber () const;
     Time GetTimeStamp () const;
+    // Bytes the header takes, also to cut messages out of a stream
+    virtual uint32_t GetSerializedSize (void) const;
     
     static TypeId GetTypeId (void);
 private:
     // Virtual private functions from base class
     virtual TypeId GetInstanceTypeId (void) const;
     virtual void Print (std::ostream& os) const;
-    virtual uint32_t GetSerializedSize (void) const;
     virtual void Serialize (Buffer::Iterator start) const;
     virtual uint32_t Deserialize (Buffer::Iterator start);
 
@@ -0,0 +1,76 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * Reads a binary trace written by main-test --trace=<file> and prints the
+ * same latency and (packet size, delay) summary as parse_output.py does for
+ * the text log, so the output can be fed to plot_delay.py/plot_latency.py.
+ */
+
+// C/C++ Includes
+#include <fstream>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+// NS-3 Includes
+#include "ns3/core-module.h"
+
+// Switchless Includes
+#include "dc-app-trace.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("DCAppTraceReaderProgram");
+
+int
+main (int argc, char *argv[])
+{
+    std::string sInput = "";
+    std::string sOutput = "";
+
+    CommandLine cmd;
+    cmd.AddValue ("input", "Binary trace file written by main-test --trace", sInput);
+    cmd.AddValue ("output", "Write the summary to this file instead of stdout", sOutput);
+    cmd.Parse (argc, argv);
+
+    DCAppTraceReader reader;
+    if (sInput.empty () || !reader.Open (sInput))
+    {
+        std::cerr << "Could not read trace file '" << sInput << "'" << std::endl;
+        return 1;
+    }
+
+    std::ofstream outputFile;
+    if (!sOutput.empty ())
+    {
+        outputFile.open (sOutput.c_str ());
+        if (!outputFile)
+        {
+            std::cerr << "Could not open output file '" << sOutput << "'" << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &os = sOutput.empty () ? std::cout : outputFile;
+
+    // Only RX events carry a delay; latency is the time of the last one
+    std::vector<std::pair<uint32_t, int64_t> > sizeDelayPairs;
+    int64_t latency = -1;
+    DCAppTraceRecord record;
+    while (reader.Read (record))
+    {
+        if (record.m_event != DCAppTraceWriter::RX)
+            continue;
+        latency = record.m_rxTime;
+        sizeDelayPairs.push_back (std::make_pair (record.m_size, record.m_rxTime - record.m_txTime));
+    }
+
+    if (latency < 0)
+        os << "Latency: None\n";
+    else
+        os << "Latency: " << latency << ".0\n";
+    os << "(Packet Size, Delay) Values:\n";
+    for (uint32_t i = 0; i < sizeDelayPairs.size (); i++)
+        os << "(" << sizeDelayPairs[i].first << ", " << sizeDelayPairs[i].second << ".0)\n";
+
+    return 0;
+}
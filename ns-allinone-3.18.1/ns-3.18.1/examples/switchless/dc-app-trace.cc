@@ -0,0 +1,175 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "dc-app-trace.h"
+
+// NS-3 Includes
+#include "ns3/log.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/inet-socket-address.h"
+
+// Switchless Includes
+#include "ns3/dim-ordered-address.h"
+#include "ns3/dim-ordered-socket-address.h"
+
+NS_LOG_COMPONENT_DEFINE ("DCAppTrace");
+
+DCAppTraceWriter::DCAppTraceWriter ()
+  : m_file (0),
+    m_buffer ()
+{
+    NS_LOG_FUNCTION (this);
+}
+
+DCAppTraceWriter::~DCAppTraceWriter ()
+{
+    NS_LOG_FUNCTION (this);
+    Close ();
+}
+
+bool
+DCAppTraceWriter::Open (const std::string& filename)
+{
+    NS_LOG_FUNCTION (this << filename);
+
+    Close ();
+    m_file = fopen (filename.c_str (), "wb");
+    if (m_file == 0)
+    {
+        NS_LOG_ERROR ("Could not open trace file " << filename);
+        return false;
+    }
+
+    DCAppTraceFileHeader header;
+    header.m_magic = MAGIC;
+    header.m_version = VERSION;
+    header.m_recordSize = sizeof (DCAppTraceRecord);
+    fwrite (&header, sizeof (header), 1, m_file);
+
+    m_buffer.reserve (BUFFER_RECORDS);
+    return true;
+}
+
+void
+DCAppTraceWriter::Close (void)
+{
+    NS_LOG_FUNCTION (this);
+
+    if (m_file == 0)
+        return;
+
+    Flush ();
+    fclose (m_file);
+    m_file = 0;
+}
+
+bool
+DCAppTraceWriter::IsOpen (void) const
+{
+    return m_file != 0;
+}
+
+void
+DCAppTraceWriter::Write (const DCAppTraceRecord& record)
+{
+    if (m_file == 0)
+        return;
+
+    m_buffer.push_back (record);
+    if (m_buffer.size () == BUFFER_RECORDS)
+        Flush ();
+}
+
+void
+DCAppTraceWriter::Flush (void)
+{
+    if (!m_buffer.empty ())
+        fwrite (&m_buffer[0], sizeof (DCAppTraceRecord), m_buffer.size (), m_file);
+    m_buffer.clear ();
+}
+
+uint32_t
+DCAppTraceWriter::PackAddress (const Address& address)
+{
+    if (InetSocketAddress::IsMatchingType (address))
+        return InetSocketAddress::ConvertFrom (address).GetIpv4 ().Get ();
+    if (Ipv4Address::IsMatchingType (address))
+        return Ipv4Address::ConvertFrom (address).Get ();
+
+    DimensionOrderedAddress dimOrdered;
+    if (DimensionOrderedSocketAddress::IsMatchingType (address))
+        dimOrdered = DimensionOrderedSocketAddress::ConvertFrom (address).GetDimensionOrderedAddress ();
+    else if (DimensionOrderedAddress::IsMatchingType (address))
+        dimOrdered = DimensionOrderedAddress::ConvertFrom (address);
+    else
+        return 0;
+    // 32 / n bits per coordinate, X in the highest bits
+    uint32_t nDims = dimOrdered.GetNDimensions ();
+    uint32_t bits = 32 / nDims;
+    uint32_t packed = 0;
+    for (uint32_t dim = 0; dim < nDims; dim++)
+    {
+        uint32_t coordinate = dimOrdered.GetCoordinate (dim);
+        if (bits < 32)
+            coordinate &= (1u << bits) - 1;
+        packed = (bits < 32 ? packed << bits : 0) | coordinate;
+    }
+    return packed;
+}
+
+DCAppTraceReader::DCAppTraceReader ()
+  : m_file (0)
+{
+    NS_LOG_FUNCTION (this);
+}
+
+DCAppTraceReader::~DCAppTraceReader ()
+{
+    NS_LOG_FUNCTION (this);
+    Close ();
+}
+
+bool
+DCAppTraceReader::Open (const std::string& filename)
+{
+    NS_LOG_FUNCTION (this << filename);
+
+    Close ();
+    m_file = fopen (filename.c_str (), "rb");
+    if (m_file == 0)
+    {
+        NS_LOG_ERROR ("Could not open trace file " << filename);
+        return false;
+    }
+
+    DCAppTraceFileHeader header;
+    if (fread (&header, sizeof (header), 1, m_file) != 1 ||
+        header.m_magic != DCAppTraceWriter::MAGIC ||
+        header.m_version != DCAppTraceWriter::VERSION ||
+        header.m_recordSize != sizeof (DCAppTraceRecord))
+    {
+        NS_LOG_ERROR ("Invalid trace file header in " << filename);
+        Close ();
+        return false;
+    }
+    return true;
+}
+
+void
+DCAppTraceReader::Close (void)
+{
+    NS_LOG_FUNCTION (this);
+
+    if (m_file == 0)
+        return;
+
+    fclose (m_file);
+    m_file = 0;
+}
+
+bool
+DCAppTraceReader::Read (DCAppTraceRecord& record)
+{
+    if (m_file == 0)
+        return false;
+    return fread (&record, sizeof (record), 1, m_file) == 1;
+}
@@ -0,0 +1,106 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef DC_APP_TRACE_H
+#define DC_APP_TRACE_H
+
+// C/C++ Includes
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// NS-3 Includes
+#include "ns3/address.h"
+
+using namespace ns3;
+
+/*
+ * Fixed-width record describing one packet sent or received by a
+ * DataCenterApp. Times are in nanoseconds, m_rxTime is -1 for TX events.
+ * Peer addresses are packed into 32 bits (see DCAppTraceWriter::PackAddress).
+ */
+typedef struct DCAppTraceRecordStruct
+{
+    int64_t         m_txTime;
+    int64_t         m_rxTime;
+    uint32_t        m_node;
+    uint32_t        m_peer;
+    uint32_t        m_size;
+    uint16_t        m_sequenceNumber;
+    uint8_t         m_event;
+    uint8_t         m_packetType;
+} DCAppTraceRecord;
+
+/*
+ * File header written once at the start of a trace file
+ */
+typedef struct DCAppTraceFileHeaderStruct
+{
+    uint32_t        m_magic;
+    uint16_t        m_version;
+    uint16_t        m_recordSize;
+} DCAppTraceFileHeader;
+
+/*
+ * Buffered writer for DataCenterApp packet records
+ */
+class DCAppTraceWriter
+{
+public:
+    // Event type of a record
+    typedef enum EVENT_ENUM
+    {
+        EVENT_INVALID = 0,
+        TX,
+        RX
+    } EVENT;
+
+    static const uint32_t MAGIC = 0x54414344;   // "DCAT"
+    static const uint16_t VERSION = 2;
+
+    // Constructor/Destructor
+    DCAppTraceWriter ();
+    ~DCAppTraceWriter ();
+
+    // Open the trace file and write the file header
+    bool Open (const std::string& filename);
+    // Flush buffered records and close the file
+    void Close (void);
+    bool IsOpen (void) const;
+
+    // Append a record, written out once the buffer is full
+    void Write (const DCAppTraceRecord& record);
+
+    // Pack an Ipv4/DimensionOrdered (socket) address into 32 bits, an
+    // n-dimensional address gets the low 32 / n bits of each coordinate
+    static uint32_t PackAddress (const Address& address);
+private:
+    static const uint32_t BUFFER_RECORDS = 4096;
+
+    void Flush (void);
+
+    FILE*                           m_file;
+    std::vector<DCAppTraceRecord>   m_buffer;
+};
+
+/*
+ * Sequential reader for files produced by DCAppTraceWriter
+ */
+class DCAppTraceReader
+{
+public:
+    // Constructor/Destructor
+    DCAppTraceReader ();
+    ~DCAppTraceReader ();
+
+    // Open the trace file and validate its header
+    bool Open (const std::string& filename);
+    void Close (void);
+
+    // Read the next record, false at the end of the file
+    bool Read (DCAppTraceRecord& record);
+private:
+    FILE*           m_file;
+};
+
+#endif
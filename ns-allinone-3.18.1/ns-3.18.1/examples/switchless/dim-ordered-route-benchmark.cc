@@ -0,0 +1,103 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * Microbenchmark for DimensionOrderedL3Protocol::FindRoute
+ *
+ * Builds a cube-dimordered topology and looks up the route from every node
+ * to every other node, first recomputing each route (EnableRouteCache=false)
+ * and then through the precomputed next-hop tables. Both passes must agree.
+ */
+
+// NS-3 Includes
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/switchless-module.h"
+
+// Switchless Includes
+#include "p2p-cube-dimordered.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("DimensionOrderedRouteBenchmark");
+
+static int64_t
+RunLookups (std::vector<Ptr<DimensionOrderedL3Protocol> > &protocols,
+            std::vector<DimensionOrderedAddress> &addresses,
+            uint32_t iterations, bool routeCache,
+            std::vector<uint8_t> &routes)
+{
+    for (uint32_t i = 0; i < protocols.size (); i++)
+        protocols[i]->SetAttribute ("EnableRouteCache", BooleanValue (routeCache));
+
+    routes.assign (protocols.size () * addresses.size (), 0);
+
+    SystemWallClockMs clock;
+    clock.Start ();
+    for (uint32_t iter = 0; iter < iterations; iter++)
+    {
+        for (uint32_t src = 0; src < protocols.size (); src++)
+        {
+            for (uint32_t dst = 0; dst < addresses.size (); dst++)
+                routes[src * addresses.size () + dst] = protocols[src]->FindRoute (addresses[dst]);
+        }
+    }
+    return clock.End ();
+}
+
+int
+main (int argc, char *argv[])
+{
+    unsigned nXdim = 16;
+    unsigned nYdim = 8;
+    unsigned nZdim = 8;
+    uint32_t nIterations = 10;
+    bool bTorus = true;
+
+    CommandLine cmd;
+    cmd.AddValue ("t1", "X dimension", nXdim);
+    cmd.AddValue ("t2", "Y dimension", nYdim);
+    cmd.AddValue ("t3", "Z dimension", nZdim);
+    cmd.AddValue ("iter", "Number of passes over all node pairs", nIterations);
+    cmd.AddValue ("torus", "Build a torus instead of a mesh", bTorus);
+    cmd.Parse (argc, argv);
+
+    PointToPointHelper pointToPoint;
+    pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("100Gbps"));
+    pointToPoint.SetChannelAttribute ("Delay", StringValue ("500ns"));
+
+    std::cout << "Making topology\n";
+    PointToPointCubeDimorderedHelper topology (nXdim, nYdim, nZdim, bTorus, pointToPoint);
+
+    uint32_t nNodes = nXdim * nYdim * nZdim;
+    std::vector<Ptr<DimensionOrderedL3Protocol> > protocols;
+    std::vector<DimensionOrderedAddress> addresses;
+    for (uint32_t i = 0; i < nNodes; i++)
+    {
+        protocols.push_back (topology.GetNode (i)->GetObject<DimensionOrderedL3Protocol> ());
+        addresses.push_back (DimensionOrderedAddress::ConvertFrom (topology.GetAddress (i)));
+    }
+
+    std::vector<uint8_t> computedRoutes;
+    std::vector<uint8_t> cachedRoutes;
+    int64_t computedMs = RunLookups (protocols, addresses, nIterations, false, computedRoutes);
+    int64_t cachedMs = RunLookups (protocols, addresses, nIterations, true, cachedRoutes);
+
+    if (computedRoutes != cachedRoutes)
+    {
+        std::cout << "Route cache disagrees with computed routes" << std::endl;
+        return 1;
+    }
+
+    double lookups = static_cast<double> (nNodes) * nNodes * nIterations;
+    std::cout << "Nodes: " << nNodes << "\n"
+              << "Lookups: " << lookups << "\n"
+              << "Computed: " << computedMs << " ms (" << computedMs * 1e6 / lookups << " ns/lookup)\n"
+              << "Cached: " << cachedMs << " ms (" << cachedMs * 1e6 / lookups << " ns/lookup)\n";
+    if (cachedMs > 0)
+        std::cout << "Speedup: " << static_cast<double> (computedMs) / cachedMs << "x\n";
+
+    Simulator::Destroy ();
+    return 0;
+}
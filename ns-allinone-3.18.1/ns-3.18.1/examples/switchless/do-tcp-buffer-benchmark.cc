@@ -0,0 +1,197 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * Microbenchmark for DoTcpTxBuffer and DoTcpRxBuffer
+ *
+ * Streams data through the switchless TCP buffers and through the list and
+ * map based TcpTxBuffer and TcpRxBuffer of the internet module, which the
+ * switchless buffers were copied from. The sender keeps a window of
+ * unacknowledged data in the Tx buffer and cuts segments from it, the
+ * receiver gets the segments with some of them late and reads whatever is
+ * in order after every segment. Both implementations must deliver the same
+ * bytes.
+ */
+
+// NS-3 Includes
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/switchless-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("DoTcpBufferBenchmark");
+
+// Application writes: a few real header bytes and a zero-filled payload
+static Ptr<Packet>
+MakeWrite (uint32_t size, uint32_t index)
+{
+    uint8_t header[16];
+    for (uint32_t i = 0; i < sizeof (header); i++)
+        header[i] = static_cast<uint8_t> (index * 31 + i);
+    uint32_t headerSize = std::min<uint32_t> (sizeof (header), size);
+    Ptr<Packet> p = Create<Packet> (header, headerSize);
+    p->AddAtEnd (Create<Packet> (size - headerSize));
+    return p;
+}
+
+static uint64_t
+Digest (uint64_t digest, Ptr<Packet> p)
+{
+    std::vector<uint8_t> data (p->GetSize ());
+    if (!data.empty ())
+        p->CopyData (&data[0], data.size ());
+    for (uint32_t i = 0; i < data.size (); i++)
+        digest = (digest ^ data[i]) * 1099511628211ULL;
+    return digest;
+}
+
+// Send nBytes keeping inFlight bytes unacknowledged, returns the wall time
+template <class TxBuffer>
+static int64_t
+RunTx (uint32_t bufferSize, uint32_t writeSize, uint32_t segmentSize, uint32_t inFlight, uint64_t nBytes,
+       bool digest, uint64_t &result)
+{
+    std::vector<Ptr<Packet> > writes;
+    for (uint32_t i = 0; i < 16; i++)
+        writes.push_back (MakeWrite (writeSize, i));
+    TxBuffer buffer;
+    buffer.SetMaxBufferSize (bufferSize);
+    SequenceNumber32 next (0);
+    uint64_t sent = 0;
+    uint32_t nWrites = 0;
+    result = 14695981039346656037ULL;
+
+    SystemWallClockMs clock;
+    clock.Start ();
+    while (sent < nBytes)
+    {
+        while (buffer.Available () >= writeSize)
+            buffer.Add (writes[nWrites++ % writes.size ()]);
+        Ptr<Packet> segment = buffer.CopyFromSequence (segmentSize, next);
+        next += segment->GetSize ();
+        sent += segment->GetSize ();
+        if (digest)
+            result = Digest (result, segment);
+        if (static_cast<uint32_t> (next - buffer.HeadSequence ()) > inFlight)
+            buffer.DiscardUpTo (next - inFlight);
+    }
+    return clock.End ();
+}
+
+// Receive nBytes in segments, holding every gap-th segment back by delay
+// segments, returns the wall time
+template <class RxBuffer, class Header>
+static int64_t
+RunRx (uint32_t bufferSize, uint32_t segmentSize, uint32_t gap, uint32_t delay, uint64_t nBytes,
+       bool digest, uint64_t &result)
+{
+    std::vector<Ptr<Packet> > segments;
+    for (uint32_t i = 0; i < 16; i++)
+        segments.push_back (MakeWrite (segmentSize, i));
+    RxBuffer buffer;
+    buffer.SetMaxBufferSize (bufferSize);
+    std::vector<std::pair<uint32_t, uint32_t> > late; // Segment number, due after this segment number
+    uint32_t nSegments = nBytes / segmentSize;
+    uint64_t read = 0;
+    result = 14695981039346656037ULL;
+    Header header;
+
+    SystemWallClockMs clock;
+    clock.Start ();
+    for (uint32_t i = 0; i < nSegments + delay; i++)
+    {
+        if (i < nSegments && gap > 0 && i % gap == 0)
+            late.push_back (std::make_pair (i, i + delay));
+        else if (i < nSegments)
+        {
+            header.SetSequenceNumber (SequenceNumber32 (i * segmentSize));
+            buffer.Add (segments[i % segments.size ()], header);
+        }
+        while (!late.empty () && late.front ().second <= i)
+        {
+            uint32_t segment = late.front ().first;
+            header.SetSequenceNumber (SequenceNumber32 (segment * segmentSize));
+            buffer.Add (segments[segment % segments.size ()], header);
+            late.erase (late.begin ());
+        }
+        Ptr<Packet> data = buffer.Extract (bufferSize);
+        if (data)
+        {
+            read += data->GetSize ();
+            if (digest)
+                result = Digest (result, data);
+        }
+    }
+    int64_t elapsed = clock.End ();
+    if (!digest)
+        result = read;
+    return elapsed;
+}
+
+int
+main (int argc, char *argv[])
+{
+    uint32_t nBufferSize = 1048576;
+    uint32_t nWriteSize = 4011;
+    uint32_t nSegmentSize = 1460;
+    uint32_t nGap = 64;
+    uint32_t nDelay = 32;
+    uint32_t nMegabytes = 2048;
+
+    CommandLine cmd;
+    cmd.AddValue ("bufsize", "Tx and Rx buffer size in bytes", nBufferSize);
+    cmd.AddValue ("writesize", "Application write size in bytes", nWriteSize);
+    cmd.AddValue ("segsize", "Segment size in bytes", nSegmentSize);
+    cmd.AddValue ("gap", "Every this many segments one arrives late, 0 for none", nGap);
+    cmd.AddValue ("delay", "Number of segments a late segment arrives after its turn", nDelay);
+    cmd.AddValue ("mb", "Megabytes to stream through each buffer", nMegabytes);
+    cmd.Parse (argc, argv);
+
+    if (nWriteSize > nBufferSize / 4 || nSegmentSize > nBufferSize / 4 || nDelay * nSegmentSize > nBufferSize / 2)
+    {
+        std::cout << "Writes, segments and the late data must fit well in the buffer\n";
+        return 1;
+    }
+    uint32_t inFlight = nBufferSize * 3 / 4;
+    uint64_t nBytes = static_cast<uint64_t> (nMegabytes) << 20;
+
+    // The same bytes must come out of both implementations
+    uint64_t verifyBytes = std::min<uint64_t> (nBytes, 16 << 20);
+    uint64_t listDigest, ringDigest, mapDigest, intervalDigest;
+    RunTx<TcpTxBuffer> (nBufferSize, nWriteSize, nSegmentSize, inFlight, verifyBytes, true, listDigest);
+    RunTx<DoTcpTxBuffer> (nBufferSize, nWriteSize, nSegmentSize, inFlight, verifyBytes, true, ringDigest);
+    RunRx<TcpRxBuffer, TcpHeader> (nBufferSize, nSegmentSize, nGap, nDelay, verifyBytes, true, mapDigest);
+    RunRx<DoTcpRxBuffer, DoTcpHeader> (nBufferSize, nSegmentSize, nGap, nDelay, verifyBytes, true, intervalDigest);
+    if (listDigest != ringDigest || mapDigest != intervalDigest)
+    {
+        std::cout << "The buffers disagree on the data" << std::endl;
+        return 1;
+    }
+
+    uint64_t listSent, ringSent, mapRead, intervalRead;
+    int64_t listMs = RunTx<TcpTxBuffer> (nBufferSize, nWriteSize, nSegmentSize, inFlight, nBytes, false, listSent);
+    int64_t ringMs = RunTx<DoTcpTxBuffer> (nBufferSize, nWriteSize, nSegmentSize, inFlight, nBytes, false, ringSent);
+    int64_t mapMs = RunRx<TcpRxBuffer, TcpHeader> (nBufferSize, nSegmentSize, nGap, nDelay, nBytes, false, mapRead);
+    int64_t intervalMs = RunRx<DoTcpRxBuffer, DoTcpHeader> (nBufferSize, nSegmentSize, nGap, nDelay, nBytes, false,
+                                                            intervalRead);
+    if (mapRead != intervalRead)
+    {
+        std::cout << "The Rx buffers read " << mapRead << " and " << intervalRead << " bytes" << std::endl;
+        return 1;
+    }
+
+    double segments = static_cast<double> (nBytes) / nSegmentSize;
+    std::cout << "Buffer: " << nBufferSize << " bytes, " << inFlight << " in flight\n"
+              << "Segments: " << segments << " of " << nSegmentSize << " bytes\n"
+              << "Tx list: " << listMs << " ms (" << listMs * 1e6 / segments << " ns/segment)\n"
+              << "Tx ring: " << ringMs << " ms (" << ringMs * 1e6 / segments << " ns/segment)\n"
+              << "Rx map: " << mapMs << " ms (" << mapMs * 1e6 / segments << " ns/segment)\n"
+              << "Rx intervals: " << intervalMs << " ms (" << intervalMs * 1e6 / segments << " ns/segment)\n";
+    if (ringMs > 0 && intervalMs > 0)
+        std::cout << "Speedup: Tx " << static_cast<double> (listMs) / ringMs << "x, Rx "
+                  << static_cast<double> (mapMs) / intervalMs << "x\n";
+
+    Simulator::Destroy ();
+    return 0;
+}
@@ -0,0 +1,954 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "flow-level-sim.h"
+
+// C/C++ Includes
+#include <math.h>
+#include <algorithm>
+#include <fstream>
+
+// NS-3 Includes
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/ppp-header.h"
+
+NS_LOG_COMPONENT_DEFINE ("FlowLevelSimulator");
+
+static const uint32_t NO_LINK = 0xffffffff;
+// Bytes left when a flow is considered drained
+static const double DRAINED_BYTES = 1e-6;
+
+bool
+FlowLevelSimulator::Event::operator> (const Event& other) const
+{
+    if (m_time != other.m_time)
+        return m_time > other.m_time;
+    return m_seq > other.m_seq;
+}
+
+FlowLevelSimulator::FlowLevelSimulator (PointToPointTopoHelper* topology, DataCenterApp::NETWORK_STACK stack)
+  : m_topology (topology),
+    m_stack (stack),
+    m_updateInterval (0.0),
+    m_recordFlows (false),
+    m_searchGeneration (0),
+    m_shareVersion (0),
+    m_seq (0),
+    m_now (0.0),
+    m_lastRateUpdate (0.0),
+    m_updatePending (false),
+    m_random (1),
+    m_latencyHistogram (),
+    m_rxBytes (0),
+    m_firstTxTime (INFINITY),
+    m_lastRxTime (0.0),
+    m_nRateUpdates (0)
+{
+    NS_LOG_FUNCTION (this);
+    BuildGraph ();
+}
+
+FlowLevelSimulator::~FlowLevelSimulator ()
+{
+    NS_LOG_FUNCTION (this);
+}
+
+void
+FlowLevelSimulator::SetRateUpdateInterval (Time interval)
+{
+    NS_LOG_FUNCTION (this << interval);
+    m_updateInterval = interval.GetNanoSeconds ();
+}
+
+void
+FlowLevelSimulator::EnableFlowRecords (void)
+{
+    NS_LOG_FUNCTION (this);
+    m_recordFlows = true;
+}
+
+void
+FlowLevelSimulator::BuildGraph (void)
+{
+    NS_LOG_FUNCTION (this);
+
+    uint32_t nNodes = NodeList::GetNNodes ();
+    m_deviceLinks.resize (nNodes);
+    m_neighbours.resize (nNodes);
+    m_dimOrdered.resize (nNodes);
+
+    // One directed link per point-to-point device, towards its peer
+    for (uint32_t node = 0; node < nNodes; node++)
+    {
+        Ptr<Node> n = NodeList::GetNode (node);
+        m_deviceLinks[node].assign (n->GetNDevices (), NO_LINK);
+        for (uint32_t i = 0; i < n->GetNDevices (); i++)
+        {
+            Ptr<PointToPointNetDevice> device = DynamicCast<PointToPointNetDevice> (n->GetDevice (i));
+            if (device == 0 || device->GetChannel () == 0 || device->GetChannel ()->GetNDevices () != 2)
+                continue;
+            Ptr<Channel> channel = device->GetChannel ();
+            Ptr<NetDevice> peer = channel->GetDevice (0) == device ? channel->GetDevice (1) : channel->GetDevice (0);
+
+            DataRateValue rate;
+            device->GetAttribute ("DataRate", rate);
+            TimeValue delay;
+            channel->GetAttribute ("Delay", delay);
+
+            Link link;
+            link.m_node = node;
+            link.m_ifIndex = i;
+            link.m_peer = peer->GetNode ()->GetId ();
+            link.m_capacity = rate.Get ().GetBitRate () / 8e9;
+            link.m_delay = delay.Get ().GetNanoSeconds ();
+            link.m_allocated = 0.0;
+            link.m_bytes = 0.0;
+            link.m_remaining = 0.0;
+            link.m_unfrozen = 0;
+            link.m_version = 0;
+            link.m_mark = 0;
+            link.m_flowsStart = 0;
+            link.m_flowsEnd = 0;
+            m_deviceLinks[node][i] = m_links.size ();
+            m_links.push_back (link);
+        }
+    }
+
+    for (uint32_t l = 0; l < m_links.size (); l++)
+    {
+        Link& link = m_links[l];
+        Ptr<NetDevice> device = NodeList::GetNode (link.m_node)->GetDevice (link.m_ifIndex);
+        Ptr<Channel> channel = device->GetChannel ();
+        Ptr<NetDevice> peer = channel->GetDevice (0) == device ? channel->GetDevice (1) : channel->GetDevice (0);
+        Neighbour neighbour;
+        neighbour.m_node = link.m_peer;
+        neighbour.m_outLink = l;
+        neighbour.m_inLink = m_deviceLinks[link.m_peer][peer->GetIfIndex ()];
+        m_neighbours[link.m_node].push_back (neighbour);
+    }
+
+    // Addresses of every node, to find the destination of a message
+    for (uint32_t node = 0; node < nNodes; node++)
+    {
+        Ptr<Node> n = NodeList::GetNode (node);
+        Ptr<Ipv4> ipv4 = n->GetObject<Ipv4> ();
+        for (uint32_t i = 0; ipv4 != 0 && i < ipv4->GetNInterfaces (); i++)
+        {
+            for (uint32_t j = 0; j < ipv4->GetNAddresses (i); j++)
+            {
+                Ipv4Address address = ipv4->GetAddress (i, j).GetLocal ();
+                if (address != Ipv4Address::GetLoopback ())
+                    m_ipv4Nodes[address] = node;
+            }
+        }
+        Ptr<DimensionOrderedL3Protocol> dimOrdered = n->GetObject<DimensionOrderedL3Protocol> ();
+        m_dimOrdered[node] = dimOrdered;
+        for (uint32_t dir = 0; dimOrdered != 0 && dir < DimensionOrdered::LOOPBACK; dir++)
+        {
+            DimensionOrderedAddress address =
+                dimOrdered->GetAddress (static_cast<DimensionOrdered::InterfaceDirection> (dir)).GetLocal ();
+            if (!(address == DimensionOrderedAddress::GetZero ()))
+                m_doNodes[address] = node;
+        }
+    }
+
+    NS_LOG_INFO ("Flow-level graph: " << nNodes << " nodes, " << m_links.size () << " links");
+}
+
+uint32_t
+FlowLevelSimulator::GetNodeForAddress (const Address& address) const
+{
+    if (Ipv4Address::IsMatchingType (address))
+    {
+        std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash>::const_iterator it =
+            m_ipv4Nodes.find (Ipv4Address::ConvertFrom (address));
+        if (it != m_ipv4Nodes.end ())
+            return it->second;
+    }
+    else if (DimensionOrderedAddress::IsMatchingType (address))
+    {
+        std::unordered_map<DimensionOrderedAddress, uint32_t, DimensionOrderedAddressHash>::const_iterator it =
+            m_doNodes.find (DimensionOrderedAddress::ConvertFrom (address));
+        if (it != m_doNodes.end ())
+            return it->second;
+    }
+    NS_FATAL_ERROR ("No node has address " << address);
+    return 0;
+}
+
+uint32_t
+FlowLevelSimulator::GetPath (uint32_t src, uint32_t dst, const Address& dstAddress)
+{
+    uint64_t key = (static_cast<uint64_t> (src) << 32) | dst;
+    std::unordered_map<uint64_t, uint32_t>::iterator it = m_pathCache.find (key);
+    if (it != m_pathCache.end ())
+        return it->second;
+
+    uint32_t path;
+    if (DimensionOrderedAddress::IsMatchingType (dstAddress))
+        path = FindDimensionOrderedPath (src, dstAddress);
+    else
+        path = FindShortestPath (src, dst);
+    m_pathCache[key] = path;
+    return path;
+}
+
+uint32_t
+FlowLevelSimulator::FindDimensionOrderedPath (uint32_t src, const Address& dstAddress)
+{
+    DimensionOrderedAddress destination = DimensionOrderedAddress::ConvertFrom (dstAddress);
+    uint32_t path = m_pathLinks.size ();
+    m_pathLinks.push_back (0);
+
+    // Follow the routing decision of every hop
+    uint32_t node = src;
+    while (true)
+    {
+        Ptr<DimensionOrderedL3Protocol> dimOrdered = m_dimOrdered[node];
+        DimensionOrdered::InterfaceDirection dir = dimOrdered->FindRoute (destination);
+        if (dir == DimensionOrdered::LOOPBACK)
+            break;
+        Ptr<NetDevice> device = dimOrdered->GetNetDevice (dir);
+        if (dir == DimensionOrdered::INVALID_DIR || device == 0 ||
+            m_deviceLinks[node][device->GetIfIndex ()] == NO_LINK)
+            NS_FATAL_ERROR ("No route from node " << node << " to " << destination);
+        uint32_t link = m_deviceLinks[node][device->GetIfIndex ()];
+        m_pathLinks.push_back (link);
+        node = m_links[link].m_peer;
+        if (m_pathLinks.size () - path > m_links.size ())
+            NS_FATAL_ERROR ("Routing loop from node " << src << " to " << destination);
+    }
+    m_pathLinks[path] = m_pathLinks.size () - path - 1;
+    return path;
+}
+
+uint32_t
+FlowLevelSimulator::FindShortestPath (uint32_t src, uint32_t dst)
+{
+    // Bidirectional breadth first search, expanding the smaller frontier a
+    // level at a time. Every node a frontier node can meet on the other
+    // side is in that side's last level, so the first meeting point gives
+    // a shortest path.
+    if (m_searchMark.size () != m_neighbours.size ())
+    {
+        m_searchMark.assign (m_neighbours.size (), 0);
+        m_searchVia.assign (m_neighbours.size (), NO_LINK);
+        m_searchGeneration = 0;
+    }
+    m_searchGeneration += 2;
+    std::vector<uint32_t>& side = m_searchMark;     // generation from src, +1 from dst
+    std::vector<uint32_t>& via = m_searchVia;       // link towards the side's root
+    std::vector<uint32_t> frontier[2];
+    frontier[0].push_back (src);
+    frontier[1].push_back (dst);
+    side[src] = m_searchGeneration;
+    side[dst] = m_searchGeneration + 1;
+
+    uint32_t bestFrom = NO_LINK, bestLink = NO_LINK, bestTo = NO_LINK;
+    while (src != dst && bestLink == NO_LINK)
+    {
+        if (frontier[0].empty () || frontier[1].empty ())
+            NS_FATAL_ERROR ("No route from node " << src << " to node " << dst);
+        uint32_t s = frontier[0].size () <= frontier[1].size () ? 0 : 1;
+        uint32_t mark = m_searchGeneration + s;
+        uint32_t otherMark = m_searchGeneration + 1 - s;
+        std::vector<uint32_t> next;
+        for (uint32_t i = 0; i < frontier[s].size () && bestLink == NO_LINK; i++)
+        {
+            uint32_t node = frontier[s][i];
+            for (uint32_t j = 0; j < m_neighbours[node].size (); j++)
+            {
+                const Neighbour& neighbour = m_neighbours[node][j];
+                // Links point from src towards dst
+                uint32_t link = s == 0 ? neighbour.m_outLink : neighbour.m_inLink;
+                if (side[neighbour.m_node] == otherMark)
+                {
+                    bestFrom = s == 0 ? node : neighbour.m_node;
+                    bestTo = s == 0 ? neighbour.m_node : node;
+                    bestLink = link;
+                    break;
+                }
+                if (side[neighbour.m_node] != mark)
+                {
+                    side[neighbour.m_node] = mark;
+                    via[neighbour.m_node] = link;
+                    next.push_back (neighbour.m_node);
+                }
+            }
+        }
+        frontier[s].swap (next);
+    }
+
+    std::vector<uint32_t> links;
+    for (uint32_t node = bestFrom; src != dst && node != src; node = m_links[via[node]].m_node)
+        links.push_back (via[node]);
+    std::reverse (links.begin (), links.end ());
+    if (src != dst)
+        links.push_back (bestLink);
+    for (uint32_t node = bestTo; src != dst && node != dst; node = m_links[via[node]].m_peer)
+        links.push_back (via[node]);
+
+    uint32_t path = m_pathLinks.size ();
+    m_pathLinks.push_back (links.size ());
+    m_pathLinks.insert (m_pathLinks.end (), links.begin (), links.end ());
+    return path;
+}
+
+bool
+FlowLevelSimulator::AddApplication (DataCenterApp::SendParams& params, uint32_t nodeId)
+{
+    NS_LOG_FUNCTION (this << nodeId);
+
+    if (!params.m_sending)
+        return true;
+    if (params.m_nReceivers > params.m_nodes.size () || params.m_nodes.empty ())
+    {
+        NS_LOG_ERROR ("Number of receivers is greater than number of nodes");
+        return false;
+    }
+    if (params.m_minSendInterval > params.m_maxSendInterval)
+    {
+        NS_LOG_ERROR ("Min send interval is greater than max send interval");
+        return false;
+    }
+    if (params.m_sendPattern == DataCenterApp::OPEN_LOOP)
+    {
+        NS_LOG_ERROR ("Open-loop sending is not supported by the flow-level engine");
+        return false;
+    }
+
+    Sender sender;
+    sender.m_node = m_topology->GetNode (nodeId)->GetId ();
+    DataCenterApp::copySendParams (params, sender.m_params);
+    sender.m_iterationCount = 0;
+    sender.m_totalPacketsSent = 0;
+    sender.m_responseCount = 0;
+
+    // Headers of a message on the wire, the payload is added per flow
+    Ptr<Packet> appPacket = Create<Packet> (0);
+    appPacket->AddHeader (DCAppHeader ());
+    sender.m_overhead = PppHeader ().GetSerializedSize () + appPacket->GetSize ();
+    switch (m_stack)
+    {
+        case DataCenterApp::UDP_IP_STACK:
+            sender.m_overhead += Ipv4Header ().GetSerializedSize () + UdpHeader ().GetSerializedSize ();
+            break;
+        case DataCenterApp::TCP_IP_STACK:
+            sender.m_overhead += Ipv4Header ().GetSerializedSize () + TcpHeader ().GetSerializedSize ();
+            break;
+        case DataCenterApp::UDP_DO_STACK:
+        case DataCenterApp::TCP_DO_STACK:
+        case DataCenterApp::HOMA_DO_STACK:
+        {
+            DimensionOrderedHeader header;
+            DimensionOrderedAddress address = DimensionOrderedAddress::ConvertFrom (params.m_nodes[0]);
+            header.SetSource (address);
+            header.SetDestination (address);
+            sender.m_overhead += header.GetSerializedSize ();
+            if (m_stack == DataCenterApp::UDP_DO_STACK)
+                sender.m_overhead += DoUdpHeader ().GetSerializedSize ();
+            else if (m_stack == DataCenterApp::HOMA_DO_STACK)
+                sender.m_overhead += DoHomaHeader ().GetSerializedSize ();
+            else
+                sender.m_overhead += DoTcpHeader ().GetSerializedSize ();
+            break;
+        }
+        default:
+            NS_LOG_ERROR ("Invalid stack specified in FlowLevelSimulator::AddApplication()");
+            return false;
+    }
+
+    // Address responses are sent back to
+    if (Ipv4Address::IsMatchingType (params.m_nodes[0]))
+        sender.m_address = m_topology->GetIpv4Address (nodeId);
+    else
+    {
+        Ptr<DimensionOrderedL3Protocol> dimOrdered = m_dimOrdered[sender.m_node];
+        for (uint32_t dir = 0; dir < DimensionOrdered::LOOPBACK; dir++)
+        {
+            DimensionOrderedAddress address =
+                dimOrdered->GetAddress (static_cast<DimensionOrdered::InterfaceDirection> (dir)).GetLocal ();
+            if (!(address == DimensionOrderedAddress::GetZero ()))
+            {
+                sender.m_address = address;
+                break;
+            }
+        }
+    }
+
+    m_senders.push_back (sender);
+    return true;
+}
+
+void
+FlowLevelSimulator::Schedule (double time, EVENT type, uint32_t a, uint32_t b)
+{
+    Event event;
+    event.m_time = time;
+    event.m_seq = m_seq++;
+    event.m_type = type;
+    event.m_a = a;
+    event.m_b = b;
+    m_events.push (event);
+}
+
+void
+FlowLevelSimulator::Run (void)
+{
+    NS_LOG_FUNCTION (this);
+
+    for (uint32_t i = 0; i < m_senders.size (); i++)
+        KickOffSending (i);
+
+    while (!m_events.empty ())
+    {
+        Event event = m_events.top ();
+        m_events.pop ();
+        m_now = event.m_time;
+        switch (event.m_type)
+        {
+            case EVENT_SEND:
+                SendPacket (event.m_a, event.m_b);
+                break;
+            case EVENT_BULK_SEND:
+                BulkSendPackets (event.m_a);
+                break;
+            case EVENT_FINISH:
+                FinishFlow (event.m_a, event.m_b);
+                break;
+            case EVENT_DELIVER:
+                DeliverFlow (event.m_a);
+                break;
+            case EVENT_UPDATE:
+                UpdateRates ();
+                break;
+        }
+    }
+    NS_ASSERT (m_active.empty ());
+    NS_LOG_INFO ("Flow-level run: " << m_nRateUpdates << " rate updates");
+}
+
+void
+FlowLevelSimulator::StartFlow (uint32_t sender, uint32_t receiver, bool response)
+{
+    const Sender& s = m_senders[sender];
+    const Address& receiverAddress = s.m_params.m_nodes[receiver];
+
+    uint32_t index;
+    if (m_freeFlows.empty ())
+    {
+        index = m_flows.size ();
+        m_flows.push_back (Flow ());
+    }
+    else
+    {
+        index = m_freeFlows.back ();
+        m_freeFlows.pop_back ();
+    }
+    Flow& flow = m_flows[index];
+    flow.m_sender = sender;
+    flow.m_receiver = receiver;
+    flow.m_response = response;
+    uint32_t receiverNode = GetNodeForAddress (receiverAddress);
+    flow.m_src = response ? receiverNode : s.m_node;
+    flow.m_dst = response ? s.m_node : receiverNode;
+    flow.m_path = GetPath (flow.m_src, flow.m_dst, response ? s.m_address : receiverAddress);
+    flow.m_payload = response ? 0 : s.m_params.m_packetSize;
+    flow.m_size = flow.m_payload + s.m_overhead;
+    flow.m_remaining = flow.m_size;
+    flow.m_lastUpdate = m_now;
+    flow.m_start = m_now;
+    // The version carries on from the slot's earlier flows, whose FINISH
+    // events may still be queued
+    flow.m_frozen = false;
+    if (m_now < m_firstTxTime)
+        m_firstTxTime = m_now;
+
+    // Store and forward on the hops after the first one, and propagation
+    uint32_t nHops = m_pathLinks[flow.m_path];
+    const uint32_t* links = &m_pathLinks[flow.m_path + 1];
+    flow.m_tail = 0.0;
+    flow.m_rate = INFINITY;
+    for (uint32_t i = 0; i < nHops; i++)
+    {
+        Link& link = m_links[links[i]];
+        link.m_bytes += flow.m_size;
+        flow.m_tail += link.m_delay;
+        if (i > 0)
+            flow.m_tail += flow.m_size / link.m_capacity;
+        // Until the next rate update the flow uses what is left of its path
+        double spare = link.m_capacity - link.m_allocated;
+        flow.m_rate = std::min (flow.m_rate, spare > 0.0 ? spare : 0.0);
+    }
+
+    if (nHops == 0)
+    {
+        flow.m_rate = 0.0;
+        flow.m_remaining = 0.0;
+        flow.m_activeIndex = NO_LINK;
+        Schedule (m_now, EVENT_DELIVER, index, 0);
+        return;
+    }
+
+    for (uint32_t i = 0; i < nHops; i++)
+        m_links[links[i]].m_allocated += flow.m_rate;
+    flow.m_activeIndex = m_active.size ();
+    m_active.push_back (index);
+    ScheduleFinish (flow);
+    RequestUpdate ();
+}
+
+void
+FlowLevelSimulator::ScheduleFinish (Flow& flow)
+{
+    uint32_t index = &flow - &m_flows[0];
+    flow.m_version++;
+    if (flow.m_rate > 0.0)
+        Schedule (m_now + flow.m_remaining / flow.m_rate, EVENT_FINISH, index, flow.m_version);
+}
+
+void
+FlowLevelSimulator::FinishFlow (uint32_t index, uint32_t version)
+{
+    Flow& flow = m_flows[index];
+    if (flow.m_version != version || flow.m_activeIndex == NO_LINK)
+        return;
+
+    uint32_t nHops = m_pathLinks[flow.m_path];
+    const uint32_t* links = &m_pathLinks[flow.m_path + 1];
+    for (uint32_t i = 0; i < nHops; i++)
+        m_links[links[i]].m_allocated -= flow.m_rate;
+    flow.m_remaining = 0.0;
+    flow.m_rate = 0.0;
+
+    m_active[flow.m_activeIndex] = m_active.back ();
+    m_flows[m_active.back ()].m_activeIndex = flow.m_activeIndex;
+    m_active.pop_back ();
+    flow.m_activeIndex = NO_LINK;
+
+    Schedule (m_now + flow.m_tail, EVENT_DELIVER, index, 0);
+    RequestUpdate ();
+}
+
+void
+FlowLevelSimulator::RequestUpdate (void)
+{
+    if (m_updatePending)
+        return;
+    m_updatePending = true;
+    Schedule (std::max (m_now, m_lastRateUpdate + m_updateInterval), EVENT_UPDATE, 0, 0);
+}
+
+void
+FlowLevelSimulator::UpdateRates (void)
+{
+    m_updatePending = false;
+    m_lastRateUpdate = m_now;
+    m_nRateUpdates++;
+    if (m_active.empty ())
+        return;
+
+    // Drain the flows at their old rates and take them off their links
+    std::vector<uint32_t> touched;
+    for (uint32_t f = 0; f < m_active.size (); f++)
+    {
+        Flow& flow = m_flows[m_active[f]];
+        flow.m_remaining -= flow.m_rate * (m_now - flow.m_lastUpdate);
+        if (flow.m_remaining < DRAINED_BYTES)
+            flow.m_remaining = 0.0;
+        flow.m_lastUpdate = m_now;
+        flow.m_frozen = false;
+        uint32_t nHops = m_pathLinks[flow.m_path];
+        const uint32_t* links = &m_pathLinks[flow.m_path + 1];
+        for (uint32_t i = 0; i < nHops; i++)
+        {
+            Link& link = m_links[links[i]];
+            link.m_allocated -= flow.m_rate;
+            if (link.m_unfrozen == 0)
+            {
+                touched.push_back (links[i]);
+                link.m_remaining = link.m_capacity;
+            }
+            link.m_unfrozen++;
+        }
+    }
+
+    // Flows of every link, in one array
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < touched.size (); i++)
+    {
+        Link& link = m_links[touched[i]];
+        link.m_flowsStart = total;
+        total += link.m_unfrozen;
+        link.m_flowsEnd = total;
+        link.m_unfrozen = 0;
+    }
+    std::vector<uint32_t> linkFlows (total);
+    for (uint32_t f = 0; f < m_active.size (); f++)
+    {
+        Flow& flow = m_flows[m_active[f]];
+        uint32_t nHops = m_pathLinks[flow.m_path];
+        const uint32_t* links = &m_pathLinks[flow.m_path + 1];
+        for (uint32_t i = 0; i < nHops; i++)
+        {
+            Link& link = m_links[links[i]];
+            linkFlows[link.m_flowsStart + link.m_unfrozen++] = m_active[f];
+        }
+    }
+
+    // Water-filling: the link with the smallest fair share fixes the rate
+    // of its remaining flows. Shares only grow, so a link is pushed again
+    // once per bottleneck that changes it and stale entries are skipped.
+    typedef std::pair<double, std::pair<uint32_t, uint64_t> > Share;
+    std::priority_queue<Share, std::vector<Share>, std::greater<Share> > shares;
+    for (uint32_t i = 0; i < touched.size (); i++)
+    {
+        Link& link = m_links[touched[i]];
+        link.m_version = ++m_shareVersion;
+        shares.push (Share (link.m_remaining / link.m_unfrozen, std::make_pair (touched[i], link.m_version)));
+    }
+    std::vector<uint32_t> changed;
+    while (!shares.empty ())
+    {
+        Share share = shares.top ();
+        shares.pop ();
+        Link& bottleneck = m_links[share.second.first];
+        if (bottleneck.m_version != share.second.second || bottleneck.m_unfrozen == 0)
+            continue;
+
+        double rate = std::max (share.first, 0.0);
+        uint64_t mark = ++m_shareVersion;
+        changed.clear ();
+        for (uint32_t j = bottleneck.m_flowsStart; j < bottleneck.m_flowsEnd; j++)
+        {
+            Flow& flow = m_flows[linkFlows[j]];
+            if (flow.m_frozen)
+                continue;
+            flow.m_frozen = true;
+            flow.m_rate = rate;
+            uint32_t nHops = m_pathLinks[flow.m_path];
+            const uint32_t* links = &m_pathLinks[flow.m_path + 1];
+            for (uint32_t i = 0; i < nHops; i++)
+            {
+                Link& link = m_links[links[i]];
+                link.m_remaining -= rate;
+                link.m_unfrozen--;
+                if (link.m_mark != mark)
+                {
+                    link.m_mark = mark;
+                    changed.push_back (links[i]);
+                }
+            }
+        }
+        for (uint32_t i = 0; i < changed.size (); i++)
+        {
+            Link& link = m_links[changed[i]];
+            if (link.m_unfrozen == 0)
+                continue;
+            link.m_version = ++m_shareVersion;
+            shares.push (Share (link.m_remaining / link.m_unfrozen, std::make_pair (changed[i], link.m_version)));
+        }
+    }
+
+    for (uint32_t f = 0; f < m_active.size (); f++)
+    {
+        Flow& flow = m_flows[m_active[f]];
+        uint32_t nHops = m_pathLinks[flow.m_path];
+        const uint32_t* links = &m_pathLinks[flow.m_path + 1];
+        for (uint32_t i = 0; i < nHops; i++)
+            m_links[links[i]].m_allocated += flow.m_rate;
+        ScheduleFinish (flow);
+    }
+}
+
+void
+FlowLevelSimulator::DeliverFlow (uint32_t index)
+{
+    Flow& flow = m_flows[index];
+    double latency = m_now - flow.m_start;
+    m_latencyHistogram.Add (static_cast<uint64_t> (llround (latency)));
+    m_rxBytes += flow.m_payload;
+    if (m_now > m_lastRxTime)
+        m_lastRxTime = m_now;
+    if (m_recordFlows)
+    {
+        FlowRecord record;
+        record.m_src = flow.m_src;
+        record.m_dst = flow.m_dst;
+        record.m_bytes = flow.m_payload;
+        record.m_response = flow.m_response;
+        record.m_start = flow.m_start;
+        record.m_fct = latency;
+        m_records.push_back (record);
+    }
+
+    uint32_t sender = flow.m_sender;
+    uint32_t receiver = flow.m_receiver;
+    bool response = flow.m_response;
+    m_freeFlows.push_back (index);
+
+    if (!response)
+    {
+        StartFlow (sender, receiver, true);
+        return;
+    }
+
+    Sender& s = m_senders[sender];
+    switch (s.m_params.m_sendPattern)
+    {
+        case DataCenterApp::FIXED_INTERVAL:
+        case DataCenterApp::RANDOM_INTERVAL:
+            // If we received all responses, can schedule another iteration
+            if (++s.m_responseCount == s.m_params.m_nReceivers)
+            {
+                s.m_responseCount = 0;
+                if (s.m_iterationCount < s.m_params.m_nIterations)
+                    BulkScheduleSend (sender);
+            }
+            break;
+        case DataCenterApp::FIXED_SPORADIC:
+        case DataCenterApp::RANDOM_SPORADIC:
+            if (s.m_totalPacketsSent < s.m_params.m_nIterations * s.m_params.m_nReceivers)
+                ScheduleSend (sender, receiver);
+            break;
+        default:
+            break;
+    }
+}
+
+void
+FlowLevelSimulator::KickOffSending (uint32_t sender)
+{
+    Sender& s = m_senders[sender];
+    switch (s.m_params.m_sendPattern)
+    {
+        case DataCenterApp::FIXED_INTERVAL:
+        case DataCenterApp::RANDOM_INTERVAL:
+            BulkSendPackets (sender);
+            break;
+        case DataCenterApp::FIXED_SPORADIC:
+        case DataCenterApp::RANDOM_SPORADIC:
+        {
+            if (s.m_params.m_receivers == DataCenterApp::ALL_IN_LIST)
+            {
+                for (uint32_t i = 0; i < s.m_params.m_nodes.size (); i++)
+                {
+                    if (s.m_params.m_sendPattern == DataCenterApp::FIXED_SPORADIC)
+                        Schedule (m_now + SelectRandomInterval (s), EVENT_SEND, sender, i);
+                    else
+                        ScheduleSend (sender, i);
+                }
+            }
+            else
+            {
+                for (uint32_t i = 0; i < s.m_params.m_nReceivers; i++)
+                {
+                    if (s.m_params.m_sendPattern == DataCenterApp::FIXED_SPORADIC)
+                    {
+                        double interval = SelectRandomInterval (s);
+                        Schedule (m_now + interval, EVENT_SEND, sender, SelectRandomReceiver (s));
+                    }
+                    else
+                        ScheduleSend (sender, 0);
+                }
+            }
+            break;
+        }
+        default:
+            NS_LOG_ERROR ("Invalid send pattern specified");
+            break;
+    }
+}
+
+void
+FlowLevelSimulator::BulkSendPackets (uint32_t sender)
+{
+    Sender& s = m_senders[sender];
+    if (s.m_iterationCount >= s.m_params.m_nIterations)
+        return;
+
+    if (s.m_params.m_receivers == DataCenterApp::ALL_IN_LIST)
+    {
+        for (uint32_t i = 0; i < s.m_params.m_nodes.size (); i++)
+        {
+            StartFlow (sender, i, false);
+            s.m_totalPacketsSent++;
+        }
+    }
+    else
+    {
+        // Unique random subset of the receivers
+        std::vector<uint32_t> subset;
+        while (subset.size () < s.m_params.m_nReceivers)
+        {
+            uint32_t candidate = SelectRandomReceiver (s);
+            if (std::find (subset.begin (), subset.end (), candidate) == subset.end ())
+                subset.push_back (candidate);
+        }
+        for (uint32_t i = 0; i < subset.size (); i++)
+        {
+            StartFlow (sender, subset[i], false);
+            s.m_totalPacketsSent++;
+        }
+    }
+    s.m_iterationCount++;
+}
+
+void
+FlowLevelSimulator::SendPacket (uint32_t sender, uint32_t receiver)
+{
+    Sender& s = m_senders[sender];
+    if (s.m_totalPacketsSent < s.m_params.m_nIterations * s.m_params.m_nReceivers)
+    {
+        StartFlow (sender, receiver, false);
+        s.m_totalPacketsSent++;
+    }
+}
+
+void
+FlowLevelSimulator::BulkScheduleSend (uint32_t sender)
+{
+    Sender& s = m_senders[sender];
+    double interval = s.m_params.m_sendPattern == DataCenterApp::FIXED_INTERVAL ?
+        s.m_params.m_sendInterval.GetNanoSeconds () : SelectRandomInterval (s);
+    Schedule (m_now + interval, EVENT_BULK_SEND, sender, 0);
+}
+
+void
+FlowLevelSimulator::ScheduleSend (uint32_t sender, uint32_t receiver)
+{
+    Sender& s = m_senders[sender];
+    if (s.m_params.m_receivers == DataCenterApp::RANDOM_SUBSET)
+        receiver = SelectRandomReceiver (s);
+    double interval = s.m_params.m_sendPattern == DataCenterApp::FIXED_SPORADIC ?
+        s.m_params.m_sendInterval.GetNanoSeconds () : SelectRandomInterval (s);
+    Schedule (m_now + interval, EVENT_SEND, sender, receiver);
+}
+
+uint32_t
+FlowLevelSimulator::SelectRandomReceiver (const Sender& sender)
+{
+    return m_random () % sender.m_params.m_nodes.size ();
+}
+
+double
+FlowLevelSimulator::SelectRandomInterval (const Sender& sender)
+{
+    int64_t min = sender.m_params.m_minSendInterval.GetNanoSeconds ();
+    int64_t max = sender.m_params.m_maxSendInterval.GetNanoSeconds ();
+    return m_random () % (max - min + 1) + min;
+}
+
+const LatencyHistogram&
+FlowLevelSimulator::GetLatencyHistogram (void) const
+{
+    return m_latencyHistogram;
+}
+
+uint64_t
+FlowLevelSimulator::GetRxBytes (void) const
+{
+    return m_rxBytes;
+}
+
+double
+FlowLevelSimulator::GetSeconds (void) const
+{
+    if (m_latencyHistogram.GetCount () == 0 || m_lastRxTime <= m_firstTxTime)
+        return 0.0;
+    return (m_lastRxTime - m_firstTxTime) / 1e9;
+}
+
+void
+FlowLevelSimulator::PrintStatistics (std::ostream& os) const
+{
+    os << "Latency: ";
+    m_latencyHistogram.Print (os);
+    os << "\n";
+
+    double seconds = GetSeconds ();
+    os << "Throughput: " << m_rxBytes << " bytes in " << seconds << " s";
+    if (seconds > 0.0)
+        os << " (" << m_rxBytes * 8.0 / seconds / 1e9 << " Gbps, " <<
+              m_latencyHistogram.GetCount () / seconds << " packets/s)";
+    os << "\n";
+
+    // Utilisation of the links that carried traffic, over the whole run
+    uint32_t used = 0;
+    double sum = 0.0;
+    double max = 0.0;
+    for (uint32_t l = 0; l < m_links.size (); l++)
+    {
+        if (m_links[l].m_bytes == 0.0 || seconds == 0.0)
+            continue;
+        double utilisation = m_links[l].m_bytes / (m_links[l].m_capacity * seconds * 1e9);
+        used++;
+        sum += utilisation;
+        max = std::max (max, utilisation);
+    }
+    os << "Links: " << used << " of " << m_links.size () << " used, utilisation mean=" <<
+          (used ? 100.0 * sum / used : 0.0) << "% max=" << 100.0 * max << "%\n";
+}
+
+void
+FlowLevelSimulator::PrintValidation (std::ostream& os, const LatencyHistogram& packetLatency,
+                                     uint64_t packetRxBytes, double packetSeconds) const
+{
+    double flowGbps = GetSeconds () > 0.0 ? m_rxBytes * 8.0 / GetSeconds () / 1e9 : 0.0;
+    double packetGbps = packetSeconds > 0.0 ? packetRxBytes * 8.0 / packetSeconds / 1e9 : 0.0;
+    const char* names[] = { "count", "mean", "p50", "p90", "p99", "max", "Gbps" };
+    double flow[] = { (double) m_latencyHistogram.GetCount (), m_latencyHistogram.GetMean (),
+                      (double) m_latencyHistogram.GetPercentile (0.5),
+                      (double) m_latencyHistogram.GetPercentile (0.9),
+                      (double) m_latencyHistogram.GetPercentile (0.99),
+                      (double) m_latencyHistogram.GetMax (), flowGbps };
+    double packet[] = { (double) packetLatency.GetCount (), packetLatency.GetMean (),
+                        (double) packetLatency.GetPercentile (0.5),
+                        (double) packetLatency.GetPercentile (0.9),
+                        (double) packetLatency.GetPercentile (0.99),
+                        (double) packetLatency.GetMax (), packetGbps };
+
+    os << "Validation (flow-level vs packet-level):\n";
+    for (uint32_t i = 0; i < sizeof (flow) / sizeof (flow[0]); i++)
+    {
+        os << "    " << names[i] << ": " << flow[i] << " vs " << packet[i];
+        if (packet[i] != 0.0)
+            os << " (" << (flow[i] - packet[i]) / packet[i] * 100.0 << "%)";
+        os << "\n";
+    }
+}
+
+bool
+FlowLevelSimulator::WriteFlows (std::string filename) const
+{
+    std::ofstream out (filename.c_str ());
+    if (!out)
+        return false;
+    out << "# src dst bytes type start_ns fct_ns\n";
+    for (uint32_t i = 0; i < m_records.size (); i++)
+    {
+        const FlowRecord& record = m_records[i];
+        out << record.m_src << " " << record.m_dst << " " << record.m_bytes << " " <<
+               (record.m_response ? "RESPONSE" : "REQUEST") << " " <<
+               record.m_start << " " << record.m_fct << "\n";
+    }
+    return out.good ();
+}
+
+bool
+FlowLevelSimulator::WriteLinks (std::string filename) const
+{
+    std::ofstream out (filename.c_str ());
+    if (!out)
+        return false;
+    double seconds = GetSeconds ();
+    out << "# node device peer gbps bytes utilisation\n";
+    for (uint32_t l = 0; l < m_links.size (); l++)
+    {
+        const Link& link = m_links[l];
+        out << link.m_node << " " << link.m_ifIndex << " " << link.m_peer << " " <<
+               link.m_capacity * 8.0 << " " << link.m_bytes << " " <<
+               (seconds > 0.0 ? link.m_bytes / (link.m_capacity * seconds * 1e9) : 0.0) << "\n";
+    }
+    return out.good ();
+}
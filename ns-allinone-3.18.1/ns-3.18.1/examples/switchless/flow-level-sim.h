@@ -0,0 +1,232 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef FLOW_LEVEL_SIM_H
+#define FLOW_LEVEL_SIM_H
+
+// C/C++ Includes
+#include <stdint.h>
+#include <ostream>
+#include <queue>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// NS-3 Includes
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+// Switchless Includes
+#include "data-center-app.h"
+#include "latency-histogram.h"
+#include "p2p-topology-interface.h"
+
+using namespace ns3;
+
+/*
+ * Flow-level (fluid) replacement for running a DataCenterApp on every node.
+ *
+ * Every message a DataCenterApp would send, request or response, is a flow
+ * of its wire size along the route the packet-level stack would take:
+ * dimension-ordered routes are taken from the DimensionOrderedL3Protocol of
+ * each hop, IP routes are a shortest path over the point-to-point links
+ * (ties may be broken differently from Ipv4GlobalRouting). Routes are
+ * computed once per node pair and cached.
+ *
+ * Active flows share the links max-min fairly. Rates are recomputed by
+ * water-filling when flows arrive and depart, at most once per rate update
+ * interval; in between a new flow gets the spare capacity of its path. A
+ * flow is delivered once its bytes have drained plus the propagation delay
+ * and store-and-forward time of the hops after the first one, and delivery
+ * drives the same request/response and iteration logic as DataCenterApp.
+ *
+ * Queues are not modelled: flows sharing a link finish together instead
+ * of one after the other, so mean latencies come out higher than with
+ * FIFO queues, and there are no losses, retransmissions or TCP handshakes.
+ *
+ * The topology and addresses must be built, but no applications installed
+ * and no routing tables populated. Run () does not use the ns-3 Simulator.
+ */
+class FlowLevelSimulator
+{
+public:
+    FlowLevelSimulator (PointToPointTopoHelper* topology, DataCenterApp::NETWORK_STACK stack);
+    ~FlowLevelSimulator ();
+
+    // Recompute rates at most once per interval, 0 on every arrival and departure
+    void SetRateUpdateInterval (Time interval);
+    // Keep a record of every flow for WriteFlows
+    void EnableFlowRecords (void);
+
+    // Same parameters as DataCenterApp::Setup, for the sending nodes
+    bool AddApplication (DataCenterApp::SendParams& params, uint32_t nodeId);
+    void Run (void);
+
+    const LatencyHistogram& GetLatencyHistogram (void) const;
+    uint64_t GetRxBytes (void) const;
+    // From the first send to the last delivery
+    double GetSeconds (void) const;
+
+    // Same latency and throughput lines as DataCenterApp, plus link utilisation
+    void PrintStatistics (std::ostream& os) const;
+    // Relative error of the flow-level results against a packet-level run
+    void PrintValidation (std::ostream& os, const LatencyHistogram& packetLatency,
+                          uint64_t packetRxBytes, double packetSeconds) const;
+    // One line per flow: source, destination, bytes, start and completion time in ns
+    bool WriteFlows (std::string filename) const;
+    // One line per directed link: node, device, peer, capacity, bytes and utilisation
+    bool WriteLinks (std::string filename) const;
+
+private:
+    friend class FlowLevelSimulatorTest;
+
+    typedef enum EVENT_ENUM
+    {
+        EVENT_SEND = 0,
+        EVENT_BULK_SEND,
+        EVENT_FINISH,
+        EVENT_DELIVER,
+        EVENT_UPDATE
+    } EVENT;
+
+    struct Event
+    {
+        double      m_time;         // ns
+        uint64_t    m_seq;
+        EVENT       m_type;
+        uint32_t    m_a;
+        uint32_t    m_b;
+        bool operator> (const Event& other) const;
+    };
+
+    // Directed point-to-point link
+    struct Link
+    {
+        uint32_t    m_node;
+        uint32_t    m_ifIndex;
+        uint32_t    m_peer;
+        double      m_capacity;     // bytes per ns
+        double      m_delay;        // ns
+        double      m_allocated;    // sum of the rates of the flows on the link
+        double      m_bytes;
+        // Water-filling state
+        double      m_remaining;
+        uint32_t    m_unfrozen;
+        uint64_t    m_version;      // of the link's latest share in the heap
+        uint64_t    m_mark;
+        uint32_t    m_flowsStart;
+        uint32_t    m_flowsEnd;
+    };
+
+    struct Neighbour
+    {
+        uint32_t    m_node;
+        uint32_t    m_outLink;
+        uint32_t    m_inLink;
+    };
+
+    struct Sender
+    {
+        uint32_t                    m_node;
+        Address                     m_address;
+        uint32_t                    m_overhead;
+        DataCenterApp::SendParams   m_params;
+        uint32_t                    m_iterationCount;
+        uint32_t                    m_totalPacketsSent;
+        uint32_t                    m_responseCount;
+    };
+
+    struct Flow
+    {
+        uint32_t    m_sender;
+        uint32_t    m_receiver;     // index into the sender's m_nodes
+        bool        m_response;
+        uint32_t    m_src;
+        uint32_t    m_dst;
+        uint32_t    m_path;         // offset of the hop count in m_pathLinks
+        uint32_t    m_payload;
+        double      m_size;
+        double      m_remaining;
+        double      m_rate;
+        double      m_lastUpdate;
+        double      m_start;
+        double      m_tail;         // delivery time after the bytes drained
+        uint32_t    m_version;
+        uint32_t    m_activeIndex;
+        bool        m_frozen;
+    };
+
+    struct FlowRecord
+    {
+        uint32_t    m_src;
+        uint32_t    m_dst;
+        uint32_t    m_bytes;
+        bool        m_response;
+        double      m_start;
+        double      m_fct;
+    };
+
+    void BuildGraph (void);
+    uint32_t GetNodeForAddress (const Address& address) const;
+    uint32_t GetPath (uint32_t src, uint32_t dst, const Address& dstAddress);
+    uint32_t FindDimensionOrderedPath (uint32_t src, const Address& dstAddress);
+    uint32_t FindShortestPath (uint32_t src, uint32_t dst);
+
+    void Schedule (double time, EVENT type, uint32_t a, uint32_t b);
+    void StartFlow (uint32_t sender, uint32_t receiver, bool response);
+    void FinishFlow (uint32_t flow, uint32_t version);
+    void DeliverFlow (uint32_t flow);
+    void RequestUpdate (void);
+    void UpdateRates (void);
+    void ScheduleFinish (Flow& flow);
+
+    // DataCenterApp sending logic
+    void KickOffSending (uint32_t sender);
+    void BulkSendPackets (uint32_t sender);
+    void SendPacket (uint32_t sender, uint32_t receiver);
+    void BulkScheduleSend (uint32_t sender);
+    void ScheduleSend (uint32_t sender, uint32_t receiver);
+    uint32_t SelectRandomReceiver (const Sender& sender);
+    double SelectRandomInterval (const Sender& sender);
+
+    PointToPointTopoHelper*                         m_topology;
+    DataCenterApp::NETWORK_STACK                    m_stack;
+    double                                          m_updateInterval;   // ns
+    bool                                            m_recordFlows;
+
+    std::vector<Link>                               m_links;
+    std::vector<std::vector<Neighbour> >            m_neighbours;
+    std::vector<std::vector<uint32_t> >             m_deviceLinks;      // [node][ifIndex]
+    std::vector<Ptr<DimensionOrderedL3Protocol> >   m_dimOrdered;
+    std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash> m_ipv4Nodes;
+    std::unordered_map<DimensionOrderedAddress, uint32_t, DimensionOrderedAddressHash> m_doNodes;
+    std::unordered_map<uint64_t, uint32_t>          m_pathCache;
+    // Hop count followed by the links of every cached path
+    std::vector<uint32_t>                           m_pathLinks;
+    // Marks of the shortest path search, reused between searches
+    std::vector<uint32_t>                           m_searchMark;
+    std::vector<uint32_t>                           m_searchVia;
+    uint32_t                                        m_searchGeneration;
+    uint64_t                                        m_shareVersion;
+
+    std::vector<Sender>                             m_senders;
+    std::vector<Flow>                               m_flows;
+    std::vector<uint32_t>                           m_freeFlows;
+    std::vector<uint32_t>                           m_active;
+    std::vector<FlowRecord>                         m_records;
+
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event> > m_events;
+    uint64_t                                        m_seq;
+    double                                          m_now;
+    double                                          m_lastRateUpdate;
+    bool                                            m_updatePending;
+    std::minstd_rand                                m_random;
+
+    LatencyHistogram                                m_latencyHistogram;
+    uint64_t                                        m_rxBytes;
+    double                                          m_firstTxTime;
+    double                                          m_lastRxTime;
+    uint64_t                                        m_nRateUpdates;
+};
+
+#endif
@@ -0,0 +1,174 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "latency-histogram.h"
+
+// C/C++ Includes
+#include <math.h>
+
+#ifdef NS3_MPI
+#include <mpi.h>
+#endif
+
+LatencyHistogram::LatencyHistogram ()
+  : m_buckets (NUM_BUCKETS, 0),
+    m_count (0),
+    m_min (0),
+    m_max (0),
+    m_sum (0.0)
+{
+}
+
+LatencyHistogram::~LatencyHistogram ()
+{
+}
+
+uint32_t
+LatencyHistogram::BucketIndex (uint64_t value)
+{
+    if (value < SUB_BUCKETS)
+        return value;
+
+    uint32_t exponent = 63 - __builtin_clzll (value);
+    if (exponent > MAX_EXPONENT)
+        return NUM_BUCKETS - 1;
+    uint32_t subBucket = (value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + subBucket;
+}
+
+uint64_t
+LatencyHistogram::BucketLowerBound (uint32_t index)
+{
+    uint32_t group = index / SUB_BUCKETS;
+    uint64_t subBucket = index % SUB_BUCKETS;
+    if (group == 0)
+        return subBucket;
+    return (SUB_BUCKETS + subBucket) << (group - 1);
+}
+
+uint64_t
+LatencyHistogram::BucketUpperBound (uint32_t index)
+{
+    uint32_t group = index / SUB_BUCKETS;
+    if (group == 0)
+        return index;
+    return BucketLowerBound (index) + (static_cast<uint64_t> (1) << (group - 1)) - 1;
+}
+
+void
+LatencyHistogram::Add (uint64_t value)
+{
+    m_buckets[BucketIndex (value)]++;
+    if (m_count == 0 || value < m_min)
+        m_min = value;
+    if (value > m_max)
+        m_max = value;
+    m_count++;
+    m_sum += value;
+}
+
+void
+LatencyHistogram::Merge (const LatencyHistogram& other)
+{
+    if (other.m_count == 0)
+        return;
+
+    for (uint32_t i = 0; i < NUM_BUCKETS; i++)
+        m_buckets[i] += other.m_buckets[i];
+    if (m_count == 0 || other.m_min < m_min)
+        m_min = other.m_min;
+    if (other.m_max > m_max)
+        m_max = other.m_max;
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+}
+
+void
+LatencyHistogram::AllReduce (void)
+{
+#ifdef NS3_MPI
+    // An empty histogram has no minimum
+    uint64_t min = m_count > 0 ? m_min : UINT64_MAX;
+    MPI_Allreduce (MPI_IN_PLACE, &m_buckets[0], NUM_BUCKETS, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce (MPI_IN_PLACE, &m_count, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce (MPI_IN_PLACE, &min, 1, MPI_UINT64_T, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce (MPI_IN_PLACE, &m_max, 1, MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Allreduce (MPI_IN_PLACE, &m_sum, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    m_min = m_count > 0 ? min : 0;
+#endif
+}
+
+void
+LatencyHistogram::Reset (void)
+{
+    m_buckets.assign (NUM_BUCKETS, 0);
+    m_count = 0;
+    m_min = 0;
+    m_max = 0;
+    m_sum = 0.0;
+}
+
+uint64_t
+LatencyHistogram::GetCount (void) const
+{
+    return m_count;
+}
+
+uint64_t
+LatencyHistogram::GetMin (void) const
+{
+    return m_min;
+}
+
+uint64_t
+LatencyHistogram::GetMax (void) const
+{
+    return m_max;
+}
+
+double
+LatencyHistogram::GetMean (void) const
+{
+    if (m_count == 0)
+        return 0.0;
+    return m_sum / m_count;
+}
+
+uint64_t
+LatencyHistogram::GetPercentile (double fraction) const
+{
+    if (m_count == 0)
+        return 0;
+
+    uint64_t rank = static_cast<uint64_t> (ceil (fraction * m_count));
+    if (rank == 0)
+        rank = 1;
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < NUM_BUCKETS; i++)
+    {
+        seen += m_buckets[i];
+        if (seen >= rank)
+        {
+            // Report the highest value the bucket can hold, within the observed range
+            uint64_t value = BucketUpperBound (i);
+            if (value > m_max)
+                value = m_max;
+            if (value < m_min)
+                value = m_min;
+            return value;
+        }
+    }
+    return m_max;
+}
+
+void
+LatencyHistogram::Print (std::ostream& os) const
+{
+    os << "count=" << m_count <<
+          " mean=" << GetMean () << "ns" <<
+          " p50=" << GetPercentile (0.5) << "ns" <<
+          " p90=" << GetPercentile (0.9) << "ns" <<
+          " p99=" << GetPercentile (0.99) << "ns" <<
+          " p99.9=" << GetPercentile (0.999) << "ns" <<
+          " max=" << m_max << "ns";
+}
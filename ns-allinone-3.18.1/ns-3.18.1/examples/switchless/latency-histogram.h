@@ -0,0 +1,62 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+// C/C++ Includes
+#include <stdint.h>
+#include <ostream>
+#include <vector>
+
+/*
+ * Fixed-memory, log-bucketed histogram of latencies in nanoseconds.
+ *
+ * Values below 2^SUB_BUCKET_BITS are counted exactly; larger values fall
+ * into one of 2^SUB_BUCKET_BITS linear sub-buckets per power of two, so a
+ * reported percentile is within 1/2^SUB_BUCKET_BITS of the true value.
+ * Values of 2^MAX_EXPONENT ns (~39 hours) and above share the last bucket.
+ * Count, sum, min and max are exact.
+ */
+class LatencyHistogram
+{
+public:
+    static const uint32_t SUB_BUCKET_BITS = 4;
+    static const uint32_t MAX_EXPONENT = 47;
+
+    // Constructor/Destructor
+    LatencyHistogram ();
+    ~LatencyHistogram ();
+
+    // Record one latency value
+    void Add (uint64_t value);
+    // Add all samples of another histogram to this one
+    void Merge (const LatencyHistogram& other);
+    // Merge the histograms of all MPI ranks into this one, on every rank
+    void AllReduce (void);
+    void Reset (void);
+
+    uint64_t GetCount (void) const;
+    uint64_t GetMin (void) const;
+    uint64_t GetMax (void) const;
+    double GetMean (void) const;
+    // Value below which the given fraction (0-1) of samples fall
+    uint64_t GetPercentile (double fraction) const;
+
+    // Print count, mean, p50/p90/p99/p99.9 and max
+    void Print (std::ostream& os) const;
+private:
+    static const uint32_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const uint32_t NUM_BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+    static uint32_t BucketIndex (uint64_t value);
+    static uint64_t BucketLowerBound (uint32_t index);
+    static uint64_t BucketUpperBound (uint32_t index);
+
+    std::vector<uint64_t>   m_buckets;
+    uint64_t                m_count;
+    uint64_t                m_min;
+    uint64_t                m_max;
+    double                  m_sum;
+};
+
+#endif
@@ -10,18 +10,30 @@
 #include "ns3/internet-module.h"
 #include "ns3/point-to-point-module.h"
 #include "ns3/applications-module.h"
+#include "ns3/mpi-interface.h"
 
 // Switchless Includes
 #include "data-center-app.h"
+#include "flow-level-sim.h"
 #include "p2p-topology-interface.h"
 // #include "p2p-2d-mesh.h"
 #include "p2p-fattree.h"
 #include "p2p-cube.h"
 #include "p2p-hierarchical.h"
 #include "p2p-cube-dimordered.h"
+#include "p2p-kary-ncube-dimordered.h"
+#include "port-load-counters.h"
 
+#include <algorithm>
+#include <fstream>
+#include <sstream>
 #include <unordered_set>
 #include <utility> // std::pair, std::make_pair
+#include <vector>
+
+#ifdef NS3_MPI
+#include <mpi.h>
+#endif
 
 using namespace ns3;
 
@@ -35,17 +47,53 @@ NS_LOG_COMPONENT_DEFINE ("MainProgram");
 #define RANDOM 1
 #define FIXED 2
 #define CUBE_DIMORDERED 5
+#define KARY_NCUBE_DIMORDERED 6
 #define NO_TOPO 8
 
 #define L4_TCP 1
 #define L4_UDP 2
+#define L4_HOMA 3
+
+// Open-loop inter-arrival times with mean 1: exponential (Poisson arrivals),
+// Pareto with the given shape, or resampled from a trace of intervals
+static Ptr<RandomVariableStream>
+CreateInterArrival (std::string sDistribution, double dParetoShape, const std::vector<double>& trace)
+{
+    if (sDistribution == "exp")
+    {
+        Ptr<ExponentialRandomVariable> interArrival = CreateObject<ExponentialRandomVariable> ();
+        interArrival->SetAttribute ("Mean", DoubleValue (1.0));
+        return interArrival;
+    }
+    if (sDistribution == "pareto")
+    {
+        Ptr<ParetoRandomVariable> interArrival = CreateObject<ParetoRandomVariable> ();
+        interArrival->SetAttribute ("Mean", DoubleValue (1.0));
+        interArrival->SetAttribute ("Shape", DoubleValue (dParetoShape));
+        return interArrival;
+    }
+    // The trace is sorted and scaled to mean 1
+    Ptr<EmpiricalRandomVariable> interArrival = CreateObject<EmpiricalRandomVariable> ();
+    for (uint32_t i = 0; i < trace.size (); i++)
+        interArrival->CDF (trace[i], trace.size () > 1 ? i / (trace.size () - 1.0) : 1.0);
+    return interArrival;
+}
 
 
+#ifdef NS3_MPI
+// The sum, or with MPI_MIN or MPI_MAX the extreme, of a value over all MPI ranks
+static uint64_t
+AllReduce (uint64_t value, MPI_Op op)
+{
+    MPI_Allreduce (MPI_IN_PLACE, &value, 1, MPI_UINT64_T, op, MPI_COMM_WORLD);
+    return value;
+}
+#endif
+
 int
 main (int argc, char * argv[])
 {
 
-    LogComponentEnable ("DataCenterApp", LOG_DEBUG);
     // LogComponentEnable ("DataCenterApp", LOG_LEVEL_ALL);
     // LogComponentEnable ("DimensionOrderedL3Protocol", LOG_LEVEL_ALL);
     // LogComponentEnable ("DimensionOrderedL3Protocol", LOG_LEVEL_ALL);
@@ -75,6 +123,10 @@ main (int argc, char * argv[])
     unsigned nZdim;
     nXdim = nYdim = nZdim = 0;
 
+    // parameters for the k-ary n-cube, e.g. 4x4x4x4
+    std::string sDims = "";
+    std::vector<unsigned> dims;
+
     int topologytype = 0;
     int topo_sub1 = 0;
     int topo_sub2 = 0;
@@ -97,8 +149,81 @@ main (int argc, char * argv[])
     int rChoice=0;
     CommandLine cmd;
     int debuglog = 0;
-    cmd.AddValue("debug", "Debug", debuglog);
+    std::string sTraceFile = "";
+    bool bMpi = false;
+    int nThreads = 1;
+    bool bCutThrough = false;
+    bool bFlowLevel = false;
+    bool bValidate = false;
+    int nFlowUpdateInterval = 1000;
+    std::string sFlowStatsFile = "";
+    std::string sLinkStatsFile = "";
+    bool bGlobalRouting = false;
+    bool bFastPath = true;
+    std::string sEcmp = "none";
+    std::string sEcmpHash = "murmur3";
+    std::string sPortStatsFile = "";
+    int nCredits = 0;
+    int nVcs = 1;
+    std::string sOpenLoop = "";
+    double dParetoShape = 1.5;
+    std::string sInterArrivalTrace = "";
+    double dLoad = 1.0;
+    int nLoadSteps = 0;
+    int nStepTime = 50;
+    int nQueueSize = 20000;
+    bool bSack = false;
+    int nMinRto = 0;
+    int nEcnThreshold = 0;
+    std::string sTcpVariant = "NewReno";
+    int nMss = 0;
+    int nOffload = 0;
+    cmd.AddValue("debug", "Text log: 0 off, 1 RX/TX blocks, 2 one line per packet", debuglog);
+    cmd.AddValue("trace", "Write a binary per-packet trace to this file", sTraceFile);
+    cmd.AddValue("mpi", "Split the cube-dimordered topology over the MPI ranks", bMpi);
+    cmd.AddValue("threads", "Split the cube-dimordered topology over this many threads", nThreads);
+    cmd.AddValue("cutthrough", "Virtual cut-through forwarding on the cube-dimordered links", bCutThrough);
+    cmd.AddValue("flowlevel", "Run the flow-level (fluid) engine instead of the packet-level simulation", bFlowLevel);
+    cmd.AddValue("validate", "Run both the flow-level engine and the packet-level simulation and compare them",
+                 bValidate);
+    cmd.AddValue("flowupdate", "Flow-level rate update interval in ns, 0 for every arrival and departure",
+                 nFlowUpdateInterval);
+    cmd.AddValue("flowstats", "Write the flow-level completion time of every flow to this file", sFlowStatsFile);
+    cmd.AddValue("linkstats", "Write the flow-level utilisation of every link to this file", sLinkStatsFile);
+    cmd.AddValue("globalrouting", "Populate the IP routes with global routing even for the tree topologies",
+                 bGlobalRouting);
+    cmd.AddValue("ecmp", "Spread IP packets over all equal cost routes: none, packet (random) or flow (hash)", sEcmp);
+    cmd.AddValue("ecmphash", "Hash function of --ecmp=flow: murmur3 or fnv1a", sEcmpHash);
+    cmd.AddValue("portstats", "Write the packets and bytes sent by every port to this file", sPortStatsFile);
+    cmd.AddValue("credits", "Credit-based flow control on the dimension-ordered links with receive buffers of "
+                 "this many packets: senders wait instead of queues dropping. 0 for none", nCredits);
+    cmd.AddValue("vcs", "Virtual channels per dimension-ordered link, each with its own queue and credits. With 2 "
+                 "or more, packets change channel at the torus wraparound links so that flow control cannot "
+                 "deadlock", nVcs);
+    cmd.AddValue("openloop", "Send open loop, without waiting for responses, with exp (Poisson), pareto or trace "
+                 "inter-arrival times", sOpenLoop);
+    cmd.AddValue("paretoshape", "Shape of the --openloop=pareto inter-arrival times, above 1", dParetoShape);
+    cmd.AddValue("iatrace", "File of --openloop=trace inter-arrival times, one per line in any unit", sInterArrivalTrace);
+    cmd.AddValue("load", "Open-loop payload injection rate per sender, as a fraction of the link rate", dLoad);
+    cmd.AddValue("loadsweep", "Step the open-loop load through this many steps up to --load, e.g. 10 for 10% to "
+                 "100%, and report the accepted throughput and latency of each step", nLoadSteps);
+    cmd.AddValue("steptime", "Duration of each --loadsweep step in us", nStepTime);
+    cmd.AddValue("queuesize", "Packets each DropTail output queue holds before it drops", nQueueSize);
+    cmd.AddValue("sack", "Selective acknowledgements and SACK loss recovery for the dimension-ordered TCP", bSack);
+    cmd.AddValue("ecn", "Mark ECN-capable packets at dimension-ordered output queues of this many packets, and "
+                 "negotiate ECN on the dimension-ordered TCP connections, 0 for none", nEcnThreshold);
+    cmd.AddValue("tcp", "Congestion control of the dimension-ordered TCP: NewReno, Dctcp, Westwood, Reno, Tahoe "
+                 "or Rfc793", sTcpVariant);
+    cmd.AddValue("mss", "Send TCP messages as a byte stream in segments of this many bytes, 0 for one segment "
+                 "per message", nMss);
+    cmd.AddValue("offload", "Experimental segmentation offload for the dimension-ordered TCP: hand segments of up "
+                 "to this many bytes down the stack, which go on the wire as --mss segments. 0 for none", nOffload);
+    cmd.AddValue("minrto", "Minimum TCP retransmission timeout in us, also the SYN timeout and the RTT estimate "
+                 "before the first sample. 0 for the 200 ms default", nMinRto);
+    cmd.AddValue("fastpath", "Forward dimension-ordered transit packets without touching their header",
+                 bFastPath);
     cmd.AddValue("tp", "Topology",topologytype); // 1 or 2 or 3
+    cmd.AddValue("dims", "Nodes per dimension of the k-ary n-cube topology, e.g. 4x4x4x4", sDims);
     cmd.AddValue("t1", "",topo_sub1); // leaf-fan-out or row or m
     cmd.AddValue("t2", "",topo_sub2);  //non-leaf-fan-out or column or n
     cmd.AddValue("t3", "",topo_sub3); // leaf-fan-out or row or m
@@ -121,7 +246,65 @@ main (int argc, char * argv[])
     if(debuglog==1)
     {
         LogComponentEnable ("DataCenterApp", LOG_INFO);
-        LogComponentDisable("DataCenterApp", LOG_DEBUG);
+    }
+    else if(debuglog==2)
+    {
+        LogComponentEnable ("DataCenterApp", LOG_DEBUG);
+    }
+
+    // With --mpi every rank builds the whole topology but only runs the
+    // applications of the nodes in its own slab
+    uint32_t systemId = 0;
+    uint32_t systemCount = 1;
+    bool bDimOrdered = topologytype == CUBE_DIMORDERED || topologytype == KARY_NCUBE_DIMORDERED;
+    if (bMpi && nThreads > 1)
+    {
+        std::cout << "--mpi and --threads cannot be combined\n";
+        return 1;
+    }
+    if (nThreads < 1)
+    {
+        std::cout << "--threads needs at least one thread\n";
+        return 1;
+    }
+    if (bMpi)
+    {
+        if (!bDimOrdered)
+        {
+            std::cout << "MPI is only supported for the dimension-ordered topologies\n";
+            return 1;
+        }
+        GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::DistributedSimulatorImpl"));
+        MpiInterface::Enable (&argc, &argv);
+        systemId = MpiInterface::GetSystemId ();
+        systemCount = MpiInterface::GetSize ();
+        if (!sTraceFile.empty())
+            sTraceFile += "." + std::to_string(systemId);
+    }
+    // With --threads all partitions run in this process, one per thread
+    else if (nThreads > 1)
+    {
+        if (!bDimOrdered)
+        {
+            std::cout << "Threads are only supported for the dimension-ordered topologies\n";
+            return 1;
+        }
+        GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+        systemCount = nThreads;
+    }
+
+    // One trace file per partition of this process, as the writers are not shared between threads
+    std::vector<DCAppTraceWriter *> traceWriters;
+    for (int i = 0; !sTraceFile.empty() && i < nThreads; i++)
+    {
+        std::string sPartitionFile = (nThreads > 1) ? sTraceFile + "." + std::to_string(i) : sTraceFile;
+        DCAppTraceWriter *traceWriter = new DCAppTraceWriter;
+        traceWriters.push_back(traceWriter);
+        if (!traceWriter->Open(sPartitionFile))
+        {
+            std::cout << "Could not open trace file " << sPartitionFile << std::endl;
+            return 1;
+        }
     }
     if(sChoice != 0)
     {  
@@ -165,6 +348,23 @@ main (int argc, char * argv[])
         nYdim= topo_sub2;
         nZdim= topo_sub3;
     }
+    else if (topologytype == KARY_NCUBE_DIMORDERED)
+    {
+        std::istringstream dimStream(sDims);
+        std::string sDim;
+        while (std::getline(dimStream, sDim, 'x'))
+            dims.push_back(atoi(sDim.c_str()));
+        if (dims.empty())
+        {
+            std::cout << "The k-ary n-cube topology needs --dims\n";
+            return 1;
+        }
+        if (nNeighbor != 0)
+        {
+            std::cout << "Neighbor workloads are not supported for the k-ary n-cube topology\n";
+            return 1;
+        }
+    }
     else if (topologytype == FATTREE)
     {
     }
@@ -173,18 +373,153 @@ main (int argc, char * argv[])
         NS_ASSERT(false);
     }
 
+    if ((bFlowLevel || bValidate) && (bMpi || nThreads > 1))
+    {
+        std::cout << "The flow-level engine runs in a single thread\n";
+        return 1;
+    }
+    if (l4_type == L4_HOMA && !bDimOrdered)
+    {
+        std::cout << "Homa is only supported for the dimension-ordered topologies\n";
+        return 1;
+    }
+    if (bCutThrough && (!bDimOrdered || bMpi || nThreads > 1))
+    {
+        std::cout << "Cut-through is only supported for the dimension-ordered topologies in a single thread\n";
+        return 1;
+    }
+    if (!sPortStatsFile.empty() && bMpi)
+    {
+        std::cout << "Port statistics are only collected in a single process\n";
+        return 1;
+    }
+    if (nCredits > 0 && (!bDimOrdered || bMpi || nThreads > 1))
+    {
+        std::cout << "Flow control is only supported for the dimension-ordered topologies in a single thread\n";
+        return 1;
+    }
+    if (nVcs < 1 || nVcs > 255 || (nVcs > 1 && !bDimOrdered))
+    {
+        std::cout << "Virtual channels are only supported for the dimension-ordered topologies, 1 to 255\n";
+        return 1;
+    }
+    if (nCredits > 0 && bTorus && nVcs < 2)
+        std::cout << "Warning: without virtual channels the torus rings can deadlock under flow control\n";
+    if (sEcmp != "none" && sEcmp != "packet" && sEcmp != "flow")
+    {
+        std::cout << "Invalid --ecmp " << sEcmp << "\n";
+        return 1;
+    }
+    if (sEcmpHash != "murmur3" && sEcmpHash != "fnv1a")
+    {
+        std::cout << "Invalid --ecmphash " << sEcmpHash << "\n";
+        return 1;
+    }
+    bool bEcmp = sEcmp != "none";
+    std::vector<double> interArrivalTrace;
+    if (!sOpenLoop.empty())
+    {
+        if (sOpenLoop != "exp" && sOpenLoop != "pareto" && sOpenLoop != "trace")
+        {
+            std::cout << "Invalid --openloop " << sOpenLoop << "\n";
+            return 1;
+        }
+        if (bFlowLevel || bValidate)
+        {
+            std::cout << "Open-loop sending is not supported by the flow-level engine\n";
+            return 1;
+        }
+        if (sOpenLoop == "pareto" && dParetoShape <= 1.0)
+        {
+            std::cout << "The Pareto shape must be above 1 for the mean to exist\n";
+            return 1;
+        }
+        if (dLoad <= 0.0)
+        {
+            std::cout << "The open-loop load must be positive\n";
+            return 1;
+        }
+        if (sOpenLoop == "trace")
+        {
+            std::ifstream traceStream(sInterArrivalTrace.c_str());
+            double interval;
+            while (traceStream >> interval)
+                if (interval >= 0.0)
+                    interArrivalTrace.push_back(interval);
+            double sum = 0.0;
+            for (unsigned i = 0; i < interArrivalTrace.size(); i++)
+                sum += interArrivalTrace[i];
+            if (sum <= 0.0)
+            {
+                std::cout << "Could not read inter-arrival times from " << sInterArrivalTrace << "\n";
+                return 1;
+            }
+            std::sort(interArrivalTrace.begin(), interArrivalTrace.end());
+            for (unsigned i = 0; i < interArrivalTrace.size(); i++)
+                interArrivalTrace[i] *= interArrivalTrace.size() / sum;
+        }
+    }
+    if (nLoadSteps < 0 || (nLoadSteps > 0 && (sOpenLoop.empty() || nStepTime <= 0)))
+    {
+        std::cout << "A load sweep needs --openloop and a positive --steptime\n";
+        return 1;
+    }
+    // Steps run back to back from time 0, so a saturated step leaves its
+    // backlog to the next one
+    if (nLoadSteps > 0)
+    {
+        std::vector<double> loads;
+        for (int i = 1; i <= nLoadSteps; i++)
+            loads.push_back(dLoad * i / nLoadSteps);
+        DataCenterApp::SetLoadSteps(loads, MicroSeconds(nStepTime));
+    }
     NS_ASSERT(l4_type != 0);
 
 
     Config::SetDefault ("ns3::DropTailQueue::Mode", StringValue ("QUEUE_MODE_PACKETS"));
-    Config::SetDefault ("ns3::DropTailQueue::MaxPackets", UintegerValue (20000));
+    Config::SetDefault ("ns3::DropTailQueue::MaxPackets", UintegerValue (nQueueSize));
+    Config::SetDefault ("ns3::DoTcpSocketBase::Sack", BooleanValue (bSack));
+    Config::SetDefault ("ns3::DoTcpSocketBase::Ecn", BooleanValue (nEcnThreshold > 0));
+    Config::SetDefault ("ns3::DimensionOrderedL3Protocol::EcnMarkingThreshold", UintegerValue (nEcnThreshold));
+    TypeId tcpVariant;
+    if (!TypeId::LookupByNameFailSafe ("ns3::DoTcp" + sTcpVariant, &tcpVariant))
+    {
+        std::cout << "Unknown TCP variant " << sTcpVariant << "\n";
+        return 1;
+    }
+    Config::SetDefault ("ns3::DoTcpL4Protocol::SocketType", TypeIdValue (tcpVariant));
+    if (nOffload > 0 && nMss == 0)
+    {
+        std::cout << "--offload needs --mss\n";
+        return 1;
+    }
+    Config::SetDefault ("ns3::DoTcpSocketBase::SegmentationOffload", UintegerValue (nOffload));
+    if (nMinRto > 0)
+    {
+        Config::SetDefault ("ns3::RttEstimator::MinRTO", TimeValue (MicroSeconds (nMinRto)));
+        Config::SetDefault ("ns3::RttEstimator::InitialEstimation", TimeValue (MicroSeconds (nMinRto)));
+        Config::SetDefault ("ns3::DoTcpSocket::ConnTimeout", TimeValue (MicroSeconds (nMinRto)));
+    }
+    Config::SetDefault ("ns3::DimensionOrderedL3Protocol::EnableTransitFastPath", BooleanValue (bFastPath));
+    Config::SetDefault ("ns3::Ipv4GlobalRouting::RandomEcmpRouting", BooleanValue (sEcmp == "packet"));
+    Config::SetDefault ("ns3::Ipv4GlobalRouting::FlowEcmpRouting", BooleanValue (sEcmp == "flow"));
+    Config::SetDefault ("ns3::Ipv4GlobalRouting::EcmpHashFunction",
+                        EnumValue (sEcmpHash == "fnv1a" ? Ipv4GlobalRouting::ECMP_HASH_FNV1A
+                                                        : Ipv4GlobalRouting::ECMP_HASH_MURMUR3));
     // common variables
     PointToPointHelper pointToPoint;
 
 
-    pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("100Gbps")); // 100Gbps is 10Gbps for some reason
+    DataRate linkRate ("100Gbps");
+    pointToPoint.SetDeviceAttribute ("DataRate", DataRateValue (linkRate)); // 100Gbps is 10Gbps for some reason
     // pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
     pointToPoint.SetChannelAttribute ("Delay", StringValue ("500ns")); // .5us
+    // Lossless links: the per-port buffers are bounded and a sender without
+    // credits holds its packets instead of the next hop dropping them
+    if (nCredits > 0)
+        pointToPoint.SetDeviceAttribute ("FlowControlBuffer", UintegerValue (nCredits));
+    if (nVcs > 1)
+        pointToPoint.SetDeviceAttribute ("VirtualChannels", UintegerValue (nVcs));
 
     std::cout << "Making topology\n";
     PointToPointTopoHelper * topology;
@@ -213,13 +548,40 @@ main (int argc, char * argv[])
                 network_stack_type = DataCenterApp::TCP_IP_STACK;
         }
         else{
-            topology = new PointToPointCubeDimorderedHelper(nXdim, nYdim, nZdim, bTorus, pointToPoint);
+            // Routers can start forwarding once the PPP and routing headers are in
+            if (bCutThrough)
+                pointToPoint.SetChannelAttribute ("CutThroughHeaderSize",
+                                                  UintegerValue (2 + DimensionOrderedHeader ().GetSerializedSize ()));
+            topology = new PointToPointCubeDimorderedHelper(nXdim, nYdim, nZdim, bTorus, pointToPoint, systemCount);
             if (l4_type == L4_UDP)
                 network_stack_type = DataCenterApp::UDP_DO_STACK;
+            else if (l4_type == L4_HOMA)
+                network_stack_type = DataCenterApp::HOMA_DO_STACK;
             else
                 network_stack_type = DataCenterApp::TCP_DO_STACK;
         }
     }
+    else if (topologytype == KARY_NCUBE_DIMORDERED){
+        unsigned nCubeNodes = 1;
+        for (unsigned i = 0; i < dims.size(); i++)
+            nCubeNodes *= dims[i];
+        NS_ASSERT(nNodes <= nCubeNodes);
+        if (bCutThrough)
+        {
+            std::vector<uint16_t> coordinates(dims.size(), 1);
+            DimensionOrderedHeader header;
+            header.SetSource(DimensionOrderedAddress(coordinates));
+            header.SetDestination(DimensionOrderedAddress(coordinates));
+            pointToPoint.SetChannelAttribute ("CutThroughHeaderSize", UintegerValue (2 + header.GetSerializedSize ()));
+        }
+        topology = new PointToPointKaryNCubeDimorderedHelper(dims, bTorus, pointToPoint, systemCount);
+        if (l4_type == L4_UDP)
+            network_stack_type = DataCenterApp::UDP_DO_STACK;
+        else if (l4_type == L4_HOMA)
+            network_stack_type = DataCenterApp::HOMA_DO_STACK;
+        else
+            network_stack_type = DataCenterApp::TCP_DO_STACK;
+    }
     else if (topologytype == HIERARCHICAL){
         topology = new PointToPointHierarchicalHelper(nNodes, nEdge, nAgg, nRepl1, nRepl2, pointToPoint);
         if (l4_type == L4_UDP)
@@ -243,6 +605,14 @@ main (int argc, char * argv[])
     //std::cout << "Point 1\n";
     topology->AssignIpv4Addresses(nodeAddresses, linkAddresses); 
     std::cout << "Finished assigning IP addresses\n";
+    FlowLevelSimulator *flowSim = NULL;
+    if (bFlowLevel || bValidate)
+    {
+        flowSim = new FlowLevelSimulator(topology, network_stack_type);
+        flowSim->SetRateUpdateInterval(NanoSeconds(nFlowUpdateInterval));
+        if (!sFlowStatsFile.empty())
+            flowSim->EnableFlowRecords();
+    }
     //std::cout << "Point 2\n";
     // Random Seed 
     srand(100);
@@ -458,16 +828,32 @@ main (int argc, char * argv[])
             params.m_maxSendInterval = MicroSeconds(nMaxinterval);
             params.m_minSendInterval = MicroSeconds(nMininterval);
         }
+        if (!sOpenLoop.empty())
+        {
+            params.m_sendPattern = DataCenterApp::OPEN_LOOP;
+            // The load steps already include --load
+            params.m_injectionRate = DataRate(linkRate.GetBitRate() * (nLoadSteps > 0 ? 1.0 : dLoad));
+            params.m_interArrival = CreateInterArrival(sOpenLoop, dParetoShape, interArrivalTrace);
+        }
         params.m_packetSize = nPacketSize;
         params.m_nIterations = nIterations; 
         // std::cout << "Number of receivers: " <<  params.m_nReceivers<< std::endl;
         // std::cout << "Number of nodes in set: " <<  params.m_nodes.size() << std::endl;
         Ptr<DataCenterApp> app = CreateObject<DataCenterApp>();
         bool ret = app->Setup(params, *it, network_stack_type, DEBUG);
-        if (!ret){
+        if (!ret || (flowSim && !flowSim->AddApplication(params, *it))){
             std::cout << "Setup senders failed" << std::endl;
             exit(1);
         }
+        // Apps are still set up to keep rand() as in the packet-level run
+        if (bFlowLevel)
+            continue;
+        // Apps of remote nodes are still set up to keep rand() in step across ranks
+        if (bMpi && topology->GetNode(*it)->GetSystemId() != systemId)
+            continue;
+        if (!traceWriters.empty())
+            app->SetTrace(traceWriters[bMpi ? 0 : topology->GetNode(*it)->GetSystemId()]);
+        app->SetSegmentSize(nMss);
         topology->GetNode(*it)->AddApplication(app);
 
         app->SetStartTime (Seconds(0.));
@@ -476,29 +862,209 @@ main (int argc, char * argv[])
     for (std::unordered_set<int>::iterator it = nonsenderSet.begin(); it != nonsenderSet.end(); it++){
         DataCenterApp::SendParams params;
         params.m_sending = false;
+        // To cut the messages out of TCP streams
+        params.m_packetSize = nPacketSize;
         Ptr<DataCenterApp> app = CreateObject<DataCenterApp>();
         bool ret = app->Setup(params, *it, network_stack_type, DEBUG); 
         if (!ret){
             std::cout << "Setup receivers failed" << std::endl;
             exit(1);
         }
+        if (bFlowLevel)
+            continue;
+        // Apps of remote nodes are still set up to keep rand() in step across ranks
+        if (bMpi && topology->GetNode(*it)->GetSystemId() != systemId)
+            continue;
+        if (!traceWriters.empty())
+            app->SetTrace(traceWriters[bMpi ? 0 : topology->GetNode(*it)->GetSystemId()]);
+        app->SetSegmentSize(nMss);
         topology->GetNode(*it)->AddApplication(app);
         app->SetStartTime (Seconds(0.));
         app->SetStopTime (Seconds(100000.));
     }
 
 
+    if (flowSim)
+    {
+        std::cout << "Running flow-level simulation\n";
+        SystemWallClockMs flowWallClock;
+        flowWallClock.Start ();
+        flowSim->Run ();
+        int64_t flowWallMs = flowWallClock.End ();
+        std::cout << "Flow-level wall time: " << flowWallMs << " ms\n";
+        flowSim->PrintStatistics (std::cout);
+        if (!sFlowStatsFile.empty() && !flowSim->WriteFlows(sFlowStatsFile))
+            std::cout << "Could not write " << sFlowStatsFile << std::endl;
+        if (!sLinkStatsFile.empty() && !flowSim->WriteLinks(sLinkStatsFile))
+            std::cout << "Could not write " << sLinkStatsFile << std::endl;
+        if (bFlowLevel)
+        {
+            Simulator::Destroy ();
+            delete flowSim;
+            return 0;
+        }
+    }
+
     //Config::SetDefault ("ns3::ArpCache::PendingQueueSize", UintegerValue (MAX_BURST_SIZE/L2MTU*3));
     if (network_stack_type == DataCenterApp::UDP_IP_STACK || network_stack_type == DataCenterApp::TCP_IP_STACK){
-        std::cout << "Populating routing table\n";
-        Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+        SystemWallClockMs routingClock;
+        routingClock.Start ();
+        if (bGlobalRouting || !topology->PopulateRoutingTables(bEcmp))
+        {
+            std::cout << "Populating routing table\n";
+            Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+        }
+        std::cout << "Routing wall time: " << routingClock.End () << " ms\n";
     }
 
+    PortLoadCounters portLoad;
+    if (!sPortStatsFile.empty())
+        portLoad.Install ();
+
     std::cout << "Running simulation\n";
+    SystemWallClockMs wallClock;
+    wallClock.Start ();
     Simulator::Run ();
+    int64_t wallMs = wallClock.End ();
+    uint64_t nEvents = Simulator::GetEventCount ();
+    DimensionOrderedL3Protocol::Statistics doStatistics = DimensionOrderedL3Protocol::Statistics ();
+    for (NodeList::Iterator it = NodeList::Begin (); bDimOrdered && it != NodeList::End (); it++)
+    {
+        Ptr<DimensionOrderedL3Protocol> l3 = (*it)->GetObject<DimensionOrderedL3Protocol> ();
+        if (!l3)
+            continue;
+        const DimensionOrderedL3Protocol::Statistics& statistics = l3->GetStatistics ();
+        doStatistics.forwarded += statistics.forwarded;
+        doStatistics.fastForwarded += statistics.fastForwarded;
+        doStatistics.packetCopies += statistics.packetCopies;
+        doStatistics.headersAdded += statistics.headersAdded;
+        doStatistics.headersRemoved += statistics.headersRemoved;
+        doStatistics.headersPeeked += statistics.headersPeeked;
+        doStatistics.queueSamples += statistics.queueSamples;
+        doStatistics.queuedSum += statistics.queuedSum;
+        doStatistics.peakQueued = std::max (doStatistics.peakQueued, statistics.peakQueued);
+        doStatistics.ecnMarked += statistics.ecnMarked;
+    }
+    DoHomaL4Protocol::Statistics homaStatistics = DoHomaL4Protocol::Statistics ();
+    for (NodeList::Iterator it = NodeList::Begin (); l4_type == L4_HOMA && it != NodeList::End (); it++)
+    {
+        Ptr<DoHomaL4Protocol> homa = (*it)->GetObject<DoHomaL4Protocol> ();
+        if (!homa)
+            continue;
+        const DoHomaL4Protocol::Statistics& statistics = homa->GetStatistics ();
+        homaStatistics.messagesSent += statistics.messagesSent;
+        homaStatistics.messagesDelivered += statistics.messagesDelivered;
+        homaStatistics.grants += statistics.grants;
+        homaStatistics.resends += statistics.resends;
+        homaStatistics.bytesRetransmitted += statistics.bytesRetransmitted;
+        homaStatistics.abandoned += statistics.abandoned;
+    }
+    PointToPointNetDevice::FlowControlStatistics fcStatistics = PointToPointNetDevice::FlowControlStatistics ();
+    uint64_t nLeftQueued = 0;
+    for (NodeList::Iterator it = NodeList::Begin (); nCredits > 0 && it != NodeList::End (); it++)
+    {
+        for (uint32_t i = 0; i < (*it)->GetNDevices (); i++)
+        {
+            Ptr<PointToPointNetDevice> device = DynamicCast<PointToPointNetDevice> ((*it)->GetDevice (i));
+            if (!device)
+                continue;
+            const PointToPointNetDevice::FlowControlStatistics& statistics = device->GetFlowControlStatistics ();
+            fcStatistics.creditStalls += statistics.creditStalls;
+            fcStatistics.peakBuffered = std::max (fcStatistics.peakBuffered, statistics.peakBuffered);
+            fcStatistics.peakQueued = std::max (fcStatistics.peakQueued, statistics.peakQueued);
+            fcStatistics.peakHeld = std::max (fcStatistics.peakHeld, statistics.peakHeld);
+            nLeftQueued += device->GetNQueued ();
+        }
+    }
     Simulator::Destroy ();
+    for (uint32_t i = 0; i < traceWriters.size(); i++)
+        delete traceWriters[i];
+
+    // Every rank only counted its own nodes: combine the counts before
+    // printing them
+    uint64_t nMinEvents = nEvents;
+    uint64_t nMaxEvents = nEvents;
+#ifdef NS3_MPI
+    if (bMpi)
+    {
+        nMinEvents = AllReduce (nEvents, MPI_MIN);
+        nMaxEvents = AllReduce (nEvents, MPI_MAX);
+        nEvents = AllReduce (nEvents, MPI_SUM);
+        wallMs = AllReduce (wallMs, MPI_MAX);
+        doStatistics.forwarded = AllReduce (doStatistics.forwarded, MPI_SUM);
+        doStatistics.fastForwarded = AllReduce (doStatistics.fastForwarded, MPI_SUM);
+        doStatistics.packetCopies = AllReduce (doStatistics.packetCopies, MPI_SUM);
+        doStatistics.headersAdded = AllReduce (doStatistics.headersAdded, MPI_SUM);
+        doStatistics.headersRemoved = AllReduce (doStatistics.headersRemoved, MPI_SUM);
+        doStatistics.headersPeeked = AllReduce (doStatistics.headersPeeked, MPI_SUM);
+        doStatistics.queueSamples = AllReduce (doStatistics.queueSamples, MPI_SUM);
+        doStatistics.queuedSum = AllReduce (doStatistics.queuedSum, MPI_SUM);
+        doStatistics.peakQueued = AllReduce (doStatistics.peakQueued, MPI_MAX);
+        doStatistics.ecnMarked = AllReduce (doStatistics.ecnMarked, MPI_SUM);
+        homaStatistics.messagesSent = AllReduce (homaStatistics.messagesSent, MPI_SUM);
+        homaStatistics.messagesDelivered = AllReduce (homaStatistics.messagesDelivered, MPI_SUM);
+        homaStatistics.grants = AllReduce (homaStatistics.grants, MPI_SUM);
+        homaStatistics.resends = AllReduce (homaStatistics.resends, MPI_SUM);
+        homaStatistics.bytesRetransmitted = AllReduce (homaStatistics.bytesRetransmitted, MPI_SUM);
+        homaStatistics.abandoned = AllReduce (homaStatistics.abandoned, MPI_SUM);
+        DataCenterApp::AllReduceGlobalStatistics ();
+    }
+#endif
 
     std::cout << "Simulation finished\n";
+    // The other ranks hold the same totals
+    if (bMpi && systemId != 0)
+    {
+        MpiInterface::Disable ();
+        return 0;
+    }
+    if (bMpi)
+        std::cout << "Ranks: " << systemCount << " (events per rank: " << nMinEvents << " to " << nMaxEvents << ")\n";
+    else if (nThreads > 1)
+        std::cout << "Threads: " << nThreads << "\n";
+    std::cout << "Wall time: " << wallMs << " ms\n";
+    std::cout << "Events: " << nEvents << "\n";
+    DataCenterApp::PrintGlobalStatistics (std::cout);
+    if (nLoadSteps > 0)
+        DataCenterApp::PrintLoadSteps (std::cout, linkRate, senderSet.size());
+    if (bDimOrdered)
+        std::cout << "DO L3: forwarded=" << doStatistics.forwarded << " fastpath=" << doStatistics.fastForwarded <<
+                     " packet copies=" << doStatistics.packetCopies << " headers added=" << doStatistics.headersAdded <<
+                     " removed=" << doStatistics.headersRemoved << " peeked=" << doStatistics.headersPeeked << "\n";
+    // Queue lengths as the packets leaving a node found them, and the time
+    // from the first send to the last receive
+    if (bDimOrdered && doStatistics.queueSamples > 0)
+        std::cout << "DO queues: mean occupancy=" <<
+                     static_cast<double> (doStatistics.queuedSum) / doStatistics.queueSamples << " peak=" <<
+                     doStatistics.peakQueued << " packets, ECN marked=" << doStatistics.ecnMarked <<
+                     ", completion time=" << DataCenterApp::GetGlobalSeconds () * 1e6 << " us\n";
+    if (l4_type == L4_HOMA)
+        std::cout << "Homa: messages sent=" << homaStatistics.messagesSent << " delivered=" <<
+                     homaStatistics.messagesDelivered << " grants=" << homaStatistics.grants << " resends=" <<
+                     homaStatistics.resends << " retransmitted=" << homaStatistics.bytesRetransmitted <<
+                     " bytes abandoned=" << homaStatistics.abandoned << "\n";
+    // Packets still queued at the end are stuck waiting for credits (deadlock)
+    if (nCredits > 0)
+        std::cout << "Flow control: credit stalls=" << fcStatistics.creditStalls << " peak buffered=" <<
+                     fcStatistics.peakBuffered << "/" << nCredits * nVcs << " peak queued=" << fcStatistics.peakQueued <<
+                     " peak held=" << fcStatistics.peakHeld << " left queued=" << nLeftQueued << "\n";
+    if (!sPortStatsFile.empty())
+    {
+        std::unordered_set<uint32_t> hosts;
+        for (int i = 0; i < nNodes; i++)
+            hosts.insert (topology->GetNode(i)->GetId ());
+        portLoad.PrintBalance (std::cout, hosts);
+        if (!portLoad.Write (sPortStatsFile))
+            std::cout << "Could not write " << sPortStatsFile << std::endl;
+    }
+    if (flowSim)
+    {
+        flowSim->PrintValidation (std::cout, DataCenterApp::GetGlobalLatencyHistogram (),
+                                  DataCenterApp::GetGlobalRxBytes (), DataCenterApp::GetGlobalSeconds ());
+        delete flowSim;
+    }
+    if (bMpi)
+        MpiInterface::Disable ();
 
     return 0;
 }
@@ -33,13 +33,29 @@ NS_LOG_COMPONENT_DEFINE ("PointToPointCubeDimorderedHelper");
 namespace ns3 {
 
 PointToPointCubeDimorderedHelper::PointToPointCubeDimorderedHelper (unsigned x, unsigned y, unsigned z, bool isTorus,
-                                                PointToPointHelper pointToPoint)
+                                                PointToPointHelper pointToPoint, unsigned nPartitions)
 {
 
   // unsigned num_nodes = pow(nMary,nNcube);
   unsigned num_nodes = x * y * z;
   m_total_nodes = num_nodes;
-  m_nodes.Create(num_nodes);
+  m_dimsMax = DimensionOrderedAddress (x, y, z);
+
+  // One slab of planes per partition, in node id order
+  bool sliceZ = (z >= nPartitions);
+  if (nPartitions == 0 || (!sliceZ && x < nPartitions))
+    {
+      NS_FATAL_ERROR ("Cannot split a " << x << "x" << y << "x" << z << " cube into "
+                      << nPartitions << " partitions");
+    }
+  for (unsigned zi = 0; zi < z; zi++){
+    for (unsigned yi = 0; yi < y; yi++){
+      for (unsigned xi = 0; xi < x; xi++){
+        unsigned systemId = sliceZ ? (zi * nPartitions / z) : (xi * nPartitions / x);
+        m_nodes.Create(1, systemId);
+      }
+    }
+  }
 
   // for (unsigned i = 0; i < num_nodes; i++){
   //   m_hub_bridge_devs.Add(reallyfastbus.Install(m_nodes.Get(i), m_hubs.Get(i)));
@@ -53,8 +69,8 @@ PointToPointCubeDimorderedHelper::PointToPointCubeDimorderedHelper (unsigned x,
   //     // Setup DimensionOrdered L3 Protocol
   //     CreateAndAggregateObjectFromTypeId (node, "ns3::DimensionOrderedL3Protocol");
   //     Ptr<DimensionOrdered> dimOrdered = node->GetObject<DimensionOrdered> ();
-  //     dimOrdered->SetOrigin (std::make_tuple (1,1,1));
-  //     dimOrdered->SetDimensionsMax (std::make_tuple (x,y,z));
+  //     dimOrdered->SetOrigin (DimensionOrderedAddress (1, 1, 1));
+  //     dimOrdered->SetDimensionsMax (DimensionOrderedAddress (x, y, z));
       
   //     // Setup raw socket factory
   //     Ptr<DimensionOrderedRawSocketFactoryImpl> rawFactory = CreateObject<DimensionOrderedRawSocketFactoryImpl> ();
@@ -62,7 +78,7 @@ PointToPointCubeDimorderedHelper::PointToPointCubeDimorderedHelper (unsigned x,
   // }
 
   DimensionOrderedStackHelper stack;
-  stack.Install (m_nodes, std::make_tuple(1,1,1), std::make_tuple(x,y,z));
+  stack.Install (m_nodes, DimensionOrderedAddress (1, 1, 1), DimensionOrderedAddress (x, y, z));
 
   // Setup topology
   DimensionOrderedAddressHelper::AddressAssignmentList assignList;
@@ -176,7 +192,8 @@ PointToPointCubeDimorderedHelper::GetIpv4Address (unsigned nodeid)
 Address
 PointToPointCubeDimorderedHelper::GetAddress (unsigned nodeid)
 {
-  return (m_diminterfaces.GetAddress(nodeid));
+  // The interface container is in link order, not node order
+  return DimensionOrderedAddressHelper::GetCubeAddress (nodeid, DimensionOrderedAddress (1, 1, 1), m_dimsMax);
 }
 
 } // namespace ns3
@@ -41,8 +41,14 @@ namespace ns3 {
 class PointToPointCubeDimorderedHelper : public PointToPointTopoHelper
 {
 public: 
+  /**
+   * \param nPartitions number of MPI ranks to spread the nodes over. The
+   * cube is cut into slabs of whole Z planes (X planes when there are
+   * fewer Z planes than partitions), node system ids are set to their
+   * slab and links between slabs become remote channels.
+   */
   PointToPointCubeDimorderedHelper (unsigned x, unsigned y, unsigned z, bool isTorus,
-                          PointToPointHelper pointToPoint);
+                          PointToPointHelper pointToPoint, unsigned nPartitions = 1);
 
   ~PointToPointCubeDimorderedHelper ();
 
@@ -54,6 +60,7 @@ public:
 
 private:
   unsigned m_total_nodes;
+  DimensionOrderedAddress m_dimsMax;
 
   NodeContainer m_nodes;
   NetDeviceContainer m_devices;
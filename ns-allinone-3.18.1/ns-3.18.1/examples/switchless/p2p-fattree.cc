@@ -31,6 +31,7 @@
 // #include "ns3/net-device.h"
 #include "ns3/point-to-point-module.h"
 #include "p2p-fattree.h"
+#include "p2p-tree-routes.h"
  
 NS_LOG_COMPONENT_DEFINE ("PointToPointFattreeHelper");
 
@@ -67,6 +68,7 @@ Node * makeOneNode(NodeContainer & container){
 PointToPointFattreeHelper::PointToPointFattreeHelper(unsigned num_node,
                           PointToPointHelper p2phelper)
 {
+  m_num_node = num_node;
   m_node.Create(num_node + 1);
   p2phelper.SetDeviceAttribute ("DataRate", StringValue ("100Gbps")); // 100Gbps is 10Gbps for some reason
   p2phelper.SetChannelAttribute ("Delay", StringValue ("1500ns")); // .5us * 3
@@ -101,6 +103,19 @@ PointToPointFattreeHelper::AssignIpv4Addresses (Ipv4AddressHelper node_ip, Ipv4A
   // }
 }
 
+bool
+PointToPointFattreeHelper::PopulateRoutingTables (bool ecmp)
+{
+  // Every host has a default route to the root, which reaches the hosts
+  // through its interface routes
+  std::pair<Ptr<Ipv4>, uint32_t> host = m_interfaces.Get (0);
+  PointToPointTreeRoutes routes (std::vector<Ipv4Address> (), host.first->GetAddress (host.second, 0).GetMask ());
+  for (unsigned i = 0; i < m_num_node; i++)
+    routes.AddUpRoute (m_node_devices.Get (i * 2));
+  std::cout << "Installed " << routes.GetNRoutes () << " tree routes\n";
+  return true;
+}
+
 Ptr<Node> 
 PointToPointFattreeHelper::GetNode (unsigned nodeid)
 {
@@ -48,6 +48,7 @@ public:
 
   void AssignIpv4Addresses (Ipv4AddressHelper ip, Ipv4AddressHelper router_ip);
   Address GetAddress(unsigned nodeid);
+  bool PopulateRoutingTables (bool ecmp);
 
 private:
   void recursiveMakeTree(Node * root, unsigned group_size, unsigned router_fanout, unsigned tree_depth, uint64_t base_datarate,
@@ -18,6 +18,7 @@
  */
 
 #include <math.h>
+#include <algorithm>
 
 #include "ns3/internet-stack-helper.h"
 #include "ns3/point-to-point-helper.h"
@@ -31,6 +32,7 @@
 // #include "ns3/net-device.h"
 #include "ns3/point-to-point-module.h"
 #include "p2p-hierarchical.h"
+#include "p2p-tree-routes.h"
  
 NS_LOG_COMPONENT_DEFINE ("PointToPointHierarchicalHelper");
 
@@ -56,6 +58,14 @@ PointToPointHierarchicalHelper::PointToPointHierarchicalHelper(unsigned num_node
   m_edge.Create(num_edge);
   m_agg.Create(num_agg * num_repl1);
   m_core.Create(num_core * num_repl1 * num_repl2);
+  m_num_node = num_node;
+  m_num_edge = num_edge;
+  m_num_agg = num_agg;
+  m_num_core = num_core;
+  m_num_repl1 = num_repl1;
+  m_num_repl2 = num_repl2;
+  m_num_node_per_edge = num_node_per_edge;
+  m_num_edge_per_agg = num_edge_per_agg;
   std::cout << "num_node: " << num_node << std::endl;
   std::cout << "num_edge: " << num_edge << std::endl;
   std::cout << "num_agg: " << num_agg * num_repl1 << std::endl;
@@ -115,6 +125,61 @@ PointToPointHierarchicalHelper::AssignIpv4Addresses (Ipv4AddressHelper node_ip,
   }
 }
 
+bool
+PointToPointHierarchicalHelper::PopulateRoutingTables (bool ecmp)
+{
+  std::vector<Ipv4Address> hostNetworks (m_num_node);
+  std::pair<Ptr<Ipv4>, uint32_t> host = m_interfaces.Get (0);
+  Ipv4Mask mask = host.first->GetAddress (host.second, 0).GetMask ();
+  for (unsigned i = 0; i < m_num_node; i++)
+    hostNetworks[i] = m_interfaces.GetAddress (i * 2).CombineMask (mask);
+  PointToPointTreeRoutes routes (hostNetworks, mask);
+
+  // Hosts reach their edge switch through the default route, and edge
+  // switches their hosts through the interface routes
+  for (unsigned i = 0; i < m_num_node; i++)
+    routes.AddUpRoute (m_node_devices.Get (i * 2));
+
+  // Edge e is linked to agg e / num_edge_per_agg of every replica, the
+  // devices of link (e, replica) are pair e * num_repl1 + replica
+  unsigned nUplinks1 = ecmp ? m_num_repl1 : 1;
+  for (unsigned e = 0; e < m_num_edge; e++)
+    {
+      unsigned first = std::min (e * m_num_node_per_edge, m_num_node);
+      unsigned end = std::min (first + m_num_node_per_edge, m_num_node);
+      for (unsigned r = 0; r < m_num_repl1; r++)
+        {
+          unsigned link = e * m_num_repl1 + r;
+          if (r < nUplinks1)
+            routes.AddUpRoute (m_router_devices.Get (link * 2));
+          routes.AddDownRoutes (m_router_devices.Get (link * 2 + 1), first, end);
+        }
+    }
+
+  // Agg a of replica r1 is linked to the cores r1 * num_repl2 + r2, the
+  // devices come after the edge links in (a, r1, r2) order
+  if (m_num_core != 0)
+    {
+      unsigned nUplinks2 = ecmp ? m_num_repl2 : 1;
+      unsigned nodesPerAgg = m_num_node_per_edge * m_num_edge_per_agg;
+      for (unsigned a = 0; a < m_num_agg; a++)
+        {
+          unsigned first = std::min (a * nodesPerAgg, m_num_node);
+          unsigned end = std::min (first + nodesPerAgg, m_num_node);
+          for (unsigned r1 = 0; r1 < m_num_repl1; r1++)
+            for (unsigned r2 = 0; r2 < m_num_repl2; r2++)
+              {
+                unsigned link = m_num_edge * m_num_repl1 + (a * m_num_repl1 + r1) * m_num_repl2 + r2;
+                if (r2 < nUplinks2)
+                  routes.AddUpRoute (m_router_devices.Get (link * 2));
+                routes.AddDownRoutes (m_router_devices.Get (link * 2 + 1), first, end);
+              }
+        }
+    }
+  std::cout << "Installed " << routes.GetNRoutes () << " tree routes\n";
+  return true;
+}
+
 Ptr<Node> 
 PointToPointHierarchicalHelper::GetNode (unsigned nodeid)
 {
@@ -47,6 +47,7 @@ public:
   void InstallStack (InternetStackHelper stack);
   void AssignIpv4Addresses (Ipv4AddressHelper ip, Ipv4AddressHelper link_ip);
   Address GetAddress(unsigned nodeid);
+  bool PopulateRoutingTables (bool ecmp);
 private:
 
   NodeContainer m_node;
@@ -62,7 +63,14 @@ private:
   // Ipv4InterfaceContainer m_coreIface;
   // Ipv4InterfaceContainer m_otherIface;
 
-  //unsigned m_num_node;
+  unsigned m_num_node;
+  unsigned m_num_edge;
+  unsigned m_num_agg;
+  unsigned m_num_core;
+  unsigned m_num_repl1;
+  unsigned m_num_repl2;
+  unsigned m_num_node_per_edge;
+  unsigned m_num_edge_per_agg;
 };
 
 } // namespace ns3
@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+
+#include "p2p-kary-ncube-dimordered.h"
+ 
+NS_LOG_COMPONENT_DEFINE ("PointToPointKaryNCubeDimorderedHelper");
+
+
+namespace ns3 {
+
+PointToPointKaryNCubeDimorderedHelper::PointToPointKaryNCubeDimorderedHelper (std::vector<unsigned> dims, bool isTorus,
+                                                                              PointToPointHelper pointToPoint,
+                                                                              unsigned nPartitions)
+  : m_dims (dims)
+{
+  unsigned nDims = dims.size ();
+  if (nDims == 0 || nDims > DimensionOrderedAddress::MAX_DIMS)
+    {
+      NS_FATAL_ERROR ("Cannot build a cube of " << nDims << " dimensions, at most "
+                      << DimensionOrderedAddress::MAX_DIMS << " are supported");
+    }
+
+  unsigned num_nodes = 1;
+  std::vector<uint16_t> origin (nDims, 1);
+  std::vector<uint16_t> dimsMax (nDims);
+  for (unsigned dim = 0; dim < nDims; dim++)
+    {
+      if (dims[dim] == 0 || dims[dim] >= DimensionOrderedAddress::BROADCAST_COORDINATE - 1)
+        {
+          NS_FATAL_ERROR ("Cannot have " << dims[dim] << " nodes in dimension " << dim);
+        }
+      num_nodes *= dims[dim];
+      dimsMax[dim] = dims[dim];
+    }
+  m_origin = DimensionOrderedAddress (origin);
+  m_dimsMax = DimensionOrderedAddress (dimsMax);
+
+  // One slab of planes per partition, in node id order
+  unsigned sliceDim = (dims[nDims - 1] >= nPartitions) ? nDims - 1 : 0;
+  if (nPartitions == 0 || dims[sliceDim] < nPartitions)
+    {
+      NS_FATAL_ERROR ("Cannot split the cube into " << nPartitions << " partitions");
+    }
+  unsigned sliceStride = 1;
+  for (unsigned dim = 0; dim < sliceDim; dim++)
+    sliceStride *= dims[dim];
+  for (unsigned i = 0; i < num_nodes; i++)
+    {
+      unsigned plane = (i / sliceStride) % dims[sliceDim];
+      m_nodes.Create (1, plane * nPartitions / dims[sliceDim]);
+    }
+
+  DimensionOrderedStackHelper stack;
+  stack.Install (m_nodes, m_origin, m_dimsMax);
+
+  // Link every node to its NEG neighbour in every dimension; with a torus
+  // the first node of a ring is linked to the last one instead
+  DimensionOrderedAddressHelper::AddressAssignmentList assignList;
+  unsigned stride = 1;
+  for (unsigned dim = 0; dim < nDims; dim++)
+    {
+      for (unsigned nodeid = 0; nodeid < num_nodes; nodeid++)
+        {
+          unsigned coordinate = (nodeid / stride) % dims[dim];
+          unsigned neighbour;
+          if (coordinate != 0)
+            neighbour = nodeid - stride;
+          else if (isTorus && dims[dim] > 1)
+            neighbour = nodeid + (dims[dim] - 1) * stride;
+          else
+            continue;
+
+          NetDeviceContainer devices = pointToPoint.Install (m_nodes.Get (nodeid), m_nodes.Get (neighbour));
+          assignList.push_back (std::make_tuple (devices.Get (0), GetCubeAddress (nodeid),
+                                                 DimensionOrdered::GetDirection (dim, true)));
+          assignList.push_back (std::make_tuple (devices.Get (1), GetCubeAddress (neighbour),
+                                                 DimensionOrdered::GetDirection (dim, false)));
+        }
+      stride *= dims[dim];
+    }
+  DimensionOrderedAddressHelper::Assign (assignList);
+}
+
+PointToPointKaryNCubeDimorderedHelper::~PointToPointKaryNCubeDimorderedHelper ()
+{
+}
+
+DimensionOrderedAddress
+PointToPointKaryNCubeDimorderedHelper::GetCubeAddress (unsigned nodeid) const
+{
+  return DimensionOrderedAddressHelper::GetCubeAddress (nodeid, m_origin, m_dimsMax);
+}
+
+void
+PointToPointKaryNCubeDimorderedHelper::InstallStack (InternetStackHelper stack)
+{
+}
+
+void
+PointToPointKaryNCubeDimorderedHelper::AssignIpv4Addresses (Ipv4AddressHelper node_ip, Ipv4AddressHelper link_ip)
+{
+}
+
+Ptr<Node> 
+PointToPointKaryNCubeDimorderedHelper::GetNode (unsigned nodeid)
+{
+  return (m_nodes.Get(nodeid));
+}
+
+Ipv4Address
+PointToPointKaryNCubeDimorderedHelper::GetIpv4Address (unsigned nodeid)
+{
+  return 0;
+}
+
+Address
+PointToPointKaryNCubeDimorderedHelper::GetAddress (unsigned nodeid)
+{
+  return GetCubeAddress (nodeid);
+}
+
+} // namespace ns3
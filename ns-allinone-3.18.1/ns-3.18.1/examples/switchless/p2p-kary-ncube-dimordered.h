@@ -0,0 +1,73 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef POINT_TO_POINT_KARY_NCUBE_DIMORDERED_HELPER_H
+#define POINT_TO_POINT_KARY_NCUBE_DIMORDERED_HELPER_H
+
+#include <vector>
+
+#include "ns3/internet-stack-helper.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/switchless-module.h"
+
+#include "p2p-topology-interface.h"
+namespace ns3 {
+
+/**
+ * \ingroup pointtopointlayout
+ *
+ * \brief A helper to create a mesh or torus of any number of dimensions
+ * running the DimensionOrdered stack
+ *
+ * Node i has the address GetCubeAddress (i) with coordinates starting at
+ * 1, X varying fastest, like PointToPointCubeDimorderedHelper.
+ */
+class PointToPointKaryNCubeDimorderedHelper : public PointToPointTopoHelper
+{
+public: 
+  /**
+   * \param dims number of nodes along every dimension, X first
+   * \param nPartitions number of partitions to spread the nodes over. The
+   * cube is cut into slabs of the highest dimension (of X when it has
+   * fewer planes than partitions), node system ids are set to their slab
+   * and links between slabs become remote channels.
+   */
+  PointToPointKaryNCubeDimorderedHelper (std::vector<unsigned> dims, bool isTorus,
+                                         PointToPointHelper pointToPoint, unsigned nPartitions = 1);
+
+  ~PointToPointKaryNCubeDimorderedHelper ();
+
+  Ptr<Node> GetNode (unsigned nodeid);
+  Ipv4Address GetIpv4Address (unsigned nodeid);
+  void InstallStack (InternetStackHelper stack);
+  void AssignIpv4Addresses (Ipv4AddressHelper ip, Ipv4AddressHelper link_ip);
+  Address GetAddress(unsigned nodeid);
+
+private:
+  DimensionOrderedAddress GetCubeAddress (unsigned nodeid) const;
+
+  std::vector<unsigned> m_dims;
+  DimensionOrderedAddress m_origin;
+  DimensionOrderedAddress m_dimsMax;
+  NodeContainer m_nodes;
+};
+
+} // namespace ns3
+
+#endif /* POINT_TO_POINT_KARY_NCUBE_DIMORDERED_HELPER_H */
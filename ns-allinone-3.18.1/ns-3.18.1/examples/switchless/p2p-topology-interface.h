@@ -54,6 +54,16 @@ public:
 
   virtual void AssignIpv4Addresses (Ipv4AddressHelper ip, Ipv4AddressHelper link_ip) = 0;
   virtual Address GetAddress(unsigned nodeid) = 0;
+
+  /**
+   * Install the IP routes directly from the structure of the topology,
+   * after the addresses are assigned.
+   *
+   * \param ecmp route over every uplink instead of the first one only
+   * \returns false if the topology cannot, and global routing must be
+   * populated instead
+   */
+  virtual bool PopulateRoutingTables (bool ecmp) { return false; }
 };
 
 } // namespace ns3
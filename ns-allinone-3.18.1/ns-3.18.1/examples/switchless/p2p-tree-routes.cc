@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/channel.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/global-router-interface.h"
+
+#include "p2p-tree-routes.h"
+
+NS_LOG_COMPONENT_DEFINE ("PointToPointTreeRoutes");
+
+
+namespace ns3 {
+
+namespace {
+
+// Interface of device and the address of its peer on the link
+uint32_t
+GetLinkInterface (Ptr<NetDevice> device, Ipv4Address &gateway)
+{
+  Ptr<Channel> channel = device->GetChannel ();
+  NS_ASSERT_MSG (channel && channel->GetNDevices () == 2, "Not a point-to-point link");
+  Ptr<NetDevice> peer = channel->GetDevice (channel->GetDevice (0) == device ? 1 : 0);
+  Ptr<Ipv4> peerIpv4 = peer->GetNode ()->GetObject<Ipv4> ();
+  gateway = peerIpv4->GetAddress (peerIpv4->GetInterfaceForDevice (peer), 0).GetLocal ();
+  Ptr<Ipv4> ipv4 = device->GetNode ()->GetObject<Ipv4> ();
+  int32_t interface = ipv4->GetInterfaceForDevice (device);
+  NS_ASSERT_MSG (interface >= 0, "No IPv4 interface on the device");
+  return interface;
+}
+
+} // anonymous namespace
+
+PointToPointTreeRoutes::PointToPointTreeRoutes (std::vector<Ipv4Address> hostNetworks, Ipv4Mask hostMask)
+  : m_hostNetworks (hostNetworks),
+    m_hostMask (hostMask),
+    m_hostBits (32 - hostMask.GetPrefixLength ()),
+    m_nRoutes (0)
+{
+}
+
+void
+PointToPointTreeRoutes::AddUpRoute (Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (this << device);
+  Ipv4Address gateway;
+  uint32_t interface = GetLinkInterface (device, gateway);
+  Ptr<GlobalRouter> router = device->GetNode ()->GetObject<GlobalRouter> ();
+  NS_ASSERT_MSG (router, "No global routing on node " << device->GetNode ()->GetId ());
+  router->GetRoutingProtocol ()->AddNetworkRouteTo (Ipv4Address::GetAny (), Ipv4Mask::GetZero (),
+                                                    gateway, interface);
+  m_nRoutes++;
+}
+
+void
+PointToPointTreeRoutes::AddDownRoutes (Ptr<NetDevice> device, uint32_t first, uint32_t end)
+{
+  NS_LOG_FUNCTION (this << device << first << end);
+  Ipv4Address gateway;
+  uint32_t interface = GetLinkInterface (device, gateway);
+  Ptr<Ipv4StaticRouting> routing = Ipv4StaticRoutingHelper ().GetStaticRouting (device->GetNode ()->GetObject<Ipv4> ());
+  while (first < end)
+    {
+      // Largest aligned block of consecutive host networks starting at first
+      uint32_t network = m_hostNetworks[first].Get () >> m_hostBits;
+      uint32_t bits = 0;
+      while (bits + m_hostBits < 32
+             && (network & ((2U << bits) - 1)) == 0
+             && first + (2U << bits) <= end
+             && m_hostNetworks[first + (2U << bits) - 1].Get () >> m_hostBits == network + (2U << bits) - 1)
+        {
+          bits++;
+        }
+      Ipv4Mask mask (m_hostMask.Get () << bits);
+      routing->AddNetworkRouteTo (m_hostNetworks[first], mask, gateway, interface);
+      m_nRoutes++;
+      first += 1U << bits;
+    }
+}
+
+uint32_t
+PointToPointTreeRoutes::GetNRoutes (void) const
+{
+  return m_nRoutes;
+}
+
+} // namespace ns3
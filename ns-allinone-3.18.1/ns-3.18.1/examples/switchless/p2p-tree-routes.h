@@ -0,0 +1,66 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef POINT_TO_POINT_TREE_ROUTES_H
+#define POINT_TO_POINT_TREE_ROUTES_H
+
+#include <vector>
+
+#include "ns3/ipv4-address.h"
+#include "ns3/net-device.h"
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+/**
+ * \brief Installs the routes of a tree of point-to-point links directly,
+ * instead of running global routing over the whole topology.
+ *
+ * Down routes cover the networks of the hosts below a link and go into
+ * the Ipv4StaticRouting of the node, with the host networks of a range of
+ * hosts merged into as few prefixes as possible. Up routes are default
+ * routes in the Ipv4GlobalRouting of the node, which the list routing
+ * only consults when no static route matched; with several uplinks every
+ * one of them is an equal cost route. Networks of directly connected
+ * hosts are covered by the interface routes of the static routing.
+ */
+class PointToPointTreeRoutes
+{
+public:
+  /**
+   * \param hostNetworks network address of the host link of every host,
+   * consecutive hosts should have consecutive networks
+   * \param hostMask network mask of the host links
+   */
+  PointToPointTreeRoutes (std::vector<Ipv4Address> hostNetworks, Ipv4Mask hostMask);
+
+  /// Default route through the peer of device
+  void AddUpRoute (Ptr<NetDevice> device);
+  /// Routes to the networks of hosts [first, end) through the peer of device
+  void AddDownRoutes (Ptr<NetDevice> device, uint32_t first, uint32_t end);
+
+  uint32_t GetNRoutes (void) const;
+
+private:
+  std::vector<Ipv4Address> m_hostNetworks;
+  Ipv4Mask m_hostMask;
+  uint32_t m_hostBits;
+  uint32_t m_nRoutes;
+};
+
+} // namespace ns3
+
+#endif /* POINT_TO_POINT_TREE_ROUTES_H */
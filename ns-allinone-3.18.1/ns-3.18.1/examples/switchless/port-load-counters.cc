@@ -0,0 +1,106 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+// C/C++ Includes
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+// NS-3 Includes
+#include "ns3/point-to-point-net-device.h"
+
+// Switchless Includes
+#include "port-load-counters.h"
+
+void
+PortLoadCounters::Port::Count (Ptr<const Packet> packet)
+{
+    m_packets++;
+    m_bytes += packet->GetSize ();
+}
+
+void
+PortLoadCounters::Install (void)
+{
+    NS_ASSERT (m_ports.empty ());
+    std::vector<Ptr<PointToPointNetDevice> > devices;
+    for (NodeList::Iterator it = NodeList::Begin (); it != NodeList::End (); it++)
+    {
+        for (uint32_t i = 0; i < (*it)->GetNDevices (); i++)
+        {
+            Ptr<PointToPointNetDevice> device = DynamicCast<PointToPointNetDevice> ((*it)->GetDevice (i));
+            if (!device)
+                continue;
+            Ptr<Channel> channel = device->GetChannel ();
+            Ptr<NetDevice> peer = channel->GetDevice (channel->GetDevice (0) == device ? 1 : 0);
+            Port port = { (*it)->GetId (), i, peer->GetNode ()->GetId (), 0, 0 };
+            m_ports.push_back (port);
+            devices.push_back (device);
+        }
+    }
+    for (uint32_t p = 0; p < m_ports.size (); p++)
+        devices[p]->TraceConnectWithoutContext ("PhyTxBegin", MakeCallback (&Port::Count, &m_ports[p]));
+}
+
+bool
+PortLoadCounters::Write (std::string filename) const
+{
+    std::ofstream out (filename.c_str ());
+    if (!out)
+        return false;
+    out << "# node device peer packets bytes\n";
+    for (uint32_t p = 0; p < m_ports.size (); p++)
+    {
+        const Port& port = m_ports[p];
+        out << port.m_node << " " << port.m_ifIndex << " " << port.m_peer << " " <<
+               port.m_packets << " " << port.m_bytes << "\n";
+    }
+    return out.good ();
+}
+
+uint32_t
+PortLoadCounters::GetNPorts (void) const
+{
+    return m_ports.size ();
+}
+
+uint64_t
+PortLoadCounters::GetTotalPackets (void) const
+{
+    uint64_t packets = 0;
+    for (uint32_t p = 0; p < m_ports.size (); p++)
+        packets += m_ports[p].m_packets;
+    return packets;
+}
+
+void
+PortLoadCounters::PrintBalance (std::ostream& os, const std::unordered_set<uint32_t>& hosts) const
+{
+    std::vector<uint64_t> bytes;
+    for (uint32_t p = 0; p < m_ports.size (); p++)
+    {
+        const Port& port = m_ports[p];
+        if (hosts.count (port.m_node) == 0 && hosts.count (port.m_peer) == 0)
+            bytes.push_back (port.m_bytes);
+    }
+    if (bytes.empty ())
+    {
+        os << "Fabric ports: none\n";
+        return;
+    }
+    double mean = 0.0;
+    uint32_t idle = 0;
+    for (uint32_t i = 0; i < bytes.size (); i++)
+    {
+        mean += bytes[i];
+        idle += (bytes[i] == 0);
+    }
+    mean /= bytes.size ();
+    double variance = 0.0;
+    for (uint32_t i = 0; i < bytes.size (); i++)
+        variance += (bytes[i] - mean) * (bytes[i] - mean);
+    variance /= bytes.size ();
+    os << "Fabric ports: count=" << bytes.size () << " idle=" << idle <<
+          " bytes min=" << *std::min_element (bytes.begin (), bytes.end ()) <<
+          " mean=" << mean << " max=" << *std::max_element (bytes.begin (), bytes.end ()) <<
+          " cv=" << (mean > 0.0 ? std::sqrt (variance) / mean : 0.0) << "\n";
+}
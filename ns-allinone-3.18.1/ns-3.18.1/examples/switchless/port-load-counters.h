@@ -0,0 +1,54 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef PORT_LOAD_COUNTERS_H
+#define PORT_LOAD_COUNTERS_H
+
+// C/C++ Includes
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// NS-3 Includes
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+using namespace ns3;
+
+/*
+ * Packets and bytes sent by every point-to-point device, counted when
+ * their transmission starts, to check how evenly multipath routing
+ * spreads the load over the ports of the switches.
+ */
+class PortLoadCounters
+{
+public:
+    // Trace every point-to-point device of every node
+    void Install (void);
+
+    // One line per port: node, device, peer, packets and bytes
+    bool Write (std::string filename) const;
+    // Spread of the bytes sent over the ports between two switches
+    void PrintBalance (std::ostream& os, const std::unordered_set<uint32_t>& hosts) const;
+
+    // Number of ports and packets sent over all of them
+    uint32_t GetNPorts (void) const;
+    uint64_t GetTotalPackets (void) const;
+
+private:
+    struct Port
+    {
+        uint32_t    m_node;
+        uint32_t    m_ifIndex;
+        uint32_t    m_peer;
+        uint64_t    m_packets;
+        uint64_t    m_bytes;
+        void Count (Ptr<const Packet> packet);
+    };
+
+    // Not resized after Install, the trace callbacks point into it
+    std::vector<Port> m_ports;
+};
+
+#endif
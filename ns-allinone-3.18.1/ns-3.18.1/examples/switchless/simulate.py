@@ -306,18 +306,16 @@ if __name__ == '__main__':
 												# logfname = topo
 												# logfname += ".log"
 
-												command = './waf --run "main-test' + args + ' --debug=1"'
-												commands.append(command)
 												# logfnames.append(logfname)
 												# logfname = "Weather_" + topo + "_" + `numreceiver`
 												logfname = "Nbody1000_" + topo + "_" + `interval`
 												logfname += '.log'
 												logfnames.append(logfname)
+												# binary per-packet trace instead of the --debug=1 text log
+												command = './waf --run "main-test' + args + ' --trace=' + logfname + '.trace"'
+												commands.append(command)
 												# print(command)
 
-	import parse_output
-	from cStringIO import StringIO
-
 	execute = False
 	writetofile = False
 
@@ -334,15 +332,9 @@ if __name__ == '__main__':
 		# print(logfnames[i])
 		if execute:
 			os.system(command) 
-			sys.stdout = parseout = StringIO()
-			parse_output.parseOutput(logfnames[i])
-			sys.stdout = sys.__stdout__
-			# print(parseout.getvalue()) # UNCOMMENT TO SEE THE PARSED OUTPUT
 			parsedf = logfnames[i] + ".parsed"
-			f = open(parsedf,'w')
-			f.write(parseout.getvalue())
+			os.system('./waf --run "dc-app-trace-reader --input=' + logfnames[i] + '.trace --output=' + parsedf + '"')
 			filestoplot.append(parsedf)
-			f.close()
 
 	if execute:
 		import plot_delay
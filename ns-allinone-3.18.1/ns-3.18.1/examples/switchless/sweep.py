@@ -0,0 +1,230 @@
+#!/usr/bin/python
+
+# Runs a sweep of main-test configurations in parallel and collects the
+# latency/throughput summary of every run into one results table.
+#
+# The sweep spec is a JSON file; every list-valued key is swept over and the
+# cross product of all lists is run. Keys and defaults are in DEFAULT_SPEC.
+# Runs use the already built main-test binary directly (build it once with
+# ./waf build), a pool of workers bounded by cores and available memory,
+# and are retried before being recorded as failed.
+#
+# Usage: ./examples/switchless/sweep.py [spec.json] [--jobs N] [--output results.tsv]
+# (run from the ns-3 top level directory)
+
+import argparse
+import glob
+import itertools
+import json
+import os
+import re
+import subprocess
+import sys
+import threading
+import time
+
+from simulate import parseStandardVariables
+
+# Equivalent of the override block in simulate.py
+DEFAULT_SPEC = {
+    "nodes": [1024],
+    "topologies": ["fattree", "hierarchical", "cube-dimordered", "mesh-dimordered"],
+    "hierarchical_type": "balanced",
+    "workload": "all-to-all",
+    "intervaltypes": ["fixed"],
+    "synctypes": [1],
+    "intervals": [0],
+    "packetsizes": [4000],
+    "numiterations": [1],
+    "numsenders": [1],
+    "numreceivers": [.2],
+    "l4types": ["UDP"],
+    # Estimated peak memory of one run, used to bound the number of workers
+    "mem_mb_per_node": 2,
+    "timeout": 0,
+    "retries": 1
+}
+
+SWEPT_KEYS = ["nodes", "topologies", "intervaltypes", "synctypes", "intervals",
+              "packetsizes", "numiterations", "numsenders", "numreceivers", "l4types"]
+
+RESULT_COLUMNS = ["count", "mean", "p50", "p90", "p99", "p99.9", "max", "bytes", "seconds", "gbps", "pps"]
+
+def findBinary ():
+    for profile in ["optimized", "release", "debug"]:
+        matches = glob.glob(os.path.join("build", "examples", "switchless", "ns*-main-test-" + profile))
+        if matches:
+            return os.path.abspath(matches[0])
+    return None
+
+def loadSpec (specFilename):
+    spec = dict(DEFAULT_SPEC)
+    if specFilename:
+        spec.update(json.load(open(specFilename)))
+    return spec
+
+def makeConfigs (spec):
+    configs = []
+    for values in itertools.product(*[spec[key] for key in SWEPT_KEYS]):
+        config = dict(zip(SWEPT_KEYS, values))
+        nNode = config["nodes"]
+
+        argdict = {}
+        argdict["nNode"] = nNode
+        argdict["topo"] = config["topologies"]
+        argdict["hierarchical_type"] = spec["hierarchical_type"]
+        argdict["intervaltype"] = config["intervaltypes"]
+        argdict["interval"] = config["intervals"]
+        argdict["synctype"] = config["synctypes"]
+        argdict["packetsize"] = config["packetsizes"]
+        argdict["numiteration"] = config["numiterations"]
+        argdict["l4type"] = config["l4types"]
+        args = parseStandardVariables(argdict).split()
+
+        workload = spec["workload"]
+        if workload == "all-to-all" or workload == "test":
+            args += ["--ncount=%d" % nNode, "--scount=%d" % nNode, "--rcount=%d" % (nNode - 1)]
+        elif workload == "rnrm":
+            args += ["--ncount=%d" % nNode,
+                     "--scount=%d" % int(config["numsenders"] * nNode),
+                     "--rcount=%d" % int(config["numreceivers"] * nNode)]
+        elif workload == "rnnm":
+            args += ["--ncount=%d" % nNode,
+                     "--scount=%d" % int(config["numsenders"] * nNode),
+                     "--neighborcount=%d" % config["numreceivers"]]
+        else:
+            print "Unknown workload '" + workload + "'"
+            sys.exit(1)
+
+        config["args"] = args
+        configs.append(config)
+    return configs
+
+def availableMemoryMb ():
+    try:
+        for line in open("/proc/meminfo"):
+            if line.startswith("MemAvailable:"):
+                return int(line.split()[1]) / 1024
+    except IOError:
+        pass
+    return None
+
+def workerCount (spec, configs, requested):
+    cores = requested or os.sysconf("SC_NPROCESSORS_ONLN")
+    memory = availableMemoryMb()
+    if memory is None or not configs:
+        return max(1, min(cores, len(configs)))
+    largest = max(config["nodes"] for config in configs) * spec["mem_mb_per_node"]
+    return max(1, min(cores, len(configs), memory / max(1, largest)))
+
+def parseSummary (output):
+    result = {}
+    match = re.search(r"Latency: count=(\d+) mean=([\d.e+-]+)ns p50=(\d+)ns p90=(\d+)ns "
+                      r"p99=(\d+)ns p99\.9=(\d+)ns max=(\d+)ns", output)
+    if match:
+        for column, value in zip(RESULT_COLUMNS[:7], match.groups()):
+            result[column] = value
+    match = re.search(r"Throughput: (\d+) bytes in ([\d.e+-]+) s(?: \(([\d.e+-]+) Gbps, ([\d.e+-]+) packets/s\))?",
+                      output)
+    if match:
+        for column, value in zip(RESULT_COLUMNS[7:], match.groups()):
+            result[column] = value if value is not None else ""
+    return result
+
+class Sweep:
+    def __init__ (self, binary, spec, configs, jobs):
+        self.binary = binary
+        self.spec = spec
+        self.configs = configs
+        self.jobs = jobs
+        self.results = [None] * len(configs)
+        self.next = 0
+        self.lock = threading.Lock()
+        self.env = dict(os.environ)
+        libraryPath = os.path.abspath("build")
+        if self.env.get("LD_LIBRARY_PATH"):
+            libraryPath += ":" + self.env["LD_LIBRARY_PATH"]
+        self.env["LD_LIBRARY_PATH"] = libraryPath
+
+    def runOnce (self, config):
+        command = [self.binary] + config["args"]
+        if self.spec["timeout"] > 0:
+            command = ["timeout", str(self.spec["timeout"])] + command
+        start = time.time()
+        process = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, env=self.env)
+        output = process.communicate()[0]
+        return process.returncode, time.time() - start, output
+
+    def worker (self):
+        while True:
+            with self.lock:
+                if self.next == len(self.configs):
+                    return
+                index = self.next
+                self.next += 1
+            config = self.configs[index]
+
+            attempts = 0
+            while True:
+                attempts += 1
+                returncode, wall, output = self.runOnce(config)
+                if returncode == 0 or attempts > self.spec["retries"]:
+                    break
+
+            result = parseSummary(output) if returncode == 0 else {}
+            result["status"] = "ok" if returncode == 0 else "failed(%d)" % returncode
+            result["attempts"] = attempts
+            result["wall"] = "%.1f" % wall
+            with self.lock:
+                self.results[index] = result
+                print "[%d/%d] %s %s: %s in %ss" % (index + 1, len(self.configs), config["topologies"],
+                                                   " ".join(config["args"]), result["status"], result["wall"])
+                sys.stdout.flush()
+
+    def run (self):
+        threads = [threading.Thread(target=self.worker) for i in range(self.jobs)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+    def writeResults (self, outputFilename):
+        columns = SWEPT_KEYS + ["status", "attempts", "wall"] + RESULT_COLUMNS
+        outputFile = open(outputFilename, "w")
+        outputFile.write("\t".join(columns) + "\n")
+        for config, result in zip(self.configs, self.results):
+            row = dict(config)
+            row.update(result)
+            outputFile.write("\t".join(str(row.get(column, "")) for column in columns) + "\n")
+        outputFile.close()
+
+def main ():
+    parser = argparse.ArgumentParser(description="Run a main-test sweep in parallel")
+    parser.add_argument("spec", nargs="?", help="JSON sweep spec (defaults to DEFAULT_SPEC)")
+    parser.add_argument("--jobs", type=int, default=0, help="Maximum parallel runs (default: cores)")
+    parser.add_argument("--output", default="sweep-results.tsv", help="Results table")
+    parser.add_argument("--dry-run", action="store_true", help="Only print the command lines")
+    options = parser.parse_args()
+
+    spec = loadSpec(options.spec)
+    configs = makeConfigs(spec)
+    binary = findBinary()
+    if binary is None:
+        print "main-test binary not found, run ./waf build from the ns-3 directory first"
+        sys.exit(1)
+
+    if options.dry_run:
+        for config in configs:
+            print binary + " " + " ".join(config["args"])
+        return
+
+    jobs = workerCount(spec, configs, options.jobs)
+    print "Running %d configurations with %d workers" % (len(configs), jobs)
+    sweep = Sweep(binary, spec, configs, jobs)
+    sweep.run()
+    sweep.writeResults(options.output)
+    failed = len([result for result in sweep.results if result["status"] != "ok"])
+    print "Wrote %s (%d ok, %d failed)" % (options.output, len(configs) - failed, failed)
+
+if __name__ == "__main__":
+    main()
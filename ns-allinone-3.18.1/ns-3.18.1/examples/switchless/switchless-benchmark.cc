@@ -0,0 +1,422 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * Simulator performance benchmark for the switchless topologies
+ *
+ * Builds one topology with the given number of hosts, runs a fixed workload
+ * on it and prints one JSON object with the wall time of every phase, the
+ * events executed per second, the memory use and the simulated packets per
+ * wall second, so runs can be compared across commits. benchmark.py runs
+ * the whole matrix of topologies and sizes.
+ *
+ * Every host sends one request per iteration to each of its receivers,
+ * which respond:
+ *  all-to-all  fanout receivers drawn uniformly from all hosts, fixed seed
+ *  neighbor    the rest of its rack of 16 on the trees, the adjacent
+ *              hosts of the grid on the cubes and meshes
+ *
+ * Memory is the heap in use (mallinfo2) where available, otherwise the
+ * resident set size. The bytes per pending event are measured up front by
+ * scheduling a batch of empty events in a fresh simulator.
+ */
+
+// C/C++ Includes
+#include <malloc.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <unordered_set>
+#include <vector>
+
+// NS-3 Includes
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+
+// Switchless Includes
+#include "data-center-app.h"
+#include "p2p-topology-interface.h"
+#include "p2p-fattree.h"
+#include "p2p-cube.h"
+#include "p2p-hierarchical.h"
+#include "p2p-cube-dimordered.h"
+#include "port-load-counters.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("SwitchlessBenchmark");
+
+// Same limit on the rack depth as simulate.py
+static const uint32_t FANOUT = 16;
+
+static uint64_t
+GetHeapBytes (void)
+{
+#if defined (__GLIBC_PREREQ)
+#if __GLIBC_PREREQ (2, 33)
+    struct mallinfo2 info = mallinfo2 ();
+    return info.uordblks + info.hblkhd;
+#endif
+#endif
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    std::ifstream statm ("/proc/self/statm");
+    statm >> size >> resident;
+    return resident * sysconf (_SC_PAGESIZE);
+}
+
+static uint64_t
+GetPeakRssKb (void)
+{
+    struct rusage usage;
+    getrusage (RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static double
+BytesPer (uint64_t after, uint64_t before, uint32_t count)
+{
+    return after > before ? double (after - before) / count : 0.0;
+}
+
+static void
+EmptyEvent (void)
+{
+}
+
+// Heap bytes per event waiting in the scheduler
+static double
+MeasurePendingEventBytes (uint32_t nEvents)
+{
+    if (nEvents == 0)
+        return 0.0;
+    Simulator::Schedule (NanoSeconds (0), &EmptyEvent);
+    uint64_t before = GetHeapBytes ();
+    for (uint32_t i = 0; i < nEvents; i++)
+        Simulator::Schedule (NanoSeconds (i + 1), &EmptyEvent);
+    uint64_t after = GetHeapBytes ();
+    Simulator::Destroy ();
+    return BytesPer (after, before, nEvents);
+}
+
+// Grid dimensions of getXY and getXYZ in simulate.py
+static void
+GetGridDimensions (uint32_t nHosts, bool bMesh, uint32_t& x, uint32_t& y, uint32_t& z)
+{
+    if (bMesh)
+    {
+        x = y = std::ceil (std::sqrt (double (nHosts)));
+        z = 1;
+    }
+    else
+    {
+        uint32_t i = std::ceil (std::pow (double (nHosts), .333333333));
+        if (i <= FANOUT)
+        {
+            x = y = z = i;
+        }
+        else
+        {
+            z = FANOUT;
+            x = y = std::ceil (std::sqrt (std::ceil (double (nHosts) / z)));
+        }
+    }
+    while (x * z * (y - 1) > nHosts)
+        y--;
+}
+
+static void
+AddGridNeighbor (std::vector<uint32_t>& receivers, uint32_t self, uint32_t neighbor, uint32_t nHosts)
+{
+    if (neighbor == self || neighbor >= nHosts)
+        return;
+    for (uint32_t i = 0; i < receivers.size (); i++)
+    {
+        if (receivers[i] == neighbor)
+            return;
+    }
+    receivers.push_back (neighbor);
+}
+
+static std::string
+JsonString (const std::string& s)
+{
+    std::string json = "\"";
+    for (uint32_t i = 0; i < s.size (); i++)
+    {
+        if (s[i] == '"' || s[i] == '\\')
+            json += '\\';
+        json += s[i];
+    }
+    return json + "\"";
+}
+
+static double
+PerSecond (uint64_t count, double ms)
+{
+    return ms > 0.0 ? count * 1000.0 / ms : 0.0;
+}
+
+// SystemWallClockMs only counts clock ticks, too coarse for the small runs
+class WallClock
+{
+public:
+    void Start (void)
+    {
+        m_start = std::chrono::steady_clock::now ();
+    }
+    double End (void) const
+    {
+        return std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - m_start).count ();
+    }
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+int
+main (int argc, char *argv[])
+{
+    std::string sTopology = "cube-dimordered";
+    uint32_t nHosts = 1024;
+    std::string sWorkload = "all-to-all";
+    uint32_t nFanout = 8;
+    uint32_t nPacketSize = 1000;
+    uint32_t nIterations = 2;
+    uint32_t nInterval = 10;
+    std::string sL4 = "udp";
+    std::string sScheduler = "ns3::MapScheduler";
+    uint32_t nPendingEvents = 1000000;
+    std::string sLabel = "";
+    std::string sOutput = "";
+
+    CommandLine cmd;
+    cmd.AddValue ("topology", "fattree, hierarchical, cube, cube-dimordered or mesh-dimordered", sTopology);
+    cmd.AddValue ("nodes", "Number of hosts", nHosts);
+    cmd.AddValue ("workload", "all-to-all or neighbor", sWorkload);
+    cmd.AddValue ("fanout", "Receivers of every host in the all-to-all workload", nFanout);
+    cmd.AddValue ("psize", "Request size in bytes", nPacketSize);
+    cmd.AddValue ("iter", "Iterations of every sender", nIterations);
+    cmd.AddValue ("isize", "Interval between iterations in us", nInterval);
+    cmd.AddValue ("l4", "udp, tcp, or homa (dimension-ordered topologies only)", sL4);
+    cmd.AddValue ("scheduler", "Event scheduler type", sScheduler);
+    cmd.AddValue ("pending", "Events scheduled to measure the bytes per pending event, 0 to skip", nPendingEvents);
+    cmd.AddValue ("label", "Free text copied to the result, e.g. the commit", sLabel);
+    cmd.AddValue ("output", "Also append the result to this file", sOutput);
+    cmd.Parse (argc, argv);
+
+    bool bTree = sTopology == "fattree" || sTopology == "hierarchical";
+    bool bDimOrdered = sTopology == "cube-dimordered" || sTopology == "mesh-dimordered";
+    if (!bTree && !bDimOrdered && sTopology != "cube")
+    {
+        std::cerr << "Invalid --topology " << sTopology << "\n";
+        return 1;
+    }
+    if (sWorkload != "all-to-all" && sWorkload != "neighbor")
+    {
+        std::cerr << "Invalid --workload " << sWorkload << "\n";
+        return 1;
+    }
+    if ((sL4 != "udp" && sL4 != "tcp" && sL4 != "homa") || (sL4 == "homa" && !bDimOrdered))
+    {
+        std::cerr << "Invalid --l4 " << sL4 << "\n";
+        return 1;
+    }
+    if (nHosts < 2)
+    {
+        std::cerr << "The benchmark needs at least 2 hosts\n";
+        return 1;
+    }
+    nFanout = std::min (nFanout, nHosts - 1);
+
+    Time::SetResolution (Time::NS);
+    GlobalValue::Bind ("SchedulerType", StringValue (sScheduler));
+    Config::SetDefault ("ns3::DropTailQueue::Mode", StringValue ("QUEUE_MODE_PACKETS"));
+    Config::SetDefault ("ns3::DropTailQueue::MaxPackets", UintegerValue (20000));
+
+    double pendingEventBytes = MeasurePendingEventBytes (nPendingEvents);
+    uint64_t baseHeapBytes = GetHeapBytes ();
+
+    PointToPointHelper pointToPoint;
+    pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("100Gbps"));
+    pointToPoint.SetChannelAttribute ("Delay", StringValue ("500ns"));
+
+    // Build: nodes, links, stacks and addresses
+    WallClock buildClock;
+    buildClock.Start ();
+    PointToPointTopoHelper *topology;
+    DataCenterApp::NETWORK_STACK stack;
+    uint32_t x = 0, y = 0, z = 0;
+    if (sTopology == "fattree")
+    {
+        topology = new PointToPointFattreeHelper (nHosts, pointToPoint);
+    }
+    else if (sTopology == "hierarchical")
+    {
+        // "balanced" of getHierarhicalValues in simulate.py
+        uint32_t nEdge = 1;
+        uint32_t nAgg = 0;
+        if (nHosts > FANOUT * FANOUT)
+        {
+            nEdge = std::ceil (std::pow (double (nHosts), 0.66666));
+            nAgg = std::ceil (std::pow (double (nHosts), 0.33333));
+        }
+        else if (nHosts > FANOUT)
+        {
+            nEdge = std::ceil (std::sqrt (double (nHosts)));
+            nAgg = 1;
+        }
+        topology = new PointToPointHierarchicalHelper (nHosts, nEdge, nAgg, 1, 1, pointToPoint);
+    }
+    else
+    {
+        GetGridDimensions (nHosts, sTopology == "mesh-dimordered", x, y, z);
+        if (bDimOrdered)
+            topology = new PointToPointCubeDimorderedHelper (x, y, z, true, pointToPoint);
+        else
+            topology = new PointToPointCubeHelper (x, y, z, true, pointToPoint);
+    }
+    if (bDimOrdered)
+        stack = sL4 == "udp" ? DataCenterApp::UDP_DO_STACK :
+                sL4 == "homa" ? DataCenterApp::HOMA_DO_STACK : DataCenterApp::TCP_DO_STACK;
+    else
+        stack = sL4 == "udp" ? DataCenterApp::UDP_IP_STACK : DataCenterApp::TCP_IP_STACK;
+
+    InternetStackHelper internet;
+    topology->InstallStack (internet);
+    Ipv4AddressHelper nodeAddresses;
+    Ipv4AddressHelper linkAddresses;
+    nodeAddresses.SetBase ("0.0.0.0", "255.255.0.0");
+    linkAddresses.SetBase ("128.0.0.0", "255.255.0.0");
+    topology->AssignIpv4Addresses (nodeAddresses, linkAddresses);
+    double buildMs = buildClock.End ();
+
+    WallClock routingClock;
+    routingClock.Start ();
+    if (!bDimOrdered && !topology->PopulateRoutingTables (false))
+        Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+    double routingMs = routingClock.End ();
+    uint32_t nNodes = NodeList::GetNNodes ();
+    uint64_t networkHeapBytes = GetHeapBytes ();
+
+    // Applications
+    WallClock setupClock;
+    setupClock.Start ();
+    srand (100);
+    std::minstd_rand random (100);
+    uint64_t nRequests = 0;
+    for (uint32_t i = 0; i < nHosts; i++)
+    {
+        std::vector<uint32_t> receivers;
+        if (sWorkload == "all-to-all")
+        {
+            std::unordered_set<uint32_t> chosen;
+            while (receivers.size () < nFanout)
+            {
+                uint32_t receiver = random () % nHosts;
+                if (receiver != i && chosen.insert (receiver).second)
+                    receivers.push_back (receiver);
+            }
+        }
+        else if (bTree)
+        {
+            for (uint32_t j = i - i % FANOUT; j < std::min (i - i % FANOUT + FANOUT, nHosts); j++)
+            {
+                if (j != i)
+                    receivers.push_back (j);
+            }
+        }
+        else
+        {
+            uint32_t px = i % x;
+            uint32_t py = (i / x) % y;
+            uint32_t pz = i / (x * y);
+            AddGridNeighbor (receivers, i, pz * x * y + py * x + (px + 1) % x, nHosts);
+            AddGridNeighbor (receivers, i, pz * x * y + py * x + (px + x - 1) % x, nHosts);
+            AddGridNeighbor (receivers, i, pz * x * y + ((py + 1) % y) * x + px, nHosts);
+            AddGridNeighbor (receivers, i, pz * x * y + ((py + y - 1) % y) * x + px, nHosts);
+            AddGridNeighbor (receivers, i, ((pz + 1) % z) * x * y + py * x + px, nHosts);
+            AddGridNeighbor (receivers, i, ((pz + z - 1) % z) * x * y + py * x + px, nHosts);
+        }
+
+        DataCenterApp::SendParams params;
+        params.m_sending = !receivers.empty ();
+        for (uint32_t j = 0; j < receivers.size (); j++)
+            params.m_nodes.push_back (topology->GetAddress (receivers[j]));
+        params.m_receivers = DataCenterApp::ALL_IN_LIST;
+        params.m_nReceivers = receivers.size ();
+        params.m_sendPattern = DataCenterApp::FIXED_INTERVAL;
+        params.m_sendInterval = MicroSeconds (nInterval);
+        params.m_packetSize = nPacketSize;
+        params.m_nIterations = nIterations;
+        nRequests += uint64_t (receivers.size ()) * nIterations;
+
+        Ptr<DataCenterApp> app = CreateObject<DataCenterApp> ();
+        if (!app->Setup (params, i, stack, true))
+        {
+            std::cerr << "Setup of host " << i << " failed\n";
+            return 1;
+        }
+        topology->GetNode (i)->AddApplication (app);
+        app->SetStartTime (Seconds (0.));
+        app->SetStopTime (Seconds (100000.));
+    }
+    PortLoadCounters portLoad;
+    portLoad.Install ();
+    double setupMs = setupClock.End ();
+    uint64_t setupHeapBytes = GetHeapBytes ();
+
+    WallClock runClock;
+    runClock.Start ();
+    Simulator::Run ();
+    double runMs = runClock.End ();
+    uint64_t nEvents = Simulator::GetEventCount ();
+    uint64_t nPackets = portLoad.GetTotalPackets ();
+    Simulator::Destroy ();
+    uint64_t nMessages = DataCenterApp::GetGlobalLatencyHistogram ().GetCount ();
+
+    std::ostringstream result;
+    result << "{\"label\": " << JsonString (sLabel) <<
+              ", \"topology\": " << JsonString (sTopology) <<
+              ", \"hosts\": " << nHosts <<
+              ", \"nodes\": " << nNodes <<
+              ", \"ports\": " << portLoad.GetNPorts () <<
+              ", \"workload\": " << JsonString (sWorkload) <<
+              ", \"fanout\": " << nFanout <<
+              ", \"packet_size\": " << nPacketSize <<
+              ", \"iterations\": " << nIterations <<
+              ", \"l4\": " << JsonString (sL4) <<
+              ", \"scheduler\": " << JsonString (sScheduler) <<
+              ", \"build_ms\": " << buildMs <<
+              ", \"routing_ms\": " << routingMs <<
+              ", \"setup_ms\": " << setupMs <<
+              ", \"run_ms\": " << runMs <<
+              ", \"events\": " << nEvents <<
+              ", \"events_per_second\": " << PerSecond (nEvents, runMs) <<
+              ", \"requests\": " << nRequests <<
+              ", \"messages_received\": " << nMessages <<
+              ", \"packets_sent\": " << nPackets <<
+              ", \"packets_per_second\": " << PerSecond (nPackets, runMs) <<
+              ", \"simulated_seconds\": " << DataCenterApp::GetGlobalSeconds () <<
+              ", \"peak_rss_kb\": " << GetPeakRssKb () <<
+              ", \"bytes_per_node\": " << BytesPer (networkHeapBytes, baseHeapBytes, nNodes) <<
+              ", \"app_bytes_per_host\": " << BytesPer (setupHeapBytes, networkHeapBytes, nHosts) <<
+              ", \"bytes_per_pending_event\": " << pendingEventBytes << "}";
+    std::cout << result.str () << std::endl;
+    if (!sOutput.empty ())
+    {
+        std::ofstream out (sOutput.c_str (), std::ios::app);
+        out << result.str () << "\n";
+        if (!out)
+        {
+            std::cerr << "Could not write " << sOutput << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -120,7 +120,7 @@ DimensionOrderedInterfaceContainer
 SetupDimensionOrderedStack (NodeContainer &nodes, NetDeviceContainer &devices)
 {
     DimensionOrderedStackHelper stack;
-    stack.Install (nodes, std::make_tuple(1,1,0), std::make_tuple(2,1,0));
+    stack.Install (nodes, DimensionOrderedAddress (1, 1, 0), DimensionOrderedAddress (2, 1, 0));
 
     DimensionOrderedAddressHelper::AddressAssignmentList assignList;
 
@@ -0,0 +1,306 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "uinteger.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+namespace {
+
+// Rungs below the first one, and buckets of one rung
+const uint32_t MAX_RUNGS = 8;
+const uint32_t MAX_BUCKETS = 65536;
+
+struct EventLess
+{
+  bool operator () (const Scheduler::Event &a, const Scheduler::Event &b) const
+  {
+    return a.key < b.key;
+  }
+};
+
+} // anonymous namespace
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .AddConstructor<LadderScheduler> ()
+    .AddAttribute ("SpawnThreshold",
+                   "Buckets with more events than this are spread over a finer rung "
+                   "instead of being sorted into Bottom.",
+                   UintegerValue (50),
+                   MakeUintegerAccessor (&LadderScheduler::m_spawnThreshold),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_spawnThreshold (50),
+    m_topMin (0),
+    m_topMax (0),
+    m_topStart (0),
+    m_rungs (MAX_RUNGS),
+    m_nRungs (0),
+    m_size (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+bool
+LadderScheduler::FindBucket (uint64_t ts, uint32_t &rung, uint32_t &bucket) const
+{
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      const Rung &r = m_rungs[i];
+      if (ts < r.start + r.current * r.width)
+        {
+          continue;
+        }
+      uint64_t index = std::min<uint64_t> ((ts - r.start) / r.width, r.nBuckets - 1);
+      // Otherwise the last bucket has been dequeued already and the event
+      // falls in the last bucket of a finer rung, or in Bottom
+      if (index >= r.current)
+        {
+          rung = i;
+          bucket = index;
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+LadderScheduler::FillRung (Rung &rung, Bucket &events, uint64_t minTs, uint64_t maxTs)
+{
+  NS_LOG_FUNCTION (this << events.size () << minTs << maxTs);
+  uint64_t span = maxTs - minTs;
+  uint64_t nBuckets = std::min<uint64_t> (events.size (), MAX_BUCKETS);
+  rung.start = minTs;
+  rung.width = span / nBuckets + 1;
+  rung.nBuckets = span / rung.width + 1;
+  rung.current = 0;
+  rung.count = events.size ();
+  if (rung.buckets.size () < rung.nBuckets)
+    {
+      rung.buckets.resize (rung.nBuckets);
+    }
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      rung.buckets[(i->key.m_ts - minTs) / rung.width].push_back (*i);
+    }
+  events.clear ();
+}
+
+void
+LadderScheduler::Refill (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_bottom.empty ());
+  while (true)
+    {
+      if (m_nRungs == 0)
+        {
+          if (m_top.empty ())
+            {
+              return;
+            }
+          Rung &first = m_rungs[0];
+          FillRung (first, m_top, m_topMin, m_topMax);
+          m_topStart = first.start + first.nBuckets * first.width;
+          m_nRungs = 1;
+        }
+
+      Rung &rung = m_rungs[m_nRungs - 1];
+      if (rung.count == 0)
+        {
+          m_nRungs--;
+          continue;
+        }
+      while (rung.buckets[rung.current].empty ())
+        {
+          rung.current++;
+        }
+      Bucket &bucket = rung.buckets[rung.current];
+      rung.current++;
+      rung.count -= bucket.size ();
+
+      uint64_t minTs = bucket.front ().key.m_ts;
+      uint64_t maxTs = minTs;
+      for (Bucket::const_iterator i = bucket.begin (); i != bucket.end (); ++i)
+        {
+          minTs = std::min (minTs, i->key.m_ts);
+          maxTs = std::max (maxTs, i->key.m_ts);
+        }
+      if (bucket.size () > m_spawnThreshold && minTs < maxTs && m_nRungs < MAX_RUNGS)
+        {
+          NS_LOG_LOGIC ("spawn rung " << m_nRungs << " for " << bucket.size () << " events");
+          FillRung (m_rungs[m_nRungs], bucket, minTs, maxTs);
+          m_nRungs++;
+          continue;
+        }
+
+      NS_LOG_LOGIC ("move " << bucket.size () << " events to bottom");
+      m_bottom.assign (bucket.begin (), bucket.end ());
+      bucket.clear ();
+      if (!std::is_sorted (m_bottom.begin (), m_bottom.end (), EventLess ()))
+        {
+          std::sort (m_bottom.begin (), m_bottom.end (), EventLess ());
+        }
+      // Later events in the range of an exhausted rung go to Bottom
+      if (rung.current == rung.nBuckets)
+        {
+          m_nRungs--;
+        }
+      return;
+    }
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  uint64_t ts = ev.key.m_ts;
+  uint32_t rung;
+  uint32_t bucket;
+  if (ts >= m_topStart)
+    {
+      if (m_top.empty ())
+        {
+          m_topMin = m_topMax = ts;
+        }
+      m_topMin = std::min (m_topMin, ts);
+      m_topMax = std::max (m_topMax, ts);
+      m_top.push_back (ev);
+    }
+  else if (FindBucket (ts, rung, bucket))
+    {
+      m_rungs[rung].buckets[bucket].push_back (ev);
+      m_rungs[rung].count++;
+    }
+  else
+    {
+      m_bottom.insert (std::upper_bound (m_bottom.begin (), m_bottom.end (), ev, EventLess ()), ev);
+      // Keep sorted inserts short by spreading a long Bottom over a new
+      // rung, unless its events all have the same timestamp
+      if (m_bottom.size () > m_spawnThreshold && m_nRungs < MAX_RUNGS
+          && m_bottom.front ().key.m_ts < m_bottom.back ().key.m_ts)
+        {
+          NS_LOG_LOGIC ("spawn rung " << m_nRungs << " for " << m_bottom.size () << " bottom events");
+          uint64_t minTs = m_bottom.front ().key.m_ts;
+          uint64_t maxTs = m_bottom.back ().key.m_ts;
+          m_spill.assign (m_bottom.begin (), m_bottom.end ());
+          m_bottom.clear ();
+          FillRung (m_rungs[m_nRungs], m_spill, minTs, maxTs);
+          m_nRungs++;
+        }
+    }
+  m_size++;
+  if (m_bottom.empty ())
+    {
+      Refill ();
+    }
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_size == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  return m_bottom.front ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Event next = m_bottom.front ();
+  m_bottom.pop_front ();
+  m_size--;
+  if (m_bottom.empty () && m_size > 0)
+    {
+      Refill ();
+    }
+  return next;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  uint64_t ts = ev.key.m_ts;
+  uint32_t rung;
+  uint32_t bucket;
+  Bucket *events = 0;
+  if (ts >= m_topStart)
+    {
+      events = &m_top;
+    }
+  else if (FindBucket (ts, rung, bucket))
+    {
+      events = &m_rungs[rung].buckets[bucket];
+      m_rungs[rung].count--;
+    }
+  if (events != 0)
+    {
+      Bucket::iterator i = events->begin ();
+      while (i != events->end () && i->key.m_uid != ev.key.m_uid)
+        {
+          ++i;
+        }
+      NS_ASSERT (i != events->end () && i->impl == ev.impl);
+      *i = events->back ();
+      events->pop_back ();
+    }
+  else
+    {
+      std::deque<Event>::iterator i = std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, EventLess ());
+      NS_ASSERT (i != m_bottom.end () && i->key.m_uid == ev.key.m_uid);
+      m_bottom.erase (i);
+    }
+  m_size--;
+  if (m_bottom.empty () && m_size > 0)
+    {
+      Refill ();
+    }
+}
+
+} // namespace ns3
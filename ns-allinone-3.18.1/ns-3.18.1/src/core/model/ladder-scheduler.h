@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <deque>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue of "Ladder Queue: An
+ * O(1) Priority Queue Structure for Large-Scale Discrete Event Simulation"
+ * by Tang, Goh and Thng (2005). Events far in the future are appended to
+ * an unsorted Top list. When the near future runs out, Top is spread over
+ * the buckets of a rung whose bucket width is the span of Top divided by
+ * the number of events in it. The first non-empty bucket is either sorted
+ * into the Bottom list, from which events are dequeued, or, if it holds
+ * more than SpawnThreshold events, spread over a finer rung sized from the
+ * span of that bucket. Events inserted before the buckets still to be
+ * dequeued are sorted into Bottom, which is itself spread over a new rung
+ * when it grows past SpawnThreshold. Inserts and removals are O(1)
+ * amortised.
+ *
+ * Events are only ever sorted when they reach Bottom, by timestamp and
+ * then by uid, so events with the same timestamp run in the order they
+ * were scheduled. A bucket whose events all have the same timestamp goes
+ * to Bottom whatever its size, and as the uids of a synchronized burst
+ * are already in order it is not sorted at all.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  LadderScheduler ();
+  virtual ~LadderScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Event PeekNext (void) const;
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+
+private:
+  typedef std::vector<Event> Bucket;
+
+  struct Rung
+  {
+    uint64_t start;
+    uint64_t width;
+    // Index of the next bucket to dequeue, the buckets before it are empty
+    uint32_t current;
+    uint32_t nBuckets;
+    uint32_t count;
+    // The last bucket also takes the events up to the start of the
+    // current bucket of the rung above
+    std::vector<Bucket> buckets;
+  };
+
+  // Rung and bucket an event goes to, false for Bottom
+  bool FindBucket (uint64_t ts, uint32_t &rung, uint32_t &bucket) const;
+  void FillRung (Rung &rung, Bucket &events, uint64_t minTs, uint64_t maxTs);
+  // Move the earliest events to Bottom, which must be empty
+  void Refill (void);
+
+  uint32_t m_spawnThreshold;
+
+  Bucket m_top;
+  uint64_t m_topMin;
+  uint64_t m_topMax;
+  // Events at or after this timestamp go to Top
+  uint64_t m_topStart;
+  // Only the first m_nRungs are in use, the others keep their buckets
+  std::vector<Rung> m_rungs;
+  uint32_t m_nRungs;
+  // Sorted, not empty whenever the scheduler is not
+  std::deque<Event> m_bottom;
+  // Bottom events on their way to a new rung
+  Bucket m_spill;
+  uint32_t m_size;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
@@ -23,6 +23,10 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include <set>
+#include <utility>
+#include <vector>
 
 using namespace ns3;
 
@@ -131,7 +135,10 @@ SimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (!a.IsExpired (), true, "");
   Simulator::Cancel (a);
   NS_TEST_EXPECT_MSG_EQ (a.IsExpired (), true, "");
+  uint64_t eventCount = Simulator::GetEventCount ();
   Simulator::Run ();
+  // The canceled A is still taken off the event list, the removed C is not
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetEventCount () - eventCount, 3, "A, B and D should have been executed");
   NS_TEST_EXPECT_MSG_EQ (m_a, true, "Event A did not run ?");
   NS_TEST_EXPECT_MSG_EQ (m_b, true, "Event B did not run ?");
   NS_TEST_EXPECT_MSG_EQ (m_c, true, "Event C did not run ?");
@@ -459,6 +466,110 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+private:
+  uint32_t Random (uint32_t max);
+  ObjectFactory m_schedulerFactory;
+  uint32_t m_random;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check the order of bursts, ties and removals, " + schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory),
+    m_random (1)
+{
+}
+
+uint32_t
+SchedulerOrderTestCase::Random (uint32_t max)
+{
+  m_random = m_random * 1103515245 + 12345;
+  return (m_random >> 8) % max;
+}
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  // Pending events in the order they must come out: by timestamp, then uid
+  std::set<std::pair<uint64_t, uint32_t> > expected;
+  std::vector<Scheduler::Event> pending;
+  uint64_t now = 0;
+  uint32_t uid = 4;
+  for (uint32_t step = 0; step < 20000; step++)
+    {
+      uint32_t action = Random (100);
+      if (action < 50 || expected.empty ())
+        {
+          // Mostly near events, some far ones and synchronized bursts
+          uint32_t kind = Random (10);
+          uint64_t ts = now;
+          uint32_t count = 1;
+          if (kind < 5)
+            {
+              ts += Random (1000);
+            }
+          else if (kind < 8)
+            {
+              ts += Random (1000000);
+            }
+          else if (kind == 8)
+            {
+              ts += Random (100);
+              count = 100 + Random (200);
+            }
+          for (uint32_t i = 0; i < count; i++)
+            {
+              Scheduler::Event ev;
+              ev.impl = 0;
+              ev.key.m_ts = ts;
+              ev.key.m_uid = uid++;
+              ev.key.m_context = 0;
+              scheduler->Insert (ev);
+              expected.insert (std::make_pair (ts, ev.key.m_uid));
+              pending.push_back (ev);
+            }
+        }
+      else if (action < 55)
+        {
+          // Remove a random pending event, if it has not run yet
+          uint32_t index = Random (pending.size ());
+          Scheduler::Event ev = pending[index];
+          pending[index] = pending.back ();
+          pending.pop_back ();
+          if (expected.erase (std::make_pair (ev.key.m_ts, ev.key.m_uid)) == 1)
+            {
+              scheduler->Remove (ev);
+            }
+        }
+      else
+        {
+          NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), false, "Scheduler lost events");
+          Scheduler::Event next = scheduler->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (next.key.m_ts, expected.begin ()->first, "Events out of timestamp order");
+          NS_TEST_ASSERT_MSG_EQ (next.key.m_uid, expected.begin ()->second, "Events with the same timestamp "
+                                 "out of scheduling order");
+          expected.erase (expected.begin ());
+          now = next.key.m_ts;
+        }
+      if (pending.size () > 4 * expected.size () + 1000)
+        {
+          pending.clear ();
+        }
+    }
+  while (!expected.empty ())
+    {
+      Scheduler::Event next = scheduler->RemoveNext ();
+      NS_TEST_ASSERT_MSG_EQ (next.key.m_uid, expected.begin ()->second, "Events out of order");
+      expected.erase (expected.begin ());
+    }
+  NS_TEST_EXPECT_MSG_EQ (scheduler->IsEmpty (), true, "Scheduler has extra events");
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +586,16 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -18,6 +18,7 @@
 
 #include <vector>
 #include <iomanip>
+#include <algorithm>
 #include "ns3/names.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
@@ -27,6 +28,9 @@
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/node.h"
+#include "ns3/hash-fnv.h"
 #include "ipv4-global-routing.h"
 #include "global-route-manager.h"
 
@@ -51,13 +55,28 @@ Ipv4GlobalRouting::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&Ipv4GlobalRouting::m_respondToInterfaceEvents),
                    MakeBooleanChecker ())
+    .AddAttribute ("FlowEcmpRouting",
+                   "Set to true if packets are routed among ECMP by a hash of their addresses, protocol and ports, so that the packets of a flow follow a single route; takes precedence over RandomEcmpRouting",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Ipv4GlobalRouting::m_flowEcmpRouting),
+                   MakeBooleanChecker ())
+    .AddAttribute ("EcmpHashFunction",
+                   "The hash function of FlowEcmpRouting",
+                   EnumValue (ECMP_HASH_MURMUR3),
+                   MakeEnumAccessor (&Ipv4GlobalRouting::m_ecmpHashFunction),
+                   MakeEnumChecker (ECMP_HASH_MURMUR3, "Murmur3",
+                                    ECMP_HASH_FNV1A, "Fnv1a"))
   ;
   return tid;
 }
 
 Ipv4GlobalRouting::Ipv4GlobalRouting () 
   : m_randomEcmpRouting (false),
-    m_respondToInterfaceEvents (false)
+    m_respondToInterfaceEvents (false),
+    m_flowEcmpRouting (false),
+    m_ecmpHashFunction (ECMP_HASH_MURMUR3),
+    m_fnv1aHasher (Create<Hash::Function::Fnv1a> ()),
+    m_routeIndexValid (false)
 {
   NS_LOG_FUNCTION (this);
 
@@ -78,6 +97,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  m_routeIndexValid = false;
 }
 
 void 
@@ -88,6 +108,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  m_routeIndexValid = false;
 }
 
 void 
@@ -103,6 +124,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_routeIndexValid = false;
 }
 
 void 
@@ -116,6 +138,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_routeIndexValid = false;
 }
 
 void 
@@ -135,23 +158,31 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
 
 
 Ptr<Ipv4Route>
-Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
+Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif,
+                                 const Ipv4Header *header, Ptr<const Packet> p)
 {
-  NS_LOG_FUNCTION (this << dest << oif);
+  NS_LOG_FUNCTION (this << dest << oif << header << p);
   NS_LOG_LOGIC ("Looking for route for destination " << dest);
   Ptr<Ipv4Route> rtentry = 0;
   // store all available routes that bring packets to their destination
   typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
   RouteVec_t allRoutes;
 
+  if (!m_routeIndexValid)
+    {
+      BuildRouteIndex ();
+    }
+
   NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin (); 
-       i != m_hostRoutes.end (); 
-       i++) 
+  std::unordered_map<uint32_t, std::vector<Ipv4RoutingTableEntry *> >::const_iterator host =
+    m_hostRouteIndex.find (dest.Get ());
+  if (host != m_hostRouteIndex.end ())
     {
-      NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (dest)) 
+      for (RouteVec_t::const_iterator i = host->second.begin (); 
+           i != host->second.end (); 
+           i++) 
         {
+          NS_ASSERT ((*i)->IsHost ());
           if (oif != 0)
             {
               if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
@@ -167,25 +198,40 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
   if (allRoutes.size () == 0) // if no host route is found
     {
       NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
-           j != m_networkRoutes.end (); 
+      // a destination may match networks of several masks, keep them in
+      // the order of m_networkRoutes
+      IndexedRoutes matches;
+      uint32_t nMasks = 0;
+      for (std::vector<NetworkRouteIndex>::const_iterator j = m_networkRouteIndex.begin (); 
+           j != m_networkRouteIndex.end (); 
            j++) 
         {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry)) 
+          std::unordered_map<uint32_t, IndexedRoutes>::const_iterator network =
+            j->networks.find (dest.CombineMask (j->mask).Get ());
+          if (network != j->networks.end ())
             {
-              if (oif != 0)
+              matches.insert (matches.end (), network->second.begin (), network->second.end ());
+              nMasks++;
+            }
+        }
+      if (nMasks > 1)
+        {
+          std::sort (matches.begin (), matches.end ());
+        }
+      for (IndexedRoutes::const_iterator j = matches.begin (); 
+           j != matches.end (); 
+           j++) 
+        {
+          if (oif != 0)
+            {
+              if (oif != m_ipv4->GetNetDevice (j->second->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
                 }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
             }
+          allRoutes.push_back (j->second);
+          NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << j->second);
         }
     }
   if (allRoutes.size () == 0)  // consider external if no host/network found
@@ -214,11 +260,15 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
     }
   if (allRoutes.size () > 0 ) // if route(s) is found
     {
-      // pick up one of the routes uniformly at random if random
-      // ECMP routing is enabled, or always select the first route
-      // consistently if random ECMP routing is disabled
+      // pick up one of the routes by the hash of the flow if flow ECMP
+      // routing is enabled, uniformly at random if random ECMP routing
+      // is enabled, or always select the first route consistently
       uint32_t selectIndex;
-      if (m_randomEcmpRouting)
+      if (m_flowEcmpRouting && header != 0 && allRoutes.size () > 1)
+        {
+          selectIndex = GetFlowHash (*header, p) % allRoutes.size ();
+        }
+      else if (m_randomEcmpRouting)
         {
           selectIndex = m_rand->GetInteger (0, allRoutes.size ()-1);
         }
@@ -243,6 +293,62 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
     }
 }
 
+void
+Ipv4GlobalRouting::BuildRouteIndex (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_hostRouteIndex.clear ();
+  m_networkRouteIndex.clear ();
+  for (HostRoutesCI i = m_hostRoutes.begin (); 
+       i != m_hostRoutes.end (); 
+       i++) 
+    {
+      m_hostRouteIndex[(*i)->GetDest ().Get ()].push_back (*i);
+    }
+  uint32_t position = 0;
+  for (NetworkRoutesCI j = m_networkRoutes.begin (); 
+       j != m_networkRoutes.end (); 
+       j++, position++) 
+    {
+      Ipv4Mask mask = (*j)->GetDestNetworkMask ();
+      std::vector<NetworkRouteIndex>::iterator index = m_networkRouteIndex.begin ();
+      while (index != m_networkRouteIndex.end () && index->mask != mask)
+        {
+          index++;
+        }
+      if (index == m_networkRouteIndex.end ())
+        {
+          index = m_networkRouteIndex.insert (index, NetworkRouteIndex ());
+          index->mask = mask;
+        }
+      uint32_t network = (*j)->GetDestNetwork ().CombineMask (mask).Get ();
+      index->networks[network].push_back (std::make_pair (position, *j));
+    }
+  m_routeIndexValid = true;
+}
+
+uint32_t
+Ipv4GlobalRouting::GetFlowHash (const Ipv4Header &header, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << header << p);
+  uint32_t key[5];
+  uint32_t size = 4 * sizeof (uint32_t);
+  key[0] = m_ipv4->GetObject<Node> ()->GetId ();
+  key[1] = header.GetSource ().Get ();
+  key[2] = header.GetDestination ().Get ();
+  key[3] = header.GetProtocol ();
+  // TCP and UDP headers start with the source and destination ports,
+  // which only the first fragment carries
+  if (p != 0 && (header.GetProtocol () == 6 || header.GetProtocol () == 17)
+      && header.GetFragmentOffset () == 0 && p->GetSize () >= 4)
+    {
+      p->CopyData (reinterpret_cast<uint8_t *> (&key[4]), 4);
+      size += sizeof (uint32_t);
+    }
+  Hasher &hasher = (m_ecmpHashFunction == ECMP_HASH_FNV1A) ? m_fnv1aHasher : m_murmur3Hasher;
+  return hasher.clear ().GetHash32 (reinterpret_cast<const char *> (key), size);
+}
+
 uint32_t 
 Ipv4GlobalRouting::GetNRoutes (void) const
 {
@@ -307,6 +413,7 @@ void
 Ipv4GlobalRouting::RemoveRoute (uint32_t index)
 {
   NS_LOG_FUNCTION (this << index);
+  m_routeIndexValid = false;
   if (index < m_hostRoutes.size ())
     {
       uint32_t tmp = 0;
@@ -390,6 +497,9 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  m_hostRouteIndex.clear ();
+  m_networkRouteIndex.clear ();
+  m_routeIndexValid = false;
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -459,7 +569,7 @@ Ipv4GlobalRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<Net
 // See if this is a unicast packet we have a route for.
 //
   NS_LOG_LOGIC ("Unicast destination- looking up");
-  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination (), oif);
+  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination (), oif, &header);
   if (rtentry)
     {
       sockerr = Socket::ERROR_NOTERROR;
@@ -536,7 +646,7 @@ Ipv4GlobalRouting::RouteInput  (Ptr<const Packet> p, const Ipv4Header &header, P
     }
   // Next, try to find a route
   NS_LOG_LOGIC ("Unicast destination- looking up global route");
-  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination ());
+  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination (), 0, &header, p);
   if (rtentry != 0)
     {
       NS_LOG_LOGIC ("Found unicast destination- calling unicast callback");
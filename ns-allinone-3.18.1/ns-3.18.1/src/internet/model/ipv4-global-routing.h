@@ -22,12 +22,15 @@
 
 #include <list>
 #include <stdint.h>
+#include <unordered_map>
+#include <vector>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/hash.h"
 
 namespace ns3 {
 
@@ -69,6 +72,13 @@ class Node;
 class Ipv4GlobalRouting : public Ipv4RoutingProtocol
 {
 public:
+  /// Hash functions for FlowEcmpRouting
+  enum EcmpHashFunction
+  {
+    ECMP_HASH_MURMUR3,
+    ECMP_HASH_FNV1A
+  };
+
   static TypeId GetTypeId (void);
 /**
  * \brief Construct an empty Ipv4GlobalRouting routing protocol,
@@ -231,6 +241,12 @@ private:
   bool m_respondToInterfaceEvents;
   /// A uniform random number generator for randomly routing packets among ECMP 
   Ptr<UniformRandomVariable> m_rand;
+  /// Set to true if packets are routed among ECMP by a hash of their flow
+  bool m_flowEcmpRouting;
+  /// Hash function of the flows
+  enum EcmpHashFunction m_ecmpHashFunction;
+  Hasher m_murmur3Hasher;
+  Hasher m_fnv1aHasher;
 
   typedef std::list<Ipv4RoutingTableEntry *> HostRoutes;
   typedef std::list<Ipv4RoutingTableEntry *>::const_iterator HostRoutesCI;
@@ -242,12 +258,51 @@ private:
   typedef std::list<Ipv4RoutingTableEntry *>::const_iterator ASExternalRoutesCI;
   typedef std::list<Ipv4RoutingTableEntry *>::iterator ASExternalRoutesI;
 
-  Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
+  /// Network routes with their position in m_networkRoutes
+  typedef std::vector<std::pair<uint32_t, Ipv4RoutingTableEntry *> > IndexedRoutes;
+
+  /// Network routes sharing one mask, by masked destination network
+  struct NetworkRouteIndex
+  {
+    Ipv4Mask mask;
+    std::unordered_map<uint32_t, IndexedRoutes> networks;
+  };
+
+  /**
+   * \param header if not 0, and FlowEcmpRouting is set, select among
+   * equal cost routes by the flow of the packet
+   * \param p if not 0, the packet after the IP header, for the ports
+   */
+  Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0,
+                               const Ipv4Header *header = 0, Ptr<const Packet> p = 0);
+
+  /**
+   * \brief Hash of the addresses, protocol and, when p starts with a TCP
+   * or UDP header, ports of a packet, salted with the node id so that
+   * successive hops do not all make the same choice.
+   */
+  uint32_t GetFlowHash (const Ipv4Header &header, Ptr<const Packet> p);
+
+  /**
+   * \brief Rebuild the host and network route index from the route lists.
+   *
+   * Lookups return the same routes, in the same order, as a linear scan
+   * of the lists: every host route to the destination, else every
+   * matching network route whatever its prefix length.
+   */
+  void BuildRouteIndex (void);
 
   HostRoutes m_hostRoutes;
   NetworkRoutes m_networkRoutes;
   ASExternalRoutes m_ASexternalRoutes; // External routes imported
 
+  /// False when the routes changed since the index was built
+  bool m_routeIndexValid;
+  /// Host routes by destination address, in list order
+  std::unordered_map<uint32_t, std::vector<Ipv4RoutingTableEntry *> > m_hostRouteIndex;
+  /// One entry per distinct network mask
+  std::vector<NetworkRouteIndex> m_networkRouteIndex;
+
   Ptr<Ipv4> m_ipv4;
 };
 
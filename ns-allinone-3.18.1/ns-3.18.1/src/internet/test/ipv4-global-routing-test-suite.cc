@@ -0,0 +1,201 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+
+using namespace ns3;
+
+/*
+ * The route index behind Ipv4GlobalRouting::LookupGlobal must select the
+ * same route as a scan of the route lists: host routes first, then the
+ * first matching network route in insertion order, whatever its mask.
+ */
+class Ipv4GlobalRoutingLookupTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingLookupTestCase ();
+  virtual void DoRun (void);
+
+private:
+  Ptr<NetDevice> Lookup (const char *dest, Ptr<NetDevice> oif = 0);
+
+  Ptr<Ipv4GlobalRouting> m_routing;
+};
+
+Ipv4GlobalRoutingLookupTestCase::Ipv4GlobalRoutingLookupTestCase ()
+  : TestCase ("Host and network route lookup")
+{
+}
+
+Ptr<NetDevice>
+Ipv4GlobalRoutingLookupTestCase::Lookup (const char *dest, Ptr<NetDevice> oif)
+{
+  Ipv4Header header;
+  header.SetDestination (Ipv4Address (dest));
+  Socket::SocketErrno sockerr;
+  Ptr<Ipv4Route> route = m_routing->RouteOutput (0, header, oif, sockerr);
+  return route == 0 ? 0 : route->GetOutputDevice ();
+}
+
+void
+Ipv4GlobalRoutingLookupTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<Ipv4L3Protocol> ipv4 = CreateObject<Ipv4L3Protocol> ();
+  node->AggregateObject (ipv4);
+  m_routing = CreateObject<Ipv4GlobalRouting> ();
+  ipv4->SetRoutingProtocol (m_routing);
+
+  Ptr<SimpleNetDevice> dev[2];
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      dev[i] = CreateObject<SimpleNetDevice> ();
+      dev[i]->SetAddress (Mac48Address::Allocate ());
+      node->AddDevice (dev[i]);
+      uint32_t interface = ipv4->AddInterface (dev[i]);
+      Ipv4Address local ((10 << 24) | (i << 16) | 1);
+      ipv4->AddAddress (interface, Ipv4InterfaceAddress (local, Ipv4Mask ("255.255.0.0")));
+      ipv4->SetUp (interface);
+    }
+  uint32_t if0 = ipv4->GetInterfaceForDevice (dev[0]);
+  uint32_t if1 = ipv4->GetInterfaceForDevice (dev[1]);
+
+  // the /16 is added before the more specific /24 and wins
+  m_routing->AddNetworkRouteTo ("10.2.0.0", "255.255.0.0", "10.1.0.2", if1);
+  m_routing->AddNetworkRouteTo ("10.2.1.0", "255.255.255.0", "10.0.0.2", if0);
+  m_routing->AddHostRouteTo ("10.2.1.7", "10.0.0.2", if0);
+  m_routing->AddNetworkRouteTo ("10.3.0.0", "255.255.0.0", "10.1.0.2", if1);
+  m_routing->AddNetworkRouteTo ("10.3.0.0", "255.255.0.0", "10.0.0.2", if0);
+
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.2.1.5"), dev[1], "First matching network route in insertion order");
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.2.2.5"), dev[1], "Network route");
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.2.1.7"), dev[0], "Host route before network routes");
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.4.0.1"), 0, "No route");
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.3.0.1"), dev[1], "First of equal cost routes");
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.3.0.1", dev[0]), dev[0], "Route on the requested device");
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.2.2.5", dev[0]), 0, "No route on the requested device");
+
+  // routes are indexed host routes first, remove the /16
+  NS_TEST_EXPECT_MSG_EQ (m_routing->GetRoute (1)->GetDestNetworkMask (), Ipv4Mask ("255.255.0.0"), "Route order");
+  m_routing->RemoveRoute (1);
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.2.1.5"), dev[0], "Remaining network route");
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.2.2.5"), 0, "Removed network route");
+
+  m_routing->RemoveRoute (0);
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.2.1.7"), dev[0], "Network route after removing the host route");
+  m_routing->AddHostRouteTo ("10.2.1.7", "10.1.0.2", if1);
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.2.1.7"), dev[1], "Added host route");
+
+  node->Dispose ();
+  m_routing = 0;
+}
+
+/*
+ * With FlowEcmpRouting the packets of a flow always take the same one of
+ * several equal cost routes, and different flows spread over all of them.
+ */
+class Ipv4GlobalRoutingFlowEcmpTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingFlowEcmpTestCase (Ipv4GlobalRouting::EcmpHashFunction hash, std::string name);
+  virtual void DoRun (void);
+
+private:
+  Ipv4GlobalRouting::EcmpHashFunction m_hash;
+};
+
+Ipv4GlobalRoutingFlowEcmpTestCase::Ipv4GlobalRoutingFlowEcmpTestCase (Ipv4GlobalRouting::EcmpHashFunction hash,
+                                                                      std::string name)
+  : TestCase ("Flow ECMP with " + name),
+    m_hash (hash)
+{
+}
+
+void
+Ipv4GlobalRoutingFlowEcmpTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<Ipv4L3Protocol> ipv4 = CreateObject<Ipv4L3Protocol> ();
+  node->AggregateObject (ipv4);
+  Ptr<Ipv4GlobalRouting> routing = CreateObject<Ipv4GlobalRouting> ();
+  routing->SetAttribute ("FlowEcmpRouting", BooleanValue (true));
+  routing->SetAttribute ("EcmpHashFunction", EnumValue (m_hash));
+  ipv4->SetRoutingProtocol (routing);
+
+  const uint32_t nDevices = 4;
+  Ptr<SimpleNetDevice> dev[nDevices];
+  for (uint32_t i = 0; i < nDevices; i++)
+    {
+      dev[i] = CreateObject<SimpleNetDevice> ();
+      dev[i]->SetAddress (Mac48Address::Allocate ());
+      node->AddDevice (dev[i]);
+      uint32_t interface = ipv4->AddInterface (dev[i]);
+      ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address ((10 << 24) | (i << 16) | 1),
+                                                         Ipv4Mask ("255.255.0.0")));
+      ipv4->SetUp (interface);
+      routing->AddNetworkRouteTo (Ipv4Address::GetAny (), Ipv4Mask::GetZero (),
+                                  Ipv4Address ((10 << 24) | (i << 16) | 2), interface);
+    }
+
+  uint32_t count[nDevices] = { 0 };
+  Ipv4Header header;
+  header.SetDestination (Ipv4Address ("10.8.0.1"));
+  header.SetProtocol (17);
+  Socket::SocketErrno sockerr;
+  for (uint32_t flow = 0; flow < 256; flow++)
+    {
+      header.SetSource (Ipv4Address ((10 << 24) | (9 << 16) | flow));
+      Ptr<NetDevice> first = routing->RouteOutput (0, header, 0, sockerr)->GetOutputDevice ();
+      for (uint32_t i = 0; i < 4; i++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (routing->RouteOutput (0, header, 0, sockerr)->GetOutputDevice (), first,
+                                 "Flow " << flow << " changed route");
+        }
+      for (uint32_t i = 0; i < nDevices; i++)
+        {
+          count[i] += (first == dev[i]);
+        }
+    }
+  for (uint32_t i = 0; i < nDevices; i++)
+    {
+      NS_TEST_EXPECT_MSG_GT (count[i], 256 / nDevices / 2, "Route " << i << " underused");
+    }
+
+  node->Dispose ();
+}
+
+static class Ipv4GlobalRoutingTestSuite : public TestSuite
+{
+public:
+  Ipv4GlobalRoutingTestSuite ()
+    : TestSuite ("ipv4-global-routing", UNIT)
+  {
+    AddTestCase (new Ipv4GlobalRoutingLookupTestCase (), TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingFlowEcmpTestCase (Ipv4GlobalRouting::ECMP_HASH_MURMUR3, "Murmur3"),
+                 TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingFlowEcmpTestCase (Ipv4GlobalRouting::ECMP_HASH_FNV1A, "Fnv1a"),
+                 TestCase::QUICK);
+  }
+} g_ipv4GlobalRoutingTestSuite;
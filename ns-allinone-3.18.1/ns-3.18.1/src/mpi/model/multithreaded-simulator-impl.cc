@@ -0,0 +1,675 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+#include "mpi-receiver.h"
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/make-event.h"
+#include "ns3/channel.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/net-device.h"
+#include "ns3/nstime.h"
+#include "ns3/system-thread.h"
+#include "ns3/ptr.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <sched.h>
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+// Busy-wait this many times on a barrier before yielding the processor
+static const uint32_t BARRIER_SPINS = 1000;
+static const uint64_t MAX_TS = 0x7fffffffffffffffLL;
+
+bool MultithreadedSimulatorImpl::m_enabled = false;
+thread_local MultithreadedSimulatorImpl::LogicalProcess *MultithreadedSimulatorImpl::m_currentLp = 0;
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<Object> ()
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_lookAhead (MAX_TS),
+    m_stopTs (MAX_TS),
+    m_barrierCount (0),
+    m_barrierGeneration (0)
+{
+  NS_LOG_FUNCTION (this);
+  m_global.id = 0;
+  m_global.impl = this;
+  m_global.events = 0;
+  // uids 0 to 3 are reserved by EventId
+  m_global.uid = 4;
+  m_global.currentUid = 0;
+  m_global.currentTs = 0;
+  m_global.currentContext = 0xffffffff;
+  m_global.eventCount = 0;
+  m_global.windowEnd = 0;
+  m_global.stop = false;
+  m_global.publishedNextTs = MAX_TS;
+  m_global.publishedStop = false;
+  m_enabled = true;
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_global.events->IsEmpty ())
+    {
+      Scheduler::Event next = m_global.events->RemoveNext ();
+      next.impl->Unref ();
+    }
+  m_global.events = 0;
+  for (uint32_t i = 0; i < m_lps.size (); ++i)
+    {
+      delete m_lps[i];
+    }
+  m_lps.clear ();
+  m_receivers.clear ();
+  m_enabled = false;
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsEnabled (void)
+{
+  if (!m_enabled)
+    {
+      // Make sure the configured implementation has been created
+      Simulator::GetImplementation ();
+    }
+  return m_enabled;
+}
+
+MultithreadedSimulatorImpl::LogicalProcess *
+MultithreadedSimulatorImpl::GetCurrent (void) const
+{
+  if (m_currentLp != 0)
+    {
+      return m_currentLp;
+    }
+  return const_cast<LogicalProcess *> (&m_global);
+}
+
+MultithreadedSimulatorImpl::LogicalProcess *
+MultithreadedSimulatorImpl::GetLogicalProcess (uint32_t context) const
+{
+  if (m_currentLp == 0)
+    {
+      return const_cast<LogicalProcess *> (&m_global);
+    }
+  if (context < m_contextLp.size ())
+    {
+      return m_lps[m_contextLp[context]];
+    }
+  return m_currentLp;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::Insert (LogicalProcess *lp, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = lp->uid;
+  // Logical processes interleave their uids so that keys stay unique
+  // when their events are merged back after Run
+  lp->uid += lp == &m_global ? 1 : m_lps.size ();
+  lp->events->Insert (ev);
+  return ev.key.m_uid;
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  NS_ASSERT_MSG (m_currentLp == 0, "Cannot change the scheduler of a running simulation");
+  m_schedulerFactory = schedulerFactory;
+
+  Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+  if (m_global.events != 0)
+    {
+      while (!m_global.events->IsEmpty ())
+        {
+          Scheduler::Event next = m_global.events->RemoveNext ();
+          scheduler->Insert (next);
+        }
+    }
+  m_global.events = scheduler;
+  // The logical processes only hold events during Run
+  for (uint32_t i = 0; i < m_lps.size (); ++i)
+    {
+      m_lps[i]->events = schedulerFactory.Create<Scheduler> ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Partition (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t nLps = 1;
+  m_contextLp.resize (NodeList::GetNNodes ());
+  m_receivers.resize (NodeList::GetNNodes ());
+  for (uint32_t i = 0; i < NodeList::GetNNodes (); ++i)
+    {
+      Ptr<Node> node = NodeList::GetNode (i);
+      m_contextLp[i] = node->GetSystemId ();
+      nLps = std::max (nLps, node->GetSystemId () + 1);
+
+      m_receivers[i].assign (node->GetNDevices (), 0);
+      for (uint32_t j = 0; j < node->GetNDevices (); ++j)
+        {
+          m_receivers[i][j] = PeekPointer (node->GetDevice (j)->GetObject<MpiReceiver> ());
+        }
+    }
+
+  while (m_lps.size () < nLps)
+    {
+      LogicalProcess *lp = new LogicalProcess;
+      lp->id = m_lps.size ();
+      lp->impl = this;
+      lp->events = m_schedulerFactory.Create<Scheduler> ();
+      lp->eventCount = 0;
+      m_lps.push_back (lp);
+    }
+  for (uint32_t i = 0; i < m_lps.size (); ++i)
+    {
+      LogicalProcess *lp = m_lps[i];
+      lp->uid = m_global.uid + i;
+      lp->currentUid = m_global.currentUid;
+      lp->currentTs = m_global.currentTs;
+      lp->currentContext = 0xffffffff;
+      lp->windowEnd = m_global.currentTs;
+      lp->stop = false;
+      lp->outbox.resize (m_lps.size ());
+    }
+
+  // Hand the events scheduled outside of Run to the partition of their node
+  while (!m_global.events->IsEmpty ())
+    {
+      Scheduler::Event ev = m_global.events->RemoveNext ();
+      uint32_t lp = ev.key.m_context < m_contextLp.size () ? m_contextLp[ev.key.m_context] : 0;
+      m_lps[lp]->events->Insert (ev);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::CalculateLookAhead (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_lookAhead = MAX_TS;
+  for (NodeList::Iterator iter = NodeList::Begin (); iter != NodeList::End (); ++iter)
+    {
+      for (uint32_t i = 0; i < (*iter)->GetNDevices (); ++i)
+        {
+          Ptr<NetDevice> localNetDevice = (*iter)->GetDevice (i);
+          // only works for p2p links currently
+          if (!localNetDevice->IsPointToPoint ())
+            {
+              continue;
+            }
+          Ptr<Channel> channel = localNetDevice->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+
+          bool remote = false;
+          for (uint32_t j = 0; j < channel->GetNDevices (); ++j)
+            {
+              remote |= channel->GetDevice (j)->GetNode ()->GetSystemId () != (*iter)->GetSystemId ();
+            }
+          if (!remote)
+            {
+              continue;
+            }
+
+          TimeValue delay;
+          channel->GetAttribute ("Delay", delay);
+          m_lookAhead = std::min (m_lookAhead, static_cast<uint64_t> (delay.Get ().GetTimeStep ()));
+        }
+    }
+
+  if (m_lookAhead == 0)
+    {
+      NS_FATAL_ERROR ("Channels between partitions need a non-zero delay");
+    }
+  NS_LOG_LOGIC ("lookahead " << TimeStep (m_lookAhead));
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Partition ();
+  CalculateLookAhead ();
+
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 1; i < m_lps.size (); ++i)
+    {
+      Ptr<SystemThread> thread =
+        Create<SystemThread> (MakeBoundCallback (&MultithreadedSimulatorImpl::RunThread, m_lps[i]));
+      thread->Start ();
+      threads.push_back (thread);
+    }
+  RunLogicalProcess (m_lps[0]);
+  for (uint32_t i = 0; i < threads.size (); ++i)
+    {
+      threads[i]->Join ();
+    }
+
+  // Continue at the time of the most advanced partition and take back
+  // the events that are left
+  m_global.stop = false;
+  for (uint32_t i = 0; i < m_lps.size (); ++i)
+    {
+      LogicalProcess *lp = m_lps[i];
+      if (lp->currentTs >= m_global.currentTs)
+        {
+          m_global.currentTs = lp->currentTs;
+          m_global.currentUid = lp->currentUid;
+        }
+      m_global.uid = std::max (m_global.uid, lp->uid);
+      m_global.stop |= lp->stop;
+      while (!lp->events->IsEmpty ())
+        {
+          m_global.events->Insert (lp->events->RemoveNext ());
+        }
+    }
+  m_stopTs = MAX_TS;
+}
+
+void
+MultithreadedSimulatorImpl::RunThread (LogicalProcess *lp)
+{
+  lp->impl->RunLogicalProcess (lp);
+}
+
+void
+MultithreadedSimulatorImpl::RunLogicalProcess (LogicalProcess *lp)
+{
+  NS_LOG_FUNCTION (this << lp->id);
+
+  m_currentLp = lp;
+  while (true)
+    {
+      ReceiveMessages (lp);
+      lp->publishedNextTs = lp->events->IsEmpty () ? MAX_TS : lp->events->PeekNext ().key.m_ts;
+      lp->publishedStop = lp->stop;
+      Barrier ();
+
+      // Every logical process computes the same window from the published values
+      uint64_t nextTs = MAX_TS;
+      bool stop = false;
+      for (uint32_t i = 0; i < m_lps.size (); ++i)
+        {
+          nextTs = std::min (nextTs, m_lps[i]->publishedNextTs);
+          stop |= m_lps[i]->publishedStop;
+        }
+      if (stop || nextTs == MAX_TS || nextTs >= m_stopTs)
+        {
+          break;
+        }
+      lp->windowEnd = m_lookAhead >= MAX_TS - nextTs ? MAX_TS : nextTs + m_lookAhead;
+      lp->windowEnd = std::min (lp->windowEnd, m_stopTs);
+
+      while (!lp->stop && !lp->events->IsEmpty ()
+             && lp->events->PeekNext ().key.m_ts < lp->windowEnd)
+        {
+          ProcessOneEvent (lp);
+        }
+      Barrier ();
+    }
+  m_currentLp = 0;
+}
+
+void
+MultithreadedSimulatorImpl::ReceiveMessages (LogicalProcess *lp)
+{
+  // Source order keeps the uids, and thus the order of ties, deterministic
+  for (uint32_t i = 0; i < m_lps.size (); ++i)
+    {
+      Mailbox &mailbox = m_lps[i]->outbox[lp->id];
+      for (std::vector<Message>::const_iterator it = mailbox.messages.begin ();
+           it != mailbox.messages.end (); ++it)
+        {
+          EventImpl *event = it->event;
+          if (event == 0)
+            {
+              Ptr<Packet> p = Create<Packet> (&mailbox.data[it->offset], it->size, true);
+              MpiReceiver *receiver = m_receivers[it->context][it->ifIndex];
+              NS_ASSERT_MSG (receiver != 0, "No MpiReceiver on node " << it->context <<
+                             " device " << it->ifIndex);
+              event = MakeEvent (&MpiReceiver::Receive, receiver, p);
+            }
+          Insert (lp, it->ts, it->context, event);
+        }
+      mailbox.messages.clear ();
+      mailbox.data.clear ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (LogicalProcess *lp)
+{
+  Scheduler::Event next = lp->events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= lp->currentTs);
+  NS_LOG_LOGIC ("handle " << next.key.m_ts);
+  lp->currentTs = next.key.m_ts;
+  lp->currentContext = next.key.m_context;
+  lp->currentUid = next.key.m_uid;
+  lp->eventCount++;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::Barrier (void)
+{
+  uint32_t generation = m_barrierGeneration.load (std::memory_order_acquire);
+  if (m_barrierCount.fetch_add (1, std::memory_order_acq_rel) + 1 == m_lps.size ())
+    {
+      m_barrierCount.store (0, std::memory_order_relaxed);
+      m_barrierGeneration.fetch_add (1, std::memory_order_release);
+      return;
+    }
+  for (uint32_t spins = 0; m_barrierGeneration.load (std::memory_order_acquire) == generation; ++spins)
+    {
+      if (spins >= BARRIER_SPINS)
+        {
+          sched_yield ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t node, uint32_t dev)
+{
+  LogicalProcess *lp = m_currentLp;
+  NS_ASSERT_MSG (lp != 0, "Packets can only be sent between partitions while running");
+  NS_ASSERT (static_cast<uint64_t> (rxTime.GetTimeStep ()) >= lp->windowEnd);
+
+  Mailbox &mailbox = lp->outbox[lp->impl->m_contextLp[node]];
+  Message message;
+  message.ts = rxTime.GetTimeStep ();
+  message.context = node;
+  message.event = 0;
+  message.ifIndex = dev;
+  message.offset = mailbox.data.size ();
+  message.size = p->GetSerializedSize ();
+  mailbox.data.resize (message.offset + message.size);
+  p->Serialize (&mailbox.data[message.offset], message.size);
+  mailbox.messages.push_back (message);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return GetCurrent ()->id;
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  return m_global.events->IsEmpty () || m_global.stop;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  GetCurrent ()->stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &time)
+{
+  NS_LOG_FUNCTION (this << time.GetTimeStep ());
+  if (m_currentLp == 0)
+    {
+      m_stopTs = std::min (m_stopTs, m_global.currentTs + time.GetTimeStep ());
+    }
+  else
+    {
+      Simulator::Schedule (time, &Simulator::Stop);
+    }
+}
+
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &time, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << time.GetTimeStep () << event);
+  LogicalProcess *lp = GetCurrent ();
+  Time tAbsolute = time + TimeStep (lp->currentTs);
+
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (lp->currentTs));
+  uint64_t ts = tAbsolute.GetTimeStep ();
+  uint32_t uid = Insert (lp, ts, lp->currentContext, event);
+  return EventId (event, ts, lp->currentContext, uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << time.GetTimeStep () << event);
+  LogicalProcess *lp = GetCurrent ();
+  LogicalProcess *target = GetLogicalProcess (context);
+  uint64_t ts = lp->currentTs + time.GetTimeStep ();
+
+  if (target == lp)
+    {
+      Insert (lp, ts, context, event);
+      return;
+    }
+
+  if (ts < lp->windowEnd)
+    {
+      NS_FATAL_ERROR ("Event for node " << context << " in another partition scheduled " <<
+                      time << " ahead, which is below the lookahead of " << TimeStep (m_lookAhead));
+    }
+  Message message;
+  message.ts = ts;
+  message.context = context;
+  message.event = event;
+  message.ifIndex = 0;
+  message.offset = 0;
+  message.size = 0;
+  lp->outbox[target->id].messages.push_back (message);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << event);
+  LogicalProcess *lp = GetCurrent ();
+  uint32_t uid = Insert (lp, lp->currentTs, lp->currentContext, event);
+  return EventId (event, lp->currentTs, lp->currentContext, uid);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << event);
+  EventId id (Ptr<EventImpl> (event, false), GetCurrent ()->currentTs, 0xffffffff, 2);
+  CriticalSection critical (m_destroyMutex);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  return TimeStep (GetCurrent ()->currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetCurrent ()->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection critical (m_destroyMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  // Events with an EventId always live in the partition that scheduled them
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  GetCurrent ()->events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &ev) const
+{
+  if (ev.GetUid () == 2)
+    {
+      if (ev.PeekEventImpl () == 0
+          || ev.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection critical (const_cast<SystemMutex &> (m_destroyMutex));
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == ev)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  LogicalProcess *lp = GetCurrent ();
+  if (ev.PeekEventImpl () == 0
+      || ev.GetTs () < lp->currentTs
+      || (ev.GetTs () == lp->currentTs
+          && ev.GetUid () <= lp->currentUid)
+      || ev.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (MAX_TS);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return GetCurrent ()->currentContext;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetEventCount (void) const
+{
+  uint64_t count = m_global.eventCount;
+  for (uint32_t i = 0; i < m_lps.size (); ++i)
+    {
+      count += m_lps[i]->eventCount;
+    }
+  return count;
+}
+
+} // namespace ns3
@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/object-factory.h"
+#include "ns3/system-mutex.h"
+#include "ns3/packet.h"
+#include "ns3/ptr.h"
+
+#include <atomic>
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+class MpiReceiver;
+
+/**
+ * \ingroup mpi
+ *
+ * \brief Conservative parallel simulator running the partitions of a
+ * single process on shared-memory threads.
+ *
+ * Every distinct Node system id is a logical process with its own event
+ * list, run by its own thread (system id 0 runs on the calling thread).
+ * The logical processes advance in lock step over windows of one
+ * lookahead, the smallest delay of a point-to-point channel between
+ * nodes of different system ids, so no event can arrive in the past.
+ *
+ * Packets crossing partitions go through a PointToPointRemoteChannel,
+ * are serialized into a per (source, destination) mailbox and delivered
+ * to the MpiReceiver of the destination device at the start of the next
+ * window. Each mailbox has a single writer and a single reader which
+ * are separated by the window barrier, so no locking is needed.
+ *
+ * Events of equal timestamp in different partitions are not ordered with
+ * respect to each other, so runs with ties across partitions may differ
+ * from the sequential simulators. Simulator::Stop takes effect at the end
+ * of the current window.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MultithreadedSimulatorImpl ();
+  ~MultithreadedSimulatorImpl ();
+
+  // virtual from SimulatorImpl
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &time);
+  virtual EventId Schedule (Time const &time, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &ev);
+  virtual void Cancel (const EventId &ev);
+  virtual bool IsExpired (const EventId &ev) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+  virtual uint64_t GetEventCount (void) const;
+
+  /**
+   * \returns true if the simulator implementation in use is a
+   * MultithreadedSimulatorImpl
+   */
+  static bool IsEnabled (void);
+
+  /**
+   * \brief Send a packet to a device of a node in another partition
+   *
+   * Must be called from within the running simulation.
+   *
+   * \param p packet to send
+   * \param rxTime absolute receive time
+   * \param node destination node id
+   * \param dev destination device ifIndex
+   */
+  static void SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t node, uint32_t dev);
+
+private:
+  /// An event or a serialized packet on its way to another partition
+  struct Message
+  {
+    uint64_t ts;
+    uint32_t context;
+    EventImpl *event;     // 0 for a packet
+    uint32_t ifIndex;
+    uint32_t offset;      // of the packet bytes in Mailbox::data
+    uint32_t size;
+  };
+
+  struct Mailbox
+  {
+    std::vector<Message> messages;
+    std::vector<uint8_t> data;
+  };
+
+  struct LogicalProcess
+  {
+    uint32_t id;
+    MultithreadedSimulatorImpl *impl;
+    Ptr<Scheduler> events;
+    uint32_t uid;
+    uint32_t currentUid;
+    uint64_t currentTs;
+    uint32_t currentContext;
+    uint64_t eventCount;
+    uint64_t windowEnd;
+    bool stop;
+    // Copies read by the other logical processes between the barriers
+    uint64_t publishedNextTs;
+    bool publishedStop;
+    // Messages to every logical process, indexed by destination
+    std::vector<Mailbox> outbox;
+  };
+
+  virtual void DoDispose (void);
+
+  LogicalProcess *GetCurrent (void) const;
+  LogicalProcess *GetLogicalProcess (uint32_t context) const;
+  uint32_t Insert (LogicalProcess *lp, uint64_t ts, uint32_t context, EventImpl *event);
+  void Partition (void);
+  void CalculateLookAhead (void);
+  static void RunThread (LogicalProcess *lp);
+  void RunLogicalProcess (LogicalProcess *lp);
+  void ReceiveMessages (LogicalProcess *lp);
+  void ProcessOneEvent (LogicalProcess *lp);
+  void Barrier (void);
+
+  typedef std::list<EventId> DestroyEvents;
+
+  DestroyEvents m_destroyEvents;
+  SystemMutex m_destroyMutex;
+  ObjectFactory m_schedulerFactory;
+  // Events and time outside of Run
+  LogicalProcess m_global;
+  std::vector<LogicalProcess *> m_lps;
+  // Logical process of each context (node id)
+  std::vector<uint32_t> m_contextLp;
+  // MpiReceiver of each [node][ifIndex], for incoming packets
+  std::vector<std::vector<MpiReceiver *> > m_receivers;
+  uint64_t m_lookAhead;
+  uint64_t m_stopTs;
+
+  std::atomic<uint32_t> m_barrierCount;
+  std::atomic<uint32_t> m_barrierGeneration;
+
+  static bool m_enabled;
+  static thread_local LogicalProcess *m_currentLp;
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
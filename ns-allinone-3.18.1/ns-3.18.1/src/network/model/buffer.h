@@ -593,8 +593,11 @@ private:
    * location in a newly-allocated buffer where you should start
    * writing data. i.e., m_start should be initialized to this 
    * value.
+   *
+   * Like the free list below, this is per thread so that partitions of a
+   * multithreaded simulation never share buffer state.
    */
-  static uint32_t g_recommendedStart;
+  static thread_local uint32_t g_recommendedStart;
 
   /* offset to the start of the virtual zero area from the start 
    * of m_data->m_data
@@ -619,9 +622,9 @@ private:
   {
     ~LocalStaticDestructor ();
   };
-  static uint32_t g_maxSize;
-  static FreeList *g_freeList;
-  static struct LocalStaticDestructor g_localStaticDestructor;
+  static thread_local uint32_t g_maxSize;
+  static thread_local FreeList *g_freeList;
+  static thread_local struct LocalStaticDestructor g_localStaticDestructor;
 #endif
 };
 
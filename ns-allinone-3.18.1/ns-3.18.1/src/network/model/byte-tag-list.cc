@@ -38,12 +38,13 @@ struct ByteTagListData {
 };
 
 #ifdef USE_FREE_LIST
-static class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
+// Per thread, see Buffer::g_freeList
+static thread_local class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
 {
 public:
   ~ByteTagListDataFreeList ();
 } g_freeList;
-static uint32_t g_maxSize = 0;
+static thread_local uint32_t g_maxSize = 0;
 
 ByteTagListDataFreeList::~ByteTagListDataFreeList ()
 {
@@ -335,7 +335,9 @@ public:
   static struct PacketMetadata::Data *Allocate (uint32_t n);
   static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList;
+  // The free list and the size/uid counters are per thread so that
+  // partitions of a multithreaded simulation never share them.
+  static thread_local DataFreeList m_freeList;
   static bool m_enable;
   static bool m_enableChecking;
 
@@ -344,8 +346,8 @@ public:
   // middle of a simulation, which isn't allowed.
   static bool m_metadataSkipped;
 
-  static uint32_t m_maxSize;
-  static uint16_t m_chunkUid;
+  static thread_local uint32_t m_maxSize;
+  static thread_local uint16_t m_chunkUid;
 
   struct Data *m_data;
   /**
@@ -28,7 +28,7 @@ NS_LOG_COMPONENT_DEFINE ("Packet");
 
 namespace ns3 {
 
-uint32_t Packet::m_globalUid = 0;
+thread_local uint32_t Packet::m_globalUid = 0;
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
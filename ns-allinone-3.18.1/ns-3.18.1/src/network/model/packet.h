@@ -592,7 +592,9 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector;
 
-  static uint32_t m_globalUid;
+  // Per thread; the simulator system id in the upper bits of the uid
+  // keeps uids unique across partitions.
+  static thread_local uint32_t m_globalUid;
 };
 
 std::ostream& operator<< (std::ostream& os, const Packet &packet);
@@ -0,0 +1,89 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "cut-through-tag.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("CutThroughTag");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (CutThroughTag);
+
+TypeId 
+CutThroughTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CutThroughTag")
+    .SetParent<Tag> ()
+    .AddConstructor<CutThroughTag> ()
+  ;
+  return tid;
+}
+TypeId 
+CutThroughTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+uint32_t 
+CutThroughTag::GetSerializedSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return 8;
+}
+void 
+CutThroughTag::Serialize (TagBuffer buf) const
+{
+  NS_LOG_FUNCTION (this << &buf);
+  buf.WriteU64 (m_tailTime.GetTimeStep ());
+}
+void 
+CutThroughTag::Deserialize (TagBuffer buf)
+{
+  NS_LOG_FUNCTION (this << &buf);
+  m_tailTime = TimeStep (buf.ReadU64 ());
+}
+void 
+CutThroughTag::Print (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  os << "TailTime=" << m_tailTime;
+}
+CutThroughTag::CutThroughTag ()
+  : Tag ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CutThroughTag::CutThroughTag (Time tailTime)
+  : Tag (),
+    m_tailTime (tailTime)
+{
+  NS_LOG_FUNCTION (this << tailTime);
+}
+
+void
+CutThroughTag::SetTailTime (Time tailTime)
+{
+  NS_LOG_FUNCTION (this << tailTime);
+  m_tailTime = tailTime;
+}
+Time
+CutThroughTag::GetTailTime (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_tailTime;
+}
+
+} // namespace ns3
@@ -0,0 +1,55 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CUT_THROUGH_TAG_H
+#define CUT_THROUGH_TAG_H
+
+#include "ns3/tag.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief Marks a packet handed to the receiver before its last bit
+ * arrived, as done by channels in cut-through mode.
+ *
+ * A protocol that forwards the packet may do so right away; one that
+ * consumes it has to wait until the tail time.
+ */
+class CutThroughTag : public Tag
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer buf) const;
+  virtual void Deserialize (TagBuffer buf);
+  virtual void Print (std::ostream &os) const;
+  CutThroughTag ();
+  CutThroughTag (Time tailTime);
+  /**
+   * \param tailTime absolute time at which the last bit arrives
+   */
+  void SetTailTime (Time tailTime);
+  Time GetTailTime (void) const;
+private:
+  Time m_tailTime;
+};
+
+} // namespace ns3
+
+#endif /* CUT_THROUGH_TAG_H */
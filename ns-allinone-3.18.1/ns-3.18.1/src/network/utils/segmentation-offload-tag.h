@@ -0,0 +1,66 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef SEGMENTATION_OFFLOAD_TAG_H
+#define SEGMENTATION_OFFLOAD_TAG_H
+
+#include "ns3/tag.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief Marks a packet that stands for several segments on the wire, as
+ * handed down by a transport protocol with segmentation offload.
+ *
+ * The packet holds the headers once; every wire segment after the first
+ * repeats them. Each layer that adds a header adds its size here, so that
+ * devices can send the packet in the time its segments would take.
+ */
+class SegmentationOffloadTag : public Tag
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer buf) const;
+  virtual void Deserialize (TagBuffer buf);
+  virtual void Print (std::ostream &os) const;
+  SegmentationOffloadTag ();
+  SegmentationOffloadTag (uint16_t segments, uint16_t headerSize);
+  /**
+   * \param segments number of wire segments
+   */
+  void SetSegments (uint16_t segments);
+  uint16_t GetSegments (void) const;
+  /**
+   * \param headerSize bytes of headers every wire segment carries, below
+   * the device's own
+   */
+  void SetHeaderSize (uint16_t headerSize);
+  uint16_t GetHeaderSize (void) const;
+  /**
+   * \returns the bytes the wire segments add to the packet
+   */
+  uint32_t GetExtraWireSize (void) const;
+private:
+  uint16_t m_segments;
+  uint16_t m_headerSize;
+};
+
+} // namespace ns3
+
+#endif /* SEGMENTATION_OFFLOAD_TAG_H */
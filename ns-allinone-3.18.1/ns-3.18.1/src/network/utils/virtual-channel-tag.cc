@@ -0,0 +1,90 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "virtual-channel-tag.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("VirtualChannelTag");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (VirtualChannelTag);
+
+TypeId 
+VirtualChannelTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::VirtualChannelTag")
+    .SetParent<Tag> ()
+    .AddConstructor<VirtualChannelTag> ()
+  ;
+  return tid;
+}
+TypeId 
+VirtualChannelTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+uint32_t 
+VirtualChannelTag::GetSerializedSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return 1;
+}
+void 
+VirtualChannelTag::Serialize (TagBuffer buf) const
+{
+  NS_LOG_FUNCTION (this << &buf);
+  buf.WriteU8 (m_vc);
+}
+void 
+VirtualChannelTag::Deserialize (TagBuffer buf)
+{
+  NS_LOG_FUNCTION (this << &buf);
+  m_vc = buf.ReadU8 ();
+}
+void 
+VirtualChannelTag::Print (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  os << "VirtualChannel=" << static_cast<uint32_t> (m_vc);
+}
+VirtualChannelTag::VirtualChannelTag ()
+  : Tag (),
+    m_vc (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+VirtualChannelTag::VirtualChannelTag (uint8_t vc)
+  : Tag (),
+    m_vc (vc)
+{
+  NS_LOG_FUNCTION (this << static_cast<uint32_t> (vc));
+}
+
+void
+VirtualChannelTag::SetVirtualChannel (uint8_t vc)
+{
+  NS_LOG_FUNCTION (this << static_cast<uint32_t> (vc));
+  m_vc = vc;
+}
+uint8_t
+VirtualChannelTag::GetVirtualChannel (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_vc;
+}
+
+} // namespace ns3
@@ -0,0 +1,54 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef VIRTUAL_CHANNEL_TAG_H
+#define VIRTUAL_CHANNEL_TAG_H
+
+#include "ns3/tag.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief Selects the virtual channel a packet is sent on.
+ *
+ * Set by the protocol that forwards the packet, before it hands it to a
+ * device with several virtual channels. Packets without the tag go on
+ * virtual channel 0.
+ */
+class VirtualChannelTag : public Tag
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer buf) const;
+  virtual void Deserialize (TagBuffer buf);
+  virtual void Print (std::ostream &os) const;
+  VirtualChannelTag ();
+  VirtualChannelTag (uint8_t vc);
+  /**
+   * \param vc index of the virtual channel
+   */
+  void SetVirtualChannel (uint8_t vc);
+  uint8_t GetVirtualChannel (void) const;
+private:
+  uint8_t m_vc;
+};
+
+} // namespace ns3
+
+#endif /* VIRTUAL_CHANNEL_TAG_H */
@@ -30,6 +30,7 @@
 #include "ns3/names.h"
 #include "ns3/mpi-interface.h"
 #include "ns3/mpi-receiver.h"
+#include "ns3/multithreaded-simulator-impl.h"
 
 #include "ns3/trace-helper.h"
 #include "point-to-point-helper.h"
@@ -231,11 +232,19 @@ PointToPointHelper::Install (Ptr<Node> a, Ptr<Node> b)
   a->AddDevice (devA);
   Ptr<Queue> queueA = m_queueFactory.Create<Queue> ();
   devA->SetQueue (queueA);
+  for (uint32_t vc = 1; vc < devA->GetVirtualChannels (); vc++)
+    {
+      devA->SetVirtualChannelQueue (vc, m_queueFactory.Create<Queue> ());
+    }
   Ptr<PointToPointNetDevice> devB = m_deviceFactory.Create<PointToPointNetDevice> ();
   devB->SetAddress (Mac48Address::Allocate ());
   b->AddDevice (devB);
   Ptr<Queue> queueB = m_queueFactory.Create<Queue> ();
   devB->SetQueue (queueB);
+  for (uint32_t vc = 1; vc < devB->GetVirtualChannels (); vc++)
+    {
+      devB->SetVirtualChannelQueue (vc, m_queueFactory.Create<Queue> ());
+    }
   // If MPI is enabled, we need to see if both nodes have the same system id 
   // (rank), and the rank is the same as this instance.  If both are true, 
   //use a normal p2p channel, otherwise use a remote channel
@@ -251,6 +260,12 @@ PointToPointHelper::Install (Ptr<Node> a, Ptr<Node> b)
           useNormalChannel = false;
         }
     }
+  // With threads every partition is in this process, only links between
+  // partitions need a remote channel
+  else if (MultithreadedSimulatorImpl::IsEnabled () && a->GetSystemId () != b->GetSystemId ())
+    {
+      useNormalChannel = false;
+    }
   if (useNormalChannel)
     {
       channel = m_channelFactory.Create<PointToPointChannel> ();
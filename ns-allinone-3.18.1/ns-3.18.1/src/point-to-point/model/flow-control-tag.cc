@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "flow-control-tag.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("FlowControlTag");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (FlowControlTag);
+
+TypeId 
+FlowControlTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FlowControlTag")
+    .SetParent<Tag> ()
+    .AddConstructor<FlowControlTag> ()
+  ;
+  return tid;
+}
+TypeId 
+FlowControlTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+uint32_t 
+FlowControlTag::GetSerializedSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return 5;
+}
+void 
+FlowControlTag::Serialize (TagBuffer buf) const
+{
+  NS_LOG_FUNCTION (this << &buf);
+  buf.WriteU32 (m_ifIndex);
+  buf.WriteU8 (m_vc);
+}
+void 
+FlowControlTag::Deserialize (TagBuffer buf)
+{
+  NS_LOG_FUNCTION (this << &buf);
+  m_ifIndex = buf.ReadU32 ();
+  m_vc = buf.ReadU8 ();
+}
+void 
+FlowControlTag::Print (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  os << "IfIndex=" << m_ifIndex << " VirtualChannel=" << static_cast<uint32_t> (m_vc);
+}
+FlowControlTag::FlowControlTag ()
+  : Tag (),
+    m_ifIndex (0),
+    m_vc (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FlowControlTag::FlowControlTag (uint32_t ifIndex, uint8_t vc)
+  : Tag (),
+    m_ifIndex (ifIndex),
+    m_vc (vc)
+{
+  NS_LOG_FUNCTION (this << ifIndex << static_cast<uint32_t> (vc));
+}
+
+void
+FlowControlTag::SetIfIndex (uint32_t ifIndex)
+{
+  NS_LOG_FUNCTION (this << ifIndex);
+  m_ifIndex = ifIndex;
+}
+uint32_t
+FlowControlTag::GetIfIndex (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_ifIndex;
+}
+
+void
+FlowControlTag::SetVirtualChannel (uint8_t vc)
+{
+  NS_LOG_FUNCTION (this << static_cast<uint32_t> (vc));
+  m_vc = vc;
+}
+uint8_t
+FlowControlTag::GetVirtualChannel (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_vc;
+}
+
+} // namespace ns3
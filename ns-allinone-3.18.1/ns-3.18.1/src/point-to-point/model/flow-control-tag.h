@@ -0,0 +1,61 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef FLOW_CONTROL_TAG_H
+#define FLOW_CONTROL_TAG_H
+
+#include "ns3/tag.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ *
+ * \brief Marks a packet that holds a slot of the receive buffer of a
+ * flow-controlled PointToPointNetDevice.
+ *
+ * The device that transmits the packet on frees the slot, and so returns
+ * a credit for the virtual channel the packet arrived on to the sender on
+ * the other side of the input link, once the packet has left the node.
+ */
+class FlowControlTag : public Tag
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer buf) const;
+  virtual void Deserialize (TagBuffer buf);
+  virtual void Print (std::ostream &os) const;
+  FlowControlTag ();
+  FlowControlTag (uint32_t ifIndex, uint8_t vc);
+  /**
+   * \param ifIndex index of the receiving device on its node
+   */
+  void SetIfIndex (uint32_t ifIndex);
+  uint32_t GetIfIndex (void) const;
+  /**
+   * \param vc virtual channel whose receive buffer holds the packet
+   */
+  void SetVirtualChannel (uint8_t vc);
+  uint8_t GetVirtualChannel (void) const;
+private:
+  uint32_t m_ifIndex;
+  uint8_t m_vc;
+};
+
+} // namespace ns3
+
+#endif /* FLOW_CONTROL_TAG_H */
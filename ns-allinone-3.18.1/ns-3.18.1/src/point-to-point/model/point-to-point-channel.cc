@@ -22,6 +22,9 @@
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/cut-through-tag.h"
+#include "ns3/segmentation-offload-tag.h"
 
 NS_LOG_COMPONENT_DEFINE ("PointToPointChannel");
 
@@ -39,6 +42,13 @@ PointToPointChannel::GetTypeId (void)
                    TimeValue (Seconds (0)),
                    MakeTimeAccessor (&PointToPointChannel::m_delay),
                    MakeTimeChecker ())
+    .AddAttribute ("CutThroughHeaderSize",
+                   "Hand a packet to the receiving device once this many bytes of it have arrived, "
+                   "tagged with the arrival time of its last bit (virtual cut-through). "
+                   "0 delivers whole packets. Remote (MPI and multithreaded) channels abort if it is set.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&PointToPointChannel::m_cutThroughHeaderSize),
+                   MakeUintegerChecker<uint32_t> ())
     .AddTraceSource ("TxRxPointToPoint",
                      "Trace source indicating transmission of packet from the PointToPointChannel, used by the Animation interface.",
                      MakeTraceSourceAccessor (&PointToPointChannel::m_txrxPointToPoint))
@@ -53,7 +63,8 @@ PointToPointChannel::PointToPointChannel()
   :
     Channel (),
     m_delay (Seconds (0.)),
-    m_nDevices (0)
+    m_nDevices (0),
+    m_cutThroughHeaderSize (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -93,15 +104,52 @@ PointToPointChannel::TransmitStart (
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
 
-  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
-                                  txTime + m_delay, &PointToPointNetDevice::Receive,
-                                  m_link[wire].m_dst, p);
+  Time rxDelay = txTime + m_delay;
+  // Time until the receiver may start forwarding the packet
+  Time headTime = txTime;
+  SegmentationOffloadTag offloadTag;
+  if (m_cutThroughHeaderSize > 0 && p->GetSize () > m_cutThroughHeaderSize)
+    {
+      headTime = TimeStep (txTime.GetTimeStep () * m_cutThroughHeaderSize / p->GetSize ());
+    }
+  else if (p->PeekPacketTag (offloadTag) && offloadTag.GetSegments () > 1)
+    {
+      // The wire segments of an offloaded packet are forwarded one by one:
+      // the next hop starts once the first has arrived
+      headTime = TimeStep (txTime.GetTimeStep () / offloadTag.GetSegments ());
+    }
+  if (headTime < txTime)
+    {
+      // The wire stays busy for the whole txTime, only the receiver starts early
+      Ptr<Packet> packet = p->Copy ();
+      packet->AddPacketTag (CutThroughTag (Simulator::Now () + rxDelay));
+      rxDelay = headTime + m_delay;
+      Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
+                                      rxDelay, &PointToPointNetDevice::Receive,
+                                      m_link[wire].m_dst, packet);
+    }
+  else
+    {
+      Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
+                                      rxDelay, &PointToPointNetDevice::Receive,
+                                      m_link[wire].m_dst, p);
+    }
 
   // Call the tx anim callback on the net device
   m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
   return true;
 }
 
+void
+PointToPointChannel::TransmitCredit (Ptr<PointToPointNetDevice> src, uint32_t vc)
+{
+  NS_LOG_FUNCTION (this << src << vc);
+  uint32_t wire = src == m_link[0].m_src ? 0 : 1;
+  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
+                                  m_delay, &PointToPointNetDevice::ReceiveCredit,
+                                  m_link[wire].m_dst, vc);
+}
+
 uint32_t 
 PointToPointChannel::GetNDevices (void) const
 {
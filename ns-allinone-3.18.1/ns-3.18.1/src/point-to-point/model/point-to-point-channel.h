@@ -61,7 +61,7 @@ public:
    * \brief Attach a given netdevice to this channel
    * \param device pointer to the netdevice to attach to the channel
    */
-  void Attach (Ptr<PointToPointNetDevice> device);
+  virtual void Attach (Ptr<PointToPointNetDevice> device);
 
   /**
    * \brief Transmit a packet over this channel
@@ -72,6 +72,16 @@ public:
    */
   virtual bool TransmitStart (Ptr<Packet> p, Ptr<PointToPointNetDevice> src, Time txTime);
 
+  /**
+   * \brief Return a flow control credit to the device at the other end
+   * \param src Device whose receive buffer has freed a slot
+   * \param vc Virtual channel of the slot
+   *
+   * The credit arrives after the propagation delay. Remote channels refuse
+   * devices with flow control, see PointToPointRemoteChannel::Attach.
+   */
+  void TransmitCredit (Ptr<PointToPointNetDevice> src, uint32_t vc);
+
   /**
    * \brief Get number of devices on this channel
    * \returns number of devices on this channel
@@ -127,6 +137,8 @@ private:
 
   Time          m_delay;
   int32_t       m_nDevices;
+  // Bytes after which the receiver gets the packet, 0 to wait for all
+  uint32_t      m_cutThroughHeaderSize;
 
   /**
    * The trace source for the packet transmission animation events that the 
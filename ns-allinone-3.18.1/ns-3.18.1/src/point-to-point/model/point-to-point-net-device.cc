@@ -16,6 +16,7 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
 #include "ns3/log.h"
 #include "ns3/queue.h"
 #include "ns3/simulator.h"
@@ -25,10 +26,15 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
+#include "ns3/object-vector.h"
+#include "ns3/object-factory.h"
+#include "ns3/virtual-channel-tag.h"
+#include "ns3/segmentation-offload-tag.h"
 #include "ns3/mpi-interface.h"
 #include "point-to-point-net-device.h"
 #include "point-to-point-channel.h"
 #include "ppp-header.h"
+#include "flow-control-tag.h"
 
 NS_LOG_COMPONENT_DEFINE ("PointToPointNetDevice");
 
@@ -67,6 +73,23 @@ PointToPointNetDevice::GetTypeId (void)
                    TimeValue (Seconds (0.0)),
                    MakeTimeAccessor (&PointToPointNetDevice::m_tInterframeGap),
                    MakeTimeChecker ())
+    .AddAttribute ("FlowControlBuffer",
+                   "Packets the receive buffer of every virtual channel holds for the peer, which only "
+                   "transmits while it has credits for free slots (lossless credit-based flow control). "
+                   "Both devices of a link must use the same value. 0 disables flow control. Not "
+                   "supported on remote channels.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&PointToPointNetDevice::SetFlowControlBuffer,
+                                         &PointToPointNetDevice::GetFlowControlBuffer),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("VirtualChannels",
+                   "Virtual channels multiplexed on the link, each with its own transmit queue and, "
+                   "with flow control, its own FlowControlBuffer slots and credits. Packets go on the "
+                   "channel of their VirtualChannelTag. Both devices of a link must use the same value.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&PointToPointNetDevice::SetVirtualChannels,
+                                         &PointToPointNetDevice::GetVirtualChannels),
+                   MakeUintegerChecker<uint8_t> (1))
 
     //
     // Transmit queueing discipline for the device which includes its own set
@@ -77,6 +100,12 @@ PointToPointNetDevice::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&PointToPointNetDevice::m_queue),
                    MakePointerChecker<Queue> ())
+    .AddAttribute ("VirtualChannelQueues",
+                   "The transmit queues of all the virtual channels, TxQueue first.",
+                   ObjectVectorValue (),
+                   MakeObjectVectorAccessor (&PointToPointNetDevice::GetVirtualChannels,
+                                             &PointToPointNetDevice::GetVirtualChannelQueue),
+                   MakeObjectVectorChecker<Queue> ())
 
     //
     // Trace sources at the "top" of the net device, where packets transition
@@ -149,9 +178,24 @@ PointToPointNetDevice::PointToPointNetDevice ()
     m_txMachineState (READY),
     m_channel (0),
     m_linkUp (false),
-    m_currentPkt (0)
+    m_currentPkt (0),
+    m_nVcs (1),
+    m_txVc (0),
+    m_fcBuffer (0),
+    m_txCredits (1, 0),
+    m_rxBuffered (1, 0),
+    m_held (1),
+    m_heldFirst (1, false),
+    m_rxBufferedTotal (0),
+    m_fcReceiving (false),
+    m_currentInput (0),
+    m_currentInputVc (0)
 {
   NS_LOG_FUNCTION (this);
+  m_fcStatistics.creditStalls = 0;
+  m_fcStatistics.peakBuffered = 0;
+  m_fcStatistics.peakQueued = 0;
+  m_fcStatistics.peakHeld = 0;
 }
 
 PointToPointNetDevice::~PointToPointNetDevice ()
@@ -186,6 +230,8 @@ PointToPointNetDevice::DoDispose ()
   m_channel = 0;
   m_receiveErrorModel = 0;
   m_currentPkt = 0;
+  m_vcQueues.clear ();
+  m_held.clear ();
   NetDevice::DoDispose ();
 }
 
@@ -217,9 +263,29 @@ PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
   NS_ASSERT_MSG (m_txMachineState == READY, "Must be READY to transmit");
   m_txMachineState = BUSY;
   m_currentPkt = p;
+  if (m_fcBuffer > 0)
+    {
+      NS_ASSERT_MSG (m_txCredits[m_txVc] > 0, "Must have a credit to transmit");
+      m_txCredits[m_txVc]--;
+      FlowControlTag tag;
+      m_currentInput = 0;
+      if (p->PeekPacketTag (tag))
+        {
+          m_currentInput = tag.GetIfIndex () + 1;
+          m_currentInputVc = tag.GetVirtualChannel ();
+        }
+    }
   m_phyTxBeginTrace (m_currentPkt);
 
-  Time txTime = Seconds (m_bps.CalculateTxTime (p->GetSize ()));
+  // A packet of a transport with segmentation offload goes out as all of
+  // its wire segments, each with its own headers
+  uint32_t wireSize = p->GetSize ();
+  SegmentationOffloadTag offloadTag;
+  if (p->PeekPacketTag (offloadTag) && offloadTag.GetSegments () > 1)
+    {
+      wireSize += offloadTag.GetExtraWireSize () + (offloadTag.GetSegments () - 1) * PppHeader ().GetSerializedSize ();
+    }
+  Time txTime = Seconds (m_bps.CalculateTxTime (wireSize));
   Time txCompleteTime = txTime + m_tInterframeGap;
 
   NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << txCompleteTime.GetSeconds () << "sec");
@@ -252,12 +318,23 @@ PointToPointNetDevice::TransmitComplete (void)
   m_phyTxEndTrace (m_currentPkt);
   m_currentPkt = 0;
 
-  Ptr<Packet> p = m_queue->Dequeue ();
+  if (m_fcBuffer > 0)
+    {
+      // The packet has left the node, free its slot on the input link
+      ReleaseInput (m_currentInput, m_currentInputVc);
+      m_currentInput = 0;
+    }
+
+  Ptr<Packet> p = DequeueNext ();
   if (p == 0)
     {
       //
-      // No packet was on the queue, so we just exit.
+      // No packet was on the queues, or none has a credit, so we just exit.
       //
+      if (m_fcBuffer > 0 && GetNQueued () > 0)
+        {
+          m_fcStatistics.creditStalls++;
+        }
       return;
     }
 
@@ -314,6 +391,10 @@ PointToPointNetDevice::Receive (Ptr<Packet> packet)
       // corrupted packet, don't forward this packet up, let it go.
       //
       m_phyRxDropTrace (packet);
+      if (m_fcBuffer > 0)
+        {
+          m_channel->TransmitCredit (this, GetVirtualChannel (packet));
+        }
     }
   else 
     {
@@ -340,8 +421,228 @@ PointToPointNetDevice::Receive (Ptr<Packet> packet)
           m_promiscCallback (this, packet, protocol, GetRemote (), GetAddress (), NetDevice::PACKET_HOST);
         }
 
+      uint32_t vc = GetVirtualChannel (packet);
+      if (m_fcBuffer > 0)
+        {
+          // Hold a slot of the virtual channel the packet came on until
+          // the packet is forwarded or consumed
+          FlowControlTag tag (m_ifIndex, vc);
+          packet->ReplacePacketTag (tag);
+          m_rxBuffered[vc]++;
+          m_rxBufferedTotal++;
+          m_fcStatistics.peakBuffered = std::max (m_fcStatistics.peakBuffered, m_rxBufferedTotal);
+          m_fcReceiving = true;
+        }
+
       m_macRxTrace (packet);
       m_rxCallback (this, packet, protocol, GetRemote ());
+
+      if (m_fcReceiving)
+        {
+          // Delivered locally or dropped
+          m_fcReceiving = false;
+          ReleaseBuffer (vc);
+        }
+    }
+}
+
+void
+PointToPointNetDevice::SetFlowControlBuffer (uint32_t packets)
+{
+  NS_LOG_FUNCTION (this << packets);
+  m_fcBuffer = packets;
+  m_txCredits.assign (m_nVcs, packets);
+}
+
+uint32_t
+PointToPointNetDevice::GetFlowControlBuffer (void) const
+{
+  return m_fcBuffer;
+}
+
+void
+PointToPointNetDevice::SetVirtualChannels (uint32_t vcs)
+{
+  NS_LOG_FUNCTION (this << vcs);
+  NS_ASSERT_MSG (vcs >= 1, "A device needs at least one virtual channel");
+  m_nVcs = vcs;
+  m_vcQueues.assign (m_nVcs - 1, 0);
+  m_txVc = 0;
+  m_txCredits.assign (m_nVcs, m_fcBuffer);
+  m_rxBuffered.assign (m_nVcs, 0);
+  m_rxBufferedTotal = 0;
+  m_held.assign (m_nVcs, std::deque<Ptr<Packet> > ());
+  m_heldFirst.assign (m_nVcs, false);
+}
+
+uint32_t
+PointToPointNetDevice::GetVirtualChannels (void) const
+{
+  return m_nVcs;
+}
+
+void
+PointToPointNetDevice::SetVirtualChannelQueue (uint32_t vc, Ptr<Queue> queue)
+{
+  NS_LOG_FUNCTION (this << vc << queue);
+  NS_ASSERT_MSG (vc < m_nVcs, "No virtual channel " << vc);
+  if (vc == 0)
+    {
+      m_queue = queue;
+    }
+  else
+    {
+      m_vcQueues[vc - 1] = queue;
+    }
+}
+
+Ptr<Queue>
+PointToPointNetDevice::GetVirtualChannelQueue (uint32_t vc) const
+{
+  NS_ASSERT (vc < m_nVcs);
+  if (vc == 0)
+    {
+      return m_queue;
+    }
+  if (m_vcQueues[vc - 1] == 0)
+    {
+      ObjectFactory factory;
+      factory.SetTypeId (m_queue->GetInstanceTypeId ());
+      m_vcQueues[vc - 1] = factory.Create<Queue> ();
+    }
+  return m_vcQueues[vc - 1];
+}
+
+uint32_t
+PointToPointNetDevice::GetVirtualChannel (Ptr<const Packet> p) const
+{
+  if (m_nVcs == 1)
+    {
+      return 0;
+    }
+  VirtualChannelTag tag;
+  if (!p->PeekPacketTag (tag))
+    {
+      return 0;
+    }
+  return std::min<uint32_t> (tag.GetVirtualChannel (), m_nVcs - 1);
+}
+
+uint32_t
+PointToPointNetDevice::GetNQueued (void) const
+{
+  uint32_t queued = m_queue->GetNPackets ();
+  for (std::vector<Ptr<Queue> >::const_iterator i = m_vcQueues.begin (); i != m_vcQueues.end (); ++i)
+    {
+      if (*i != 0)
+        {
+          queued += (*i)->GetNPackets ();
+        }
+    }
+  for (uint32_t vc = 0; vc < m_held.size (); vc++)
+    {
+      queued += m_held[vc].size ();
+    }
+  return queued;
+}
+
+Ptr<Packet>
+PointToPointNetDevice::DequeueNext (void)
+{
+  // Round robin from the virtual channel after the last one served, over
+  // the channels with a packet waiting and, with flow control, a credit.
+  // Held packets and the transmit queue of a channel take turns
+  for (uint32_t i = 1; i <= m_nVcs; i++)
+    {
+      uint32_t vc = (m_txVc + i) % m_nVcs;
+      if (m_fcBuffer > 0 && m_txCredits[vc] == 0)
+        {
+          continue;
+        }
+      Ptr<Queue> queue = vc == 0 ? m_queue : m_vcQueues[vc - 1];
+      bool queued = queue != 0 && !queue->IsEmpty ();
+      if (!queued && m_held[vc].empty ())
+        {
+          continue;
+        }
+      m_txVc = vc;
+      if (!m_held[vc].empty () && (!queued || m_heldFirst[vc]))
+        {
+          m_heldFirst[vc] = false;
+          Ptr<Packet> p = m_held[vc].front ();
+          m_held[vc].pop_front ();
+          return p;
+        }
+      m_heldFirst[vc] = !m_held[vc].empty ();
+      return queue->Dequeue ();
+    }
+  return 0;
+}
+
+void
+PointToPointNetDevice::ReceiveCredit (uint32_t vc)
+{
+  NS_LOG_FUNCTION (this << vc);
+  NS_ASSERT_MSG (m_txCredits[vc] < m_fcBuffer, "More credits than the peer has buffers");
+  m_txCredits[vc]++;
+  if (m_txMachineState == READY)
+    {
+      Ptr<Packet> p = DequeueNext ();
+      if (p != 0)
+        {
+          m_snifferTrace (p);
+          m_promiscSnifferTrace (p);
+          TransmitStart (p);
+        }
+    }
+}
+
+const PointToPointNetDevice::FlowControlStatistics &
+PointToPointNetDevice::GetFlowControlStatistics (void) const
+{
+  return m_fcStatistics;
+}
+
+uint32_t
+PointToPointNetDevice::ClaimBuffer (Ptr<Packet> p, uint32_t &inputVc)
+{
+  FlowControlTag tag;
+  if (!p->PeekPacketTag (tag))
+    {
+      return 0;
+    }
+  uint32_t ifIndex = tag.GetIfIndex ();
+  if (ifIndex < m_node->GetNDevices ())
+    {
+      Ptr<PointToPointNetDevice> input = DynamicCast<PointToPointNetDevice> (m_node->GetDevice (ifIndex));
+      if (input != 0 && input->m_fcReceiving)
+        {
+          input->m_fcReceiving = false;
+          inputVc = tag.GetVirtualChannel ();
+          return ifIndex + 1;
+        }
+    }
+  // Left over from an earlier reception, the slot is already free
+  p->RemovePacketTag (tag);
+  return 0;
+}
+
+void
+PointToPointNetDevice::ReleaseBuffer (uint32_t vc)
+{
+  NS_LOG_FUNCTION (this << vc);
+  NS_ASSERT (m_rxBuffered[vc] > 0);
+  m_rxBuffered[vc]--;
+  m_rxBufferedTotal--;
+  m_channel->TransmitCredit (this, vc);
+}
+
+void
+PointToPointNetDevice::ReleaseInput (uint32_t ifIndex, uint32_t vc)
+{
+  if (ifIndex > 0)
+    {
+      DynamicCast<PointToPointNetDevice> (m_node->GetDevice (ifIndex - 1))->ReleaseBuffer (vc);
     }
 }
 
@@ -479,6 +780,11 @@ PointToPointNetDevice::Send (
       return false;
     }
 
+  uint32_t inputVc = 0;
+  uint32_t input = m_fcBuffer > 0 ? ClaimBuffer (packet, inputVc) : 0;
+  uint32_t vc = GetVirtualChannel (packet);
+  Ptr<Queue> queue = GetVirtualChannelQueue (vc);
+
   //
   // Stick a point to point protocol header on the packet in preparation for
   // shoving it out the door.
@@ -488,18 +794,21 @@ PointToPointNetDevice::Send (
   m_macTxTrace (packet);
 
   //
-  // If there's a transmission in progress, we enque the packet for later
-  // transmission; otherwise we send it now.
+  // If there's a transmission in progress, or no credit for the peer's
+  // buffer, we enque the packet for later transmission; otherwise we send
+  // it now. An idle transmitter has nothing queued on the virtual channels
+  // it has credits for, so the packet cannot overtake another one.
   //
-  if (m_txMachineState == READY) 
+  if (m_txMachineState == READY && (m_fcBuffer == 0 || m_txCredits[vc] > 0))
     {
       // 
       // Even if the transmitter is immediately available, we still enqueue and
       // dequeue the packet to hit the tracing hooks.
       //
-      if (m_queue->Enqueue (packet) == true)
+      if (queue->Enqueue (packet) == true)
         {
-          packet = m_queue->Dequeue ();
+          packet = queue->Dequeue ();
+          m_txVc = vc;
           m_snifferTrace (packet);
           m_promiscSnifferTrace (packet);
           return TransmitStart (packet);
@@ -508,12 +817,33 @@ PointToPointNetDevice::Send (
         {
           // Enqueue may fail (overflow)
           m_macTxDropTrace (packet);
+          ReleaseInput (input, inputVc);
           return false;
         }
     }
   else
     {
-      return m_queue->Enqueue (packet);
+      if (m_fcBuffer > 0 && input == 0)
+        {
+          // Nothing to drop it for: the sender would block until the
+          // transmitter takes the packet
+          m_held[vc].push_back (packet);
+          m_fcStatistics.peakHeld = std::max<uint32_t> (m_fcStatistics.peakHeld, m_held[vc].size ());
+        }
+      else if (!queue->Enqueue (packet))
+        {
+          ReleaseInput (input, inputVc);
+          return false;
+        }
+      if (m_fcBuffer > 0)
+        {
+          if (m_txMachineState == READY)
+            {
+              m_fcStatistics.creditStalls++;
+            }
+          m_fcStatistics.peakQueued = std::max (m_fcStatistics.peakQueued, GetNQueued ());
+        }
+      return true;
     }
 }
 
@@ -20,6 +20,8 @@
 #define POINT_TO_POINT_NET_DEVICE_H
 
 #include <cstring>
+#include <deque>
+#include <vector>
 #include "ns3/address.h"
 #include "ns3/node.h"
 #include "ns3/net-device.h"
@@ -144,6 +146,81 @@ public:
    */
   void Receive (Ptr<Packet> p);
 
+  /**
+   * \brief Counters of the link-level flow control
+   */
+  struct FlowControlStatistics
+  {
+    uint64_t creditStalls;    // times a queued packet waited for a credit
+    uint32_t peakBuffered;    // most packets held in the receive buffers
+    uint32_t peakQueued;      // most packets in the transmit queues
+    uint32_t peakHeld;        // most packets of the node's own senders held on a virtual channel
+  };
+
+  /**
+   * Set the depth in packets of the receive buffer, 0 to disable flow
+   * control. The peer starts with as many credits, so both devices of a
+   * link must use the same depth, and it must be set before the first
+   * packet is sent.
+   *
+   * A received packet holds a slot until it leaves the node: until the
+   * device it is forwarded on has transmitted it, or right away if it is
+   * delivered locally. Only packets forwarded by a device with flow
+   * control enabled are tracked, so all the devices of a node should use
+   * it. Packets the node sends itself do not need credits to be queued,
+   * only to be transmitted. They are never dropped: they wait outside the
+   * transmit queue, as a blocked sender would, and take turns with the
+   * forwarded packets of their virtual channel.
+   *
+   * @param packets the number of packets the peer may have in flight
+   */
+  void SetFlowControlBuffer (uint32_t packets);
+  uint32_t GetFlowControlBuffer (void) const;
+
+  /**
+   * Set the number of virtual channels, which the peer must match. Each
+   * has its own transmit queue, virtual channel 0 the one of SetQueue,
+   * and with flow control its own FlowControlBuffer slots and credits, so a packet
+   * blocked on one virtual channel does not hold up the others. The
+   * transmitter serves the virtual channels that have a packet and a
+   * credit round robin.
+   *
+   * Packets are sent on the virtual channel of their VirtualChannelTag,
+   * or the last one if the tag names a higher one, and on virtual channel
+   * 0 without the tag. The protocol that forwards a packet chooses the
+   * virtual channel of the next hop; a received packet keeps the tag it
+   * arrived with until then.
+   *
+   * @param vcs the number of virtual channels, at least 1
+   */
+  void SetVirtualChannels (uint32_t vcs);
+  uint32_t GetVirtualChannels (void) const;
+
+  /**
+   * Attach the transmit queue of a virtual channel. Virtual channels
+   * without one get a queue of the type of the queue of virtual channel 0,
+   * with default attributes, when they are first used.
+   *
+   * @param vc the virtual channel, below GetVirtualChannels ()
+   * @param queue Ptr to the new queue.
+   */
+  void SetVirtualChannelQueue (uint32_t vc, Ptr<Queue> queue);
+
+  /**
+   * @returns the packets waiting to be transmitted on all the virtual
+   * channels, in the transmit queues or held for the node's own senders
+   */
+  uint32_t GetNQueued (void) const;
+
+  /**
+   * Receive a flow control credit for a virtual channel from a connected
+   * PointToPointChannel, and transmit the next queued packet if the device
+   * was waiting for it.
+   */
+  void ReceiveCredit (uint32_t vc);
+
+  const FlowControlStatistics &GetFlowControlStatistics (void) const;
+
   // The remaining methods are documented in ns3::NetDevice*
 
   virtual void SetIfIndex (const uint32_t index);
@@ -248,6 +325,27 @@ private:
 
   void NotifyLinkUp (void);
 
+  /**
+   * Claim the receive buffer slot of a packet being forwarded from another
+   * device of this node, so that it is freed after transmission instead of
+   * when the receiving device has handed the packet up.
+   * @param inputVc set to the virtual channel the packet arrived on
+   * @returns the index of the input device plus one, 0 if none
+   */
+  uint32_t ClaimBuffer (Ptr<Packet> p, uint32_t &inputVc);
+  // Free a slot of the receive buffer of a virtual channel and send the
+  // credit to the peer
+  void ReleaseBuffer (uint32_t vc);
+  // Free the slot held by a packet forwarded through this device, if any
+  void ReleaseInput (uint32_t ifIndex, uint32_t vc);
+
+  // Virtual channel of the VirtualChannelTag of a packet
+  uint32_t GetVirtualChannel (Ptr<const Packet> p) const;
+  // Transmit queue of a virtual channel, created if it has none
+  Ptr<Queue> GetVirtualChannelQueue (uint32_t vc) const;
+  // Next packet to transmit, 0 if no virtual channel can send
+  Ptr<Packet> DequeueNext (void);
+
   /**
    * Enumeration of the states of the transmit machine of the net device.
    */
@@ -451,6 +549,29 @@ private:
 
   Ptr<Packet> m_currentPkt;
 
+  uint32_t m_nVcs;
+  // Transmit queues of virtual channels 1 and up, 0 until set or used
+  mutable std::vector<Ptr<Queue> > m_vcQueues;
+  // Virtual channel of the last packet dequeued for transmission
+  uint32_t m_txVc;
+
+  // Receive buffer depth per virtual channel, 0 without flow control
+  uint32_t m_fcBuffer;
+  std::vector<uint32_t> m_txCredits;
+  std::vector<uint32_t> m_rxBuffered;
+  // Packets of the node's own senders waiting for the transmitter, with
+  // flow control, and whether they go before the transmit queue next
+  std::vector<std::deque<Ptr<Packet> > > m_held;
+  std::vector<bool> m_heldFirst;
+  uint32_t m_rxBufferedTotal;
+  // Set while the packet being handed up has not been forwarded yet
+  bool m_fcReceiving;
+  // Input device of m_currentPkt plus one, 0 if it holds no slot, and the
+  // virtual channel it arrived on
+  uint32_t m_currentInput;
+  uint32_t m_currentInputVc;
+  FlowControlStatistics m_fcStatistics;
+
   /**
    * \brief PPP to Ethernet protocol number mapping
    * \param protocol A PPP protocol number
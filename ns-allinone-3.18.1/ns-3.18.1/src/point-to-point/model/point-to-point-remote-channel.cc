@@ -25,7 +25,10 @@
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/uinteger.h"
 #include "ns3/mpi-interface.h"
+#include "ns3/multithreaded-simulator-impl.h"
 
 NS_LOG_COMPONENT_DEFINE ("PointToPointRemoteChannel");
 
@@ -45,12 +48,49 @@ PointToPointRemoteChannel::GetTypeId (void)
 
 PointToPointRemoteChannel::PointToPointRemoteChannel ()
 {
+  for (uint32_t i = 0; i < N_WIRES; ++i)
+    {
+      m_src[i] = 0;
+      m_dstNode[i] = 0;
+      m_dstIfIndex[i] = 0;
+    }
 }
 
 PointToPointRemoteChannel::~PointToPointRemoteChannel ()
 {
 }
 
+void
+PointToPointRemoteChannel::Attach (Ptr<PointToPointNetDevice> device)
+{
+  NS_LOG_FUNCTION (this << device);
+  PointToPointChannel::Attach (device);
+  if (GetNDevices () != N_WIRES)
+    {
+      return;
+    }
+  // Packet::Serialize does not carry the CutThroughTag of an early packet
+  UintegerValue cutThroughHeaderSize;
+  GetAttribute ("CutThroughHeaderSize", cutThroughHeaderSize);
+  NS_ABORT_MSG_IF (cutThroughHeaderSize.Get () > 0,
+                   "PointToPointRemoteChannel::Attach(): cut-through is not supported across partitions");
+
+  // Credits are returned to the peer device directly, which lives in another partition
+  for (uint32_t wire = 0; wire < N_WIRES; ++wire)
+    {
+      NS_ABORT_MSG_IF (GetSource (wire)->GetFlowControlBuffer () > 0,
+                       "PointToPointRemoteChannel::Attach(): flow control is not supported across partitions");
+    }
+
+  for (uint32_t wire = 0; wire < N_WIRES; ++wire)
+    {
+      Ptr<PointToPointNetDevice> dst = GetDestination (wire);
+      m_src[wire] = PeekPointer (GetSource (wire));
+      m_dstNode[wire] = dst->GetNode ()->GetId ();
+      m_dstIfIndex[wire] = dst->GetIfIndex ();
+    }
+}
+
 bool
 PointToPointRemoteChannel::TransmitStart (
   Ptr<Packet> p,
@@ -62,13 +102,17 @@ PointToPointRemoteChannel::TransmitStart (
 
   IsInitialized ();
 
-  uint32_t wire = src == GetSource (0) ? 0 : 1;
-  Ptr<PointToPointNetDevice> dst = GetDestination (wire);
+  uint32_t wire = PeekPointer (src) == m_src[0] ? 0 : 1;
 
-#ifdef NS3_MPI
   // Calculate the rxTime (absolute)
   Time rxTime = Simulator::Now () + txTime + GetDelay ();
-  MpiInterface::SendPacket (p, rxTime, dst->GetNode ()->GetId (), dst->GetIfIndex ());
+  if (MultithreadedSimulatorImpl::IsEnabled ())
+    {
+      MultithreadedSimulatorImpl::SendPacket (p, rxTime, m_dstNode[wire], m_dstIfIndex[wire]);
+      return true;
+    }
+#ifdef NS3_MPI
+  MpiInterface::SendPacket (p, rxTime, m_dstNode[wire], m_dstIfIndex[wire]);
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
@@ -38,7 +38,16 @@ public:
   static TypeId GetTypeId (void);
   PointToPointRemoteChannel ();
   ~PointToPointRemoteChannel ();
+  virtual void Attach (Ptr<PointToPointNetDevice> device);
   virtual bool TransmitStart (Ptr<Packet> p, Ptr<PointToPointNetDevice> src, Time txTime);
+
+private:
+  static const uint32_t N_WIRES = 2;
+  // Per wire, cached at attach time so that sending never touches the
+  // reference counts of devices that may belong to another thread
+  PointToPointNetDevice *m_src[N_WIRES];
+  uint32_t m_dstNode[N_WIRES];
+  uint32_t m_dstIfIndex[N_WIRES];
 };
 }
 
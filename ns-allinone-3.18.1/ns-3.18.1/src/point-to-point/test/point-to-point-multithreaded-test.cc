@@ -0,0 +1,222 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/global-value.h"
+#include "ns3/string.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include <vector>
+
+using namespace ns3;
+
+static const uint32_t N_NODES = 8;
+static const uint32_t N_PACKETS = 50;
+
+/*
+ * A chain of nodes forwards packets from every node to both ends, across
+ * PointToPointRemoteChannels where the chain is split into partitions.
+ * MultithreadedSimulatorImpl must give every node the same packets at the
+ * same times and in the same order on one thread and on one thread per
+ * partition, and process the same number of events.
+ */
+class MultithreadedSimulatorTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorTestCase ();
+private:
+  virtual void DoRun (void);
+
+  struct Reception
+  {
+    int64_t ts;
+    uint32_t source;
+    uint32_t seq;
+  };
+  struct Result
+  {
+    std::vector<std::vector<Reception> > receptions; // per node
+    uint64_t events;
+    int64_t end;
+  };
+
+  // Run the chain split into nPartitions partitions
+  Result Run (uint32_t nPartitions);
+  void Send (Ptr<NetDevice> device, uint32_t source, uint32_t seq, uint8_t hops);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+  void Compare (const Result &expected, const Result &result, uint32_t nPartitions);
+
+  // Next device towards each end of the chain, per node, 0 at the ends
+  std::vector<Ptr<NetDevice> > m_left;
+  std::vector<Ptr<NetDevice> > m_right;
+  // Written by the thread of the partition of the node only
+  Result *m_result;
+};
+
+MultithreadedSimulatorTestCase::MultithreadedSimulatorTestCase ()
+  : TestCase ("MultithreadedSimulatorImpl runs a partitioned chain like a single thread")
+{
+}
+
+void
+MultithreadedSimulatorTestCase::Send (Ptr<NetDevice> device, uint32_t source, uint32_t seq, uint8_t hops)
+{
+  uint8_t data[9];
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      data[i] = static_cast<uint8_t> (source >> (8 * i));
+      data[4 + i] = static_cast<uint8_t> (seq >> (8 * i));
+    }
+  data[8] = hops;
+  device->Send (Create<Packet> (data, sizeof (data)), device->GetBroadcast (), 0x800);
+}
+
+bool
+MultithreadedSimulatorTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                                         const Address &from)
+{
+  uint8_t data[9];
+  p->CopyData (data, sizeof (data));
+  Reception reception;
+  reception.ts = Simulator::Now ().GetTimeStep ();
+  reception.source = 0;
+  reception.seq = 0;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      reception.source |= static_cast<uint32_t> (data[i]) << (8 * i);
+      reception.seq |= static_cast<uint32_t> (data[4 + i]) << (8 * i);
+    }
+  uint32_t node = device->GetNode ()->GetId ();
+  m_result->receptions[node].push_back (reception);
+
+  // Keep going away from the device the packet came in on
+  if (data[8] > 1)
+    {
+      Ptr<NetDevice> next = device == m_left[node] ? m_right[node] : m_left[node];
+      Send (next, reception.source, reception.seq, data[8] - 1);
+    }
+  return true;
+}
+
+MultithreadedSimulatorTestCase::Result
+MultithreadedSimulatorTestCase::Run (uint32_t nPartitions)
+{
+  Result result;
+  result.receptions.resize (N_NODES);
+  m_result = &result;
+
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      nodes.push_back (CreateObject<Node> (i * nPartitions / N_NODES));
+    }
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue ("500ns"));
+  m_left.assign (N_NODES, 0);
+  m_right.assign (N_NODES, 0);
+  for (uint32_t i = 0; i + 1 < N_NODES; i++)
+    {
+      NetDeviceContainer devices = pointToPoint.Install (nodes[i], nodes[i + 1]);
+      m_right[i] = devices.Get (0);
+      m_left[i + 1] = devices.Get (1);
+    }
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      for (uint32_t j = 0; j < nodes[i]->GetNDevices (); j++)
+        {
+          nodes[i]->GetDevice (j)->SetReceiveCallback (MakeCallback (&MultithreadedSimulatorTestCase::Receive, this));
+        }
+    }
+
+  // Every node sends to both ends at its own offset, so that packets from
+  // different partitions do not reach a node at the same time
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      for (uint32_t k = 0; k < N_PACKETS; k++)
+        {
+          Time t = NanoSeconds (1000 * k + 37 * i);
+          if (m_left[i])
+            {
+              Simulator::ScheduleWithContext (i, t, &MultithreadedSimulatorTestCase::Send, this,
+                                              m_left[i], i, 2 * k, i);
+            }
+          if (m_right[i])
+            {
+              Simulator::ScheduleWithContext (i, t, &MultithreadedSimulatorTestCase::Send, this,
+                                              m_right[i], i, 2 * k + 1, N_NODES - 1 - i);
+            }
+        }
+    }
+
+  Simulator::Run ();
+  result.events = Simulator::GetEventCount ();
+  result.end = Simulator::Now ().GetTimeStep ();
+  m_left.clear ();
+  m_right.clear ();
+  Simulator::Destroy ();
+  m_result = 0;
+  return result;
+}
+
+void
+MultithreadedSimulatorTestCase::Compare (const Result &expected, const Result &result, uint32_t nPartitions)
+{
+  for (uint32_t node = 0; node < N_NODES; node++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (result.receptions[node].size (), expected.receptions[node].size (),
+                             "Node " << node << " received other packets with " << nPartitions << " threads");
+      for (uint32_t i = 0; i < expected.receptions[node].size (); i++)
+        {
+          const Reception &a = expected.receptions[node][i];
+          const Reception &b = result.receptions[node][i];
+          NS_TEST_ASSERT_MSG_EQ (b.source, a.source, "Reception " << i << " of node " << node
+                                 << " from another source with " << nPartitions << " threads");
+          NS_TEST_ASSERT_MSG_EQ (b.seq, a.seq, "Reception " << i << " of node " << node
+                                 << " of another packet with " << nPartitions << " threads");
+          NS_TEST_ASSERT_MSG_EQ (b.ts, a.ts, "Reception " << i << " of node " << node
+                                 << " at another time with " << nPartitions << " threads");
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (result.events, expected.events, "Other event count with " << nPartitions << " threads");
+  NS_TEST_ASSERT_MSG_EQ (result.end, expected.end, "Other end time with " << nPartitions << " threads");
+}
+
+void
+MultithreadedSimulatorTestCase::DoRun (void)
+{
+  StringValue implementation;
+  GlobalValue::GetValueByName ("SimulatorImplementationType", implementation);
+  Simulator::Destroy ();
+
+  Result expected = Run (1);
+  uint32_t received = 0;
+  for (uint32_t node = 0; node < N_NODES; node++)
+    {
+      received += expected.receptions[node].size ();
+    }
+  // Every packet reaches every node on its way to an end of the chain
+  NS_TEST_ASSERT_MSG_EQ (received, N_NODES * (N_NODES - 1) * N_PACKETS, "Packets lost");
+
+  Compare (expected, Run (2), 2);
+  Compare (expected, Run (4), 4);
+
+  GlobalValue::Bind ("SimulatorImplementationType", implementation);
+}
+
+class PointToPointMultithreadedTestSuite : public TestSuite
+{
+public:
+  PointToPointMultithreadedTestSuite ();
+};
+
+PointToPointMultithreadedTestSuite::PointToPointMultithreadedTestSuite ()
+  : TestSuite ("devices-point-to-point-multithreaded", UNIT)
+{
+  AddTestCase (new MultithreadedSimulatorTestCase, TestCase::QUICK);
+}
+
+static PointToPointMultithreadedTestSuite g_pointToPointMultithreadedTestSuite;
@@ -3,6 +3,13 @@
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/uinteger.h"
+#include "ns3/data-rate.h"
+#include "ns3/virtual-channel-tag.h"
+#include "ns3/segmentation-offload-tag.h"
+#include "ns3/cut-through-tag.h"
+#include <map>
+#include <vector>
 
 using namespace ns3;
 
@@ -56,6 +63,439 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 //-----------------------------------------------------------------------------
+class PointToPointFlowControlTest : public TestCase
+{
+public:
+  PointToPointFlowControlTest (uint32_t buffer);
+
+  virtual void DoRun (void);
+
+private:
+  bool Forward (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+  void SendPackets (Ptr<PointToPointNetDevice> device, uint32_t count);
+
+  uint32_t m_buffer;
+  Ptr<PointToPointNetDevice> m_forwardDevice;
+  uint32_t m_received;
+};
+
+PointToPointFlowControlTest::PointToPointFlowControlTest (uint32_t buffer)
+  : TestCase (buffer > 0 ? "PointToPoint credit-based flow control" : "PointToPoint without flow control"),
+    m_buffer (buffer),
+    m_received (0)
+{
+}
+
+bool
+PointToPointFlowControlTest::Forward (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                                      const Address &from)
+{
+  m_forwardDevice->Send (p->Copy (), m_forwardDevice->GetBroadcast (), protocol);
+  return true;
+}
+
+bool
+PointToPointFlowControlTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                                      const Address &from)
+{
+  m_received++;
+  return true;
+}
+
+void
+PointToPointFlowControlTest::SendPackets (Ptr<PointToPointNetDevice> device, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; i++)
+    {
+      device->Send (Create<Packet> (1000), device->GetBroadcast (), 0x800);
+    }
+}
+
+void
+PointToPointFlowControlTest::DoRun (void)
+{
+  // a sends a burst to c through b, whose link to c is ten times slower and
+  // whose transmit queue only holds two packets, while b saturates that
+  // link with a burst of its own
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<Node> c = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devAB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devBA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devBC = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devCB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channelAB = CreateObject<PointToPointChannel> ();
+  Ptr<PointToPointChannel> channelBC = CreateObject<PointToPointChannel> ();
+  channelAB->SetAttribute ("Delay", TimeValue (MicroSeconds (10)));
+  channelBC->SetAttribute ("Delay", TimeValue (MicroSeconds (10)));
+
+  Ptr<PointToPointNetDevice> devices[] = { devAB, devBA, devBC, devCB };
+  Ptr<Node> nodes[] = { a, b, b, c };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      devices[i]->SetAttribute ("DataRate", DataRateValue (DataRate (i < 2 ? "10Mbps" : "1Mbps")));
+      devices[i]->SetAttribute ("FlowControlBuffer", UintegerValue (m_buffer));
+      devices[i]->Attach (i < 2 ? channelAB : channelBC);
+      devices[i]->SetAddress (Mac48Address::Allocate ());
+      Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+      queue->SetAttribute ("MaxPackets", UintegerValue (devices[i] == devBC ? 2 : 100));
+      devices[i]->SetQueue (queue);
+      nodes[i]->AddDevice (devices[i]);
+    }
+  m_forwardDevice = devBC;
+  devBA->SetReceiveCallback (MakeCallback (&PointToPointFlowControlTest::Forward, this));
+  devCB->SetReceiveCallback (MakeCallback (&PointToPointFlowControlTest::Receive, this));
+
+  Simulator::Schedule (Seconds (1.0), &PointToPointFlowControlTest::SendPackets, this, devAB, 20);
+  Simulator::Schedule (Seconds (1.0), &PointToPointFlowControlTest::SendPackets, this, devBC, 20);
+
+  Simulator::Run ();
+
+  if (m_buffer > 0)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_received, 40, "Flow control must not lose packets");
+      NS_TEST_EXPECT_MSG_EQ (devBA->GetFlowControlStatistics ().peakBuffered, m_buffer, "Receive buffer overrun");
+      NS_TEST_EXPECT_MSG_GT (devAB->GetFlowControlStatistics ().creditStalls, 0, "Sender never waited");
+      NS_TEST_EXPECT_MSG_EQ (devAB->GetQueue ()->GetNPackets (), 0, "Packets left waiting for credits");
+      NS_TEST_EXPECT_MSG_GT (devBC->GetFlowControlStatistics ().peakHeld, 0, "The sender of b never waited");
+      NS_TEST_EXPECT_MSG_EQ (devBC->GetNQueued (), 0, "Packets of b left waiting");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_LT (m_received, 40, "The queue of b should have overflowed");
+    }
+
+  Simulator::Destroy ();
+  m_forwardDevice = 0;
+}
+//-----------------------------------------------------------------------------
+class PointToPointDatelineTest : public TestCase
+{
+public:
+  PointToPointDatelineTest (uint32_t vcs);
+
+  virtual void DoRun (void);
+
+private:
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+  void Send (uint32_t node, Ptr<Packet> p, uint32_t vc);
+  void SendPackets (uint32_t node, uint32_t count);
+
+  static const uint32_t RING = 4;
+  uint32_t m_vcs;
+  std::vector<Ptr<Node> > m_nodes;
+  // Device of every node to the next one on the ring
+  std::vector<Ptr<PointToPointNetDevice> > m_out;
+  std::map<uint64_t, uint32_t> m_destinations;
+  uint32_t m_received;
+};
+
+PointToPointDatelineTest::PointToPointDatelineTest (uint32_t vcs)
+  : TestCase (vcs > 1 ? "PointToPoint dateline virtual channels on a ring" : "PointToPoint ring deadlock"),
+    m_vcs (vcs),
+    m_received (0)
+{
+}
+
+void
+PointToPointDatelineTest::Send (uint32_t node, Ptr<Packet> p, uint32_t vc)
+{
+  VirtualChannelTag tag (vc);
+  p->ReplacePacketTag (tag);
+  m_out[node]->Send (p, m_out[node]->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointDatelineTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                                   const Address &from)
+{
+  uint32_t node = 0;
+  while (m_nodes[node] != device->GetNode ())
+    {
+      node++;
+    }
+  if (m_destinations[p->GetUid ()] == node)
+    {
+      m_received++;
+      return true;
+    }
+  // Packets move to the upper virtual channel on the link from the last
+  // node back to the first one, and stay on it
+  VirtualChannelTag tag;
+  p->PeekPacketTag (tag);
+  uint32_t vc = (m_vcs > 1 && node == RING - 1) ? 1 : tag.GetVirtualChannel ();
+  Send (node, p->Copy (), vc);
+  return true;
+}
+
+void
+PointToPointDatelineTest::SendPackets (uint32_t node, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1000);
+      m_destinations[p->GetUid ()] = (node + 2) % RING;
+      Send (node, p, (m_vcs > 1 && node == RING - 1) ? 1 : 0);
+    }
+}
+
+void
+PointToPointDatelineTest::DoRun (void)
+{
+  // Every node of a unidirectional ring sends a burst two hops ahead over
+  // links with a one packet receive buffer per virtual channel. Each node
+  // fills the buffer of the next one with a packet that waits for the
+  // buffer after it, unless the ring has a dateline.
+  for (uint32_t i = 0; i < RING; i++)
+    {
+      m_nodes.push_back (CreateObject<Node> ());
+    }
+  for (uint32_t i = 0; i < RING; i++)
+    {
+      Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+      channel->SetAttribute ("Delay", TimeValue (MicroSeconds (1)));
+      Ptr<PointToPointNetDevice> out = CreateObject<PointToPointNetDevice> ();
+      Ptr<PointToPointNetDevice> in = CreateObject<PointToPointNetDevice> ();
+      Ptr<PointToPointNetDevice> devices[] = { out, in };
+      for (uint32_t j = 0; j < 2; j++)
+        {
+          devices[j]->SetAttribute ("DataRate", DataRateValue (DataRate ("10Mbps")));
+          devices[j]->SetAttribute ("VirtualChannels", UintegerValue (m_vcs));
+          devices[j]->SetAttribute ("FlowControlBuffer", UintegerValue (1));
+          devices[j]->Attach (channel);
+          devices[j]->SetAddress (Mac48Address::Allocate ());
+          devices[j]->SetQueue (CreateObject<DropTailQueue> ());
+          for (uint32_t vc = 1; vc < m_vcs; vc++)
+            {
+              devices[j]->SetVirtualChannelQueue (vc, CreateObject<DropTailQueue> ());
+            }
+        }
+      m_nodes[i]->AddDevice (out);
+      m_nodes[(i + 1) % RING]->AddDevice (in);
+      in->SetReceiveCallback (MakeCallback (&PointToPointDatelineTest::Receive, this));
+      m_out.push_back (out);
+    }
+
+  for (uint32_t i = 0; i < RING; i++)
+    {
+      Simulator::Schedule (Seconds (1.0), &PointToPointDatelineTest::SendPackets, this, i, 3);
+    }
+
+  Simulator::Run ();
+
+  uint32_t queued = 0;
+  for (uint32_t i = 0; i < RING; i++)
+    {
+      queued += m_out[i]->GetNQueued ();
+    }
+  if (m_vcs > 1)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_received, 3 * RING, "The dateline must keep the ring from deadlocking");
+      NS_TEST_EXPECT_MSG_EQ (queued, 0, "Packets left waiting for credits");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_LT (m_received, 3 * RING, "The ring should have deadlocked");
+      NS_TEST_EXPECT_MSG_GT (queued, 0, "A deadlocked ring leaves packets queued");
+    }
+
+  Simulator::Destroy ();
+  m_nodes.clear ();
+  m_out.clear ();
+}
+//-----------------------------------------------------------------------------
+class PointToPointOffloadTest : public TestCase
+{
+public:
+  PointToPointOffloadTest ();
+
+  virtual void DoRun (void);
+
+private:
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+  void SendPackets (Ptr<PointToPointNetDevice> device);
+
+  std::vector<Time> m_rxTimes;
+  std::vector<Time> m_tailTimes;
+};
+
+PointToPointOffloadTest::PointToPointOffloadTest ()
+  : TestCase ("PointToPoint sends an offloaded packet as its wire segments")
+{
+}
+
+bool
+PointToPointOffloadTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                                  const Address &from)
+{
+  CutThroughTag tag;
+  m_rxTimes.push_back (Simulator::Now ());
+  m_tailTimes.push_back (p->PeekPacketTag (tag) ? tag.GetTailTime () : Simulator::Now ());
+  return true;
+}
+
+void
+PointToPointOffloadTest::SendPackets (Ptr<PointToPointNetDevice> device)
+{
+  // Four wire segments of 48 header bytes and the payload, then a plain packet
+  Ptr<Packet> p = Create<Packet> (1000);
+  p->AddPacketTag (SegmentationOffloadTag (4, 48));
+  device->Send (p, device->GetBroadcast (), 0x800);
+  device->Send (Create<Packet> (1000), device->GetBroadcast (), 0x800);
+}
+
+void
+PointToPointOffloadTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MicroSeconds (10)));
+
+  // One byte per microsecond
+  Ptr<PointToPointNetDevice> devices[] = { devA, devB };
+  Ptr<Node> nodes[] = { a, b };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      devices[i]->SetAttribute ("DataRate", DataRateValue (DataRate ("8Mbps")));
+      devices[i]->Attach (channel);
+      devices[i]->SetAddress (Mac48Address::Allocate ());
+      devices[i]->SetQueue (CreateObject<DropTailQueue> ());
+      nodes[i]->AddDevice (devices[i]);
+    }
+  devB->SetReceiveCallback (MakeCallback (&PointToPointOffloadTest::Receive, this));
+
+  Simulator::Schedule (Seconds (1.0), &PointToPointOffloadTest::SendPackets, this, devA);
+
+  Simulator::Run ();
+
+  // The wire carries 1000 + 2 bytes and three more PPP and 48 byte headers
+  NS_TEST_ASSERT_MSG_EQ (m_rxTimes.size (), 2, "Packets lost");
+  NS_TEST_EXPECT_MSG_EQ (m_rxTimes[0], Seconds (1.0) + MicroSeconds (1152 / 4 + 10),
+                         "Not handed on after its first segment");
+  NS_TEST_EXPECT_MSG_EQ (m_tailTimes[0], Seconds (1.0) + MicroSeconds (1152 + 10), "Wrong wire time");
+  NS_TEST_EXPECT_MSG_EQ (m_rxTimes[1], Seconds (1.0) + MicroSeconds (1152 + 1002 + 10),
+                         "The next packet did not wait for all the segments");
+
+  Simulator::Destroy ();
+}
+//-----------------------------------------------------------------------------
+class PointToPointCutThroughTest : public TestCase
+{
+public:
+  PointToPointCutThroughTest ();
+
+  virtual void DoRun (void);
+
+private:
+  bool Forward (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+  void SendPacket (Ptr<PointToPointNetDevice> device, uint32_t size);
+
+  Ptr<PointToPointNetDevice> m_next;
+  // Per hop, the time each packet was handed on and its tail arrived
+  std::vector<Time> m_rxTimes[2];
+  std::vector<Time> m_tailTimes[2];
+};
+
+PointToPointCutThroughTest::PointToPointCutThroughTest ()
+  : TestCase ("PointToPoint cut-through head and tail times through a forwarding node")
+{
+}
+
+bool
+PointToPointCutThroughTest::Forward (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                                     const Address &from)
+{
+  Receive (device, p, protocol, from);
+  // Forward right away, as DimensionOrderedL3Protocol does
+  Ptr<Packet> packet = p->Copy ();
+  CutThroughTag tag;
+  packet->RemovePacketTag (tag);
+  m_next->Send (packet, m_next->GetBroadcast (), protocol);
+  return true;
+}
+
+bool
+PointToPointCutThroughTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                                     const Address &from)
+{
+  uint32_t hop = device == m_next->GetNode ()->GetDevice (0) ? 0 : 1;
+  CutThroughTag tag;
+  m_rxTimes[hop].push_back (Simulator::Now ());
+  m_tailTimes[hop].push_back (p->PeekPacketTag (tag) ? tag.GetTailTime () : Simulator::Now ());
+  return true;
+}
+
+void
+PointToPointCutThroughTest::SendPacket (Ptr<PointToPointNetDevice> device, uint32_t size)
+{
+  device->Send (Create<Packet> (size), device->GetBroadcast (), 0x800);
+}
+
+void
+PointToPointCutThroughTest::DoRun (void)
+{
+  // a - b - c, b forwarding what a sends
+  Ptr<Node> nodes[3];
+  Ptr<PointToPointNetDevice> devices[4];
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      nodes[i] = CreateObject<Node> ();
+    }
+  for (uint32_t link = 0; link < 2; link++)
+    {
+      Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+      channel->SetAttribute ("Delay", TimeValue (MicroSeconds (10)));
+      channel->SetAttribute ("CutThroughHeaderSize", UintegerValue (50));
+      for (uint32_t end = 0; end < 2; end++)
+        {
+          // One byte per microsecond
+          Ptr<PointToPointNetDevice> device = CreateObject<PointToPointNetDevice> ();
+          device->SetAttribute ("DataRate", DataRateValue (DataRate ("8Mbps")));
+          device->Attach (channel);
+          device->SetAddress (Mac48Address::Allocate ());
+          device->SetQueue (CreateObject<DropTailQueue> ());
+          nodes[link + end]->AddDevice (device);
+          devices[2 * link + end] = device;
+        }
+    }
+  m_next = devices[2];
+  devices[1]->SetReceiveCallback (MakeCallback (&PointToPointCutThroughTest::Forward, this));
+  devices[3]->SetReceiveCallback (MakeCallback (&PointToPointCutThroughTest::Receive, this));
+
+  // 1000 and 40 bytes on the wire with the PPP header
+  Simulator::Schedule (Seconds (1.0), &PointToPointCutThroughTest::SendPacket, this, devices[0], 998);
+  Simulator::Schedule (Seconds (1.0) + MicroSeconds (3000), &PointToPointCutThroughTest::SendPacket, this,
+                       devices[0], 38);
+
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_rxTimes[0].size (), 2, "Packets lost at the forwarding node");
+  NS_TEST_ASSERT_MSG_EQ (m_rxTimes[1].size (), 2, "Packets lost at the last node");
+  // The head takes 50us on each wire; the tail leaves b 1000us after the
+  // head arrived, not the 2020us of store-and-forward
+  NS_TEST_EXPECT_MSG_EQ (m_rxTimes[0][0], Seconds (1.0) + MicroSeconds (50 + 10), "Head late at b");
+  NS_TEST_EXPECT_MSG_EQ (m_tailTimes[0][0], Seconds (1.0) + MicroSeconds (1000 + 10), "Wrong tail time at b");
+  NS_TEST_EXPECT_MSG_EQ (m_rxTimes[1][0], Seconds (1.0) + MicroSeconds (2 * (50 + 10)), "Head late at c");
+  NS_TEST_EXPECT_MSG_EQ (m_tailTimes[1][0], Seconds (1.0) + MicroSeconds (50 + 10 + 1000 + 10),
+                         "Wrong tail time at c");
+  // A packet no larger than the header is stored and forwarded
+  Time start = Seconds (1.0) + MicroSeconds (3000);
+  // (the data rate gives 40 bytes a wire time a rounding step short of 40us)
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_rxTimes[0][1], start + MicroSeconds (40 + 10), NanoSeconds (1),
+                             "Short packet early at b");
+  NS_TEST_EXPECT_MSG_EQ (m_tailTimes[0][1], m_rxTimes[0][1], "Short packet tagged at b");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_rxTimes[1][1], start + MicroSeconds (2 * (40 + 10)), NanoSeconds (2),
+                             "Short packet early at c");
+
+  m_next = 0;
+  Simulator::Destroy ();
+}
+//-----------------------------------------------------------------------------
 class PointToPointTestSuite : public TestSuite
 {
 public:
@@ -66,6 +506,12 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointFlowControlTest (0), TestCase::QUICK);
+  AddTestCase (new PointToPointFlowControlTest (2), TestCase::QUICK);
+  AddTestCase (new PointToPointDatelineTest (1), TestCase::QUICK);
+  AddTestCase (new PointToPointDatelineTest (2), TestCase::QUICK);
+  AddTestCase (new PointToPointOffloadTest, TestCase::QUICK);
+  AddTestCase (new PointToPointCutThroughTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite;
@@ -24,8 +24,8 @@ main (int argc, char *argv[])
         // Setup DimensionOrdered L3 Protocol
         CreateAndAggregateObjectFromTypeId (node, "ns3::DimensionOrderedL3Protocol");
         Ptr<DimensionOrdered> dimOrdered = node->GetObject<DimensionOrdered> ();
-        dimOrdered->SetOrigin (std::make_tuple (1,1,0));
-        dimOrdered->SetDimensionsMax (std::make_tuple (3,3,0));
+        dimOrdered->SetOrigin (DimensionOrderedAddress (1, 1, 0));
+        dimOrdered->SetDimensionsMax (DimensionOrderedAddress (3, 3, 0));
         
         // Setup raw socket factory
         Ptr<DimensionOrderedRawSocketFactoryImpl> rawFactory = CreateObject<DimensionOrderedRawSocketFactoryImpl> ();
@@ -19,7 +19,7 @@ main (int argc, char *argv[])
 
     // Install DimensionOrdered stack
     DimensionOrderedStackHelper stack;
-    stack.Install (nodes, std::make_tuple(1,1,0), std::make_tuple(3,3,0));
+    stack.Install (nodes, DimensionOrderedAddress (1, 1, 0), DimensionOrderedAddress (3, 3, 0));
 
     // Setup topology
     DimensionOrderedAddressHelper::AddressAssignmentList assignList;
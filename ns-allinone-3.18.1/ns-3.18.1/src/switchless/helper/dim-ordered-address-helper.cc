@@ -33,6 +33,24 @@ DimensionOrderedAddressHelper::Assign (AddressAssignmentList &list)
     return retval;
 }
 
+DimensionOrderedAddress
+DimensionOrderedAddressHelper::GetCubeAddress (uint32_t index, DimensionOrderedAddress const &origin,
+                                               DimensionOrderedAddress const &dimsMax)
+{
+    NS_LOG_FUNCTION (index << origin << dimsMax);
+    NS_ASSERT (origin.GetNDimensions () == dimsMax.GetNDimensions ());
+
+    std::vector<uint16_t> coordinates (origin.GetNDimensions ());
+    for (uint32_t dim = 0; dim < coordinates.size (); dim++)
+    {
+        uint32_t radix = dimsMax.GetCoordinate (dim) - origin.GetCoordinate (dim) + 1;
+        coordinates[dim] = origin.GetCoordinate (dim) + index % radix;
+        index /= radix;
+    }
+    NS_ASSERT_MSG (index == 0, "DimensionOrderedAddressHelper::GetCubeAddress(): index is outside of the cube");
+    return DimensionOrderedAddress (coordinates);
+}
+
 Ptr<DimensionOrdered>
 DimensionOrderedAddressHelper::Assign (Ptr<NetDevice> device, const DimensionOrderedAddress &address,
                                        DimensionOrdered::InterfaceDirection dir)
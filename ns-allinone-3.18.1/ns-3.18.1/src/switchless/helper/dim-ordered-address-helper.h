@@ -32,6 +32,15 @@ public:
     typedef std::vector<AddressAssignment> AddressAssignmentList;
 
     static DimensionOrderedInterfaceContainer Assign (AddressAssignmentList &list);
+
+    /**
+     * \brief Address of the index-th node of a k-ary n-cube, X varying fastest
+     * \param index node index, below the number of nodes of the cube
+     * \param origin lowest coordinate of every dimension
+     * \param dimsMax highest coordinate of every dimension
+     */
+    static DimensionOrderedAddress GetCubeAddress (uint32_t index, DimensionOrderedAddress const &origin,
+                                                   DimensionOrderedAddress const &dimsMax);
 private:
     static Ptr<DimensionOrdered> Assign (Ptr<NetDevice> device, DimensionOrderedAddress const &address,
                                                   DimensionOrdered::InterfaceDirection dir);
@@ -53,16 +53,16 @@ DimensionOrderedStackHelper::SetTcp (std::string tid, std::string n0, const Attr
 }
 
 void
-DimensionOrderedStackHelper::Install (NodeContainer c, std::tuple<uint8_t, uint8_t, uint8_t> origin,
-                                      std::tuple<uint8_t, uint8_t, uint8_t> dimsMax) const
+DimensionOrderedStackHelper::Install (NodeContainer c, DimensionOrderedAddress origin,
+                                      DimensionOrderedAddress dimsMax) const
 {
     for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
         Install (*i, origin, dimsMax);
 }
 
 void
-DimensionOrderedStackHelper::InstallAll (std::tuple<uint8_t, uint8_t, uint8_t> origin,
-                                         std::tuple<uint8_t, uint8_t, uint8_t> dimsMax) const
+DimensionOrderedStackHelper::InstallAll (DimensionOrderedAddress origin,
+                                         DimensionOrderedAddress dimsMax) const
 {
     Install (NodeContainer::GetGlobal (), origin, dimsMax);
 }
@@ -77,8 +77,8 @@ DimensionOrderedStackHelper::CreateAndAggregateObjectFromTypeId (Ptr<Node> node,
 }
 
 void
-DimensionOrderedStackHelper::Install (Ptr<Node> node, std::tuple<uint8_t, uint8_t, uint8_t> origin,
-                                      std::tuple<uint8_t, uint8_t, uint8_t> dimsMax) const
+DimensionOrderedStackHelper::Install (Ptr<Node> node, DimensionOrderedAddress origin,
+                                      DimensionOrderedAddress dimsMax) const
 {
     if (node->GetObject<DimensionOrdered> () != 0)
     {
@@ -94,14 +94,15 @@ DimensionOrderedStackHelper::Install (Ptr<Node> node, std::tuple<uint8_t, uint8_
     dimOrdered->SetDimensionsMax (dimsMax);
 
     CreateAndAggregateObjectFromTypeId (node, "ns3::DoUdpL4Protocol");
+    CreateAndAggregateObjectFromTypeId (node, "ns3::DoHomaL4Protocol");
     node->AggregateObject (m_tcpFactory.Create<Object> ());
     Ptr<PacketSocketFactory> factory = CreateObject<PacketSocketFactory> ();
     node->AggregateObject (factory);
 }
 
 void
-DimensionOrderedStackHelper::Install (std::string nodeName, std::tuple<uint8_t, uint8_t, uint8_t> origin,
-                                      std::tuple<uint8_t, uint8_t, uint8_t> dimsMax) const
+DimensionOrderedStackHelper::Install (std::string nodeName, DimensionOrderedAddress origin,
+                                      DimensionOrderedAddress dimsMax) const
 {
     Ptr<Node> node = Names::Find<Node> (nodeName);
     Install (node, origin, dimsMax);
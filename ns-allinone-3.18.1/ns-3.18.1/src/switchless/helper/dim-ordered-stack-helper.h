@@ -4,7 +4,6 @@
 
 // C/C++ includes
 #include <string>
-#include <tuple>
 
 // NS3 includes
 #include "ns3/node-container.h"
@@ -31,6 +30,7 @@ namespace ns3 {
  * This class aggregates instances of these objects, by default, to each node:
  *   - ns3::DimensionOrderedL3Protocol
  *   - ns3::DoUdpL4Protocol
+ *   - ns3::DoHomaL4Protocol
  *   - a TCP based on the TCP factory provided
  *   - a DoPacketSocketFactory
  */
@@ -60,11 +60,11 @@ public:
    * already has DimensionOrdered object aggregated to it.
    *
    * \param nodeName the name of the node on which to install the stack
-   * \param origin The origin in the DimensionOrdered topology
-   * \param dimsMax The max value of the DimensionOrdered topology dimension
+   * \param origin The lowest coordinate of every dimension of the DimensionOrdered topology
+   * \param dimsMax The highest coordinate of every dimension
    */
-  void Install (std::string nodeName, std::tuple<uint8_t, uint8_t, uint8_t> origin,
-                std::tuple<uint8_t, uint8_t, uint8_t> dimsMax) const;
+  void Install (std::string nodeName, DimensionOrderedAddress origin,
+                DimensionOrderedAddress dimsMax) const;
 
   /**
    * Aggregate implementations of the ns3::Ipv4, ns3::DoUdp, and ns3::DoTcp classes
@@ -72,11 +72,11 @@ public:
    * already has DimensionOrdered object aggregated to it.
    *
    * \param node the node on which to install the stack
-   * \param origin The origin in the DimensionOrdered topology
-   * \param dimsMax The max value of the DimensionOrdered topology dimension
+   * \param origin The lowest coordinate of every dimension of the DimensionOrdered topology
+   * \param dimsMax The highest coordinate of every dimension
    */
-  void Install (Ptr<Node> node, std::tuple<uint8_t, uint8_t, uint8_t> origin,
-                std::tuple<uint8_t, uint8_t, uint8_t> dimsMax) const;
+  void Install (Ptr<Node> node, DimensionOrderedAddress origin,
+                DimensionOrderedAddress dimsMax) const;
 
   /**
    * For each node in the input container, aggregate implementations of the 
@@ -85,17 +85,17 @@ public:
    * already has a DimensionOrdered object aggregated to it.
    *
    * \param c NodeContainer that holds the set of nodes on which to install the new stacks
-   * \param origin The origin in the DimensionOrdered topology
-   * \param dimsMax The max value of the DimensionOrdered topology dimension
+   * \param origin The lowest coordinate of every dimension of the DimensionOrdered topology
+   * \param dimsMax The highest coordinate of every dimension
    */
-  void Install (NodeContainer c, std::tuple<uint8_t, uint8_t, uint8_t> origin,
-                std::tuple<uint8_t, uint8_t, uint8_t> dimsMax) const;
+  void Install (NodeContainer c, DimensionOrderedAddress origin,
+                DimensionOrderedAddress dimsMax) const;
 
   /**
    * Aggregate DimensionOrdered, DoUdp, and DoTCP stacks to all nodes in the simulation
    */
-  void InstallAll (std::tuple<uint8_t, uint8_t, uint8_t> origin, 
-                   std::tuple<uint8_t, uint8_t, uint8_t> dimsMax) const;
+  void InstallAll (DimensionOrderedAddress origin, 
+                   DimensionOrderedAddress dimsMax) const;
 
   /**
    * \brief Set the DoTcp stack which will not need any other parameter.
@@ -1,5 +1,7 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 
+#include <stdlib.h>
+
 #include "dim-ordered-address.h"
 
 NS_LOG_COMPONENT_DEFINE ("DimensionOrderedAddress");
@@ -7,27 +9,38 @@ NS_LOG_COMPONENT_DEFINE ("DimensionOrderedAddress");
 namespace ns3 {
 
 DimensionOrderedAddress::DimensionOrderedAddress ()
-  : m_addressX (0),
-    m_addressY (0),
-    m_addressZ (0)
+  : m_nDims (3)
 {
     NS_LOG_FUNCTION (this);
+    memset (m_coordinates, 0, sizeof (m_coordinates));
 }
 
-DimensionOrderedAddress::DimensionOrderedAddress (uint8_t x, uint8_t y, uint8_t z)
-  : m_addressX (x),
-    m_addressY (y),
-    m_addressZ (z)
+DimensionOrderedAddress::DimensionOrderedAddress (uint16_t x, uint16_t y, uint16_t z)
+  : m_nDims (3)
 {
     NS_LOG_FUNCTION (this << x << y << z);
+    memset (m_coordinates, 0, sizeof (m_coordinates));
+    m_coordinates[0] = x;
+    m_coordinates[1] = y;
+    m_coordinates[2] = z;
+}
+
+DimensionOrderedAddress::DimensionOrderedAddress (const std::vector<uint16_t> &coordinates)
+  : m_nDims (coordinates.size ())
+{
+    NS_LOG_FUNCTION (this);
+    NS_ASSERT_MSG (coordinates.size () >= 1 && coordinates.size () <= MAX_DIMS,
+                   "DimensionOrderedAddress: " << coordinates.size () << " dimensions are not supported");
+    memset (m_coordinates, 0, sizeof (m_coordinates));
+    for (uint32_t i = 0; i < m_nDims; i++)
+        m_coordinates[i] = coordinates[i];
 }
 
 DimensionOrderedAddress::DimensionOrderedAddress (char const *address)
-  : m_addressX (0),
-    m_addressY (0),
-    m_addressZ (0)
+  : m_nDims (3)
 {
     NS_LOG_FUNCTION (this << address);
+    memset (m_coordinates, 0, sizeof (m_coordinates));
     AsciiToDimensionOrderedHost (address);
 }
 
@@ -36,55 +49,78 @@ DimensionOrderedAddress::~DimensionOrderedAddress ()
     NS_LOG_FUNCTION (this);
 }
 
-uint8_t
+uint32_t
+DimensionOrderedAddress::GetNDimensions (void) const
+{
+    NS_LOG_FUNCTION (this);
+    return m_nDims;
+}
+
+uint16_t
+DimensionOrderedAddress::GetCoordinate (uint32_t dim) const
+{
+    NS_LOG_FUNCTION (this << dim);
+    NS_ASSERT (dim < MAX_DIMS);
+    return m_coordinates[dim];
+}
+
+void
+DimensionOrderedAddress::SetCoordinate (uint32_t dim, uint16_t value)
+{
+    NS_LOG_FUNCTION (this << dim << value);
+    NS_ASSERT (dim < MAX_DIMS);
+    m_coordinates[dim] = value;
+    if (dim >= m_nDims)
+        m_nDims = dim + 1;
+}
+
+uint16_t
 DimensionOrderedAddress::GetAddressX (void) const
 {
     NS_LOG_FUNCTION (this);
-    return m_addressX;
+    return m_coordinates[0];
 }
 
-uint8_t
+uint16_t
 DimensionOrderedAddress::GetAddressY (void) const
 {
     NS_LOG_FUNCTION (this);
-    return m_addressY;
+    return m_coordinates[1];
 }
 
-uint8_t
+uint16_t
 DimensionOrderedAddress::GetAddressZ (void) const
 {
     NS_LOG_FUNCTION (this);
-    return m_addressZ;
+    return m_coordinates[2];
 }
 
 void
-DimensionOrderedAddress::SetAddressX (uint8_t x)
+DimensionOrderedAddress::SetAddressX (uint16_t x)
 {
     NS_LOG_FUNCTION (this << x);
-    m_addressX = x;
+    SetCoordinate (0, x);
 }
 
 void
-DimensionOrderedAddress::SetAddressY (uint8_t y)
+DimensionOrderedAddress::SetAddressY (uint16_t y)
 {
     NS_LOG_FUNCTION (this << y);
-    m_addressY = y;
+    SetCoordinate (1, y);
 }
 
 void
-DimensionOrderedAddress::SetAddressZ (uint8_t z)
+DimensionOrderedAddress::SetAddressZ (uint16_t z)
 {
     NS_LOG_FUNCTION (this << z);
-    m_addressZ = z;
+    SetCoordinate (2, z);
 }
 
 void
-DimensionOrderedAddress::SetAddress (uint8_t x, uint8_t y, uint8_t z)
+DimensionOrderedAddress::SetAddress (uint16_t x, uint16_t y, uint16_t z)
 {
     NS_LOG_FUNCTION (this << x << y << z);
-    m_addressX = x;
-    m_addressY = y;
-    m_addressZ = z;
+    *this = DimensionOrderedAddress (x, y, z);
 }
 
 
@@ -92,50 +128,67 @@ bool
 DimensionOrderedAddress::IsEqual (const DimensionOrderedAddress &other) const
 {
     NS_LOG_FUNCTION (this << other);
-    return ((m_addressX == other.m_addressX) &&
-            (m_addressY == other.m_addressY) &&
-            (m_addressZ == other.m_addressZ));
+    return *this == other;
+}
+
+uint32_t
+DimensionOrderedAddress::GetSerializedSize (void) const
+{
+    NS_LOG_FUNCTION (this);
+    return 1 + 2 * m_nDims;
 }
 
 void
-DimensionOrderedAddress::Serialize (uint8_t buf[3]) const
+DimensionOrderedAddress::Serialize (uint8_t buf[]) const
 {
     NS_LOG_FUNCTION (this << &buf);
-    buf[0] = m_addressX;
-    buf[1] = m_addressY;
-    buf[2] = m_addressZ;
+    buf[0] = m_nDims;
+    for (uint32_t i = 0; i < m_nDims; i++)
+    {
+        buf[1 + 2 * i] = m_coordinates[i] >> 8;
+        buf[2 + 2 * i] = m_coordinates[i] & 0xff;
+    }
 }
 
 DimensionOrderedAddress
-DimensionOrderedAddress::Deserialize (const uint8_t buf[3])
+DimensionOrderedAddress::Deserialize (const uint8_t buf[])
 {
     NS_LOG_FUNCTION (&buf);
-    return DimensionOrderedAddress (buf[0], buf[1], buf[2]);
+    NS_ASSERT (buf[0] >= 1 && buf[0] <= MAX_DIMS);
+    DimensionOrderedAddress address;
+    address.m_nDims = buf[0];
+    for (uint32_t i = 0; i < address.m_nDims; i++)
+        address.m_coordinates[i] = (buf[1 + 2 * i] << 8) | buf[2 + 2 * i];
+    return address;
 }
 
 void
 DimensionOrderedAddress::Print (std::ostream &os) const
 {
     NS_LOG_FUNCTION (this);
-    os << "(" << (int)(m_addressX) << 
-          ", " << (int)(m_addressY) << 
-          ", " << (int)(m_addressZ) << ")";
+    os << "(";
+    for (uint32_t i = 0; i < m_nDims; i++)
+        os << (i == 0 ? "" : ", ") << m_coordinates[i];
+    os << ")";
 }
 
 bool
 DimensionOrderedAddress::IsBroadcast (void) const
 {
     NS_LOG_FUNCTION (this);
-    return ((m_addressX == 255) &&
-            (m_addressY == 255) &&
-            (m_addressZ == 255));
+    for (uint32_t i = 0; i < m_nDims; i++)
+    {
+        if (m_coordinates[i] != BROADCAST_COORDINATE)
+            return false;
+    }
+    return true;
 }
 
 bool
 DimensionOrderedAddress::IsMatchingType (const Address &address)
 {
     NS_LOG_FUNCTION (&address);
-    return address.CheckCompatible (GetType (), 3);    
+    return address.IsMatchingType (GetType ());
 }
 
 DimensionOrderedAddress::operator Address () const
@@ -148,17 +201,17 @@ Address
 DimensionOrderedAddress::ConvertTo (void) const
 {
     NS_LOG_FUNCTION (this);
-    uint8_t buf[3];
+    uint8_t buf[MAX_SERIALIZED_SIZE];
     Serialize (buf);
-    return Address (GetType (), buf, 3);
+    return Address (GetType (), buf, GetSerializedSize ());
 }
 
 DimensionOrderedAddress
 DimensionOrderedAddress::ConvertFrom (const Address &address)
 {
     NS_LOG_FUNCTION (&address);
-    NS_ASSERT (address.CheckCompatible (GetType(), 3));
-    uint8_t buf[3];
+    NS_ASSERT (IsMatchingType (address));
+    uint8_t buf[Address::MAX_SIZE];
     address.CopyTo (buf);
     return Deserialize (buf);
 }
@@ -182,14 +235,14 @@ DimensionOrderedAddress
 DimensionOrderedAddress::GetAny (void)
 {
     NS_LOG_FUNCTION_NOARGS ();
-    return DimensionOrderedAddress (255, 255, 255);
+    return DimensionOrderedAddress (BROADCAST_COORDINATE, BROADCAST_COORDINATE, BROADCAST_COORDINATE);
 }
 
 DimensionOrderedAddress
 DimensionOrderedAddress::GetBroadcast (void)
 {
     NS_LOG_FUNCTION_NOARGS ();
-    return DimensionOrderedAddress (255, 255, 255);
+    return DimensionOrderedAddress (BROADCAST_COORDINATE, BROADCAST_COORDINATE, BROADCAST_COORDINATE);
 }
 
 DimensionOrderedAddress
@@ -203,78 +256,33 @@ void
 DimensionOrderedAddress::AsciiToDimensionOrderedHost (char const *address)
 {
     NS_LOG_FUNCTION (this << address);
-    uint8_t dimensionPos = 0;
-    bool firstParenFound = false;
-    char buf[3];
-    for (int i = 0; i < 3; i++)
-        buf[i] = '\0';
-    uint8_t bufPos = 0;
-    while (true)
+    // "(a, b, ...)": one coordinate after the parenthesis and every comma
+    std::vector<uint16_t> coordinates;
+    const char *position = strchr (address, '(');
+    if (position == 0)
+        return;
+    while (*position == '(' || *position == ',')
+    {
+        char *end;
+        coordinates.push_back (strtoul (position + 1, &end, 10));
+        position = end;
+        while (*position == ' ')
+            position++;
+    }
+    if (coordinates.size () >= 1 && coordinates.size () <= MAX_DIMS)
+        *this = DimensionOrderedAddress (coordinates);
+}
+
+size_t
+DimensionOrderedAddressHash::operator() (DimensionOrderedAddress const &address) const
+{
+    // FNV-1a over the coordinates
+    size_t hash = 2166136261u;
+    for (uint32_t i = 0; i < address.m_nDims; i++)
     {
-        switch (dimensionPos)
-        {
-            case 0:
-                if (!firstParenFound && *address == '(')
-                    firstParenFound = true;
-                else if (*address == ',')
-                {
-                    m_addressX = strtol(buf, NULL, 10);
-                    for (int i = 0; i < 3; i++)
-                        buf[i] = '\0';
-                    bufPos = 0;
-                    dimensionPos++;
-                }
-                else if (*address == ' ')
-                {
-                    // Skip over it
-                }
-                else
-                {
-                    buf[bufPos] = *address;
-                    bufPos++;
-                }
-                break;
-            case 1:
-                if (*address == ',')
-                {
-                    m_addressY = strtol(buf, NULL, 10);
-                    for (int i = 0; i < 3; i++)
-                        buf[i] = '\0';
-                    bufPos = 0;
-                    dimensionPos++;
-                }
-                else if (*address == ' ')
-                {
-                    // Skip over it
-                }
-                else
-                {
-                    buf[bufPos] = *address;
-                    bufPos++;
-                }
-                break;
-            case 2:
-                if (*address == ')')
-                {
-                    m_addressZ = strtol(buf, NULL, 10);
-                    return;
-                }
-                else if (*address == ' ')
-                {
-                    // Skip over it
-                }
-                else
-                {
-                    buf[bufPos] = *address;
-                    bufPos++;
-                }
-                break;
-            default:
-                return;
-                break;
-        }
-        address++;
+        hash = (hash ^ address.m_coordinates[i]) * 16777619u;
     }
+    return hash ^ address.m_nDims;
 }
 
 std::ostream& operator<< (std::ostream& os, DimensionOrderedAddress const& address)
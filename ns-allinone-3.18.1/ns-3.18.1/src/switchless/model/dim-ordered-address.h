@@ -4,7 +4,10 @@
 
 // C/C++ includes
 #include <stdint.h>
+#include <string.h>
+#include <functional>
 #include <ostream>
+#include <vector>
 
 // NS3 includes
 #include "ns3/log.h"
@@ -18,9 +21,21 @@ namespace ns3 {
  * \ingroup address
  *
  * \brief Dimension ordered addresses are stored in this class
+ *
+ * An address holds one 16 bit coordinate for each dimension of a k-ary
+ * n-cube, from 1 up to MAX_DIMS dimensions. Addresses built from three
+ * coordinates are the usual (x, y, z) ones. Addresses with a different
+ * number of dimensions never compare equal.
  */
 class DimensionOrderedAddress {
 public:
+  /// Largest number of dimensions of an address
+  static const uint32_t MAX_DIMS = 6;
+  /// Coordinate value of the broadcast and any addresses
+  static const uint16_t BROADCAST_COORDINATE = 0xffff;
+  /// Largest serialized size of an address
+  static const uint32_t MAX_SERIALIZED_SIZE = 1 + 2 * MAX_DIMS;
+
   // Constructors and Destructors
   DimensionOrderedAddress ();
   /**
@@ -28,54 +43,73 @@ public:
    * \param y Y component of the address
    * \param z Z component of the address
    */
-  DimensionOrderedAddress (uint8_t x, uint8_t y, uint8_t z);
+  DimensionOrderedAddress (uint16_t x, uint16_t y, uint16_t z);
+  /**
+   * \param coordinates one coordinate per dimension, X first
+   */
+  DimensionOrderedAddress (const std::vector<uint16_t> &coordinates);
   /**
    * \brief Constructs a DimensionOrderedAddress by parsing a C-string
    * 
    * Input address is in the format:
-   * (xxx, yyy, zzz)
+   * (xxx, yyy, zzz) with any number of coordinates
    * \param address C-string containing the address as described above
    */
   DimensionOrderedAddress (char const *address);
   ~DimensionOrderedAddress ();
 
+  /**
+   * \return the number of dimensions of the address
+   */
+  uint32_t GetNDimensions (void) const;
+  /**
+   * \param dim dimension, 0 is X
+   * \return the coordinate of the address in dim
+   */
+  uint16_t GetCoordinate (uint32_t dim) const;
+  /**
+   * \brief Set the coordinate of one dimension
+   * \param dim dimension, 0 is X; the address grows to dim + 1 dimensions if needed
+   * \param value coordinate
+   */
+  void SetCoordinate (uint32_t dim, uint16_t value);
   /**
    * \brief Get the X component of the address
    * \return the X component of the address
    */
-  uint8_t GetAddressX (void) const;
+  uint16_t GetAddressX (void) const;
   /**
    * \brief Get the Y component of the address
    * \return the Y component of the address
    */  
-  uint8_t GetAddressY (void) const;
+  uint16_t GetAddressY (void) const;
   /**
    * \brief Get the Z component of the address
    * \return the Z component of the address
    */
-  uint8_t GetAddressZ (void) const;
+  uint16_t GetAddressZ (void) const;
   /**
    * \brief Set the X component of the address
    * \param x X component of the address
    */
-  void SetAddressX (uint8_t x);
+  void SetAddressX (uint16_t x);
   /**
    * \brief Set the Y component of the address
    * \param y Y component of the address
    */
-  void SetAddressY (uint8_t y);
+  void SetAddressY (uint16_t y);
   /**
    * \brief Set the Z component of the address
    * \param z Z component of the address
    */
-  void SetAddressZ (uint8_t z);
+  void SetAddressZ (uint16_t z);
   /**
-   * \brief Set the address
+   * \brief Set the address to a three dimensional one
    * \param x X component of the address
    * \param y Y component of the address
    * \param z Z component of the address
    */
-  void SetAddress (uint8_t x, uint8_t y, uint8_t z);
+  void SetAddress (uint16_t x, uint16_t y, uint16_t z);
   /**
    * \brief Comparison operation between two DimensionOrderedAddresses
    * \param other Address to which to compare this address
@@ -83,17 +117,22 @@ public:
    */
   bool IsEqual (const DimensionOrderedAddress &other) const;
   /**
-   * \brief Serialize this address to a 3 byte buffer
+   * \return the number of bytes Serialize writes, 1 + 2 per dimension
+   */
+  uint32_t GetSerializedSize (void) const;
+  /**
+   * \brief Serialize this address as the number of dimensions followed by
+   * the big endian coordinates
    *
-   * \param buf output biffer to which this address gets overwritten with this DimensionOrdered Address
+   * \param buf output buffer of at least GetSerializedSize () bytes
    */
-  void Serialize (uint8_t buf[3]) const;
+  void Serialize (uint8_t buf[]) const;
   /**
-   * \brief Deserialze the 3 byte buffer to a DimensionOrderedAddress
+   * \brief Deserialze a buffer written by Serialize to a DimensionOrderedAddress
    * \param buf buffer to read address from
    * \return a DimensionOrderedAddress
    */
-  static DimensionOrderedAddress Deserialize (const uint8_t buf[3]);
+  static DimensionOrderedAddress Deserialize (const uint8_t buf[]);
   /**
    * \brief Print this address to the given output stream
    *
@@ -102,7 +141,7 @@ public:
    */
   void Print (std::ostream &os) const;
   /**
-    * \return true if address is (255, 255, 255); false otherwise
+    * \return true if every coordinate is BROADCAST_COORDINATE; false otherwise
     */
   bool IsBroadcast (void) const;
   /**
@@ -132,11 +171,11 @@ public:
    */
   static DimensionOrderedAddress GetZero (void);
   /**
-   * \return the (255, 255, 255) address
+   * \return the three dimensional broadcast address
    */
   static DimensionOrderedAddress GetAny (void);
   /**
-   * \return the (255, 255, 255) address
+   * \return the three dimensional broadcast address
    */
   static DimensionOrderedAddress GetBroadcast (void);
   /**
@@ -148,13 +187,23 @@ private:
   Address ConvertTo (void) const;
   static uint8_t GetType (void);
   void AsciiToDimensionOrderedHost (char const *address);
-  uint8_t m_addressX;
-  uint8_t m_addressY;
-  uint8_t m_addressZ;
+  // Coordinates past m_nDims are kept at 0 so whole arrays can be compared
+  uint16_t m_coordinates[MAX_DIMS];
+  uint8_t m_nDims;
 
   friend bool operator == (DimensionOrderedAddress const &a, DimensionOrderedAddress const &b);
   friend bool operator != (DimensionOrderedAddress const &a, DimensionOrderedAddress const &b);
   friend bool operator < (DimensionOrderedAddress const &a, DimensionOrderedAddress const &b);
+  friend class DimensionOrderedAddressHash;
+};
+
+/**
+ * \brief Hash function for DimensionOrderedAddress, for unordered containers
+ */
+class DimensionOrderedAddressHash : public std::unary_function<DimensionOrderedAddress, size_t>
+{
+public:
+  size_t operator() (DimensionOrderedAddress const &address) const;
 };
 
 ATTRIBUTE_HELPER_HEADER (DimensionOrderedAddress);
@@ -164,23 +213,26 @@ std::istream& operator>> (std::istream& is, DimensionOrderedAddress& address);
 
 inline bool operator == (DimensionOrderedAddress const &a, DimensionOrderedAddress const &b)
 {
-    return ((a.m_addressX == b.m_addressX) &&
-            (a.m_addressY == b.m_addressY) &&
-            (a.m_addressZ == b.m_addressZ));
+    return a.m_nDims == b.m_nDims &&
+           memcmp (a.m_coordinates, b.m_coordinates, sizeof (a.m_coordinates)) == 0;
 }
 
 inline bool operator != (DimensionOrderedAddress const &a, DimensionOrderedAddress const &b)
 {
-    return ((a.m_addressX != b.m_addressX) ||
-            (a.m_addressY != b.m_addressY) ||
-            (a.m_addressZ != b.m_addressZ));
+    return !(a == b);
 }
 
+// Orders by number of dimensions, then lexicographically from X
 inline bool operator < (DimensionOrderedAddress const &a, DimensionOrderedAddress const &b)
 {
-    return ((a.m_addressX > b.m_addressX) &&
-            (a.m_addressY > b.m_addressY) &&
-            (a.m_addressZ > b.m_addressZ));
+    if (a.m_nDims != b.m_nDims)
+        return a.m_nDims < b.m_nDims;
+    for (uint32_t i = 0; i < a.m_nDims; i++)
+    {
+        if (a.m_coordinates[i] != b.m_coordinates[i])
+            return a.m_coordinates[i] < b.m_coordinates[i];
+    }
+    return false;
 }
 
 } // namespace ns3
@@ -9,7 +9,8 @@ NS_LOG_COMPONENT_DEFINE ("DimensionOrderedEndPointDemux");
 DimensionOrderedEndPointDemux::DimensionOrderedEndPointDemux ()
   : m_ephemeral (49152), 
     m_portLast (65535), 
-    m_portFirst (49152)
+    m_portFirst (49152),
+    m_lookupProbes (0)
 {
     NS_LOG_FUNCTION (this);
 }
@@ -23,31 +24,24 @@ DimensionOrderedEndPointDemux::~DimensionOrderedEndPointDemux ()
         delete endPoint;
     }
     m_endPoints.clear ();
+    m_positions.clear ();
+    m_peerIndex.clear ();
+    m_localIndex.clear ();
+    m_portIndex.clear ();
 }
 
 bool
 DimensionOrderedEndPointDemux::LookupPortLocal (uint16_t port)
 {
     NS_LOG_FUNCTION (this << port);
-    for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
-    {
-        if ((*i)->GetLocalPort () == port)
-            return true;
-    }
-    return false;
+    return m_portIndex.find (port) != m_portIndex.end ();
 }
 
 bool
 DimensionOrderedEndPointDemux::LookupLocal (DimensionOrderedAddress addr, uint16_t port)
 {
     NS_LOG_FUNCTION (this << addr << port);
-    for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
-    {
-        if ((*i)->GetLocalPort () == port &&
-            (*i)->GetLocalAddress () == addr)
-            return true;
-    }
-    return false;
+    return m_localIndex.find (MakeKey (port, addr, 0)) != m_localIndex.end ();
 }
 
 DimensionOrderedEndPoint *
@@ -61,7 +55,7 @@ DimensionOrderedEndPointDemux::Allocate (void)
         return 0;
     }
     DimensionOrderedEndPoint *endPoint = new DimensionOrderedEndPoint (DimensionOrderedAddress::GetAny (), port);
-    m_endPoints.push_back (endPoint);
+    AddEndPoint (endPoint);
     NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
     return endPoint;
 }
@@ -77,7 +71,7 @@ DimensionOrderedEndPointDemux::Allocate (DimensionOrderedAddress address)
         return 0;
     }
     DimensionOrderedEndPoint *endPoint = new DimensionOrderedEndPoint (address, port);
-    m_endPoints.push_back (endPoint);
+    AddEndPoint (endPoint);
     NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
     return endPoint;
 }
@@ -100,7 +94,7 @@ DimensionOrderedEndPointDemux::Allocate (DimensionOrderedAddress address, uint16
         return 0;
     }
     DimensionOrderedEndPoint *endPoint = new DimensionOrderedEndPoint (address, port);
-    m_endPoints.push_back (endPoint);
+    AddEndPoint (endPoint);
     NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
     return endPoint;
 }
@@ -110,20 +104,22 @@ DimensionOrderedEndPointDemux::Allocate (DimensionOrderedAddress localAddress, u
                                          DimensionOrderedAddress peerAddress, uint16_t peerPort)
 {
     NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-    for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+    PeerIndex::iterator bucket = 
+        m_peerIndex.find (MakeKey (localPort, peerAddress, peerPort));
+    if (bucket != m_peerIndex.end ())
     {
-        if ((*i)->GetLocalPort () == localPort &&
-            (*i)->GetLocalAddress () == localAddress &&
-            (*i)->GetPeerPort () == peerPort &&
-            (*i)->GetPeerAddress () == peerAddress)
+        for (EndPointsI i = bucket->second.begin (); i != bucket->second.end (); i++)
         {
-            NS_LOG_WARN ("No way we can allocate this end-point.");
-            return 0;
+            if ((*i)->GetLocalAddress () == localAddress)
+            {
+                NS_LOG_WARN ("No way we can allocate this end-point.");
+                return 0;
+            }
         }
     }
     DimensionOrderedEndPoint *endPoint = new DimensionOrderedEndPoint (localAddress, localPort);
     endPoint->SetPeer (peerAddress, peerPort);
-    m_endPoints.push_back (endPoint);
+    AddEndPoint (endPoint);
 
     NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -134,15 +130,19 @@ void
 DimensionOrderedEndPointDemux::DeAllocate (DimensionOrderedEndPoint *endPoint)
 {
     NS_LOG_FUNCTION (this << endPoint);
-    for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
-    {
-        if (*i == endPoint)
-        {
-            delete endPoint;
-            m_endPoints.erase (i);
-            break;
-        }
-    }
+    std::unordered_map<DimensionOrderedEndPoint *, EndPointsI>::iterator position = m_positions.find (endPoint);
+    if (position == m_positions.end ())
+        return;
+    Unindex (endPoint);
+    m_endPoints.erase (position->second);
+    m_positions.erase (position);
+    delete endPoint;
+}
+
+uint64_t
+DimensionOrderedEndPointDemux::GetLookupProbes (void) const
+{
+    return m_lookupProbes;
 }
 
 /*
@@ -179,87 +179,107 @@ DimensionOrderedEndPointDemux::Lookup (DimensionOrderedAddress daddr, uint16_t d
     EndPoints retval3; // Matches all but local address
     EndPoints retval4; // Exact match on all 4
 
-    NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-    for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+    // Only endpoints connected to the source or with a wildcard peer can match
+    EndPoints *buckets[2] = { 0, 0 };
+    Key exactKey = MakeKey (dport, saddr, sport);
+    Key wildcardKey = MakeKey (dport, DimensionOrderedAddress::GetAny (), 0);
+    PeerIndex::iterator bucket = m_peerIndex.find (exactKey);
+    if (bucket != m_peerIndex.end ())
+        buckets[0] = &bucket->second;
+    if (!(wildcardKey == exactKey))
     {
-        DimensionOrderedEndPoint* endP = *i;
-        NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
-                                                   << " daddr=" << endP->GetLocalAddress ()
-                                                   << " sport=" << endP->GetPeerPort ()
-                                                   << " saddr=" << endP->GetPeerAddress ());
+        bucket = m_peerIndex.find (wildcardKey);
+        if (bucket != m_peerIndex.end ())
+            buckets[1] = &bucket->second;
+    }
 
-        if (endP->GetLocalPort () != dport)
-        {
-            NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
+    NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
+    for (uint32_t b = 0; b < 2; b++)
+    {
+        if (buckets[b] == 0)
             continue;
-        }
-        if (endP->GetBoundNetDevice ())
+        for (EndPointsI i = buckets[b]->begin (); i != buckets[b]->end (); i++)
         {
-            if (endP->GetBoundNetDevice () != incomingInterface->GetDevice())
+            DimensionOrderedEndPoint* endP = *i;
+            m_lookupProbes++;
+            NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
+                                                       << " daddr=" << endP->GetLocalAddress ()
+                                                       << " sport=" << endP->GetPeerPort ()
+                                                       << " saddr=" << endP->GetPeerAddress ());
+
+            if (endP->GetLocalPort () != dport)
             {
                 NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                                 << " because endpoint is bound to specific device and"
-                                                 << endP->GetBoundNetDevice ()
-                                                 << " does not match packet device " << incomingInterface->GetDevice ());
+                                                 << " because endpoint dport "
+                                                 << endP->GetLocalPort ()
+                                                 << " does not match packet dport " << dport);
                 continue;
             }
-        }
-        DimensionOrderedAddress incomingInterfaceAddr = daddr; // may be a broadcast
-        bool isBroadcast = daddr.IsBroadcast ();
-        NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
-        bool localAddressMatchesWildCard =
-          endP->GetLocalAddress () == DimensionOrderedAddress::GetAny ();
-        bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
+            if (endP->GetBoundNetDevice ())
+            {
+                if (endP->GetBoundNetDevice () != incomingInterface->GetDevice())
+                {
+                    NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                                                     << " because endpoint is bound to specific device and"
+                                                     << endP->GetBoundNetDevice ()
+                                                     << " does not match packet device " << incomingInterface->GetDevice ());
+                    continue;
+                }
+            }
+            DimensionOrderedAddress incomingInterfaceAddr = daddr; // may be a broadcast
+            bool isBroadcast = daddr.IsBroadcast ();
+            NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
+            bool localAddressMatchesWildCard =
+              endP->GetLocalAddress () == DimensionOrderedAddress::GetAny ();
+            bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
         
-        if (isBroadcast)
-            NS_LOG_DEBUG ("Found bcast, localaddr " << endP->GetLocalAddress ());
+            if (isBroadcast)
+                NS_LOG_DEBUG ("Found bcast, localaddr " << endP->GetLocalAddress ());
 
-        if (isBroadcast && (endP->GetLocalAddress () != DimensionOrderedAddress::GetAny ()))
-            localAddressMatchesExact = (endP->GetLocalAddress () == incomingInterfaceAddr);
+            if (isBroadcast && (endP->GetLocalAddress () != DimensionOrderedAddress::GetAny ()))
+                localAddressMatchesExact = (endP->GetLocalAddress () == incomingInterfaceAddr);
 
-        // if no match here, keep looking
-        if (!(localAddressMatchesExact || localAddressMatchesWildCard))
-            continue;
-        bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
-        bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
-        bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
-        bool remoteAddressMatchesWildCard = endP->GetPeerAddress () ==
-            DimensionOrderedAddress::GetAny ();
+            // if no match here, keep looking
+            if (!(localAddressMatchesExact || localAddressMatchesWildCard))
+                continue;
+            bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
+            bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
+            bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
+            bool remoteAddressMatchesWildCard = endP->GetPeerAddress () ==
+                DimensionOrderedAddress::GetAny ();
         
-        // If remote does not match either with exact or wildcard,
-        // skip this one
-        if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
-            continue;
-        if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
-            continue;
+            // If remote does not match either with exact or wildcard,
+            // skip this one
+            if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
+                continue;
+            if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
+                continue;
 
-        // Now figure out which return list to add this one to
-        if (localAddressMatchesWildCard &&
-            remotePeerMatchesWildCard &&
-            remoteAddressMatchesWildCard)
-        { // Only local port matches exactly
-            retval1.push_back (endP);
-        }
-        if ((localAddressMatchesExact || (isBroadcast && localAddressMatchesWildCard))&&
-            remotePeerMatchesWildCard &&
-            remoteAddressMatchesWildCard)
-        { // Only local port and local address matches exactly
-            retval2.push_back (endP);
-        }
-        if (localAddressMatchesWildCard &&
-            remotePeerMatchesExact &&
-            remoteAddressMatchesExact)
-        { // All but local address
-            retval3.push_back (endP);
-        }
-        if (localAddressMatchesExact &&
-            remotePeerMatchesExact &&
-            remoteAddressMatchesExact)
-        { // All 4 match
-            retval4.push_back (endP);
+            // Now figure out which return list to add this one to
+            if (localAddressMatchesWildCard &&
+                remotePeerMatchesWildCard &&
+                remoteAddressMatchesWildCard)
+            { // Only local port matches exactly
+                retval1.push_back (endP);
+            }
+            if ((localAddressMatchesExact || (isBroadcast && localAddressMatchesWildCard))&&
+                remotePeerMatchesWildCard &&
+                remoteAddressMatchesWildCard)
+            { // Only local port and local address matches exactly
+                retval2.push_back (endP);
+            }
+            if (localAddressMatchesWildCard &&
+                remotePeerMatchesExact &&
+                remoteAddressMatchesExact)
+            { // All but local address
+                retval3.push_back (endP);
+            }
+            if (localAddressMatchesExact &&
+                remotePeerMatchesExact &&
+                remoteAddressMatchesExact)
+            { // All 4 match
+                retval4.push_back (endP);
+            }
         }
     }
     
@@ -278,17 +298,26 @@ DimensionOrderedEndPointDemux::SimpleLookup (DimensionOrderedAddress daddr,
 {
     NS_LOG_FUNCTION (this << daddr << dport << saddr << sport);
 
+    // Exact match straight from the index
+    PeerIndex::iterator bucket = m_peerIndex.find (MakeKey (dport, saddr, sport));
+    if (bucket != m_peerIndex.end ())
+    {
+        for (EndPointsI i = bucket->second.begin (); i != bucket->second.end (); i++)
+        {
+            m_lookupProbes++;
+            if ((*i)->GetLocalAddress () == daddr)
+                return *i;
+        }
+    }
+
     // this code is a copy/paste version of an old BSD ip stack lookup function
     uint32_t genericity = 3;
     DimensionOrderedEndPoint *generic = 0;
     for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
+        m_lookupProbes++;
         if ((*i)->GetLocalPort () != dport)
             continue;
-        if ((*i)->GetLocalAddress () == daddr &&
-            (*i)->GetPeerPort () == sport &&
-            (*i)->GetPeerAddress () == saddr)
-            return *i;
         uint32_t tmp = 0;
         if ((*i)->GetLocalAddress () == DimensionOrderedAddress::GetAny ())
             tmp++;
@@ -303,6 +332,74 @@ DimensionOrderedEndPointDemux::SimpleLookup (DimensionOrderedAddress daddr,
     return generic;
 }
 
+void
+DimensionOrderedEndPointDemux::AddEndPoint (DimensionOrderedEndPoint *endPoint)
+{
+    NS_LOG_FUNCTION (this << endPoint);
+    m_endPoints.push_back (endPoint);
+    m_positions[endPoint] = --m_endPoints.end ();
+    Index (endPoint);
+    endPoint->SetDemux (this);
+}
+
+void
+DimensionOrderedEndPointDemux::Index (DimensionOrderedEndPoint *endPoint)
+{
+    NS_LOG_FUNCTION (this << endPoint);
+    uint16_t port = endPoint->GetLocalPort ();
+    m_peerIndex[MakeKey (port, endPoint->GetPeerAddress (), endPoint->GetPeerPort ())].push_back (endPoint);
+    m_localIndex[MakeKey (port, endPoint->GetLocalAddress (), 0)]++;
+    m_portIndex[port]++;
+}
+
+void
+DimensionOrderedEndPointDemux::Unindex (DimensionOrderedEndPoint *endPoint)
+{
+    NS_LOG_FUNCTION (this << endPoint);
+    uint16_t port = endPoint->GetLocalPort ();
+
+    PeerIndex::iterator bucket = 
+        m_peerIndex.find (MakeKey (port, endPoint->GetPeerAddress (), endPoint->GetPeerPort ()));
+    NS_ASSERT (bucket != m_peerIndex.end ());
+    bucket->second.remove (endPoint);
+    if (bucket->second.empty ())
+        m_peerIndex.erase (bucket);
+
+    LocalIndex::iterator local = 
+        m_localIndex.find (MakeKey (port, endPoint->GetLocalAddress (), 0));
+    NS_ASSERT (local != m_localIndex.end ());
+    if (--local->second == 0)
+        m_localIndex.erase (local);
+
+    std::unordered_map<uint16_t, uint32_t>::iterator portCount = m_portIndex.find (port);
+    NS_ASSERT (portCount != m_portIndex.end ());
+    if (--portCount->second == 0)
+        m_portIndex.erase (portCount);
+}
+
+DimensionOrderedEndPointDemux::Key
+DimensionOrderedEndPointDemux::MakeKey (uint16_t port, DimensionOrderedAddress address, uint16_t otherPort)
+{
+    Key key;
+    key.port = port;
+    key.otherPort = otherPort;
+    key.address = address;
+    return key;
+}
+
+bool
+DimensionOrderedEndPointDemux::Key::operator == (const Key &other) const
+{
+    return port == other.port && otherPort == other.otherPort && address == other.address;
+}
+
+size_t
+DimensionOrderedEndPointDemux::KeyHash::operator() (const Key &key) const
+{
+    return DimensionOrderedAddressHash () (key.address) ^
+           ((static_cast<size_t> (key.port) << 16 | key.otherPort) * 0x9e3779b1u);
+}
+
 uint16_t
 DimensionOrderedEndPointDemux::AllocateEphemeralPort (void)
 {
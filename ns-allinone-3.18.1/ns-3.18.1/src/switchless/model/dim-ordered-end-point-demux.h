@@ -4,6 +4,7 @@
 
 // C/C++ includes
 #include <list>
+#include <unordered_map>
 
 // NS3 includes
 
@@ -21,6 +22,10 @@ namespace ns3 {
  * contains a list of endpoints, and has APIs to add and find endpoints in this
  * demux.  This code is shared in common to TCP and UDP protocols in ns3.  This
  * demux sits betweens ns3's layer 4 and the socket layer
+ *
+ * Endpoints are additionally hashed by (local port, peer address, peer port),
+ * so a lookup only visits the endpoints connected to the packet's source and
+ * the ones listening with a wildcard peer, no matter how many endpoints exist.
  */
 class DimensionOrderedEndPointDemux
 {
@@ -56,13 +61,55 @@ public:
 
   void DeAllocate (DimensionOrderedEndPoint *endPoint);
 
+  /**
+   * \returns the number of endpoints Lookup and SimpleLookup have compared
+   *          with a packet so far, which measures their cost
+   */
+  uint64_t GetLookupProbes (void) const;
+
 private:
+  friend class DimensionOrderedEndPoint;
+
   uint16_t AllocateEphemeralPort (void);
+  void AddEndPoint (DimensionOrderedEndPoint *endPoint);
+
+  /**
+   * Add/remove an endpoint to/from the hash indexes. Endpoints call these
+   * around changes of their local address or peer.
+   */
+  void Index (DimensionOrderedEndPoint *endPoint);
+  void Unindex (DimensionOrderedEndPoint *endPoint);
+
+  // (port, address, other port) key of the hash indexes
+  struct Key
+  {
+      uint16_t port;
+      uint16_t otherPort;
+      DimensionOrderedAddress address;
+      bool operator == (const Key &other) const;
+  };
+  struct KeyHash
+  {
+      size_t operator() (const Key &key) const;
+  };
+  typedef std::unordered_map<Key, EndPoints, KeyHash> PeerIndex;
+  typedef std::unordered_map<Key, uint32_t, KeyHash> LocalIndex;
+
+  static Key MakeKey (uint16_t port, DimensionOrderedAddress address, uint16_t otherPort);
 
   uint16_t m_ephemeral;
   uint16_t m_portLast;
   uint16_t m_portFirst;
   EndPoints m_endPoints;
+  // Position of every endpoint in m_endPoints
+  std::unordered_map<DimensionOrderedEndPoint *, EndPointsI> m_positions;
+  // Endpoints keyed by (local port, peer address, peer port)
+  PeerIndex m_peerIndex;
+  // Number of endpoints keyed by (local port, local address)
+  LocalIndex m_localIndex;
+  // Number of endpoints keyed by local port
+  std::unordered_map<uint16_t, uint32_t> m_portIndex;
+  uint64_t m_lookupProbes;
 
 };
 
@@ -1,6 +1,7 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 
 #include "dim-ordered-end-point.h"
+#include "dim-ordered-end-point-demux.h"
 
 NS_LOG_COMPONENT_DEFINE ("DimensionOrderedEndpoint");
 
@@ -10,7 +11,8 @@ DimensionOrderedEndPoint::DimensionOrderedEndPoint (DimensionOrderedAddress addr
   : m_localAddr (address),
     m_localPort (port),
     m_peerAddr (DimensionOrderedAddress::GetAny ()),
-    m_peerPort (0)
+    m_peerPort (0),
+    m_demux (0)
 {
     NS_LOG_FUNCTION (this << address << port);
 }
@@ -36,7 +38,11 @@ void
 DimensionOrderedEndPoint::SetLocalAddress (DimensionOrderedAddress address)
 {
     NS_LOG_FUNCTION (this << address);
+    if (m_demux)
+        m_demux->Unindex (this);
     m_localAddr = address;
+    if (m_demux)
+        m_demux->Index (this);
 }
 
 uint16_t
@@ -64,8 +70,19 @@ void
 DimensionOrderedEndPoint::SetPeer (DimensionOrderedAddress address, uint16_t port)
 {
     NS_LOG_FUNCTION (this << address << port);
+    if (m_demux)
+        m_demux->Unindex (this);
     m_peerAddr = address;
     m_peerPort = port;
+    if (m_demux)
+        m_demux->Index (this);
+}
+
+void
+DimensionOrderedEndPoint::SetDemux (DimensionOrderedEndPointDemux *demux)
+{
+    NS_LOG_FUNCTION (this << demux);
+    m_demux = demux;
 }
 
 void
@@ -15,6 +15,8 @@
 
 namespace ns3 {
 
+class DimensionOrderedEndPointDemux;
+
 /**
  * \brief A representation of a dimension ordered enpoint/connection
  * 
@@ -39,6 +41,13 @@ public:
 
   void SetPeer (DimensionOrderedAddress, uint16_t port);
 
+  /**
+   * \brief Set the demux holding this endpoint, which is told when the
+   * local address or the peer of the endpoint changes
+   * \param demux the owning demux
+   */
+  void SetDemux (DimensionOrderedEndPointDemux *demux);
+
   void BindToNetDevice (Ptr<NetDevice> device);
   Ptr<NetDevice> GetBoundNetDevice (void);
 
@@ -59,6 +68,7 @@ private:
   DimensionOrderedAddress m_peerAddr;
   uint16_t m_peerPort;
   Ptr<NetDevice> m_boundnetdevice;
+  DimensionOrderedEndPointDemux *m_demux;
   Callback<void, Ptr<Packet>, DimensionOrderedHeader, uint16_t, Ptr<DimensionOrderedInterface> > m_rxCallback;
   Callback<void> m_destroyCallback;
 };
@@ -1,5 +1,7 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 
+#include <algorithm>
+
 #include "dim-ordered-header.h"
 
 NS_LOG_COMPONENT_DEFINE ("DimensionOrderedHeader");
@@ -11,9 +13,10 @@ NS_OBJECT_ENSURE_REGISTERED (DimensionOrderedHeader);
 DimensionOrderedHeader::DimensionOrderedHeader ()
   : m_payloadSize (0),
     m_protocol (0),
+    m_ecn (ECN_NotECT),
+    m_format (FORMAT_COMPACT),
     m_source (),
-    m_destination (),
-    m_headerSize (9)
+    m_destination ()
 {
 }
 
@@ -45,11 +48,26 @@ DimensionOrderedHeader::SetProtocol (uint8_t protocol)
     m_protocol = protocol;
 }
 
+void
+DimensionOrderedHeader::SetEcn (EcnType ecn)
+{
+    NS_LOG_FUNCTION (this << ecn);
+    m_ecn = ecn;
+}
+
+DimensionOrderedHeader::EcnType
+DimensionOrderedHeader::GetEcn (void) const
+{
+    NS_LOG_FUNCTION (this);
+    return static_cast<EcnType> (m_ecn);
+}
+
 void
 DimensionOrderedHeader::SetSource (DimensionOrderedAddress source)
 {
     NS_LOG_FUNCTION (this << source);
     m_source = source;
+    UpdateFormat ();
 }
 
 DimensionOrderedAddress
@@ -64,6 +82,7 @@ DimensionOrderedHeader::SetDestination (DimensionOrderedAddress dst)
 {
     NS_LOG_FUNCTION (this <<dst);
     m_destination = dst;
+    UpdateFormat ();
 }
 
 DimensionOrderedAddress
@@ -95,17 +114,75 @@ DimensionOrderedHeader::Print (std::ostream &os) const
 {
     NS_LOG_FUNCTION (this << &os);
     os << "payload size: " << m_payloadSize << " "
-       << "header size: " << m_headerSize << " "
+       << "header size: " << GetSerializedSize () << " "
        << "protocol " << m_protocol
+       << " ecn " << m_ecn
        << " "
        << m_source << " > " << m_destination;
 }
 
+DimensionOrderedHeader::Format
+DimensionOrderedHeader::GetFormat (DimensionOrderedAddress const &address)
+{
+    // The all-ones value of a format is kept for the broadcast coordinate
+    Format format = address.GetNDimensions () == 3 ? FORMAT_COMPACT : FORMAT_NARROW;
+    for (uint32_t dim = 0; dim < address.GetNDimensions (); dim++)
+    {
+        uint16_t coordinate = address.GetCoordinate (dim);
+        if (coordinate == DimensionOrderedAddress::BROADCAST_COORDINATE)
+            continue;
+        if (coordinate >= 0xff)
+            return FORMAT_WIDE;
+        if (coordinate >= 0x7f)
+            format = FORMAT_NARROW;
+    }
+    return format;
+}
+
+void
+DimensionOrderedHeader::UpdateFormat (void)
+{
+    m_format = std::max (GetFormat (m_source), GetFormat (m_destination));
+}
+
+void
+DimensionOrderedHeader::WriteAddress (Buffer::Iterator &i, DimensionOrderedAddress const &address, bool narrow)
+{
+    for (uint32_t dim = 0; dim < address.GetNDimensions (); dim++)
+    {
+        if (narrow)
+            i.WriteU8 (address.GetCoordinate (dim) & 0xff);
+        else
+            i.WriteHtonU16 (address.GetCoordinate (dim));
+    }
+}
+
+DimensionOrderedAddress
+DimensionOrderedHeader::ReadAddress (Buffer::Iterator &i, uint32_t nDims, bool narrow)
+{
+    std::vector<uint16_t> coordinates (nDims);
+    for (uint32_t dim = 0; dim < nDims; dim++)
+    {
+        if (narrow)
+        {
+            coordinates[dim] = i.ReadU8 ();
+            if (coordinates[dim] == 0xff)
+                coordinates[dim] = DimensionOrderedAddress::BROADCAST_COORDINATE;
+        }
+        else
+            coordinates[dim] = i.ReadNtohU16 ();
+    }
+    return DimensionOrderedAddress (coordinates);
+}
+
 uint32_t
 DimensionOrderedHeader::GetSerializedSize (void) const
 {
     NS_LOG_FUNCTION (this);
-    return m_headerSize;
+    NS_ASSERT (m_source.GetNDimensions () == m_destination.GetNDimensions ());
+    if (m_format == FORMAT_COMPACT)
+        return 9;
+    return 4 + 2 * m_source.GetNDimensions () * (m_format == FORMAT_NARROW ? 1 : 2);
 }
 
 void
@@ -116,12 +193,24 @@ DimensionOrderedHeader::Serialize (Buffer::Iterator start) const
 
     i.WriteHtonU16 (m_payloadSize);
     i.WriteU8 (m_protocol);
-    i.WriteU8 (m_source.GetAddressX ());
-    i.WriteU8 (m_source.GetAddressY ());
-    i.WriteU8 (m_source.GetAddressZ ());
-    i.WriteU8 (m_destination.GetAddressX ());
-    i.WriteU8 (m_destination.GetAddressY ());
-    i.WriteU8 (m_destination.GetAddressZ ());
+    if (m_format == FORMAT_COMPACT)
+    {
+        // The top bits of the first three coordinates: a set bit marking the
+        // format, then the ECN codepoint
+        uint8_t flags = 0x4 | m_ecn;
+        for (uint32_t k = 0; k < 6; k++)
+        {
+            DimensionOrderedAddress const &address = k < 3 ? m_source : m_destination;
+            uint8_t top = k < 3 ? (flags >> (2 - k)) & 1 : 0;
+            i.WriteU8 ((top << 7) | (address.GetCoordinate (k % 3) & 0x7f));
+        }
+        return;
+    }
+    // A clear top bit, the ECN codepoint, the dimensions and the width
+    bool narrow = m_format == FORMAT_NARROW;
+    i.WriteU8 ((m_ecn << 5) | (m_source.GetNDimensions () << 1) | (narrow ? 0 : 1));
+    WriteAddress (i, m_source, narrow);
+    WriteAddress (i, m_destination, narrow);
 }
 
 uint32_t
@@ -132,13 +221,35 @@ DimensionOrderedHeader::Deserialize (Buffer::Iterator start)
 
     m_payloadSize = i.ReadNtohU16 ();
     m_protocol = i.ReadU8 ();
-    m_source.SetAddressX (i.ReadU8 ());
-    m_source.SetAddressY (i.ReadU8 ());
-    m_source.SetAddressZ (i.ReadU8 ());
-    m_destination.SetAddressX (i.ReadU8 ());
-    m_destination.SetAddressY (i.ReadU8 ());
-    m_destination.SetAddressZ (i.ReadU8 ());
-    return GetSerializedSize ();
+    Buffer::Iterator peek = i;
+    uint8_t format = peek.ReadU8 ();
+    if (format & 0x80)
+    {
+        uint8_t flags = 0;
+        std::vector<uint16_t> coordinates (6);
+        for (uint32_t k = 0; k < 6; k++)
+        {
+            uint8_t byte = i.ReadU8 ();
+            if (k < 3)
+                flags = (flags << 1) | (byte >> 7);
+            coordinates[k] = byte & 0x7f;
+            if (coordinates[k] == 0x7f)
+                coordinates[k] = DimensionOrderedAddress::BROADCAST_COORDINATE;
+        }
+        m_ecn = flags & 0x3;
+        m_source = DimensionOrderedAddress (coordinates[0], coordinates[1], coordinates[2]);
+        m_destination = DimensionOrderedAddress (coordinates[3], coordinates[4], coordinates[5]);
+        m_format = FORMAT_COMPACT;
+        return i.GetDistanceFrom (start);
+    }
+    i.Next ();
+    m_ecn = (format >> 5) & 0x3;
+    uint32_t nDims = (format >> 1) & 0xf;
+    bool narrow = (format & 1) == 0;
+    m_source = ReadAddress (i, nDims, narrow);
+    m_destination = ReadAddress (i, nDims, narrow);
+    m_format = narrow ? FORMAT_NARROW : FORMAT_WIDE;
+    return i.GetDistanceFrom (start);
 }
 
 } // namespace ns3
@@ -14,10 +14,29 @@ namespace ns3 {
 
 /**
  * \brief Packet header of DimensionOrdered
+ *
+ * Payload size (2 bytes), protocol (1 byte), then the addresses. Two 3D
+ * addresses whose coordinates all fit in seven bits, like those of a cube of
+ * up to 126 nodes per dimension, take one byte per coordinate and carry the
+ * ECN codepoint in their top bits: 9 bytes in total. Other addresses follow
+ * a format byte holding the ECN codepoint, the number of dimensions and
+ * whether coordinates take one or two bytes.
  */
 class DimensionOrderedHeader : public Header
 {
 public:
+  /**
+   * \enum EcnType
+   * \brief ECN codepoints, as in the IPv4 TOS byte (RFC3168)
+   */
+  enum EcnType
+  {
+    ECN_NotECT = 0x00,
+    ECN_ECT1 = 0x01,
+    ECN_ECT0 = 0x02,
+    ECN_CE = 0x03
+  };
+
   /**
    * \brief Construct a null DimensionOrdered header
    */
@@ -33,6 +52,11 @@ public:
    */
   void SetProtocol (uint8_t num);
 
+  /**
+   * \param ecn the ECN codepoint
+   */
+  void SetEcn (EcnType ecn);
+
   /**
    * \param source the source of this packet
    */
@@ -53,6 +77,11 @@ public:
    */
   uint8_t GetProtocol (void) const;
 
+  /**
+   * \returns the ECN codepoint of this packet
+   */
+  EcnType GetEcn (void) const;
+
   /**
    * \returns the source address of this packet
    */
@@ -70,12 +99,26 @@ public:
   virtual void Serialize (Buffer::Iterator start) const;
   virtual uint32_t Deserialize (Buffer::Iterator start);
 private:
-  
+  enum Format
+  {
+    FORMAT_COMPACT, // 3D, seven bits per coordinate, no format byte
+    FORMAT_NARROW,  // one byte per coordinate
+    FORMAT_WIDE     // two bytes per coordinate
+  };
+
+  // Widest format the coordinates of the address need
+  static Format GetFormat (DimensionOrderedAddress const &address);
+  // Refresh m_format after an address changed
+  void UpdateFormat (void);
+  static void WriteAddress (Buffer::Iterator &i, DimensionOrderedAddress const &address, bool narrow);
+  static DimensionOrderedAddress ReadAddress (Buffer::Iterator &i, uint32_t nDims, bool narrow);
+
   uint16_t m_payloadSize;
   uint32_t m_protocol : 8;
+  uint32_t m_ecn : 2;
+  uint32_t m_format : 2;
   DimensionOrderedAddress m_source;
   DimensionOrderedAddress m_destination;
-  uint16_t m_headerSize; 
 
 };
 
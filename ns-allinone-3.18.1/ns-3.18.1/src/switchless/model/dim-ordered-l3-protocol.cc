@@ -1,5 +1,15 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
+#include "ns3/cut-through-tag.h"
+#include "ns3/enum.h"
+#include "ns3/pointer.h"
+#include "ns3/segmentation-offload-tag.h"
+#include "ns3/socket.h"
+#include "ns3/uinteger.h"
+#include "ns3/virtual-channel-tag.h"
+
 #include "dim-ordered-l3-protocol.h"
 
 NS_LOG_COMPONENT_DEFINE ("DimensionOrderedL3Protocol");
@@ -22,6 +32,28 @@ DimensionOrderedL3Protocol::GetTypeId (void)
                        MakeTraceSourceAccessor (&DimensionOrderedL3Protocol::m_rxTrace))
       .AddTraceSource ("Drop", "Drop DimensionOrdered packet",
                        MakeTraceSourceAccessor (&DimensionOrderedL3Protocol::m_dropTrace))
+      .AddAttribute ("EnableRouteCache", "Look up routes in a precomputed next-hop table instead of "
+                     "recomputing them for every packet.",
+                     BooleanValue (true),
+                     MakeBooleanAccessor (&DimensionOrderedL3Protocol::m_routeCacheEnabled),
+                     MakeBooleanChecker ())
+      .AddAttribute ("RoutingPolicy", "How the next hop is chosen among the directions that bring a packet "
+                     "closer to its destination. NegativeFirst on a torus needs two or more virtual channels "
+                     "on every device.",
+                     EnumValue (ROUTING_DIMENSION_ORDERED),
+                     MakeEnumAccessor (&DimensionOrderedL3Protocol::m_routingPolicy),
+                     MakeEnumChecker (ROUTING_DIMENSION_ORDERED, "DimensionOrdered",
+                                      ROUTING_NEGATIVE_FIRST, "NegativeFirst"))
+      .AddAttribute ("EnableTransitFastPath", "Forward unicast packets for other nodes with their header "
+                     "and buffer untouched when no raw socket is open.",
+                     BooleanValue (true),
+                     MakeBooleanAccessor (&DimensionOrderedL3Protocol::m_transitFastPath),
+                     MakeBooleanChecker ())
+      .AddAttribute ("EcnMarkingThreshold", "Mark ECN-capable packets with congestion experienced when the "
+                     "transmit queue of their output device holds at least this many packets, 0 to never mark.",
+                     UintegerValue (0),
+                     MakeUintegerAccessor (&DimensionOrderedL3Protocol::m_ecnThreshold),
+                     MakeUintegerChecker<uint32_t> ())
       //TODO: Can this be fixed?
       //.AddAttribute ("InterfaceList", "The set of DimensionOrdered interfaces associated to this DimensionOrdered stack.",
       //               ObjectVectorValue (),
@@ -40,9 +72,16 @@ DimensionOrderedL3Protocol::GetTypeId (void)
 DimensionOrderedL3Protocol::DimensionOrderedL3Protocol ()
   : m_protocols (),
     m_interfaces  (),
-    m_origin (0,0,0),
-    m_dimsMax (0,0,0),
+    m_origin (),
+    m_dimsMax (),
     m_node (0),
+    m_routeCacheEnabled (true),
+    m_routeCacheValid (false),
+    m_nodeAddress (),
+    m_routingPolicy (ROUTING_DIMENSION_ORDERED),
+    m_transitFastPath (true),
+    m_ecnThreshold (0),
+    m_statistics (),
     m_sendOutgoingTrace (),
     m_unicastForwardTrace (),
     m_localDeliverTrace (),
@@ -54,7 +93,10 @@ DimensionOrderedL3Protocol::DimensionOrderedL3Protocol ()
     NS_LOG_FUNCTION (this);
     // Initialize interface slots to 0
     for (int i = 0; i < NUM_DIRS; i++)
+    {
         m_interfaces[i] = 0;
+        m_virtualChannels[i] = 1;
+    }
 }
 
 DimensionOrderedL3Protocol::~DimensionOrderedL3Protocol ()
@@ -152,9 +194,13 @@ DimensionOrderedL3Protocol::DoDispose (void)
     m_protocols.clear ();
 
     for (int i = 0; i < NUM_DIRS; i++)
+    {
         m_interfaces[i] = 0;
+        m_txQueues[i].clear ();
+    }
     m_sockets.clear ();
     m_node = 0;
+    InvalidateRouteCache ();
     
     Object::DoDispose ();
 }
@@ -210,6 +256,7 @@ DimensionOrderedL3Protocol::AddDimensionOrderedInterface (Ptr<DimensionOrderedIn
     NS_LOG_FUNCTION (this << interface << dir);
     if (dir < NUM_DIRS)
         m_interfaces[dir] = interface;
+    InvalidateRouteCache ();
     return;
 }
 
@@ -291,7 +338,19 @@ DimensionOrderedL3Protocol::Receive (Ptr<NetDevice> device, Ptr<const Packet> p,
     NS_LOG_LOGIC ("Packet from " << from << " received on node " <<
                   m_node->GetId ());
 
+    // The device may still hand the same packet to other protocol handlers
+    // and sniffers, so its tags and headers are removed from a copy. The
+    // copy shares the packet buffer, and is the one the fast path forwards
     Ptr<Packet> packet = p->Copy ();
+    m_statistics.packetCopies++;
+
+    // With cut-through channels the packet arrives once its header has; it
+    // can be forwarded right away but is only delivered locally once the
+    // tail has arrived too
+    Time tailDelay;
+    CutThroughTag cutThroughTag;
+    if (packet->RemovePacketTag (cutThroughTag))
+        tailDelay = cutThroughTag.GetTailTime () - Simulator::Now ();
 
     Ptr<DimensionOrderedInterface> dimensionOrderedInterface;
     for (uint32_t i = 0; i < NUM_DIRS; i++)
@@ -312,6 +371,7 @@ DimensionOrderedL3Protocol::Receive (Ptr<NetDevice> device, Ptr<const Packet> p,
                     NS_LOG_LOGIC ("Dropping received packet -- interface is down");
                     DimensionOrderedHeader header;
                     packet->RemoveHeader (header);
+                    m_statistics.headersRemoved++;
                     m_dropTrace (header, packet, DROP_INTERFACE_DOWN, m_node->GetObject <DimensionOrdered> (),
                                  static_cast<InterfaceDirection> (i));
                     return;
@@ -320,7 +380,27 @@ DimensionOrderedL3Protocol::Receive (Ptr<NetDevice> device, Ptr<const Packet> p,
         }
     }
     DimensionOrderedHeader header;
-    packet->RemoveHeader (header);
+    if (m_transitFastPath && m_sockets.empty ())
+    {
+        packet->PeekHeader (header);
+        m_statistics.headersPeeked++;
+        if (!header.GetDestination ().IsBroadcast () && !IsLocalAddress (header.GetDestination ()))
+        {
+            NS_LOG_LOGIC ("Transit packet from " << header.GetSource () << " destined to " << header.GetDestination ());
+            uint32_t size = header.GetSerializedSize () + header.GetPayloadSize ();
+            if (size < packet->GetSize ())
+                packet->RemoveAtEnd (packet->GetSize () - size);
+            ForwardTransit (packet, header);
+            return;
+        }
+        // Already deserialised, so only drop its bytes
+        packet->RemoveAtStart (header.GetSerializedSize ());
+    }
+    else
+    {
+        packet->RemoveHeader (header);
+        m_statistics.headersRemoved++;
+    }
 
     NS_LOG_LOGIC ("Packet from " << header.GetSource () << " destined to " << header.GetDestination ());
 
@@ -340,7 +420,7 @@ DimensionOrderedL3Protocol::Receive (Ptr<NetDevice> device, Ptr<const Packet> p,
     if (header.GetDestination ().IsBroadcast ())
     {
         NS_LOG_LOGIC ("For me (DimensionOrderedAddress broadcast address)");
-        LocalDeliver (packet, header, ifd);
+        DeliverAfter (tailDelay, packet, header, ifd);
         Forward (packet, header);
         return;
     }
@@ -358,7 +438,7 @@ DimensionOrderedL3Protocol::Receive (Ptr<NetDevice> device, Ptr<const Packet> p,
                     NS_LOG_LOGIC ("For me (destination " << addr << " match)");
                 else
                     NS_LOG_LOGIC ("For me (destination " << addr << " match) on another interface " << header.GetDestination ());
-                LocalDeliver (packet, header, ifd);
+                DeliverAfter (tailDelay, packet, header, ifd);
                 return;
             }
             NS_LOG_LOGIC ("Address " << addr << " not a match for " << header.GetDestination ());
@@ -394,6 +474,17 @@ DimensionOrderedL3Protocol::Send (Ptr<Packet> packet,
 
     DimensionOrderedHeader header;
     header = BuildHeader (source, destination, protocol, packet->GetSize());
+    // The ECN field of the TOS byte, as the socket set it
+    SocketIpTosTag ipTosTag;
+    if (packet->RemovePacketTag (ipTosTag))
+        header.SetEcn (static_cast<DimensionOrderedHeader::EcnType> (ipTosTag.GetTos () & 0x3));
+    // Every wire segment of an offloaded packet carries the header
+    SegmentationOffloadTag offloadTag;
+    if (packet->RemovePacketTag (offloadTag))
+    {
+        offloadTag.SetHeaderSize (offloadTag.GetHeaderSize () + header.GetSerializedSize ());
+        packet->AddPacketTag (offloadTag);
+    }
 
     if (destination.IsBroadcast ())
     {
@@ -402,8 +493,11 @@ DimensionOrderedL3Protocol::Send (Ptr<Packet> packet,
         {
             if (m_interfaces[i])
             {
-                m_sendOutgoingTrace (header, packet, static_cast<InterfaceDirection> (i));
-                SendRealOut(static_cast<InterfaceDirection> (i), packet, header);
+                // Every interface gets its own copy to put the header on
+                Ptr<Packet> copy = packet->Copy ();
+                m_statistics.packetCopies++;
+                m_sendOutgoingTrace (header, copy, static_cast<InterfaceDirection> (i));
+                SendRealOut(static_cast<InterfaceDirection> (i), copy, header);
             }
         }
         return;
@@ -447,6 +541,15 @@ DimensionOrderedL3Protocol::SendRealOut (InterfaceDirection dir, Ptr<Packet> pac
     NS_ASSERT (dir < NUM_DIRS);
     
     packet->AddHeader (header);
+    m_statistics.headersAdded++;
+    TransmitOut (dir, packet, header);
+}
+
+void
+DimensionOrderedL3Protocol::TransmitOut (InterfaceDirection dir, Ptr<Packet> packet,
+                                         DimensionOrderedHeader const &header)
+{
+    NS_LOG_FUNCTION (this << dir << packet << &header);
 
     Ptr<DimensionOrderedInterface> outInterface = 0;
     outInterface = m_interfaces[dir];
@@ -459,25 +562,58 @@ DimensionOrderedL3Protocol::SendRealOut (InterfaceDirection dir, Ptr<Packet> pac
         NS_LOG_LOGIC ("Send to destination " << header.GetDestination ());
         //NS_ASSERT (packet->GetSize () <= outInterface->GetDevice ()->GetMtu ());
 
+        if (!m_routeCacheValid)
+            BuildRouteCache ();
+        if (m_virtualChannels[dir] > 1)
+        {
+            VirtualChannelTag vcTag (SelectVirtualChannel (dir, header));
+            packet->ReplacePacketTag (vcTag);
+        }
+        if (!m_txQueues[dir].empty ())
+        {
+            uint32_t queued = GetQueuedPackets (dir);
+            m_statistics.queueSamples++;
+            m_statistics.queuedSum += queued;
+            m_statistics.peakQueued = std::max (m_statistics.peakQueued, queued);
+            if (m_ecnThreshold > 0 && queued >= m_ecnThreshold
+                && header.GetEcn () != DimensionOrderedHeader::ECN_NotECT
+                && header.GetEcn () != DimensionOrderedHeader::ECN_CE)
+                MarkCongestion (packet);
+        }
+
         m_txTrace (packet, m_node->GetObject<DimensionOrdered> (), dir);
         outInterface->Send (packet, header.GetDestination ());
     }
     else
     {
         NS_LOG_LOGIC ("Dropping -- outgoing interface is down: " << header.GetDestination ());
+        DimensionOrderedHeader dropped;
+        packet->RemoveHeader (dropped);
+        m_statistics.headersRemoved++;
         m_dropTrace (header, packet, DROP_INTERFACE_DOWN, m_node->GetObject<DimensionOrdered> (), dir);
     }
 }
 
+void
+DimensionOrderedL3Protocol::MarkCongestion (Ptr<Packet> packet)
+{
+    NS_LOG_FUNCTION (this << packet);
+    // Transit packets carry their header serialised, so it is rewritten
+    DimensionOrderedHeader header;
+    packet->RemoveHeader (header);
+    m_statistics.headersRemoved++;
+    header.SetEcn (DimensionOrderedHeader::ECN_CE);
+    packet->AddHeader (header);
+    m_statistics.headersAdded++;
+    m_statistics.ecnMarked++;
+}
+
 void
 DimensionOrderedL3Protocol::Forward (Ptr<const Packet> p, const DimensionOrderedHeader &header)
 {
     NS_LOG_FUNCTION (this << p << header);
     NS_LOG_LOGIC ("Forwarding logic for node: " << m_node->GetId ());
 
-    //Forwarding
-    Ptr<Packet> packet = p->Copy ();
-    
     DimensionOrderedAddress destination = header.GetDestination ();
 
     if (destination.IsBroadcast ())
@@ -486,15 +622,25 @@ DimensionOrderedL3Protocol::Forward (Ptr<const Packet> p, const DimensionOrdered
         for (uint32_t i = 0; i < NUM_DIRS; i++)
         {
             if (m_interfaces[i])
+            {
+                // Every interface gets its own copy to put the header on
+                Ptr<Packet> packet = p->Copy ();
+                m_statistics.packetCopies++;
                 SendRealOut(static_cast<InterfaceDirection> (i), packet, header);
+            }
         }
         return; 
     }
+
+    //Forwarding
+    Ptr<Packet> packet = p->Copy ();
+    m_statistics.packetCopies++;
     
     NS_LOG_LOGIC ("DimensionOrderedL3Protocol::Forward case 2: unicast to " << destination);
     InterfaceDirection destDir = FindRoute (destination);
     if (destDir < NUM_DIRS)
     {
+        m_statistics.forwarded++;
         m_unicastForwardTrace (header, packet, destDir);
         SendRealOut (destDir, packet, header);
     }
@@ -506,11 +652,267 @@ DimensionOrderedL3Protocol::Forward (Ptr<const Packet> p, const DimensionOrdered
 
 }
 
+void
+DimensionOrderedL3Protocol::ForwardTransit (Ptr<Packet> packet, const DimensionOrderedHeader &header)
+{
+    NS_LOG_FUNCTION (this << packet << header);
+
+    InterfaceDirection destDir = FindRoute (header.GetDestination ());
+    if (destDir < NUM_DIRS)
+    {
+        m_statistics.forwarded++;
+        m_statistics.fastForwarded++;
+        // The forward and drop traces show the packet without its header
+        if (!m_unicastForwardTrace.IsEmpty ())
+        {
+            Ptr<Packet> payload = packet->Copy ();
+            DimensionOrderedHeader stripped;
+            payload->RemoveHeader (stripped);
+            m_unicastForwardTrace (header, payload, destDir);
+        }
+        TransmitOut (destDir, packet, header);
+    }
+    else
+    {
+        NS_LOG_WARN ("No route to host. Drop.");
+        DimensionOrderedHeader dropped;
+        packet->RemoveHeader (dropped);
+        m_statistics.headersRemoved++;
+        m_dropTrace (header, packet, DROP_NO_ROUTE, m_node->GetObject<DimensionOrdered> (), INVALID_DIR);
+    }
+}
+
+bool
+DimensionOrderedL3Protocol::IsLocalAddress (DimensionOrderedAddress address) const
+{
+    for (uint32_t i = 0; i < NUM_DIRS; i++)
+    {
+        if (m_interfaces[i] && GetAddress (static_cast<InterfaceDirection> (i)).GetLocal () == address)
+            return true;
+    }
+    return false;
+}
+
+const DimensionOrderedL3Protocol::Statistics &
+DimensionOrderedL3Protocol::GetStatistics (void) const
+{
+    return m_statistics;
+}
+
 DimensionOrdered::InterfaceDirection
 DimensionOrderedL3Protocol::FindRoute (DimensionOrderedAddress destination)
 {
     NS_LOG_FUNCTION (this << destination);
-   
+
+    // Building the cache sets m_nodeAddress
+    if (!m_routeCacheValid && (m_routeCacheEnabled || m_routingPolicy == ROUTING_NEGATIVE_FIRST))
+        BuildRouteCache ();
+    NS_ASSERT_MSG (destination.GetNDimensions () == (m_routeCacheValid ? m_nodeAddress : GetNodeAddress ()).GetNDimensions ()
+                   || destination == DimensionOrderedAddress::GetLoopback (),
+                   "DimensionOrderedL3Protocol::FindRoute(): " << destination << " has "
+                   << destination.GetNDimensions () << " dimensions, unlike the node");
+
+    if (m_routingPolicy == ROUTING_NEGATIVE_FIRST)
+        return FindAdaptiveRoute (destination);
+
+    if (!m_routeCacheEnabled)
+        return ComputeRoute (destination);
+
+    // Check for loopback or sending to the nodeAddress
+    if (destination == m_nodeAddress || destination == DimensionOrderedAddress::GetLoopback ())
+        return LOOPBACK;
+
+    // Route in the first dimension that still differs
+    uint32_t nDims = m_nodeAddress.GetNDimensions ();
+    uint32_t dim = 0;
+    while (dim < nDims - 1 && destination.GetCoordinate (dim) == m_nodeAddress.GetCoordinate (dim))
+        dim++;
+    uint16_t destAddr = destination.GetCoordinate (dim);
+    uint16_t nodeAddr = m_nodeAddress.GetCoordinate (dim);
+
+    if (destAddr < m_nextHop[dim].size ())
+        return static_cast<InterfaceDirection> (m_nextHop[dim][destAddr]);
+
+    // Destination lies outside of the topology, use the arithmetic
+    return ComputeRouteInDimension (dim, destAddr, nodeAddr);
+}
+
+DimensionOrdered::InterfaceDirection
+DimensionOrderedL3Protocol::FindAdaptiveRoute (DimensionOrderedAddress destination)
+{
+    NS_LOG_FUNCTION (this << destination);
+
+    // The transmit queues are looked up along with the next-hop tables
+    if (!m_routeCacheValid)
+        BuildRouteCache ();
+
+    if (destination == m_nodeAddress || destination == DimensionOrderedAddress::GetLoopback ())
+        return LOOPBACK;
+
+    // Shortest way around every dimension that still differs; any NEG hop
+    // goes before all POS hops, otherwise the emptier queue wins and ties
+    // keep the dimension order
+    InterfaceDirection bestDir = INVALID_DIR;
+    bool bestIsNeg = false;
+    uint32_t bestQueued = 0;
+    for (uint32_t dim = 0; dim < m_nodeAddress.GetNDimensions (); dim++)
+    {
+        uint16_t destAddr = destination.GetCoordinate (dim);
+        uint16_t nodeAddr = m_nodeAddress.GetCoordinate (dim);
+        if (destAddr == nodeAddr)
+            continue;
+
+        InterfaceDirection dir;
+        if (m_routeCacheEnabled && destAddr < m_nextHop[dim].size ())
+            dir = static_cast<InterfaceDirection> (m_nextHop[dim][destAddr]);
+        else
+            dir = ComputeRouteInDimension (dim, destAddr, nodeAddr);
+        if (dir >= NUM_DIRS)
+            continue;
+
+        bool isNeg = (dir % 2) == 1;
+        uint32_t queued = GetQueuedBytes (dir);
+        if (bestDir == INVALID_DIR || (isNeg && !bestIsNeg) ||
+            (isNeg == bestIsNeg && queued < bestQueued))
+        {
+            bestDir = dir;
+            bestIsNeg = isNeg;
+            bestQueued = queued;
+        }
+    }
+    return bestDir;
+}
+
+DimensionOrdered::InterfaceDirection
+DimensionOrderedL3Protocol::ComputeRoute (DimensionOrderedAddress destination) const
+{
+    NS_LOG_FUNCTION (this << destination);
+
+    DimensionOrderedAddress nodeAddress = GetNodeAddress ();
+
+    // Check for loopback or sending to the nodeAddress
+    if (destination == DimensionOrderedAddress::GetLoopback () || destination == nodeAddress)
+        return LOOPBACK;
+    
+    // Route in the lowest dimension that still differs
+    for (uint32_t dim = 0; dim < nodeAddress.GetNDimensions (); dim++)
+    {
+        if (destination.GetCoordinate (dim) != nodeAddress.GetCoordinate (dim))
+            return ComputeRouteInDimension (dim, destination.GetCoordinate (dim), nodeAddress.GetCoordinate (dim));
+    }
+
+    return INVALID_DIR;
+}
+
+DimensionOrdered::InterfaceDirection
+DimensionOrderedL3Protocol::ComputeRouteInDimension (uint32_t dim, int32_t destAddr, int32_t nodeAddr) const
+{
+    NS_LOG_FUNCTION (this << dim << destAddr << nodeAddr);
+
+    // Directions are laid out as POS, NEG pairs per dimension
+    InterfaceDirection posDir = static_cast<InterfaceDirection> (2 * dim);
+    InterfaceDirection negDir = static_cast<InterfaceDirection> (2 * dim + 1);
+    if (dim >= m_origin.GetNDimensions () || dim >= m_dimsMax.GetNDimensions ())
+        return INVALID_DIR;
+    int32_t originAddr = static_cast<int32_t> (m_origin.GetCoordinate (dim));
+    int32_t maxAddr = static_cast<int32_t> (m_dimsMax.GetCoordinate (dim));
+
+    //
+    // Find shortest path to correct destination in this dimension
+    //
+    // Get distance by subtraction
+    int32_t distance = destAddr - nodeAddr;
+    // Destnation is in NEG direction, but this
+    // does not mean NEG is the shortest path to take
+    if (distance < 0)
+    {
+        int32_t negDistance = -distance; 
+        int32_t posDistance = (maxAddr - nodeAddr) + (destAddr - originAddr) + 1;
+        if (posDistance < negDistance && m_interfaces[posDir])
+            return posDir;
+        else if (posDistance > negDistance && m_interfaces[negDir])
+            return negDir;
+        else if (m_interfaces[negDir])
+            return negDir;
+        else if (m_interfaces[posDir])
+            return posDir;
+    }
+    // Destination is in the POS direction, but this
+    // does not mean POS is the shortest path to take
+    else
+    {
+        int32_t posDistance = distance;
+        int32_t negDistance = (nodeAddr - originAddr) + (maxAddr - destAddr) + 1;
+        if (posDistance < negDistance && m_interfaces[posDir])
+            return posDir;
+        else if (posDistance > negDistance && m_interfaces[negDir])
+            return negDir;
+        else if (m_interfaces[posDir])
+            return posDir;
+        else if (m_interfaces[negDir])
+            return negDir;
+    }
+
+    return INVALID_DIR;
+}
+
+uint32_t
+DimensionOrderedL3Protocol::GetQueuedPackets (InterfaceDirection dir) const
+{
+    uint32_t queued = 0;
+    for (std::vector<Ptr<Queue> >::const_iterator it = m_txQueues[dir].begin (); it != m_txQueues[dir].end (); ++it)
+        queued += (*it)->GetNPackets ();
+    return queued;
+}
+
+uint32_t
+DimensionOrderedL3Protocol::GetQueuedBytes (InterfaceDirection dir) const
+{
+    uint32_t queued = 0;
+    for (std::vector<Ptr<Queue> >::const_iterator it = m_txQueues[dir].begin (); it != m_txQueues[dir].end (); ++it)
+        queued += (*it)->GetNBytes ();
+    return queued;
+}
+
+uint32_t
+DimensionOrderedL3Protocol::SelectVirtualChannel (InterfaceDirection dir, DimensionOrderedHeader const &header) const
+{
+    NS_LOG_FUNCTION (this << dir << &header);
+
+    uint32_t nVcs = m_virtualChannels[dir];
+    uint32_t dim = dir / 2;
+    DimensionOrderedAddress source = header.GetSource ();
+    if (dir == LOOPBACK || header.GetDestination ().IsBroadcast () || dim >= source.GetNDimensions ())
+        return 0;
+
+    // The wraparound link of every ring is its dateline. Packets go on the
+    // lower half of the virtual channels until they cross it and on the
+    // upper half from then on; a minimal route crosses it at most once, so
+    // neither half has a cyclic dependency. A packet travels one way in a
+    // dimension from the coordinate of its source, so it has crossed once
+    // it is behind that coordinate.
+    int32_t nodeAddr = m_nodeAddress.GetCoordinate (dim);
+    int32_t sourceAddr = source.GetCoordinate (dim);
+    bool crossed;
+    if (dir % 2 == 0)
+        crossed = nodeAddr < sourceAddr || nodeAddr == static_cast<int32_t> (m_dimsMax.GetCoordinate (dim));
+    else
+        crossed = nodeAddr > sourceAddr || nodeAddr == static_cast<int32_t> (m_origin.GetCoordinate (dim));
+    uint32_t first = crossed ? nVcs / 2 : 0;
+    uint32_t lanes = crossed ? nVcs - nVcs / 2 : nVcs / 2;
+
+    // Spread flows over the virtual channels of the class; a flow stays on
+    // one so that its packets are not reordered
+    DimensionOrderedAddressHash hash;
+    size_t flow = hash (source) * 31 + hash (header.GetDestination ());
+    return first + flow % lanes;
+}
+
+DimensionOrderedAddress
+DimensionOrderedL3Protocol::GetNodeAddress (void) const
+{
+    NS_LOG_FUNCTION (this);
+
     // Assume all addresses of all interfaces are equal, so assert that first
     bool addressInit = false;
     DimensionOrderedAddress nodeAddress;
@@ -529,151 +931,99 @@ DimensionOrderedL3Protocol::FindRoute (DimensionOrderedAddress destination)
             {
                 if (m_interfaces[i]->GetAddress ().GetLocal () != nodeAddress)
                     NS_ASSERT_MSG (false, 
-                                   "DimensionOrderedL3Protocol::FindRoute: Not all interface addresses match");
+                                   "DimensionOrderedL3Protocol::GetNodeAddress: Not all interface addresses match");
             }
         }
     }
+    return nodeAddress;
+}
 
-    // Check for loopback or sending to the nodeAddress
-    if (destination == DimensionOrderedAddress::GetLoopback () || destination == nodeAddress)
-        return LOOPBACK;
-    
-    // Check if we need to route in X dimension still 
-    if (destination.GetAddressX () != nodeAddress.GetAddressX ())
-    {
-        //
-        // Find shortest path to correct x destination
-        //
-        // Cast addresses to signed values for use with subtraction
-        int32_t destXAddr = static_cast<int32_t> (destination.GetAddressX ());
-        int32_t nodeXAddr = static_cast<int32_t> (nodeAddress.GetAddressX ());
-        int32_t originXAddr = static_cast<int32_t> (std::get<0> (m_origin));
-        int32_t maxXAddr = static_cast<int32_t> (std::get<0> (m_dimsMax));
-        // Get distance by subtraction
-        int32_t distance = destXAddr - nodeXAddr;
-        // Destnation is in X_NEG direction, but this
-        // does not mean X_NEG is the shortest path to take
-        if (distance < 0)
-        {
-           int32_t xNegDistance = -distance; 
-           int32_t xPosDistance = (maxXAddr - nodeXAddr) + (destXAddr - originXAddr) + 1;
-           if (xPosDistance < xNegDistance && m_interfaces[X_POS])
-               return X_POS;
-           else if (xPosDistance > xNegDistance && m_interfaces[X_NEG])
-               return X_NEG;
-           else if (m_interfaces[X_NEG])
-               return X_NEG;
-           else if (m_interfaces[X_POS])
-               return X_POS;
+void
+DimensionOrderedL3Protocol::BuildRouteCache (void)
+{
+    NS_LOG_FUNCTION (this);
 
-        }
-        // Destination is in the X_POS direction, but this
-        // does not mean X_POS is the shortest path to take
-        else
+    m_nodeAddress = GetNodeAddress ();
+    NS_ASSERT_MSG (m_dimsMax.GetNDimensions () >= m_nodeAddress.GetNDimensions (),
+                   "DimensionOrderedL3Protocol: node address " << m_nodeAddress << " has more dimensions "
+                   "than the topology " << m_dimsMax);
+
+    for (uint32_t dim = 0; dim < DimensionOrderedAddress::MAX_DIMS; dim++)
+    {
+        m_nextHop[dim].clear ();
+        if (dim >= m_nodeAddress.GetNDimensions ())
+            continue;
+        int32_t nodeAddr = m_nodeAddress.GetCoordinate (dim);
+        uint32_t dimMax = m_dimsMax.GetCoordinate (dim);
+        m_nextHop[dim].assign (dimMax + 1, INVALID_DIR);
+        for (uint32_t destAddr = 0; destAddr <= dimMax; destAddr++)
         {
-            int32_t xPosDistance = distance;
-            int32_t xNegDistance = (nodeXAddr - originXAddr) + (maxXAddr - destXAddr) + 1;
-            if (xPosDistance < xNegDistance && m_interfaces[X_POS])
-                return X_POS;
-            else if (xPosDistance > xNegDistance && m_interfaces[X_NEG])
-                return X_NEG;
-            else if (m_interfaces[X_POS])
-                return X_POS;
-            else if (m_interfaces[X_NEG])
-                return X_NEG;
+            if (static_cast<int32_t> (destAddr) != nodeAddr)
+                m_nextHop[dim][destAddr] = ComputeRouteInDimension (dim, destAddr, nodeAddr);
         }
-         
-    }
-    else if (destination.GetAddressY () != nodeAddress.GetAddressY ())
-    {
-        //
-        // Find shortest path to correct y destination
-        //
-        // Cast addresses to signed values for use with subtraction
-        int32_t destYAddr = static_cast<int32_t> (destination.GetAddressY ());
-        int32_t nodeYAddr = static_cast<int32_t> (nodeAddress.GetAddressY ());
-        int32_t originYAddr = static_cast<int32_t> (std::get<1> (m_origin));
-        int32_t maxYAddr = static_cast<int32_t> (std::get<1> (m_dimsMax));
-        // Get distance by subtraction
-        int32_t distance = destYAddr - nodeYAddr;
-        // Destnation is in Y_NEG direction, but this
-        // does not mean Y_NEG is the shortest path to take
-        if (distance < 0)
-        {
-           int32_t yNegDistance = -distance;
-           int32_t yPosDistance = (maxYAddr - nodeYAddr) + (destYAddr - originYAddr) + 1;
-           if (yPosDistance < yNegDistance && m_interfaces[Y_POS])
-               return Y_POS;
-           else if (yPosDistance > yNegDistance && m_interfaces[Y_NEG])
-               return Y_NEG;
-           else if (m_interfaces[Y_NEG])
-               return Y_NEG;
-           else if (m_interfaces[Y_POS])
-               return Y_POS;
+    }
 
-        }
-        // Destination is in the Y_POS direction, but this
-        // does not mean Y_POS is the shortest path to take
-        else
+    // Point-to-point devices expose the queues of their virtual channels as
+    // the VirtualChannelQueues attribute, other devices at most a TxQueue
+    for (uint32_t i = 0; i < NUM_DIRS; i++)
+    {
+        ObjectVectorValue vcQueues;
+        PointerValue queue;
+        UintegerValue vcs (1);
+        m_txQueues[i].clear ();
+        if (m_interfaces[i])
         {
-            int32_t yPosDistance = distance;
-            int32_t yNegDistance = (nodeYAddr - originYAddr) + (maxYAddr - destYAddr) + 1;
-            if (yPosDistance < yNegDistance && m_interfaces[Y_POS])
-                return Y_POS;
-            else if (yPosDistance > yNegDistance && m_interfaces[Y_NEG])
-                return Y_NEG;
-            else if (m_interfaces[Y_POS])
-                return Y_POS;
-            else if (m_interfaces[Y_NEG])
-                return Y_NEG;
+            Ptr<NetDevice> device = m_interfaces[i]->GetDevice ();
+            if (device->GetAttributeFailSafe ("VirtualChannelQueues", vcQueues))
+            {
+                for (ObjectVectorValue::Iterator it = vcQueues.Begin (); it != vcQueues.End (); ++it)
+                    if (it->second)
+                        m_txQueues[i].push_back (it->second->GetObject<Queue> ());
+            }
+            else if (device->GetAttributeFailSafe ("TxQueue", queue) && queue.Get<Queue> ())
+                m_txQueues[i].push_back (queue.Get<Queue> ());
+            device->GetAttributeFailSafe ("VirtualChannels", vcs);
         }
+        m_virtualChannels[i] = vcs.Get ();
     }
-    else if (destination.GetAddressZ () != nodeAddress.GetAddressZ ())
-    {
-        //
-        // Find shortest path to correct z destination
-        //
-        // Cast addresses to signed values for use with subtraction
-        int32_t destZAddr = static_cast<int32_t> (destination.GetAddressZ ());
-        int32_t nodeZAddr = static_cast<int32_t> (nodeAddress.GetAddressZ ());
-        int32_t originZAddr = static_cast<int32_t> (std::get<2> (m_origin));
-        int32_t maxZAddr = static_cast<int32_t> (std::get<2> (m_dimsMax));
-        // Get distance by subtraction
-        int32_t distance = destZAddr - nodeZAddr;
-        // Destnation is in Z_NEG direction, but this
-        // does not mean Z_NEG is the shortest path to take
-        if (distance < 0)
-        {
-           int32_t zNegDistance = -distance;
-           int32_t zPosDistance = (maxZAddr - nodeZAddr) + (destZAddr - originZAddr) + 1;
-           if (zPosDistance < zNegDistance && m_interfaces[Z_POS])
-               return Z_POS;
-           else if (zPosDistance > zNegDistance && m_interfaces[Z_NEG])
-               return Z_NEG;
-           else if (m_interfaces[Z_NEG])
-               return Z_NEG;
-           else if (m_interfaces[Z_POS])
-               return Z_POS;
 
-        }
-        // Destination is in the Z_POS direction, but this
-        // does not mean Z_POS is the shortest path to take
-        else
+    // The turn model orders the hops of different dimensions, the rings of
+    // a torus are only broken by the dateline virtual channels. A node at
+    // the edge of a dimension that still has a link out of it sees a ring
+    if (m_routingPolicy == ROUTING_NEGATIVE_FIRST)
+    {
+        for (uint32_t dim = 0; dim < m_nodeAddress.GetNDimensions (); dim++)
         {
-            int32_t zPosDistance = distance;
-            int32_t zNegDistance = (nodeZAddr - originZAddr) + (maxZAddr - destZAddr) + 1;
-            if (zPosDistance < zNegDistance && m_interfaces[Z_POS])
-                return Z_POS;
-            else if (zPosDistance > zNegDistance && m_interfaces[Z_NEG])
-                return Z_NEG;
-            else if (m_interfaces[Z_POS])
-                return Z_POS;
-            else if (m_interfaces[Z_NEG])
-                return Z_NEG;
+            uint16_t nodeAddr = m_nodeAddress.GetCoordinate (dim);
+            uint32_t posDir = 2 * dim;
+            uint32_t negDir = 2 * dim + 1;
+            bool ring = (nodeAddr == m_origin.GetCoordinate (dim) && m_interfaces[negDir]) ||
+                        (nodeAddr == m_dimsMax.GetCoordinate (dim) && m_interfaces[posDir]);
+            NS_ABORT_MSG_IF (ring && (m_virtualChannels[posDir] < 2 || m_virtualChannels[negDir] < 2),
+                             "DimensionOrderedL3Protocol: NegativeFirst routing on a torus can deadlock "
+                             "without two or more virtual channels on every device");
         }
     }
+    m_routeCacheValid = true;
+}
 
-    return INVALID_DIR;
+void
+DimensionOrderedL3Protocol::InvalidateRouteCache (void)
+{
+    NS_LOG_FUNCTION (this);
+    m_routeCacheValid = false;
+}
+
+void
+DimensionOrderedL3Protocol::DeliverAfter (Time delay, Ptr<const Packet> packet, DimensionOrderedHeader const &header,
+                                          InterfaceDirection ifd)
+{
+    NS_LOG_FUNCTION (this << delay << packet << &header << ifd);
+
+    if (delay.IsStrictlyPositive ())
+        Simulator::Schedule (delay, &DimensionOrderedL3Protocol::LocalDeliver, this, packet, header, ifd);
+    else
+        LocalDeliver (packet, header, ifd);
 }
 
 void
@@ -682,15 +1032,15 @@ DimensionOrderedL3Protocol::LocalDeliver (Ptr<const Packet> packet, DimensionOrd
 {
     NS_LOG_FUNCTION (this << packet << &header << ifd);
     Ptr<Packet> p = packet->Copy (); // need to pass a non-const packet up
+    m_statistics.packetCopies++;
 
     m_localDeliverTrace (header, packet, ifd);
 
     Ptr<DimensionOrderedL4Protocol> protocol = GetProtocol (header.GetProtocol ());
     if (protocol != 0)
     {
-        // we need to make a copy in the unlikely event we hit the
-        // RX_ENPOINT_UNREACH codepath
-        Ptr<Packet> copy = p->Copy ();
+        // a copy of the packet will be needed for an ICMP unreachable
+        // on the RX_ENDPOINT_UNREACH codepath, once that is implemented
         enum DimensionOrderedL4Protocol::RxStatus status = protocol->Receive (p, header, GetInterface(ifd));
         switch (status)
         {
@@ -718,6 +1068,7 @@ DimensionOrderedL3Protocol::SetAddress (InterfaceDirection dir, DimensionOrdered
     if (interface == 0)
         return false;
     bool retVal = interface->SetAddress (address);
+    InvalidateRouteCache ();
     return retVal;
 }
 
@@ -819,13 +1170,14 @@ DimensionOrderedL3Protocol::GetNetDevice (InterfaceDirection dir)
 }
 
 void
-DimensionOrderedL3Protocol::SetOrigin (std::tuple<uint8_t, uint8_t, uint8_t> origin)
+DimensionOrderedL3Protocol::SetOrigin (DimensionOrderedAddress origin)
 {
-    NS_LOG_FUNCTION (this << &origin);
+    NS_LOG_FUNCTION (this << origin);
     m_origin = origin;
+    InvalidateRouteCache ();
 }
 
-std::tuple<uint8_t, uint8_t, uint8_t>
+DimensionOrderedAddress
 DimensionOrderedL3Protocol::GetOrigin (void) const
 {
     NS_LOG_FUNCTION (this);
@@ -833,13 +1185,14 @@ DimensionOrderedL3Protocol::GetOrigin (void) const
 }
 
 void
-DimensionOrderedL3Protocol::SetDimensionsMax (std::tuple<uint8_t, uint8_t, uint8_t> dimsMax)
+DimensionOrderedL3Protocol::SetDimensionsMax (DimensionOrderedAddress dimsMax)
 {
-    NS_LOG_FUNCTION (this << &dimsMax);
+    NS_LOG_FUNCTION (this << dimsMax);
     m_dimsMax = dimsMax;
+    InvalidateRouteCache ();
 }
 
-std::tuple<uint8_t, uint8_t, uint8_t>
+DimensionOrderedAddress
 DimensionOrderedL3Protocol::GetDimensionsMax (void) const
 {
     NS_LOG_FUNCTION (this);
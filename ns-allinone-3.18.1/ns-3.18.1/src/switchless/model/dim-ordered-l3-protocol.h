@@ -3,11 +3,13 @@
 #define DIM_ORDERED_L3_PROTOCOL_H
 
 // C/C++ includes
+#include <vector>
 
 // NS3 includes
 #include "ns3/icmpv4-l4-protocol.h"
 #include "ns3/traced-callback.h"
 #include "ns3/object-vector.h"
+#include "ns3/queue.h"
 
 // Switchless includes
 #include "ns3/dim-ordered.h"
@@ -43,6 +45,38 @@ public:
       DROP_ROUTE_ERROR
   };
 
+  /**
+   * \enum RoutingPolicy
+   * \brief How the next hop is chosen among the productive directions.
+   */
+  enum RoutingPolicy
+  {
+      // Strictly X, then Y, then Z
+      ROUTING_DIMENSION_ORDERED = 0,
+      // Minimal adaptive with the negative-first turn model: the productive
+      // NEG directions are used before the POS ones and within each group
+      // the direction with the fewest bytes queued for transmission wins.
+      // On a torus the devices need two or more virtual channels
+      ROUTING_NEGATIVE_FIRST
+  };
+
+  /**
+   * \brief Packet handling counters, to measure the cost of forwarding
+   */
+  struct Statistics
+  {
+    uint64_t forwarded;       // unicast packets forwarded to another node
+    uint64_t fastForwarded;   // of which on the transit fast path
+    uint64_t packetCopies;    // Packet::Copy calls
+    uint64_t headersAdded;    // DimensionOrderedHeader serialisations
+    uint64_t headersRemoved;  // DimensionOrderedHeader deserialisations
+    uint64_t headersPeeked;   // deserialisations that leave the header in place
+    uint64_t queueSamples;    // packets handed to a device with a transmit queue
+    uint64_t queuedSum;       // packets they found in its queues
+    uint32_t peakQueued;      // most packets one of them found in its queues
+    uint64_t ecnMarked;       // ECN-capable packets marked with congestion experienced
+  };
+
   void SetNode (Ptr<Node> node);
 
   // functions defined in base class DimensionOrdered
@@ -132,10 +166,37 @@ public:
 
   Ptr<NetDevice> GetNetDevice (InterfaceDirection dir);
 
-  void SetOrigin (std::tuple<uint8_t, uint8_t, uint8_t> origin);
-  std::tuple<uint8_t, uint8_t, uint8_t> GetOrigin (void) const;
-  void SetDimensionsMax (std::tuple<uint8_t, uint8_t, uint8_t> dimsMax);
-  std::tuple<uint8_t, uint8_t, uint8_t> GetDimensionsMax (void) const;
+  void SetOrigin (DimensionOrderedAddress origin);
+  DimensionOrderedAddress GetOrigin (void) const;
+  void SetDimensionsMax (DimensionOrderedAddress dimsMax);
+  DimensionOrderedAddress GetDimensionsMax (void) const;
+
+  /**
+   * \brief Find the interface to send a packet towards destination on
+   * \param destination destination address of the packet
+   * \returns the direction of the next hop, LOOPBACK if the packet is for
+   * this node, or INVALID_DIR if there is no route
+   *
+   * When the route cache is enabled (the default) this is a lookup into a
+   * per-dimension next-hop table that is built the first time a route is
+   * needed after the origin, dimensions, interfaces or addresses change.
+   *
+   * With the NegativeFirst routing policy the result depends on the
+   * current transmit queues, so packets of one flow may take different
+   * minimal paths and arrive out of order. The turn model keeps meshes
+   * deadlock-free; the wraparound links of a torus still form rings in
+   * every dimension, so on a torus it aborts unless the devices have the
+   * virtual channels below.
+   *
+   * On a torus with lossless links, the rings are broken by giving the
+   * devices two or more virtual channels (the VirtualChannels attribute
+   * of PointToPointNetDevice): packets switch to the upper half of the
+   * virtual channels of a dimension when they cross its wraparound link.
+   * On a mesh the upper half is never used.
+   */
+  InterfaceDirection FindRoute (DimensionOrderedAddress destination);
+
+  const Statistics &GetStatistics (void) const;
 
 protected:
 
@@ -157,9 +218,38 @@ private:
     uint16_t payloadSize);
 
   void SendRealOut (InterfaceDirection dir, Ptr<Packet> packet, DimensionOrderedHeader const &header);
+  // Send a packet that already carries header
+  void TransmitOut (InterfaceDirection dir, Ptr<Packet> packet, DimensionOrderedHeader const &header);
+  // Set congestion experienced in the header a packet carries
+  void MarkCongestion (Ptr<Packet> packet);
   void Forward (Ptr<const Packet> p, const DimensionOrderedHeader &header);
-  InterfaceDirection FindRoute (DimensionOrderedAddress destination);
+  /**
+   * Forward a unicast packet for another node without taking its header
+   * off and putting it back on
+   */
+  void ForwardTransit (Ptr<Packet> packet, const DimensionOrderedHeader &header);
+  bool IsLocalAddress (DimensionOrderedAddress address) const;
 
+  /**
+   * Dimension ordered routing computed from scratch: finds the address of
+   * this node and picks the shortest way around the first dimension in which
+   * it differs from destination.
+   */
+  InterfaceDirection ComputeRoute (DimensionOrderedAddress destination) const;
+  InterfaceDirection ComputeRouteInDimension (uint32_t dim, int32_t destAddr, int32_t nodeAddr) const;
+  InterfaceDirection FindAdaptiveRoute (DimensionOrderedAddress destination);
+  // Virtual channel of the next hop on dir, with the wraparound link of
+  // every dimension as its dateline
+  uint32_t SelectVirtualChannel (InterfaceDirection dir, DimensionOrderedHeader const &header) const;
+  // Packets and bytes in the transmit queues of every virtual channel of dir
+  uint32_t GetQueuedPackets (InterfaceDirection dir) const;
+  uint32_t GetQueuedBytes (InterfaceDirection dir) const;
+  DimensionOrderedAddress GetNodeAddress (void) const;
+  void BuildRouteCache (void);
+  void InvalidateRouteCache (void);
+
+  // LocalDeliver once the tail of a cut-through packet has arrived
+  void DeliverAfter (Time delay, Ptr<const Packet> p, DimensionOrderedHeader const &header, InterfaceDirection ifd);
   void LocalDeliver (Ptr<const Packet> p, DimensionOrderedHeader const &header, InterfaceDirection ifd);
 
   void AddDimensionOrderedInterface (Ptr<DimensionOrderedInterface> interface, InterfaceDirection dir);
@@ -173,10 +263,26 @@ private:
 
   L4List_t m_protocols;
   Ptr<DimensionOrderedInterface> m_interfaces[NUM_DIRS];
-  std::tuple<uint8_t, uint8_t, uint8_t> m_origin;
-  std::tuple<uint8_t, uint8_t, uint8_t> m_dimsMax;
+  DimensionOrderedAddress m_origin;
+  DimensionOrderedAddress m_dimsMax;
   Ptr<Node> m_node;
 
+  bool m_routeCacheEnabled;
+  bool m_routeCacheValid;
+  DimensionOrderedAddress m_nodeAddress;
+  // Next hop for every coordinate of every dimension
+  std::vector<uint8_t> m_nextHop[DimensionOrderedAddress::MAX_DIMS];
+  RoutingPolicy m_routingPolicy;
+  // Transmit queues of the device of every direction, one per virtual
+  // channel, none if it has no queue
+  std::vector<Ptr<Queue> > m_txQueues[NUM_DIRS];
+  // Virtual channels of the device of every direction
+  uint32_t m_virtualChannels[NUM_DIRS];
+  bool m_transitFastPath;
+  // Queue length from which ECN-capable packets are marked, 0 for never
+  uint32_t m_ecnThreshold;
+  Statistics m_statistics;
+
   TracedCallback<const DimensionOrderedHeader &, Ptr<const Packet>, InterfaceDirection> m_sendOutgoingTrace;
   TracedCallback<const DimensionOrderedHeader &, Ptr<const Packet>, uint32_t> m_unicastForwardTrace;
   TracedCallback<const DimensionOrderedHeader &, Ptr<const Packet>, InterfaceDirection> m_localDeliverTrace;
@@ -65,7 +65,7 @@ bool
 DimensionOrderedSocketAddress::IsMatchingType (const Address &address)
 {
     NS_LOG_FUNCTION (&address);
-    return address.CheckCompatible (GetType (), 5);
+    return address.IsMatchingType (GetType ());
 }
 
 DimensionOrderedSocketAddress::operator Address () const
@@ -77,22 +77,25 @@ Address
 DimensionOrderedSocketAddress::ConvertTo (void) const
 {
     NS_LOG_FUNCTION (this);
-    uint8_t buf[5];
-    m_address.Serialize(buf);
-    buf[3] = m_port & 0xff;
-    buf[4] = (m_port >> 8) & 0xff;
-    return Address (GetType (), buf, 5);
+    // The address followed by the port
+    uint8_t buf[DimensionOrderedAddress::MAX_SERIALIZED_SIZE + 2];
+    uint32_t size = m_address.GetSerializedSize ();
+    m_address.Serialize (buf);
+    buf[size] = m_port & 0xff;
+    buf[size + 1] = (m_port >> 8) & 0xff;
+    return Address (GetType (), buf, size + 2);
 }
 
 DimensionOrderedSocketAddress
 DimensionOrderedSocketAddress::ConvertFrom (const Address &address)
 {
     NS_LOG_FUNCTION (&address);
-    NS_ASSERT (address.CheckCompatible (GetType (), 5));
-    uint8_t buf[5];
+    NS_ASSERT (IsMatchingType (address));
+    uint8_t buf[Address::MAX_SIZE];
     address.CopyTo (buf);
     DimensionOrderedAddress dimOrderedAddress = DimensionOrderedAddress::Deserialize (buf);
-    uint16_t port = buf[3] | (buf[4] << 8);
+    uint32_t size = dimOrderedAddress.GetSerializedSize ();
+    uint16_t port = buf[size] | (buf[size + 1] << 8);
     return DimensionOrderedSocketAddress (dimOrderedAddress, port);
 }
 
@@ -1,5 +1,7 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 
+#include <sstream>
+
 #include "dim-ordered.h"
 
 NS_LOG_COMPONENT_DEFINE ("DimensionOrdered");
@@ -51,9 +53,16 @@ DimensionOrdered::InterfaceDirectionToAscii (InterfaceDirection dir)
         case INVALID_DIR:
             return "INVALID_DIR";
         default:
-            return "INVALID_DIR";
+            break;
     }
 
+    // Directions of the unnamed dimensions
+    if (dir < LOOPBACK)
+    {
+        std::ostringstream oss;
+        oss << "D" << dir / 2 << (dir % 2 ? "_NEG" : "_POS");
+        return oss.str ();
+    }
     return "INVALID_DIR";
 }
 
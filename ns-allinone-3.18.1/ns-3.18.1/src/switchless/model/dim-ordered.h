@@ -3,7 +3,6 @@
 #define DIM_ORDERED_H
 
 // C/C++ includes
-#include <tuple>
 
 // NS3 includes
 #include "ns3/object.h"
@@ -50,6 +49,10 @@ public:
   /**
    * \enum Interface Direction
    * \brief The direction a specific interface faces
+   *
+   * Directions are laid out as POS, NEG pairs per dimension, so dimension d
+   * has directions 2d and 2d + 1 (see GetDirection); only the first three
+   * dimensions are named.
    */
   enum InterfaceDirection
   {
@@ -59,12 +62,22 @@ public:
       Y_NEG,
       Z_POS,
       Z_NEG,
-      LOOPBACK,
+      LOOPBACK = 2 * DimensionOrderedAddress::MAX_DIMS,
       NUM_DIRS, // THIS MUST BE THE LAST ONE BEFORE INVALID
       INVALID_DIR
   };
   static std::string InterfaceDirectionToAscii (InterfaceDirection dir);
 
+  /**
+   * \param dim dimension, 0 is X
+   * \param negative true for the NEG direction
+   * \returns the direction along dim
+   */
+  static InterfaceDirection GetDirection (uint32_t dim, bool negative)
+  {
+      return static_cast<InterfaceDirection> (2 * dim + (negative ? 1 : 0));
+  }
+
   /**
    * \param device device to add to the list of DimensionOrdered interface
    * which can be used as output interfaces during packet forwarding.
@@ -265,27 +278,28 @@ public:
 
   /**
    * \brief Sets the origin of the DimensionOrdered topology for use in routing
-   * \param origin Tuple specifying the origin in the form (x,y,z)
+   * \param origin Lowest coordinate of every dimension, with as many
+   * dimensions as the node addresses
    */
-  virtual void SetOrigin (std::tuple<uint8_t, uint8_t, uint8_t> origin) = 0;
+  virtual void SetOrigin (DimensionOrderedAddress origin) = 0;
 
   /**
    * \brief Get the current origin of the DimensionOrdered topology
-   * \returns Tuple specifiying the origin in the for (x,y,z)
+   * \returns Lowest coordinate of every dimension
    */
-  virtual std::tuple<uint8_t, uint8_t, uint8_t> GetOrigin (void) const = 0;
+  virtual DimensionOrderedAddress GetOrigin (void) const = 0;
 
   /**
    * \brief Sets the max value for each dimension
-   * \param dimsMax Tuple specifying the maximum value for each dimension in the form (x,y,z)
+   * \param dimsMax Highest coordinate of every dimension
    */
-  virtual void SetDimensionsMax (std::tuple<uint8_t, uint8_t, uint8_t> dimsMax) = 0;
+  virtual void SetDimensionsMax (DimensionOrderedAddress dimsMax) = 0;
 
   /**
    * \brief Gets the current max value for each dimension
-   * \returns Tuple specifying the max value for each dimension in the form (x,y,z)
+   * \returns Highest coordinate of every dimension
    */
-  virtual std::tuple<uint8_t, uint8_t, uint8_t> GetDimensionsMax (void) const = 0;
+  virtual DimensionOrderedAddress GetDimensionsMax (void) const = 0;
 private:
 };
 
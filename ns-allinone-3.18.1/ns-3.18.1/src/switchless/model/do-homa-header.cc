@@ -0,0 +1,197 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "do-homa-header.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (DoHomaHeader);
+
+DoHomaHeader::DoHomaHeader ()
+  : m_sourcePort (0),
+    m_destinationPort (0),
+    m_type (DATA),
+    m_priority (0),
+    m_messageId (0),
+    m_messageLength (0),
+    m_offset (0),
+    m_length (0)
+{
+}
+
+DoHomaHeader::~DoHomaHeader ()
+{
+}
+
+void
+DoHomaHeader::SetSourcePort (uint16_t port)
+{
+  m_sourcePort = port;
+}
+
+void
+DoHomaHeader::SetDestinationPort (uint16_t port)
+{
+  m_destinationPort = port;
+}
+
+void
+DoHomaHeader::SetType (PacketType type)
+{
+  m_type = type;
+}
+
+void
+DoHomaHeader::SetPriority (uint8_t priority)
+{
+  m_priority = priority;
+}
+
+void
+DoHomaHeader::SetMessageId (uint32_t id)
+{
+  m_messageId = id;
+}
+
+void
+DoHomaHeader::SetMessageLength (uint32_t length)
+{
+  m_messageLength = length;
+}
+
+void
+DoHomaHeader::SetOffset (uint32_t offset)
+{
+  m_offset = offset;
+}
+
+void
+DoHomaHeader::SetLength (uint32_t length)
+{
+  m_length = length;
+}
+
+uint16_t
+DoHomaHeader::GetSourcePort (void) const
+{
+  return m_sourcePort;
+}
+
+uint16_t
+DoHomaHeader::GetDestinationPort (void) const
+{
+  return m_destinationPort;
+}
+
+DoHomaHeader::PacketType
+DoHomaHeader::GetType (void) const
+{
+  return static_cast<PacketType> (m_type);
+}
+
+uint8_t
+DoHomaHeader::GetPriority (void) const
+{
+  return m_priority;
+}
+
+uint32_t
+DoHomaHeader::GetMessageId (void) const
+{
+  return m_messageId;
+}
+
+uint32_t
+DoHomaHeader::GetMessageLength (void) const
+{
+  return m_messageLength;
+}
+
+uint32_t
+DoHomaHeader::GetOffset (void) const
+{
+  return m_offset;
+}
+
+uint32_t
+DoHomaHeader::GetLength (void) const
+{
+  return m_length;
+}
+
+std::string
+DoHomaHeader::TypeToString (PacketType type)
+{
+  switch (type)
+    {
+    case DATA:
+      return "DATA";
+    case GRANT:
+      return "GRANT";
+    case RESEND:
+      return "RESEND";
+    case ACK:
+      return "ACK";
+    }
+  return "INVALID";
+}
+
+TypeId
+DoHomaHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DoHomaHeader")
+    .SetParent<Header> ()
+    .AddConstructor<DoHomaHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+DoHomaHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+DoHomaHeader::Print (std::ostream &os) const
+{
+  os << TypeToString (GetType ()) << " " << m_sourcePort << " > " << m_destinationPort
+     << " id=" << m_messageId << " length=" << m_messageLength
+     << " offset=" << m_offset << " [" << m_length << "]"
+     << " priority=" << static_cast<uint32_t> (m_priority);
+}
+
+uint32_t
+DoHomaHeader::GetSerializedSize (void) const
+{
+  return 22;
+}
+
+void
+DoHomaHeader::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteHtonU16 (m_sourcePort);
+  i.WriteHtonU16 (m_destinationPort);
+  i.WriteU8 (m_type);
+  i.WriteU8 (m_priority);
+  i.WriteHtonU32 (m_messageId);
+  i.WriteHtonU32 (m_messageLength);
+  i.WriteHtonU32 (m_offset);
+  i.WriteHtonU32 (m_length);
+}
+
+uint32_t
+DoHomaHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_sourcePort = i.ReadNtohU16 ();
+  m_destinationPort = i.ReadNtohU16 ();
+  m_type = i.ReadU8 ();
+  m_priority = i.ReadU8 ();
+  m_messageId = i.ReadNtohU32 ();
+  m_messageLength = i.ReadNtohU32 ();
+  m_offset = i.ReadNtohU32 ();
+  m_length = i.ReadNtohU32 ();
+  return GetSerializedSize ();
+}
+
+} // namespace ns3
@@ -0,0 +1,88 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef DO_HOMA_HEADER_H
+#define DO_HOMA_HEADER_H
+
+#include <stdint.h>
+#include <string>
+#include "ns3/header.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup homa
+ * \brief Packet header for Dimension Ordered Homa packets
+ *
+ * Every packet names the message it belongs to by the message ID the
+ * sender picked, which together with the source address is unique. DATA
+ * packets carry the bytes of the message from the offset on and the
+ * offset up to which the sender may send. GRANT packets let the sender
+ * send up to the offset, RESEND packets ask for the bytes from the offset
+ * on again, and ACK packets tell the sender the whole message arrived.
+ */
+class DoHomaHeader : public Header
+{
+public:
+  typedef enum
+  {
+    DATA = 0,
+    GRANT = 1,
+    RESEND = 2,
+    ACK = 3
+  } PacketType;
+
+  DoHomaHeader ();
+  ~DoHomaHeader ();
+
+  void SetSourcePort (uint16_t port);
+  void SetDestinationPort (uint16_t port);
+  void SetType (PacketType type);
+  /**
+   * \param priority The priority the receiver asked for, higher is more
+   * urgent
+   */
+  void SetPriority (uint8_t priority);
+  void SetMessageId (uint32_t id);
+  void SetMessageLength (uint32_t length);
+  /**
+   * \param offset First byte of the data of a DATA or RESEND packet,
+   * end of the granted bytes of a GRANT packet
+   */
+  void SetOffset (uint32_t offset);
+  /**
+   * \param length Bytes granted so far for a DATA packet, bytes to send
+   * again for a RESEND packet
+   */
+  void SetLength (uint32_t length);
+
+  uint16_t GetSourcePort (void) const;
+  uint16_t GetDestinationPort (void) const;
+  PacketType GetType (void) const;
+  uint8_t GetPriority (void) const;
+  uint32_t GetMessageId (void) const;
+  uint32_t GetMessageLength (void) const;
+  uint32_t GetOffset (void) const;
+  uint32_t GetLength (void) const;
+
+  static std::string TypeToString (PacketType type);
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+private:
+  uint16_t m_sourcePort;
+  uint16_t m_destinationPort;
+  uint8_t m_type;
+  uint8_t m_priority;
+  uint32_t m_messageId;
+  uint32_t m_messageLength;
+  uint32_t m_offset;
+  uint32_t m_length;
+};
+
+} // namespace ns3
+
+#endif /* DO_HOMA_HEADER_H */
@@ -0,0 +1,639 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include <algorithm>
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "ns3/object-vector.h"
+#include "ns3/dim-ordered.h"
+#include "ns3/dim-ordered-header.h"
+
+#include "do-homa-l4-protocol.h"
+#include "do-homa-socket-factory-impl.h"
+#include "do-homa-socket.h"
+#include "dim-ordered-end-point-demux.h"
+#include "dim-ordered-end-point.h"
+
+NS_LOG_COMPONENT_DEFINE ("DoHomaL4Protocol");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (DoHomaL4Protocol);
+
+/* The number the Linux Homa module uses */
+const uint8_t DoHomaL4Protocol::PROT_NUMBER = 146;
+
+// Delivered messages remembered to acknowledge duplicates
+static const uint32_t MAX_DELIVERED_HISTORY = 4096;
+
+TypeId
+DoHomaL4Protocol::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DoHomaL4Protocol")
+    .SetParent<DimensionOrderedL4Protocol> ()
+    .AddConstructor<DoHomaL4Protocol> ()
+    .AddAttribute ("SocketList", "The list of sockets associated to this protocol.",
+                   ObjectVectorValue (),
+                   MakeObjectVectorAccessor (&DoHomaL4Protocol::m_sockets),
+                   MakeObjectVectorChecker<DoHomaSocket> ())
+    .AddAttribute ("MaxPayloadSize",
+                   "Largest number of message bytes in one packet",
+                   UintegerValue (1460),
+                   MakeUintegerAccessor (&DoHomaL4Protocol::m_maxPayloadSize),
+                   MakeUintegerChecker<uint32_t> (1, 65535 - 60))
+    .AddAttribute ("RttBytes",
+                   "Bytes sent in a round trip, sent unscheduled and kept granted ahead of the received bytes",
+                   UintegerValue (65536),
+                   MakeUintegerAccessor (&DoHomaL4Protocol::m_rttBytes),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Overcommit",
+                   "Number of inbound messages granted at the same time",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&DoHomaL4Protocol::m_overcommit),
+                   MakeUintegerChecker<uint32_t> (1, 255))
+    .AddAttribute ("ResendTimeout",
+                   "Time without progress of a message before the missing bytes are asked for again",
+                   TimeValue (MicroSeconds (50)),
+                   MakeTimeAccessor (&DoHomaL4Protocol::m_resendTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("SenderTimeout",
+                   "Time without word from the receiver before the first packet of a message is sent again",
+                   TimeValue (MicroSeconds (500)),
+                   MakeTimeAccessor (&DoHomaL4Protocol::m_senderTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxResends",
+                   "Timeouts in a row before a message is given up",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&DoHomaL4Protocol::m_maxResends),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+DoHomaL4Protocol::DoHomaL4Protocol ()
+  : m_endPoints (new DimensionOrderedEndPointDemux ()),
+    m_nextMessageId (1),
+    m_statistics ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+DoHomaL4Protocol::~DoHomaL4Protocol ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+DoHomaL4Protocol::SetNode (Ptr<Node> node)
+{
+  m_node = node;
+}
+
+/*
+ * This method is called by AddAgregate and completes the aggregation
+ * by setting the node in the Homa stack and link it to the DimensionOrdered
+ * object present in the node along with the socket factory
+ */
+void
+DoHomaL4Protocol::NotifyNewAggregate ()
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<Node> node = this->GetObject<Node> ();
+  Ptr<DimensionOrdered> dimOrdered = this->GetObject<DimensionOrdered> ();
+
+  if (m_node == 0)
+    {
+      if ((node != 0) && (dimOrdered != 0))
+        {
+          this->SetNode (node);
+          Ptr<DoHomaSocketFactoryImpl> homaFactory = CreateObject<DoHomaSocketFactoryImpl> ();
+          homaFactory->SetHoma (this);
+          node->AggregateObject (homaFactory);
+        }
+    }
+
+  if (dimOrdered != 0 && m_downTarget.IsNull())
+    {
+      dimOrdered->Insert (this);
+      this->SetDownTarget (MakeCallback (&DimensionOrdered::Send, dimOrdered));
+    }
+  Object::NotifyNewAggregate ();
+}
+
+int
+DoHomaL4Protocol::GetProtocolNumber (void) const
+{
+  return PROT_NUMBER;
+}
+
+void
+DoHomaL4Protocol::DoDispose (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  for (std::vector<Ptr<DoHomaSocket> >::iterator i = m_sockets.begin (); i != m_sockets.end (); i++)
+    {
+      *i = 0;
+    }
+  m_sockets.clear ();
+
+  for (OutboundMap::iterator it = m_outbound.begin (); it != m_outbound.end (); it++)
+    {
+      it->second.timer.Cancel ();
+    }
+  m_outbound.clear ();
+  for (InboundMap::iterator it = m_inbound.begin (); it != m_inbound.end (); it++)
+    {
+      it->second.timer.Cancel ();
+    }
+  m_inbound.clear ();
+  m_delivered.clear ();
+  m_deliveredOrder.clear ();
+
+  if (m_endPoints != 0)
+    {
+      delete m_endPoints;
+      m_endPoints = 0;
+    }
+  m_node = 0;
+  m_downTarget.Nullify ();
+  DimensionOrderedL4Protocol::DoDispose ();
+}
+
+Ptr<Socket>
+DoHomaL4Protocol::CreateSocket (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Ptr<DoHomaSocket> socket = CreateObject<DoHomaSocket> ();
+  socket->SetNode (m_node);
+  socket->SetHoma (this);
+  m_sockets.push_back (socket);
+  return socket;
+}
+
+DimensionOrderedEndPoint *
+DoHomaL4Protocol::Allocate (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return m_endPoints->Allocate ();
+}
+
+DimensionOrderedEndPoint *
+DoHomaL4Protocol::Allocate (DimensionOrderedAddress address)
+{
+  NS_LOG_FUNCTION (this << address);
+  return m_endPoints->Allocate (address);
+}
+
+DimensionOrderedEndPoint *
+DoHomaL4Protocol::Allocate (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_endPoints->Allocate (port);
+}
+
+DimensionOrderedEndPoint *
+DoHomaL4Protocol::Allocate (DimensionOrderedAddress address, uint16_t port)
+{
+  NS_LOG_FUNCTION (this << address << port);
+  return m_endPoints->Allocate (address, port);
+}
+
+void
+DoHomaL4Protocol::DeAllocate (DimensionOrderedEndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  m_endPoints->DeAllocate (endPoint);
+}
+
+uint32_t
+DoHomaL4Protocol::GetNOutbound (void) const
+{
+  return m_outbound.size ();
+}
+
+uint32_t
+DoHomaL4Protocol::GetNInbound (void) const
+{
+  return m_inbound.size ();
+}
+
+const DoHomaL4Protocol::Statistics &
+DoHomaL4Protocol::GetStatistics (void) const
+{
+  return m_statistics;
+}
+
+uint32_t
+DoHomaL4Protocol::Send (Ptr<Packet> message,
+                        DimensionOrderedAddress saddr, DimensionOrderedAddress daddr,
+                        uint16_t sport, uint16_t dport)
+{
+  NS_LOG_FUNCTION (this << message << saddr << daddr << sport << dport);
+
+  uint32_t id = m_nextMessageId++;
+  OutboundMessage &m = m_outbound[id];
+  m.message = message;
+  m.saddr = saddr;
+  m.daddr = daddr;
+  m.sport = sport;
+  m.dport = dport;
+  m.granted = std::min (message->GetSize (), m_rttBytes);
+  m.sent = 0;
+  m.priority = 0;
+  m.lastHeard = Simulator::Now ();
+  m.resends = 0;
+  m_statistics.messagesSent++;
+
+  // The unscheduled bytes go out at once
+  SendData (id, m, 0, m.granted);
+  m.timer = Simulator::Schedule (m_senderTimeout, &DoHomaL4Protocol::OutboundTimeout, this, id);
+  return id;
+}
+
+void
+DoHomaL4Protocol::SendPacket (DoHomaHeader &homaHeader, Ptr<Packet> payload,
+                              DimensionOrderedAddress saddr, DimensionOrderedAddress daddr)
+{
+  NS_LOG_FUNCTION (this << homaHeader << saddr << daddr);
+  payload->AddHeader (homaHeader);
+  m_downTarget (payload, saddr, daddr, PROT_NUMBER);
+}
+
+void
+DoHomaL4Protocol::SendData (uint32_t id, OutboundMessage &message, uint32_t offset, uint32_t end)
+{
+  NS_LOG_FUNCTION (this << id << offset << end);
+  uint32_t length = message.message->GetSize ();
+  DoHomaHeader homaHeader;
+  homaHeader.SetType (DoHomaHeader::DATA);
+  homaHeader.SetSourcePort (message.sport);
+  homaHeader.SetDestinationPort (message.dport);
+  homaHeader.SetMessageId (id);
+  homaHeader.SetMessageLength (length);
+  homaHeader.SetLength (message.granted);
+  // Unscheduled bytes go ahead of all granted ones
+  homaHeader.SetPriority (offset < std::min (length, m_rttBytes) ? m_overcommit : message.priority);
+
+  // Packets always start at multiples of the payload size, so that data
+  // sent again lines up with what the receiver has, and the last one is
+  // sent whole even if the grant ends inside it. An empty message still
+  // takes one packet
+  offset -= offset % m_maxPayloadSize;
+  do
+    {
+      uint32_t size = std::min (m_maxPayloadSize, length - offset);
+      homaHeader.SetOffset (offset);
+      SendPacket (homaHeader, message.message->CreateFragment (offset, size), message.saddr, message.daddr);
+      if (offset < message.sent)
+        {
+          m_statistics.bytesRetransmitted += size;
+        }
+      offset += size;
+    }
+  while (offset < end);
+  message.sent = std::max (message.sent, offset);
+}
+
+void
+DoHomaL4Protocol::SendControl (DoHomaHeader::PacketType type, const MessageKey &key, const InboundMessage &message,
+                               uint32_t offset, uint32_t length, uint8_t priority)
+{
+  NS_LOG_FUNCTION (this << DoHomaHeader::TypeToString (type) << key.first << key.second << offset << length);
+  DoHomaHeader homaHeader;
+  homaHeader.SetType (type);
+  homaHeader.SetSourcePort (message.dport);
+  homaHeader.SetDestinationPort (message.sport);
+  homaHeader.SetMessageId (key.second);
+  homaHeader.SetMessageLength (message.length);
+  homaHeader.SetOffset (offset);
+  homaHeader.SetLength (length);
+  homaHeader.SetPriority (priority);
+  SendPacket (homaHeader, Create<Packet> (), message.header.GetDestination (), key.first);
+}
+
+enum DimensionOrderedL4Protocol::RxStatus
+DoHomaL4Protocol::Receive (Ptr<Packet> packet,
+                           DimensionOrderedHeader const &header,
+                           Ptr<DimensionOrderedInterface> interface)
+{
+  NS_LOG_FUNCTION (this << packet << header);
+  DoHomaHeader homaHeader;
+  packet->RemoveHeader (homaHeader);
+  switch (homaHeader.GetType ())
+    {
+    case DoHomaHeader::DATA:
+      {
+        DimensionOrderedEndPointDemux::EndPoints endPoints =
+          m_endPoints->Lookup (header.GetDestination (), homaHeader.GetDestinationPort (),
+                               header.GetSource (), homaHeader.GetSourcePort (), interface);
+        if (endPoints.empty ())
+          {
+            NS_LOG_LOGIC ("RX_ENDPOINT_UNREACH");
+            return DimensionOrderedL4Protocol::RX_ENDPOINT_UNREACH;
+          }
+        ReceiveData (packet, homaHeader, header, interface);
+        break;
+      }
+    case DoHomaHeader::GRANT:
+      ReceiveGrant (homaHeader);
+      break;
+    case DoHomaHeader::RESEND:
+      ReceiveResend (homaHeader);
+      break;
+    case DoHomaHeader::ACK:
+      ReceiveAck (homaHeader);
+      break;
+    }
+  return DimensionOrderedL4Protocol::RX_OK;
+}
+
+void
+DoHomaL4Protocol::ReceiveData (Ptr<Packet> packet, const DoHomaHeader &homaHeader,
+                               const DimensionOrderedHeader &header, Ptr<DimensionOrderedInterface> interface)
+{
+  NS_LOG_FUNCTION (this << packet << homaHeader);
+  MessageKey key (header.GetSource (), homaHeader.GetMessageId ());
+  InboundMap::iterator it = m_inbound.find (key);
+  if (it == m_inbound.end ())
+    {
+      if (m_delivered.count (key))
+        {
+          // The acknowledgement got lost
+          InboundMessage done;
+          done.header = header;
+          done.sport = homaHeader.GetSourcePort ();
+          done.dport = homaHeader.GetDestinationPort ();
+          done.length = homaHeader.GetMessageLength ();
+          SendControl (DoHomaHeader::ACK, key, done, done.length, 0, 0);
+          return;
+        }
+      it = m_inbound.insert (std::make_pair (key, InboundMessage ())).first;
+      InboundMessage &m = it->second;
+      m.header = header;
+      m.interface = interface;
+      m.sport = homaHeader.GetSourcePort ();
+      m.dport = homaHeader.GetDestinationPort ();
+      m.length = homaHeader.GetMessageLength ();
+      m.received = 0;
+      m.granted = 0;
+      m.resends = 0;
+    }
+  InboundMessage &m = it->second;
+  m.lastHeard = Simulator::Now ();
+  m.resends = 0;
+  m.granted = std::max (m.granted, std::min (homaHeader.GetLength (), m.length));
+
+  if (!m.fragments.insert (std::make_pair (homaHeader.GetOffset (), packet)).second)
+    {
+      // A sender that heard nothing for a while sends its first packet
+      // again, tell it the message is still alive
+      if (homaHeader.GetOffset () == 0)
+        {
+          SendControl (DoHomaHeader::GRANT, key, m, m.granted, 0, 0);
+        }
+      return;
+    }
+  m.received += packet->GetSize ();
+  if (m.received >= m.length)
+    {
+      Deliver (it);
+    }
+  else if (!m.timer.IsRunning ())
+    {
+      m.timer = Simulator::Schedule (m_resendTimeout, &DoHomaL4Protocol::InboundTimeout, this, key);
+    }
+  ScheduleGrants ();
+}
+
+void
+DoHomaL4Protocol::Deliver (InboundMap::iterator it)
+{
+  const MessageKey &key = it->first;
+  InboundMessage &m = it->second;
+  NS_LOG_FUNCTION (this << key.first << key.second << m.length);
+
+  Ptr<Packet> message = Create<Packet> ();
+  for (std::map<uint32_t, Ptr<Packet> >::iterator f = m.fragments.begin (); f != m.fragments.end (); f++)
+    {
+      message->AddAtEnd (f->second);
+    }
+  SendControl (DoHomaHeader::ACK, key, m, m.length, 0, 0);
+  m.timer.Cancel ();
+
+  m_delivered.insert (key);
+  m_deliveredOrder.push_back (key);
+  if (m_deliveredOrder.size () > MAX_DELIVERED_HISTORY)
+    {
+      m_delivered.erase (m_deliveredOrder.front ());
+      m_deliveredOrder.pop_front ();
+    }
+
+  DimensionOrderedEndPointDemux::EndPoints endPoints =
+    m_endPoints->Lookup (m.header.GetDestination (), m.dport, m.header.GetSource (), m.sport, m.interface);
+  for (DimensionOrderedEndPointDemux::EndPointsI endPoint = endPoints.begin ();
+       endPoint != endPoints.end (); endPoint++)
+    {
+      (*endPoint)->ForwardUp (message->Copy (), m.header, m.sport, m.interface);
+    }
+  m_statistics.messagesDelivered++;
+  m_inbound.erase (it);
+}
+
+void
+DoHomaL4Protocol::ScheduleGrants (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // Shortest remaining processing time first, the older message of two
+  // as short ones
+  std::vector<GrantCandidate> candidates;
+  for (InboundMap::iterator it = m_inbound.begin (); it != m_inbound.end (); it++)
+    {
+      if (it->second.granted < it->second.length)
+        {
+          GrantCandidate candidate;
+          candidate.remaining = it->second.length - it->second.received;
+          candidate.order = candidates.size ();
+          candidate.message = it;
+          candidates.push_back (candidate);
+        }
+    }
+  uint32_t n = std::min<uint32_t> (m_overcommit, candidates.size ());
+  std::partial_sort (candidates.begin (), candidates.begin () + n, candidates.end ());
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      InboundMessage &m = candidates[i].message->second;
+      uint32_t granted = std::min (m.length, m.received + m_rttBytes);
+      // One packet at a time, or the rest of the message
+      if (granted < m.granted + std::min (m_maxPayloadSize, m.length - m.granted))
+        {
+          continue;
+        }
+      m.granted = granted;
+      SendControl (DoHomaHeader::GRANT, candidates[i].message->first, m, granted, 0, m_overcommit - 1 - i);
+      m_statistics.grants++;
+      if (!m.timer.IsRunning ())
+        {
+          m.lastHeard = Simulator::Now ();
+          m.timer = Simulator::Schedule (m_resendTimeout, &DoHomaL4Protocol::InboundTimeout, this,
+                                         candidates[i].message->first);
+        }
+    }
+}
+
+void
+DoHomaL4Protocol::ReceiveGrant (const DoHomaHeader &homaHeader)
+{
+  NS_LOG_FUNCTION (this << homaHeader);
+  OutboundMap::iterator it = m_outbound.find (homaHeader.GetMessageId ());
+  if (it == m_outbound.end ())
+    {
+      return;
+    }
+  OutboundMessage &m = it->second;
+  m.lastHeard = Simulator::Now ();
+  m.resends = 0;
+  if (homaHeader.GetOffset () > m.granted)
+    {
+      m.granted = std::min (homaHeader.GetOffset (), m.message->GetSize ());
+      m.priority = homaHeader.GetPriority ();
+      if (m.granted > m.sent)
+        {
+          SendData (it->first, m, m.sent, m.granted);
+        }
+    }
+}
+
+void
+DoHomaL4Protocol::ReceiveResend (const DoHomaHeader &homaHeader)
+{
+  NS_LOG_FUNCTION (this << homaHeader);
+  OutboundMap::iterator it = m_outbound.find (homaHeader.GetMessageId ());
+  if (it == m_outbound.end ())
+    {
+      return;
+    }
+  OutboundMessage &m = it->second;
+  m.lastHeard = Simulator::Now ();
+  m.resends = 0;
+  // Asking for bytes is granting them, the GRANT may have been lost
+  uint32_t end = std::min (homaHeader.GetOffset () + homaHeader.GetLength (), m.message->GetSize ());
+  if (end > m.granted)
+    {
+      m.granted = end;
+      m.priority = homaHeader.GetPriority ();
+    }
+  if (homaHeader.GetOffset () < end)
+    {
+      SendData (it->first, m, homaHeader.GetOffset (), end);
+    }
+}
+
+void
+DoHomaL4Protocol::ReceiveAck (const DoHomaHeader &homaHeader)
+{
+  NS_LOG_FUNCTION (this << homaHeader);
+  OutboundMap::iterator it = m_outbound.find (homaHeader.GetMessageId ());
+  if (it != m_outbound.end ())
+    {
+      it->second.timer.Cancel ();
+      m_outbound.erase (it);
+    }
+}
+
+void
+DoHomaL4Protocol::InboundTimeout (MessageKey key)
+{
+  NS_LOG_FUNCTION (this << key.first << key.second);
+  InboundMap::iterator it = m_inbound.find (key);
+  if (it == m_inbound.end ())
+    {
+      return;
+    }
+  InboundMessage &m = it->second;
+  Time due = m.lastHeard + m_resendTimeout;
+  if (Simulator::Now () < due)
+    {
+      m.timer = Simulator::Schedule (due - Simulator::Now (), &DoHomaL4Protocol::InboundTimeout, this, key);
+      return;
+    }
+  // Waiting for our own grants is no reason to complain
+  if (m.received >= m.granted)
+    {
+      return;
+    }
+  if (++m.resends > m_maxResends)
+    {
+      NS_LOG_WARN ("Giving up message " << key.second << " from " << key.first);
+      m_statistics.abandoned++;
+      m_inbound.erase (it);
+      ScheduleGrants ();
+      return;
+    }
+
+  // Ask for the first bytes missing
+  uint32_t offset = 0;
+  uint32_t end = m.granted;
+  for (std::map<uint32_t, Ptr<Packet> >::iterator f = m.fragments.begin (); f != m.fragments.end (); f++)
+    {
+      if (f->first > offset)
+        {
+          end = f->first;
+          break;
+        }
+      offset = std::max (offset, f->first + f->second->GetSize ());
+    }
+  SendControl (DoHomaHeader::RESEND, key, m, offset, std::min (end, m.granted) - offset, m_overcommit);
+  m_statistics.resends++;
+  m.lastHeard = Simulator::Now ();
+  m.timer = Simulator::Schedule (m_resendTimeout, &DoHomaL4Protocol::InboundTimeout, this, key);
+}
+
+void
+DoHomaL4Protocol::OutboundTimeout (uint32_t id)
+{
+  NS_LOG_FUNCTION (this << id);
+  OutboundMap::iterator it = m_outbound.find (id);
+  if (it == m_outbound.end ())
+    {
+      return;
+    }
+  OutboundMessage &m = it->second;
+  Time due = m.lastHeard + m_senderTimeout;
+  if (Simulator::Now () < due)
+    {
+      m.timer = Simulator::Schedule (due - Simulator::Now (), &DoHomaL4Protocol::OutboundTimeout, this, id);
+      return;
+    }
+  if (++m.resends > m_maxResends)
+    {
+      NS_LOG_WARN ("Giving up message " << id << " to " << m.daddr);
+      m_statistics.abandoned++;
+      m_outbound.erase (it);
+      return;
+    }
+
+  // The receiver may not know the message at all
+  SendData (id, m, 0, 1);
+  m.lastHeard = Simulator::Now ();
+  m.timer = Simulator::Schedule (m_senderTimeout, &DoHomaL4Protocol::OutboundTimeout, this, id);
+}
+
+void
+DoHomaL4Protocol::SetDownTarget (DimensionOrderedL4Protocol::DownTargetCallback callback)
+{
+  NS_LOG_FUNCTION (this);
+  m_downTarget = callback;
+}
+
+DimensionOrderedL4Protocol::DownTargetCallback
+DoHomaL4Protocol::GetDownTarget (void) const
+{
+  return m_downTarget;
+}
+
+} // namespace ns3
@@ -0,0 +1,207 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef DO_HOMA_L4_PROTOCOL_H
+#define DO_HOMA_L4_PROTOCOL_H
+
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <deque>
+
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/dim-ordered-address.h"
+#include "ns3/ptr.h"
+#include "ns3/dim-ordered-l4-protocol.h"
+#include "dim-ordered-interface.h"
+#include "dim-ordered-header.h"
+#include "dim-ordered-end-point.h"
+#include "dim-ordered-end-point-demux.h"
+#include "do-homa-header.h"
+
+namespace ns3 {
+
+class Socket;
+class DoHomaSocket;
+
+/**
+ * \ingroup homa
+ * \brief Implementation of the Dimension Ordered Homa protocol
+ *
+ * The protocol keeps the state of every message the node sends or
+ * receives, the sockets only hand messages in and out. A message is sent
+ * in packets of at most MaxPayloadSize bytes, the first RttBytes of them
+ * at once. Of the messages with bytes left to grant, the receiver grants
+ * the Overcommit ones with the fewest bytes left, so that RttBytes of each
+ * are on the way. A receiver that hears nothing of a message it expects
+ * data for within ResendTimeout asks for the first missing bytes again.
+ * The receiver knows what is missing, the sender only steps in when the
+ * receiver may not know the message at all: it sends the first packet
+ * again when it hears nothing for SenderTimeout, which is much longer
+ * than a queueing delay. Both give up after MaxResends tries.
+ */
+class DoHomaL4Protocol : public DimensionOrderedL4Protocol {
+public:
+  static TypeId GetTypeId (void);
+  static const uint8_t PROT_NUMBER;
+
+  struct Statistics
+  {
+    uint64_t messagesSent;        // messages handed to the protocol
+    uint64_t messagesDelivered;   // whole messages passed up to a socket
+    uint64_t grants;              // GRANT packets sent
+    uint64_t resends;             // RESEND packets sent
+    uint64_t bytesRetransmitted;  // payload bytes sent again
+    uint64_t abandoned;           // messages given up after MaxResends
+  };
+
+  DoHomaL4Protocol ();
+  virtual ~DoHomaL4Protocol ();
+
+  void SetNode (Ptr<Node> node);
+
+  virtual int GetProtocolNumber (void) const;
+
+  /**
+   * \return A smart Socket pointer to a DoHomaSocket, allocated by this
+   * instance of the Homa protocol
+   */
+  Ptr<Socket> CreateSocket (void);
+
+  DimensionOrderedEndPoint *Allocate (void);
+  DimensionOrderedEndPoint *Allocate (DimensionOrderedAddress address);
+  DimensionOrderedEndPoint *Allocate (uint16_t port);
+  DimensionOrderedEndPoint *Allocate (DimensionOrderedAddress address, uint16_t port);
+
+  void DeAllocate (DimensionOrderedEndPoint *endPoint);
+
+  /**
+   * \brief Send a message via Homa
+   * \param message The message to send
+   * \param saddr The source DimensionOrderedAddress
+   * \param daddr The destination DimensionOrderedAddress
+   * \param sport The source port number
+   * \param dport The destination port number
+   * \return The ID of the message
+   */
+  uint32_t Send (Ptr<Packet> message,
+                 DimensionOrderedAddress saddr, DimensionOrderedAddress daddr,
+                 uint16_t sport, uint16_t dport);
+
+  // inherited from DimensionOrderedL4Protocol
+  virtual enum DimensionOrderedL4Protocol::RxStatus Receive (Ptr<Packet> p,
+                                                             DimensionOrderedHeader const &header,
+                                                             Ptr<DimensionOrderedInterface> interface);
+
+  // From DimensionOrderedL4Protocol
+  virtual void SetDownTarget (DimensionOrderedL4Protocol::DownTargetCallback cb);
+  // From DimensionOrderedL4Protocol
+  virtual DimensionOrderedL4Protocol::DownTargetCallback GetDownTarget (void) const;
+
+  /**
+   * \return The number of messages being sent and being received
+   */
+  uint32_t GetNOutbound (void) const;
+  uint32_t GetNInbound (void) const;
+
+  const Statistics &GetStatistics (void) const;
+
+protected:
+  virtual void DoDispose (void);
+  /*
+   * This function will notify other components connected to the node that a new stack member is now connected
+   * This will be used to notify Layer 3 protocol of layer 4 protocol stack to connect them together.
+   */
+  virtual void NotifyNewAggregate ();
+private:
+  // A message this node sends, by message ID
+  struct OutboundMessage
+  {
+    Ptr<Packet> message;
+    DimensionOrderedAddress saddr;
+    DimensionOrderedAddress daddr;
+    uint16_t sport;
+    uint16_t dport;
+    uint32_t granted;         // bytes the receiver lets us send
+    uint32_t sent;            // bytes sent at least once, whole packets
+    uint8_t priority;         // of the last grant
+    Time lastHeard;           // of the receiver, or the first send
+    uint32_t resends;         // timeouts since then
+    EventId timer;
+  };
+  // A message this node receives, by source address and message ID
+  typedef std::pair<DimensionOrderedAddress, uint32_t> MessageKey;
+  struct InboundMessage
+  {
+    DimensionOrderedHeader header;
+    Ptr<DimensionOrderedInterface> interface;
+    uint16_t sport;
+    uint16_t dport;
+    uint32_t length;
+    uint32_t received;        // bytes received
+    uint32_t granted;         // bytes the sender may send
+    std::map<uint32_t, Ptr<Packet> > fragments; // by offset
+    Time lastHeard;           // of the sender, or the last resend request
+    uint32_t resends;         // timeouts since then
+    EventId timer;
+  };
+  typedef std::map<uint32_t, OutboundMessage> OutboundMap;
+  typedef std::map<MessageKey, InboundMessage> InboundMap;
+  // An inbound message with bytes left to grant
+  struct GrantCandidate
+  {
+    uint32_t remaining;
+    uint32_t order;
+    InboundMap::iterator message;
+    bool operator < (const GrantCandidate &o) const
+    {
+      return remaining < o.remaining || (remaining == o.remaining && order < o.order);
+    }
+  };
+
+  void SendPacket (DoHomaHeader &homaHeader, Ptr<Packet> payload,
+                   DimensionOrderedAddress saddr, DimensionOrderedAddress daddr);
+  // Send the packets of an outbound message holding bytes [offset, end)
+  void SendData (uint32_t id, OutboundMessage &message, uint32_t offset, uint32_t end);
+  // Tell the sender of an inbound message about it
+  void SendControl (DoHomaHeader::PacketType type, const MessageKey &key, const InboundMessage &message,
+                    uint32_t offset, uint32_t length, uint8_t priority);
+  void ReceiveData (Ptr<Packet> packet, const DoHomaHeader &homaHeader,
+                    const DimensionOrderedHeader &header, Ptr<DimensionOrderedInterface> interface);
+  void ReceiveGrant (const DoHomaHeader &homaHeader);
+  void ReceiveResend (const DoHomaHeader &homaHeader);
+  void ReceiveAck (const DoHomaHeader &homaHeader);
+  // Pass a whole message up and forget it
+  void Deliver (InboundMap::iterator it);
+  // Grant the inbound messages with the fewest bytes left
+  void ScheduleGrants (void);
+  void InboundTimeout (MessageKey key);
+  void OutboundTimeout (uint32_t id);
+
+  Ptr<Node> m_node;
+  DimensionOrderedEndPointDemux *m_endPoints;
+  DoHomaL4Protocol (const DoHomaL4Protocol &o);
+  DoHomaL4Protocol &operator = (const DoHomaL4Protocol &o);
+  std::vector<Ptr<DoHomaSocket> > m_sockets;
+  DimensionOrderedL4Protocol::DownTargetCallback m_downTarget;
+
+  uint32_t m_nextMessageId;
+  OutboundMap m_outbound;
+  InboundMap m_inbound;
+  // Recently delivered messages, to acknowledge their duplicates again
+  std::set<MessageKey> m_delivered;
+  std::deque<MessageKey> m_deliveredOrder;
+  Statistics m_statistics;
+
+  // Attributes
+  uint32_t m_maxPayloadSize;
+  uint32_t m_rttBytes;
+  uint32_t m_overcommit;
+  Time m_resendTimeout;
+  Time m_senderTimeout;
+  uint32_t m_maxResends;
+};
+
+} // namespace ns3
+
+#endif /* DO_HOMA_L4_PROTOCOL_H */
@@ -0,0 +1,37 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "do-homa-socket-factory-impl.h"
+#include "do-homa-l4-protocol.h"
+#include "ns3/socket.h"
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+DoHomaSocketFactoryImpl::DoHomaSocketFactoryImpl ()
+  : m_homa (0)
+{
+}
+DoHomaSocketFactoryImpl::~DoHomaSocketFactoryImpl ()
+{
+  NS_ASSERT (m_homa == 0);
+}
+
+void
+DoHomaSocketFactoryImpl::SetHoma (Ptr<DoHomaL4Protocol> homa)
+{
+  m_homa = homa;
+}
+
+Ptr<Socket>
+DoHomaSocketFactoryImpl::CreateSocket (void)
+{
+  return m_homa->CreateSocket ();
+}
+
+void
+DoHomaSocketFactoryImpl::DoDispose (void)
+{
+  m_homa = 0;
+  DoHomaSocketFactory::DoDispose ();
+}
+
+} // namespace ns3
@@ -0,0 +1,58 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef DO_HOMA_SOCKET_FACTORY_IMPL_H
+#define DO_HOMA_SOCKET_FACTORY_IMPL_H
+
+#include "ns3/do-homa-socket-factory.h"
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class DoHomaL4Protocol;
+
+/**
+ * \ingroup switchless
+ * \defgroup homa Homa
+ *
+ * This is a receiver-driven message transport after Homa (Montazeri et
+ * al., SIGCOMM 2018). There are no connections: a socket sends every
+ * message on its own, with an ID picked by the sending node. The first
+ * round trip worth of bytes of a message goes out right away, the rest
+ * only as the receiver grants it. The receiver grants the messages with
+ * the fewest bytes left first, asks for missing data again when a message
+ * makes no progress, and acknowledges the whole message.
+ */
+
+/**
+ * \ingroup homa
+ * \brief Object to create Dimension Ordered Homa socket instances
+ * \internal
+ *
+ * This class implements the API for creating Dimension Ordered Homa
+ * sockets. It is a socket factory (deriving from class SocketFactory).
+ */
+class DoHomaSocketFactoryImpl : public DoHomaSocketFactory
+{
+public:
+  DoHomaSocketFactoryImpl ();
+  virtual ~DoHomaSocketFactoryImpl ();
+
+  void SetHoma (Ptr<DoHomaL4Protocol> homa);
+
+  /**
+   * \brief Implements a method to create a Homa socket and return
+   * a base class smart pointer to the socket.
+   * \internal
+   *
+   * \return smart pointer to Socket
+   */
+  virtual Ptr<Socket> CreateSocket (void);
+
+protected:
+  virtual void DoDispose (void);
+private:
+  Ptr<DoHomaL4Protocol> m_homa;
+};
+
+} // namespace ns3
+
+#endif /* DO_HOMA_SOCKET_FACTORY_IMPL_H */
@@ -0,0 +1,16 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "do-homa-socket-factory.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (DoHomaSocketFactory);
+
+TypeId DoHomaSocketFactory::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DoHomaSocketFactory")
+    .SetParent<SocketFactory> ()
+  ;
+  return tid;
+}
+
+} // namespace ns3
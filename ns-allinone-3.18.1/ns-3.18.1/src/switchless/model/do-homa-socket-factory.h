@@ -0,0 +1,28 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef DO_HOMA_SOCKET_FACTORY_H
+#define DO_HOMA_SOCKET_FACTORY_H
+
+#include "ns3/socket-factory.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup socket
+ *
+ * \brief API to create Dimension Ordered Homa socket instances
+ *
+ * This abstract class defines the API for the Dimension Ordered Homa
+ * socket factory.
+ *
+ * \see DoHomaSocketFactoryImpl
+ */
+class DoHomaSocketFactory : public SocketFactory
+{
+public:
+  static TypeId GetTypeId (void);
+
+};
+
+} // namespace ns3
+
+#endif /* DO_HOMA_SOCKET_FACTORY_H */
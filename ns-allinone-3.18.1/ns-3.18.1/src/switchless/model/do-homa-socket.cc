@@ -0,0 +1,427 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/uinteger.h"
+#include "ns3/dim-ordered-socket-address.h"
+#include "ns3/dim-ordered.h"
+#include "ns3/dim-ordered-header.h"
+#include "ns3/trace-source-accessor.h"
+#include "do-homa-socket.h"
+#include "dim-ordered-end-point.h"
+
+NS_LOG_COMPONENT_DEFINE ("DoHomaSocket");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (DoHomaSocket);
+
+// The message length field of the header has 32 bits, the messages are
+// kept whole until acknowledged
+static const uint32_t MAX_DO_HOMA_MESSAGE_SIZE = 0x7fffffff;
+
+TypeId
+DoHomaSocket::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DoHomaSocket")
+    .SetParent<Socket> ()
+    .AddConstructor<DoHomaSocket> ()
+    .AddAttribute ("RcvBufSize",
+                   "DoHomaSocket maximum receive buffer size (bytes)",
+                   UintegerValue (4194304),
+                   MakeUintegerAccessor (&DoHomaSocket::m_rcvBufSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("Drop", "Drop Homa message due to receive buffer overflow",
+                     MakeTraceSourceAccessor (&DoHomaSocket::m_dropTrace))
+  ;
+  return tid;
+}
+
+DoHomaSocket::DoHomaSocket ()
+  : m_endPoint (0),
+    m_node (0),
+    m_homa (0),
+    m_defaultPort (0),
+    m_errno (ERROR_NOTERROR),
+    m_shutdownSend (false),
+    m_shutdownRecv (false),
+    m_connected (false),
+    m_rxAvailable (0)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+DoHomaSocket::~DoHomaSocket ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  m_node = 0;
+  // DeAllocate deletes the endpoint, which calls Destroy and zeroes
+  // m_endPoint
+  if (m_endPoint != 0)
+    {
+      NS_ASSERT (m_homa != 0);
+      m_homa->DeAllocate (m_endPoint);
+      NS_ASSERT (m_endPoint == 0);
+    }
+  m_homa = 0;
+}
+
+void
+DoHomaSocket::SetNode (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_node = node;
+}
+
+void
+DoHomaSocket::SetHoma (Ptr<DoHomaL4Protocol> homa)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_homa = homa;
+}
+
+enum Socket::SocketErrno
+DoHomaSocket::GetErrno (void) const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return m_errno;
+}
+
+enum Socket::SocketType
+DoHomaSocket::GetSocketType (void) const
+{
+  return NS3_SOCK_SEQPACKET;
+}
+
+Ptr<Node>
+DoHomaSocket::GetNode (void) const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return m_node;
+}
+
+void
+DoHomaSocket::Destroy (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_endPoint = 0;
+}
+
+int
+DoHomaSocket::FinishBind (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  if (m_endPoint == 0)
+    {
+      m_errno = ERROR_ADDRINUSE;
+      return -1;
+    }
+  m_endPoint->SetRxCallback (MakeCallback (&DoHomaSocket::ForwardUp, Ptr<DoHomaSocket> (this)));
+  m_endPoint->SetDestroyCallback (MakeCallback (&DoHomaSocket::Destroy, Ptr<DoHomaSocket> (this)));
+  return 0;
+}
+
+int
+DoHomaSocket::Bind (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_endPoint = m_homa->Allocate ();
+  return FinishBind ();
+}
+
+int
+DoHomaSocket::Bind6 (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return -1;
+}
+
+int
+DoHomaSocket::Bind (const Address &address)
+{
+  NS_LOG_FUNCTION (this << address);
+
+  if (!DimensionOrderedSocketAddress::IsMatchingType (address))
+    {
+      NS_LOG_ERROR ("Not IsMatchingType");
+      m_errno = ERROR_INVAL;
+      return -1;
+    }
+  DimensionOrderedSocketAddress transport = DimensionOrderedSocketAddress::ConvertFrom (address);
+  DimensionOrderedAddress dimOrdered = transport.GetDimensionOrderedAddress ();
+  uint16_t port = transport.GetPort ();
+  if (dimOrdered == DimensionOrderedAddress::GetAny () && port == 0)
+    {
+      m_endPoint = m_homa->Allocate ();
+    }
+  else if (dimOrdered == DimensionOrderedAddress::GetAny ())
+    {
+      m_endPoint = m_homa->Allocate (port);
+    }
+  else if (port == 0)
+    {
+      m_endPoint = m_homa->Allocate (dimOrdered);
+    }
+  else
+    {
+      m_endPoint = m_homa->Allocate (dimOrdered, port);
+    }
+  return FinishBind ();
+}
+
+int
+DoHomaSocket::ShutdownSend (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_shutdownSend = true;
+  return 0;
+}
+
+int
+DoHomaSocket::ShutdownRecv (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_shutdownRecv = true;
+  return 0;
+}
+
+int
+DoHomaSocket::Close (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  if (m_shutdownRecv == true && m_shutdownSend == true)
+    {
+      m_errno = Socket::ERROR_BADF;
+      return -1;
+    }
+  m_shutdownRecv = true;
+  m_shutdownSend = true;
+  return 0;
+}
+
+int
+DoHomaSocket::Connect (const Address & address)
+{
+  NS_LOG_FUNCTION (this << address);
+  if (!DimensionOrderedSocketAddress::IsMatchingType (address))
+    {
+      m_errno = ERROR_INVAL;
+      return -1;
+    }
+  // Only sets the default destination, there is no connection
+  DimensionOrderedSocketAddress transport = DimensionOrderedSocketAddress::ConvertFrom (address);
+  m_defaultAddress = transport.GetDimensionOrderedAddress ();
+  m_defaultPort = transport.GetPort ();
+  m_connected = true;
+  NotifyConnectionSucceeded ();
+  return 0;
+}
+
+int
+DoHomaSocket::Listen (void)
+{
+  m_errno = Socket::ERROR_OPNOTSUPP;
+  return -1;
+}
+
+int
+DoHomaSocket::Send (Ptr<Packet> p, uint32_t flags)
+{
+  NS_LOG_FUNCTION (this << p << flags);
+
+  if (!m_connected)
+    {
+      m_errno = ERROR_NOTCONN;
+      return -1;
+    }
+  return DoSendTo (p, m_defaultAddress, m_defaultPort);
+}
+
+int
+DoHomaSocket::SendTo (Ptr<Packet> p, uint32_t flags, const Address &address)
+{
+  NS_LOG_FUNCTION (this << p << flags << address);
+  if (!DimensionOrderedSocketAddress::IsMatchingType (address))
+    {
+      m_errno = ERROR_AFNOSUPPORT;
+      return -1;
+    }
+  DimensionOrderedSocketAddress transport = DimensionOrderedSocketAddress::ConvertFrom (address);
+  return DoSendTo (p, transport.GetDimensionOrderedAddress (), transport.GetPort ());
+}
+
+int
+DoHomaSocket::DoSendTo (Ptr<Packet> p, DimensionOrderedAddress dest, uint16_t port)
+{
+  NS_LOG_FUNCTION (this << p << dest << port);
+  if (m_endPoint == 0)
+    {
+      if (Bind () == -1)
+        {
+          NS_ASSERT (m_endPoint == 0);
+          return -1;
+        }
+      NS_ASSERT (m_endPoint != 0);
+    }
+  if (m_shutdownSend)
+    {
+      m_errno = ERROR_SHUTDOWN;
+      return -1;
+    }
+  if (p->GetSize () > GetTxAvailable ())
+    {
+      m_errno = ERROR_MSGSIZE;
+      return -1;
+    }
+  if (dest.IsBroadcast ())
+    {
+      m_errno = ERROR_OPNOTSUPP;
+      return -1;
+    }
+
+  DimensionOrderedAddress src = m_endPoint->GetLocalAddress ();
+  if (src == DimensionOrderedAddress::GetAny ())
+    {
+      // Get the address for this node
+      Ptr<DimensionOrdered> dimOrdered = m_node->GetObject<DimensionOrdered> ();
+      src = dimOrdered->GetAddress (DimensionOrdered::X_POS).GetLocal ();
+      if (src == DimensionOrderedAddress::GetZero ())
+          src = dimOrdered->GetAddress (DimensionOrdered::X_NEG).GetLocal ();
+      if (src == DimensionOrderedAddress::GetZero ())
+          src = dimOrdered->GetAddress (DimensionOrdered::Y_POS).GetLocal ();
+      if (src == DimensionOrderedAddress::GetZero ())
+          src = dimOrdered->GetAddress (DimensionOrdered::Y_NEG).GetLocal ();
+      if (src == DimensionOrderedAddress::GetZero ())
+          src = dimOrdered->GetAddress (DimensionOrdered::Z_POS).GetLocal ();
+      if (src == DimensionOrderedAddress::GetZero ())
+          src = dimOrdered->GetAddress (DimensionOrdered::Z_NEG).GetLocal ();
+      NS_ASSERT (src != DimensionOrderedAddress::GetZero ());
+    }
+
+  // The protocol keeps the message until the receiver acknowledges it
+  m_homa->Send (p->Copy (), src, dest, m_endPoint->GetLocalPort (), port);
+  NotifyDataSent (p->GetSize ());
+  return p->GetSize ();
+}
+
+uint32_t
+DoHomaSocket::GetTxAvailable (void) const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return MAX_DO_HOMA_MESSAGE_SIZE;
+}
+
+uint32_t
+DoHomaSocket::GetRxAvailable (void) const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return m_rxAvailable;
+}
+
+Ptr<Packet>
+DoHomaSocket::Recv (uint32_t maxSize, uint32_t flags)
+{
+  NS_LOG_FUNCTION (this << maxSize << flags);
+  if (m_deliveryQueue.empty ())
+    {
+      m_errno = ERROR_AGAIN;
+      return 0;
+    }
+  Ptr<Packet> p = m_deliveryQueue.front ();
+  if (p->GetSize () > maxSize)
+    {
+      return 0;
+    }
+  m_deliveryQueue.pop ();
+  m_rxAvailable -= p->GetSize ();
+  return p;
+}
+
+Ptr<Packet>
+DoHomaSocket::RecvFrom (uint32_t maxSize, uint32_t flags,
+                        Address &fromAddress)
+{
+  NS_LOG_FUNCTION (this << maxSize << flags);
+  Ptr<Packet> packet = Recv (maxSize, flags);
+  if (packet != 0)
+    {
+      SocketAddressTag tag;
+      bool found;
+      found = packet->PeekPacketTag (tag);
+      NS_ASSERT (found);
+      fromAddress = tag.GetAddress ();
+    }
+  return packet;
+}
+
+int
+DoHomaSocket::GetSockName (Address &address) const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  if (m_endPoint != 0)
+    {
+      address = DimensionOrderedSocketAddress (m_endPoint->GetLocalAddress (), m_endPoint->GetLocalPort ());
+    }
+  return 0;
+}
+
+void
+DoHomaSocket::BindToNetDevice (Ptr<NetDevice> netdevice)
+{
+  NS_LOG_FUNCTION (netdevice);
+  Socket::BindToNetDevice (netdevice); // Includes sanity check
+  if (m_endPoint == 0)
+    {
+      if (Bind () == -1)
+        {
+          NS_ASSERT (m_endPoint == 0);
+          return;
+        }
+      NS_ASSERT (m_endPoint != 0);
+    }
+  m_endPoint->BindToNetDevice (netdevice);
+}
+
+bool
+DoHomaSocket::SetAllowBroadcast (bool allowBroadcast)
+{
+  return !allowBroadcast;
+}
+
+bool
+DoHomaSocket::GetAllowBroadcast () const
+{
+  return false;
+}
+
+void
+DoHomaSocket::ForwardUp (Ptr<Packet> packet, DimensionOrderedHeader header, uint16_t port,
+                         Ptr<DimensionOrderedInterface> incomingInterface)
+{
+  NS_LOG_FUNCTION (this << packet << header << port);
+
+  if (m_shutdownRecv)
+    {
+      return;
+    }
+
+  if ((m_rxAvailable + packet->GetSize ()) <= m_rcvBufSize)
+    {
+      Address address = DimensionOrderedSocketAddress (header.GetSource (), port);
+      SocketAddressTag tag;
+      tag.SetAddress (address);
+      packet->AddPacketTag (tag);
+      m_deliveryQueue.push (packet);
+      m_rxAvailable += packet->GetSize ();
+      NotifyDataRecv ();
+    }
+  else
+    {
+      // The message was acknowledged already, the application is too slow
+      NS_LOG_WARN ("No receive buffer space available.  Drop.");
+      m_dropTrace (packet);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,90 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef DO_HOMA_SOCKET_H
+#define DO_HOMA_SOCKET_H
+
+#include <stdint.h>
+#include <queue>
+#include "ns3/callback.h"
+#include "ns3/traced-callback.h"
+#include "ns3/socket.h"
+#include "ns3/ptr.h"
+#include "ns3/dim-ordered-address.h"
+#include "ns3/dim-ordered-interface.h"
+#include "ns3/do-homa-l4-protocol.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup homa
+ * \brief A sockets interface to Dimension Ordered Homa
+ *
+ * Every Send or SendTo is one message, and every Recv returns one whole
+ * message. The socket holds no state per peer, a single bound socket can
+ * send to and receive from all other nodes.
+ */
+class DoHomaSocket : public Socket
+{
+public:
+  static TypeId GetTypeId (void);
+  /**
+   * Create an unbound Homa socket.
+   */
+  DoHomaSocket ();
+  virtual ~DoHomaSocket ();
+
+  void SetNode (Ptr<Node> node);
+  void SetHoma (Ptr<DoHomaL4Protocol> homa);
+
+  virtual enum SocketErrno GetErrno (void) const;
+  virtual enum SocketType GetSocketType (void) const;
+  virtual Ptr<Node> GetNode (void) const;
+  virtual int Bind (void);
+  virtual int Bind6 (void);
+  virtual int Bind (const Address &address);
+  virtual int Close (void);
+  virtual int ShutdownSend (void);
+  virtual int ShutdownRecv (void);
+  virtual int Connect (const Address &address);
+  virtual int Listen (void);
+  virtual uint32_t GetTxAvailable (void) const;
+  virtual int Send (Ptr<Packet> p, uint32_t flags);
+  virtual int SendTo (Ptr<Packet> p, uint32_t flags, const Address &address);
+  virtual uint32_t GetRxAvailable (void) const;
+  virtual Ptr<Packet> Recv (uint32_t maxSize, uint32_t flags);
+  virtual Ptr<Packet> RecvFrom (uint32_t maxSize, uint32_t flags,
+                                Address &fromAddress);
+  virtual int GetSockName (Address &address) const;
+  virtual void BindToNetDevice (Ptr<NetDevice> netdevice);
+  virtual bool SetAllowBroadcast (bool allowBroadcast);
+  virtual bool GetAllowBroadcast () const;
+
+private:
+  // invoked by DoHomaL4Protocol
+  int FinishBind (void);
+  void ForwardUp (Ptr<Packet> p, DimensionOrderedHeader header, uint16_t port,
+                  Ptr<DimensionOrderedInterface> incomingInterface);
+  void Destroy (void);
+  int DoSendTo (Ptr<Packet> p, DimensionOrderedAddress daddr, uint16_t dport);
+
+  DimensionOrderedEndPoint *m_endPoint;
+  Ptr<Node> m_node;
+  Ptr<DoHomaL4Protocol> m_homa;
+  DimensionOrderedAddress m_defaultAddress;
+  uint16_t m_defaultPort;
+  TracedCallback<Ptr<const Packet> > m_dropTrace;
+
+  enum SocketErrno m_errno;
+  bool m_shutdownSend;
+  bool m_shutdownRecv;
+  bool m_connected;
+
+  std::queue<Ptr<Packet> > m_deliveryQueue;
+  uint32_t m_rxAvailable;
+
+  // Socket attributes
+  uint32_t m_rcvBufSize;
+};
+
+} // namespace ns3
+
+#endif /* DO_HOMA_SOCKET_H */
@@ -0,0 +1,90 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "do-rtt-estimator.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("DoRttEstimator");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (DoRttMeanDeviation);
+
+TypeId
+DoRttMeanDeviation::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DoRttMeanDeviation")
+    .SetParent<RttEstimator> ()
+    .AddConstructor<DoRttMeanDeviation> ()
+    .AddAttribute ("Gain",
+                   "Gain used in estimating the RTT, must be 0 < Gain < 1",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&DoRttMeanDeviation::m_gain),
+                   MakeDoubleChecker<double> (0, 1))
+  ;
+  return tid;
+}
+
+DoRttMeanDeviation::DoRttMeanDeviation ()
+  : m_variance (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+DoRttMeanDeviation::DoRttMeanDeviation (const DoRttMeanDeviation& c)
+  : RttEstimator (c),
+    m_gain (c.m_gain),
+    m_variance (c.m_variance)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+DoRttMeanDeviation::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+DoRttMeanDeviation::Measurement (Time m)
+{
+  NS_LOG_FUNCTION (this << m);
+  if (m_nSamples)
+    {
+      Time err = m - m_currentEstimatedRtt;
+      m_currentEstimatedRtt += Time::FromDouble (err.ToDouble (Time::NS) * m_gain, Time::NS);
+      Time difference = Abs (err) - m_variance;
+      m_variance += Time::FromDouble (difference.ToDouble (Time::NS) * m_gain, Time::NS);
+    }
+  else
+    { // First sample, as in RttMeanDeviation
+      m_currentEstimatedRtt = m;
+      m_variance = m;
+    }
+  m_nSamples++;
+}
+
+Time
+DoRttMeanDeviation::RetransmitTimeout ()
+{
+  Time rto = Max (m_currentEstimatedRtt + Time (4 * m_variance.GetTimeStep ()), m_minRto);
+  NS_LOG_DEBUG ("RetransmitTimeout: est " << m_currentEstimatedRtt << " var " << m_variance <<
+                " multiplier " << m_multiplier << " rto " << rto);
+  return Time (rto.GetTimeStep () * m_multiplier);
+}
+
+Ptr<RttEstimator>
+DoRttMeanDeviation::Copy () const
+{
+  NS_LOG_FUNCTION (this);
+  return CopyObject<DoRttMeanDeviation> (this);
+}
+
+void
+DoRttMeanDeviation::Reset ()
+{
+  NS_LOG_FUNCTION (this);
+  m_variance = Seconds (0);
+  RttEstimator::Reset ();
+}
+
+} // namespace ns3
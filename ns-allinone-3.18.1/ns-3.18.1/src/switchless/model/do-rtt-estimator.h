@@ -0,0 +1,45 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef DO_RTT_ESTIMATOR_H
+#define DO_RTT_ESTIMATOR_H
+
+#include "ns3/rtt-estimator.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Mean-deviation RTT estimator with the RTO in full time resolution
+ *
+ * The same Jacobson/Karels estimator as RttMeanDeviation, but
+ * RttMeanDeviation rounds the estimate, the deviation and the MinRTO
+ * attribute down to whole milliseconds before it computes the RTO, so any
+ * RTT in the fabric counts as zero and a MinRTO below 1 ms gives an RTO of
+ * zero. This estimator keeps them in nanoseconds, which makes a
+ * microsecond MinRTO usable.
+ */
+class DoRttMeanDeviation : public RttEstimator
+{
+public:
+  static TypeId GetTypeId (void);
+
+  DoRttMeanDeviation ();
+  DoRttMeanDeviation (const DoRttMeanDeviation& c);
+
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Measurement (Time measure);
+  /**
+   * \return max (srtt + 4 * rttvar, MinRTO) times the backoff multiplier
+   */
+  virtual Time RetransmitTimeout ();
+  virtual Ptr<RttEstimator> Copy () const;
+  virtual void Reset ();
+
+private:
+  double m_gain;     //< Filter gain
+  Time   m_variance; //< Current mean deviation
+};
+
+} // namespace ns3
+
+#endif /* DO_RTT_ESTIMATOR_H */
@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#define NS_LOG_APPEND_CONTEXT \
+  if (m_node) { std::clog << Simulator::Now ().GetSeconds () << " [node " << m_node->GetId () << "] "; }
+
+#include "do-tcp-dctcp.h"
+#include "ns3/log.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/node.h"
+
+NS_LOG_COMPONENT_DEFINE ("DoTcpDctcp");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (DoTcpDctcp);
+
+TypeId
+DoTcpDctcp::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DoTcpDctcp")
+    .SetParent<DoTcpNewReno> ()
+    .AddConstructor<DoTcpDctcp> ()
+    .AddAttribute ("Gain", "Weight of the fraction of bytes marked in the last window in alpha",
+                   DoubleValue (1.0 / 16),
+                   MakeDoubleAccessor (&DoTcpDctcp::m_gain),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("InitialAlpha", "Estimate of the fraction of bytes marked before the first window",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&DoTcpDctcp::m_alpha),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddTraceSource ("Alpha",
+                     "Estimate of the fraction of bytes marked",
+                     MakeTraceSourceAccessor (&DoTcpDctcp::m_alpha))
+  ;
+  return tid;
+}
+
+DoTcpDctcp::DoTcpDctcp (void)
+  : m_alpha (1.0), // mute valgrind, actual value set by the attribute system
+    m_gain (1.0 / 16),
+    m_ackedBytes (0),
+    m_markedBytes (0),
+    m_windowEnd (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+DoTcpDctcp::DoTcpDctcp (const DoTcpDctcp& sock)
+  : DoTcpNewReno (sock),
+    m_alpha (sock.m_alpha),
+    m_gain (sock.m_gain),
+    m_ackedBytes (0),
+    m_markedBytes (0),
+    m_windowEnd (sock.m_windowEnd)
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_LOGIC ("Invoked the copy constructor");
+}
+
+DoTcpDctcp::~DoTcpDctcp (void)
+{
+}
+
+Ptr<DoTcpSocketBase>
+DoTcpDctcp::Fork (void)
+{
+  return CopyObject<DoTcpDctcp> (this);
+}
+
+/** Count the bytes acknowledged with and without ECN-Echo, and react to it (RFC8257 sec.3.3) */
+void
+DoTcpDctcp::EcnEcho (const DoTcpHeader& t)
+{
+  NS_LOG_FUNCTION (this << t);
+  bool ece = t.GetFlags () & DoTcpHeader::ECE;
+  uint32_t acked = t.GetAckNumber () - m_txBuffer.HeadSequence ();
+  m_ackedBytes += acked;
+  if (ece)
+    {
+      m_markedBytes += acked;
+    }
+
+  if (t.GetAckNumber () > m_windowEnd)
+    { // A window of data is acknowledged: fold its fraction of marked bytes into alpha
+      if (m_ackedBytes > 0)
+        {
+          double marked = static_cast<double> (m_markedBytes) / m_ackedBytes;
+          m_alpha = (1 - m_gain) * m_alpha.Get () + m_gain * marked;
+        }
+      m_ackedBytes = 0;
+      m_markedBytes = 0;
+      m_windowEnd = m_highTxMark;
+      NS_LOG_LOGIC ("DCTCP alpha " << m_alpha << " until seqnum " << m_windowEnd);
+    }
+
+  if (ece && !m_inFastRec && t.GetAckNumber () > m_ecnRecover)
+    { // Once per window, cut cwnd by the extent of the congestion instead of halving it
+      uint32_t cwnd = static_cast<uint32_t> (m_cWnd.Get () * (1 - m_alpha.Get () / 2));
+      m_ssThresh = std::max (2 * m_segmentSize, cwnd);
+      m_cWnd = m_ssThresh;
+      m_ecnRecover = m_highTxMark;
+      m_cwrPending = true;
+      NS_LOG_INFO ("ECN-Echo with alpha " << m_alpha << ". Reset cwnd to " << m_cWnd);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,48 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef DO_TCP_DCTCP_H
+#define DO_TCP_DCTCP_H
+
+#include "do-tcp-newreno.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup socket
+ * \ingroup tcp
+ *
+ * \brief An implementation of a stream socket using TCP.
+ *
+ * This class contains the DCTCP congestion control of \RFC{8257} on top of
+ * DoTcpNewReno. The sender keeps a moving average of the fraction of its
+ * bytes that were marked with congestion experienced on their way, and on
+ * ECN-Echo cuts cwnd in proportion to it instead of halving it. Losses are
+ * handled as in DoTcpNewReno. It needs the Ecn attribute of the sockets and
+ * queues that mark at a low threshold, see the EcnMarkingThreshold attribute
+ * of DimensionOrderedL3Protocol.
+ */
+class DoTcpDctcp : public DoTcpNewReno
+{
+public:
+  static TypeId GetTypeId (void);
+  /**
+   * Create an unbound tcp socket.
+   */
+  DoTcpDctcp (void);
+  DoTcpDctcp (const DoTcpDctcp& sock);
+  virtual ~DoTcpDctcp (void);
+
+protected:
+  virtual Ptr<DoTcpSocketBase> Fork (void); // Call CopyObject<DoTcpDctcp> to clone me
+  virtual void EcnEcho (const DoTcpHeader& t); // Update alpha every window, cut cwnd by alpha / 2 on ECN-Echo
+
+private:
+  TracedValue<double> m_alpha;       //< Estimate of the fraction of bytes marked
+  double              m_gain;        //< Weight of the last window in alpha
+  uint32_t            m_ackedBytes;  //< Bytes acknowledged in this window
+  uint32_t            m_markedBytes; //< Of which with ECN-Echo
+  SequenceNumber32    m_windowEnd;   //< The window ends when the ACKs pass it
+};
+
+} // namespace ns3
+
+#endif /* DO_TCP_DCTCP_H */
@@ -9,6 +9,12 @@ namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED (DoTcpHeader);
 
+// TCP option kinds
+static const uint8_t OPTION_END = 0;
+static const uint8_t OPTION_NOP = 1;
+static const uint8_t OPTION_SACK_PERMITTED = 4;
+static const uint8_t OPTION_SACK = 5;
+
 DoTcpHeader::DoTcpHeader ()
   : m_sourcePort (0),
     m_destinationPort (0),
@@ -18,6 +24,7 @@ DoTcpHeader::DoTcpHeader ()
     m_flags (0),
     m_windowSize (0xffff),
     m_urgentPointer (0),
+    m_sackPermitted (false),
     m_calcChecksum (false),
     m_goodChecksum (true)
 {
@@ -66,6 +73,20 @@ void DoTcpHeader::SetUrgentPointer (uint16_t urgentPointer)
   m_urgentPointer = urgentPointer;
 }
 
+void DoTcpHeader::SetSackPermitted (bool permitted)
+{
+  m_sackPermitted = permitted;
+  UpdateLength ();
+}
+void DoTcpHeader::AddSackBlock (SequenceNumber32 start, SequenceNumber32 end)
+{
+  if (m_sackBlocks.size () < MAX_SACK_BLOCKS)
+    {
+      m_sackBlocks.push_back (SackBlock (start, end));
+      UpdateLength ();
+    }
+}
+
 uint16_t DoTcpHeader::GetSourcePort () const
 {
   return m_sourcePort;
@@ -98,6 +119,25 @@ uint16_t DoTcpHeader::GetUrgentPointer () const
 {
   return m_urgentPointer;
 }
+bool DoTcpHeader::GetSackPermitted (void) const
+{
+  return m_sackPermitted;
+}
+const DoTcpHeader::SackList& DoTcpHeader::GetSackBlocks (void) const
+{
+  return m_sackBlocks;
+}
+
+void
+DoTcpHeader::UpdateLength (void)
+{
+  uint32_t optionBytes = m_sackPermitted ? 2 : 0;
+  if (!m_sackBlocks.empty ())
+    {
+      optionBytes += 2 + 8 * m_sackBlocks.size ();
+    }
+  m_length = 5 + (optionBytes + 3) / 4;
+}
 
 void 
 DoTcpHeader::InitializeChecksum (DimensionOrderedAddress source, 
@@ -144,7 +184,7 @@ DoTcpHeader::CalculateHeaderChecksum (uint16_t size) const
       it.WriteU8 (m_protocol); /* protocol */
       it.WriteU8 (size >> 8); /* length */
       it.WriteU8 (size & 0xff); /* length */
-      hdrSize = 12;
+      hdrSize = m_source.GetLength () + m_destination.GetLength () + 4;
     }
 
   it = buf.Begin ();
@@ -213,6 +253,14 @@ void DoTcpHeader::Print (std::ostream &os)  const
       os<<"]";
     }
   os<<" Seq="<<m_sequenceNumber<<" Ack="<<m_ackNumber<<" Win="<<m_windowSize;
+  if (m_sackPermitted)
+    {
+      os<<" SackOK";
+    }
+  for (SackList::const_iterator it = m_sackBlocks.begin (); it != m_sackBlocks.end (); ++it)
+    {
+      os<<" Sack="<<it->first<<"-"<<it->second;
+    }
 }
 uint32_t DoTcpHeader::GetSerializedSize (void)  const
 {
@@ -230,6 +278,30 @@ void DoTcpHeader::Serialize (Buffer::Iterator start)  const
   i.WriteHtonU16 (0);
   i.WriteHtonU16 (m_urgentPointer);
 
+  // Options, padded with NOPs to the header length
+  uint32_t optionBytes = 4 * m_length - 20;
+  if (m_sackPermitted)
+    {
+      i.WriteU8 (OPTION_SACK_PERMITTED);
+      i.WriteU8 (2);
+      optionBytes -= 2;
+    }
+  if (!m_sackBlocks.empty ())
+    {
+      i.WriteU8 (OPTION_SACK);
+      i.WriteU8 (2 + 8 * m_sackBlocks.size ());
+      for (SackList::const_iterator it = m_sackBlocks.begin (); it != m_sackBlocks.end (); ++it)
+        {
+          i.WriteHtonU32 (it->first.GetValue ());
+          i.WriteHtonU32 (it->second.GetValue ());
+        }
+      optionBytes -= 2 + 8 * m_sackBlocks.size ();
+    }
+  for (; optionBytes > 0; optionBytes--)
+    {
+      i.WriteU8 (OPTION_NOP);
+    }
+
   if(m_calcChecksum)
     {
       uint16_t headerChecksum = CalculateHeaderChecksum (start.GetSize ());
@@ -249,12 +321,54 @@ uint32_t DoTcpHeader::Deserialize (Buffer::Iterator start)
   m_sequenceNumber = i.ReadNtohU32 ();
   m_ackNumber = i.ReadNtohU32 ();
   uint16_t field = i.ReadNtohU16 ();
-  m_flags = field & 0x3F;
+  m_flags = field & 0xFF; // With the ECE and CWR bits of RFC3168
   m_length = field>>12;
   m_windowSize = i.ReadNtohU16 ();
   i.Next (2);
   m_urgentPointer = i.ReadNtohU16 ();
 
+  m_sackPermitted = false;
+  m_sackBlocks.clear ();
+  uint32_t optionBytes = m_length > 5 ? 4 * m_length - 20 : 0;
+  while (optionBytes > 0)
+    {
+      uint8_t kind = i.ReadU8 ();
+      optionBytes--;
+      if (kind == OPTION_END)
+        {
+          break;
+        }
+      if (kind == OPTION_NOP || optionBytes == 0)
+        {
+          continue;
+        }
+      uint8_t length = i.ReadU8 ();
+      optionBytes--;
+      if (length < 2 || length - 2u > optionBytes)
+        {
+          break; // Malformed, ignore the rest
+        }
+      uint32_t remaining = length - 2;
+      if (kind == OPTION_SACK_PERMITTED)
+        {
+          m_sackPermitted = true;
+        }
+      else if (kind == OPTION_SACK)
+        {
+          for (; remaining >= 8; remaining -= 8)
+            {
+              SequenceNumber32 start (i.ReadNtohU32 ());
+              SequenceNumber32 end (i.ReadNtohU32 ());
+              if (m_sackBlocks.size () < MAX_SACK_BLOCKS)
+                {
+                  m_sackBlocks.push_back (SackBlock (start, end));
+                }
+            }
+        }
+      i.Next (remaining);
+      optionBytes -= length - 2;
+    }
+
   if(m_calcChecksum)
     {
       uint16_t headerChecksum = CalculateHeaderChecksum (start.GetSize ());
@@ -3,6 +3,7 @@
 #define DO_TCP_HEADER_H
 
 #include <stdint.h>
+#include <vector>
 #include "ns3/header.h"
 #include "ns3/buffer.h"
 #include "ns3/do-tcp-socket-factory.h"
@@ -122,6 +123,34 @@ public:
   typedef enum { NONE = 0, FIN = 1, SYN = 2, RST = 4, PSH = 8, ACK = 16, 
                  URG = 32, ECE = 64, CWR = 128} Flags_t;
 
+  /// Received data [first, second) reported by a SACK option (RFC 2018)
+  typedef std::pair<SequenceNumber32, SequenceNumber32> SackBlock;
+  typedef std::vector<SackBlock> SackList;
+
+  /// Most SACK blocks that fit in the 40 bytes of TCP options
+  static const uint32_t MAX_SACK_BLOCKS = 4;
+
+  /**
+   * \param permitted whether to carry the SACK-permitted option, only
+   *        meaningful on a SYN
+   */
+  void SetSackPermitted (bool permitted);
+  /**
+   * \return whether the SACK-permitted option is present
+   */
+  bool GetSackPermitted (void) const;
+  /**
+   * \brief Report the received data [start, end) in the SACK option
+   *
+   * Blocks beyond MAX_SACK_BLOCKS are ignored. The header length follows
+   * the options.
+   */
+  void AddSackBlock (SequenceNumber32 start, SequenceNumber32 end);
+  /**
+   * \return the blocks of the SACK option, in the order they were added
+   */
+  const SackList& GetSackBlocks (void) const;
+
   static TypeId GetTypeId (void);
   virtual TypeId GetInstanceTypeId (void) const;
   virtual void Print (std::ostream &os) const;
@@ -137,14 +166,18 @@ public:
 
 private:
   uint16_t CalculateHeaderChecksum (uint16_t size) const;
+  // Set m_length from the options
+  void UpdateLength (void);
   uint16_t m_sourcePort;
   uint16_t m_destinationPort;
   SequenceNumber32 m_sequenceNumber;
   SequenceNumber32 m_ackNumber;
   uint8_t m_length; // really a uint4_t
-  uint8_t m_flags;      // really a uint6_t
+  uint8_t m_flags;      // the six RFC793 flags, ECE and CWR
   uint16_t m_windowSize;
   uint16_t m_urgentPointer;
+  bool m_sackPermitted;
+  SackList m_sackBlocks;
 
   Address m_source;
   Address m_destination;
@@ -18,6 +18,7 @@
 #include "do-tcp-socket-factory-impl.h"
 #include "do-tcp-newreno.h"
 #include "ns3/rtt-estimator.h"
+#include "do-rtt-estimator.h"
 
 #include <vector>
 #include <sstream>
@@ -46,7 +47,7 @@ DoTcpL4Protocol::GetTypeId (void)
     .AddConstructor<DoTcpL4Protocol> ()
     .AddAttribute ("RttEstimatorType",
                    "Type of RttEstimator objects.",
-                   TypeIdValue (RttMeanDeviation::GetTypeId ()),
+                   TypeIdValue (DoRttMeanDeviation::GetTypeId ()),
                    MakeTypeIdAccessor (&DoTcpL4Protocol::m_rttTypeId),
                    MakeTypeIdChecker ())
     .AddAttribute ("SocketType",
@@ -321,8 +322,7 @@ DoTcpL4Protocol::SendPacket (Ptr<Packet> packet, const DoTcpHeader &outgoing,
   NS_LOG_FUNCTION (this << packet << saddr << daddr << oif);
   // XXX outgoingHeader cannot be logged
 
-  DoTcpHeader outgoingHeader = outgoing;
-  outgoingHeader.SetLength (5); //header length in units of 32bit words
+  DoTcpHeader outgoingHeader = outgoing; // Its length follows its options
   /** \todo UrgentPointer */
   /* outgoingHeader.SetUrgentPointer (0); */
   if(Node::ChecksumEnabled ())
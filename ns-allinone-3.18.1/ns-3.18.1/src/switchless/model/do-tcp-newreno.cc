@@ -39,7 +39,8 @@ DoTcpNewReno::GetTypeId (void)
 DoTcpNewReno::DoTcpNewReno (void)
   : m_retxThresh (3), // mute valgrind, actual value set by the attribute system
     m_inFastRec (false),
-    m_limitedTx (false) // mute valgrind, actual value set by the attribute system
+    m_limitedTx (false), // mute valgrind, actual value set by the attribute system
+    m_ecnRecover (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -51,7 +52,8 @@ DoTcpNewReno::DoTcpNewReno (const DoTcpNewReno& sock)
     m_initialCWnd (sock.m_initialCWnd),
     m_retxThresh (sock.m_retxThresh),
     m_inFastRec (false),
-    m_limitedTx (sock.m_limitedTx)
+    m_limitedTx (sock.m_limitedTx),
+    m_ecnRecover (sock.m_ecnRecover)
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_LOGIC ("Invoked the copy constructor");
@@ -103,7 +105,13 @@ DoTcpNewReno::NewAck (const SequenceNumber32& seq)
                 " ssthresh " << m_ssThresh);
 
   // Check for exit condition of fast recovery
-  if (m_inFastRec && seq < m_recover)
+  if (m_inFastRec && seq < m_recover && m_sackOk)
+    { // Partial ACK with SACK: cwnd stays, the scoreboard tells what to resend (RFC6675 sec.5 step C)
+      DoTcpSocketBase::NewAck (seq);
+      SendSackRecoveryData (m_cWnd, m_retxThresh);
+      return;
+    }
+  else if (m_inFastRec && seq < m_recover)
     { // Partial ACK, partial window deflation (RFC2582 sec.3 bullet #5 paragraph 3)
       m_cWnd -= seq - m_txBuffer.HeadSequence ();
       m_cWnd += m_segmentSize;  // increase cwnd
@@ -119,10 +127,12 @@ DoTcpNewReno::NewAck (const SequenceNumber32& seq)
       NS_LOG_INFO ("Received full ACK. Leaving fast recovery with cwnd set to " << m_cWnd);
     }
 
-  // Increase of cwnd based on current phase (slow start or congestion avoidance)
+  // Increase of cwnd based on current phase (slow start or congestion avoidance),
+  // as for every ACK the segments of an offloaded packet would have drawn
+  uint32_t acks = OffloadedAcks (seq - m_txBuffer.HeadSequence ());
   if (m_cWnd < m_ssThresh)
     { // Slow start mode, add one segSize to cWnd. Default m_ssThresh is 65535. (RFC2001, sec.1)
-      m_cWnd += m_segmentSize;
+      m_cWnd += m_segmentSize * acks;
       NS_LOG_INFO ("In SlowStart, updated to cwnd " << m_cWnd << " ssthresh " << m_ssThresh);
     }
   else
@@ -130,7 +140,7 @@ DoTcpNewReno::NewAck (const SequenceNumber32& seq)
       // To increase cwnd for one segSize per RTT, it should be (ackBytes*segSize)/cwnd
       double adder = static_cast<double> (m_segmentSize * m_segmentSize) / m_cWnd.Get ();
       adder = std::max (1.0, adder);
-      m_cWnd += static_cast<uint32_t> (adder);
+      m_cWnd += static_cast<uint32_t> (adder) * acks;
       NS_LOG_INFO ("In CongAvoid, updated to cwnd " << m_cWnd << " ssthresh " << m_ssThresh);
     }
 
@@ -143,7 +153,25 @@ void
 DoTcpNewReno::DupAck (const DoTcpHeader& t, uint32_t count)
 {
   NS_LOG_FUNCTION (this << count);
-  if (count == m_retxThresh && !m_inFastRec)
+  if (m_sackOk && !m_inFastRec
+      && (count == m_retxThresh || LostBoundary (m_retxThresh) > m_txBuffer.HeadSequence ()))
+    { // Enough dupacks or SACKed data to call the head lost: SACK recovery (RFC6675 sec.5 step 4)
+      SequenceNumber32 head = m_txBuffer.HeadSequence ();
+      m_ssThresh = std::max (2 * m_segmentSize, BytesInFlight () / 2);
+      m_cWnd = m_ssThresh;
+      m_recover = m_highTxMark;
+      m_inFastRec = true;
+      NS_LOG_INFO ("SACK loss recovery. Reset cwnd to " << m_cWnd << " until seqnum " << m_recover);
+      uint32_t hole = m_scoreboard.empty () ? m_segmentSize
+        : std::min<uint32_t> (m_segmentSize, m_scoreboard.front ().first - head);
+      m_highRxt = head + SequenceNumber32 (SendDataPacket (head, hole, true));
+      SendSackRecoveryData (m_cWnd, m_retxThresh);
+    }
+  else if (m_sackOk && m_inFastRec)
+    { // Every dupack shrinks the pipe instead of inflating cwnd
+      SendSackRecoveryData (m_cWnd, m_retxThresh);
+    }
+  else if (count == m_retxThresh && !m_inFastRec)
     { // triple duplicate ack triggers fast retransmit (RFC2582 sec.3 bullet #1)
       m_ssThresh = std::max (2 * m_segmentSize, BytesInFlight () / 2);
       m_cWnd = m_ssThresh + 3 * m_segmentSize;
@@ -192,6 +220,22 @@ DoTcpNewReno::Retransmit (void)
   DoRetransmit ();                          // Retransmit the packet
 }
 
+/** Cut cwnd like for a loss, but without retransmitting, at most once per window of data (RFC3168 sec.6.1.2) */
+void
+DoTcpNewReno::EcnEcho (const DoTcpHeader& t)
+{
+  NS_LOG_FUNCTION (this << t);
+  if (!(t.GetFlags () & DoTcpHeader::ECE) || m_inFastRec || t.GetAckNumber () <= m_ecnRecover)
+    {
+      return;
+    }
+  m_ssThresh = std::max (2 * m_segmentSize, BytesInFlight () / 2);
+  m_cWnd = m_ssThresh;
+  m_ecnRecover = m_highTxMark;
+  m_cwrPending = true;
+  NS_LOG_INFO ("ECN-Echo. Reset cwnd to " << m_cWnd << " until seqnum " << m_ecnRecover);
+}
+
 void
 DoTcpNewReno::SetSegSize (uint32_t size)
 {
@@ -35,6 +35,7 @@ protected:
   virtual void NewAck (SequenceNumber32 const& seq); // Inc cwnd and call NewAck() of parent
   virtual void DupAck (const DoTcpHeader& t, uint32_t count);  // Halving cwnd and reset nextTxSequence
   virtual void Retransmit (void); // Exit fast recovery upon retransmit timeout
+  virtual void EcnEcho (const DoTcpHeader& t); // Halve cwnd once per window on ECN-Echo
 
   // Implementing ns3::DoTcpSocket -- Attribute get/set
   virtual void     SetSegSize (uint32_t size);
@@ -53,6 +54,7 @@ protected:
   uint32_t               m_retxThresh;   //< Fast Retransmit threshold
   bool                   m_inFastRec;    //< currently in fast recovery
   bool                   m_limitedTx;    //< perform limited transmit
+  SequenceNumber32       m_ecnRecover;   //< Highest Tx seqnum at the last reduction for ECN-Echo
 };
 
 } // namespace ns3
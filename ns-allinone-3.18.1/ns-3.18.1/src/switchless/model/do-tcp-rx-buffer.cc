@@ -1,4 +1,7 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include <algorithm>
+#include <cstring>
+
 #include "ns3/packet.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
@@ -29,7 +32,8 @@ DoTcpRxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 DoTcpRxBuffer::DoTcpRxBuffer (uint32_t n)
-  : m_nextRxSeq (n), m_gotFin (false), m_size (0), m_maxBuffer (32768), m_availBytes (0)
+  : m_nextRxSeq (n), m_gotFin (false), m_size (0), m_maxBuffer (32768), m_availBytes (0),
+    m_headSeq (n), m_head (0)
 {
 }
 
@@ -47,6 +51,10 @@ void
 DoTcpRxBuffer::SetNextRxSequence (const SequenceNumber32& s)
 {
   m_nextRxSeq = s;
+  if (m_size == 0)
+    {
+      m_headSeq = s;
+    }
 }
 
 uint32_t
@@ -81,6 +89,7 @@ DoTcpRxBuffer::IncNextRxSequence ()
   // this is supposed to be called only during the three-way handshake
   NS_ASSERT (m_size == 0);
   m_nextRxSeq++;
+  m_headSeq = m_nextRxSeq;
 }
 
 // Return the lowest sequence number that this DoTcpRxBuffer cannot accept
@@ -91,11 +100,8 @@ DoTcpRxBuffer::MaxRxSequence (void) const
     { // No data allowed beyond FIN
       return m_finSeq;
     }
-  else if (m_data.size ())
-    { // No data allowed beyond Rx window allowed
-      return m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
-    }
-  return m_nextRxSeq + SequenceNumber32 (m_maxBuffer);
+  // No data allowed beyond Rx window allowed
+  return m_headSeq + SequenceNumber32 (m_maxBuffer);
 }
 
 void
@@ -114,6 +120,31 @@ DoTcpRxBuffer::Finished (void)
   return (m_gotFin && m_finSeq < m_nextRxSeq);
 }
 
+void
+DoTcpRxBuffer::Reserve (uint32_t n)
+{
+  if (n <= m_data.size ())
+    {
+      return;
+    }
+  uint32_t capacity = std::max<uint32_t> (n, 2 * m_data.size ());
+  NS_LOG_LOGIC ("Growing ring from " << m_data.size () << " to " << capacity << " bytes");
+  std::vector<uint8_t> data (capacity);
+  std::copy (m_data.begin () + m_head, m_data.end (), data.begin ());
+  std::copy (m_data.begin (), m_data.begin () + m_head, data.begin () + (m_data.size () - m_head));
+  m_data.swap (data);
+  m_head = 0;
+}
+
+void
+DoTcpRxBuffer::Release (void)
+{
+  NS_LOG_LOGIC ("Releasing ring of " << m_data.size () << " bytes");
+  std::vector<uint8_t> ().swap (m_data);
+  std::vector<uint8_t> ().swap (m_scratch);
+  m_head = 0;
+}
+
 bool
 DoTcpRxBuffer::Add (Ptr<Packet> p, DoTcpHeader const& tcph)
 {
@@ -127,67 +158,68 @@ DoTcpRxBuffer::Add (Ptr<Packet> p, DoTcpHeader const& tcph)
 
   // Trim packet to fit Rx window specification
   if (headSeq < m_nextRxSeq) headSeq = m_nextRxSeq;
-  if (m_data.size ())
+  SequenceNumber32 maxSeq = m_headSeq + SequenceNumber32 (m_maxBuffer);
+  if (maxSeq < tailSeq) tailSeq = maxSeq;
+  if (headSeq >= tailSeq)
     {
-      SequenceNumber32 maxSeq = m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
-      if (maxSeq < tailSeq) tailSeq = maxSeq;
-      if (tailSeq < headSeq) headSeq = tailSeq;
+      NS_LOG_LOGIC ("Nothing to buffer");
+      return false; // Nothing to buffer anyway
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end () && i->first <= tailSeq)
+
+  // Intervals overlapping or touching the new data, [first, last)
+  std::vector<Interval>::iterator first = m_intervals.begin ();
+  while (first != m_intervals.end () && first->end < headSeq)
     {
-      SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      if (lastByteSeq > headSeq)
+      ++first;
+    }
+  std::vector<Interval>::iterator last = first;
+  uint32_t duplicate = 0;
+  Interval merged = { headSeq, tailSeq };
+  for (; last != m_intervals.end () && last->start <= tailSeq; ++last)
+    {
+      SequenceNumber32 overlapStart = std::max (last->start, headSeq);
+      SequenceNumber32 overlapEnd = std::min (last->end, tailSeq);
+      if (overlapStart < overlapEnd)
         {
-          if (i->first > headSeq && lastByteSeq < tailSeq)
-            { // Rare case: Existing packet is embedded fully in the new packet
-              m_size -= i->second->GetSize ();
-              m_data.erase (i++);
-              continue;
-            }
-          if (i->first <= headSeq)
-            { // Incoming head is overlapped
-              headSeq = lastByteSeq;
-            }
-          if (lastByteSeq >= tailSeq)
-            { // Incoming tail is overlapped
-              tailSeq = i->first;
-            }
+          duplicate += overlapEnd - overlapStart;
         }
-      ++i;
+      merged.start = std::min (merged.start, last->start);
+      merged.end = std::max (merged.end, last->end);
     }
-  // We now know how much we are going to store, trim the packet
-  if (headSeq >= tailSeq)
+  uint32_t length = tailSeq - headSeq;
+  if (duplicate == length)
     {
       NS_LOG_LOGIC ("Nothing to buffer");
-      return false; // Nothing to buffer anyway
+      return false; // All of it is buffered already
+    }
+
+  // Copy the data into the ring, rewriting bytes that are already there
+  Reserve (tailSeq - m_headSeq);
+  uint32_t offset = headSeq - tcph.GetSequenceNumber ();
+  uint32_t start = (m_head + (headSeq - m_headSeq)) % m_data.size ();
+  if (offset == 0 && start + length <= m_data.size ())
+    {
+      p->CopyData (&m_data[start], length);
     }
   else
     {
-      uint32_t start = headSeq - tcph.GetSequenceNumber ();
-      uint32_t length = tailSeq - headSeq;
-      p = p->CreateFragment (start, length);
-      NS_ASSERT (length == p->GetSize ());
+      m_scratch.resize (offset + length);
+      p->CopyData (&m_scratch[0], offset + length);
+      uint32_t firstPart = std::min (length, static_cast<uint32_t> (m_data.size ()) - start);
+      std::memcpy (&m_data[start], &m_scratch[offset], firstPart);
+      std::memcpy (&m_data[0], &m_scratch[offset + firstPart], length - firstPart);
     }
-  // Insert packet into buffer
-  NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
-  m_data [ headSeq ] = p;
-  NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
+  first = m_intervals.erase (first, last);
+  m_intervals.insert (first, merged);
+  NS_LOG_LOGIC ("Buffered data of seqno=" << headSeq << " len=" << length);
+
   // Update variables
-  m_size += p->GetSize ();      // Occupancy
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  m_size += length - duplicate;      // Occupancy
+  Interval& head = m_intervals.front ();
+  if (head.start <= m_nextRxSeq && m_nextRxSeq < head.end)
     {
-      if (i->first < m_nextRxSeq)
-        {
-          continue;
-        }
-      else if (i->first > m_nextRxSeq)
-        {
-          break;
-        };
-      m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      m_availBytes += i->second->GetSize ();
+      m_availBytes += head.end - m_nextRxSeq.Get ();
+      m_nextRxSeq = head.end;
     }
   NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
   if (m_gotFin && m_nextRxSeq == m_finSeq)
@@ -205,41 +237,66 @@ DoTcpRxBuffer::Extract (uint32_t maxSize)
   uint32_t extractSize = std::min (maxSize, m_availBytes);
   NS_LOG_LOGIC ("Requested to extract " << extractSize << " bytes from DoTcpRxBuffer of size=" << m_size);
   if (extractSize == 0) return 0;  // No contiguous block to return
-  NS_ASSERT (m_data.size ()); // At least we have something to extract
-  Ptr<Packet> outPkt = Create<Packet> (); // The packet that contains all the data to return
-  BufIterator i;
-  while (extractSize)
-    { // Check the buffered data for delivery
-      i = m_data.begin ();
-      NS_ASSERT (i->first <= m_nextRxSeq); // in-sequence data expected
-      // Check if we send the whole pkt or just a partial
-      uint32_t pktSize = i->second->GetSize ();
-      if (pktSize <= extractSize)
-        { // Whole packet is extracted
-          outPkt->AddAtEnd (i->second);
-          m_data.erase (i);
-          m_size -= pktSize;
-          m_availBytes -= pktSize;
-          extractSize -= pktSize;
-        }
-      else
-        { // Partial is extracted and done
-          outPkt->AddAtEnd (i->second->CreateFragment (0, extractSize));
-          m_data[i->first + SequenceNumber32 (extractSize)] = i->second->CreateFragment (extractSize, pktSize - extractSize);
-          m_data.erase (i);
-          m_size -= extractSize;
-          m_availBytes -= extractSize;
-          extractSize = 0;
-        }
+  NS_ASSERT (m_intervals.size () && m_intervals.front ().start == m_headSeq); // in-sequence data expected
+
+  // Copy the data out of the ring in one packet
+  Ptr<Packet> outPkt;
+  if (m_head + extractSize <= m_data.size ())
+    {
+      outPkt = Create<Packet> (&m_data[m_head], extractSize);
     }
-  if (outPkt->GetSize () == 0)
+  else
+    {
+      uint32_t firstPart = m_data.size () - m_head;
+      m_scratch.resize (extractSize);
+      std::memcpy (&m_scratch[0], &m_data[m_head], firstPart);
+      std::memcpy (&m_scratch[firstPart], &m_data[0], extractSize - firstPart);
+      outPkt = Create<Packet> (&m_scratch[0], extractSize);
+    }
+  m_head = (m_head + extractSize) % m_data.size ();
+  m_headSeq += extractSize;
+  m_size -= extractSize;
+  m_availBytes -= extractSize;
+  m_intervals.front ().start = m_headSeq;
+  if (m_intervals.front ().start == m_intervals.front ().end)
     {
-      NS_LOG_LOGIC ("Nothing extracted.");
-      return 0;
+      m_intervals.erase (m_intervals.begin ());
+    }
+  if (m_size == 0)
+    {
+      Release ();
     }
   NS_LOG_LOGIC ("Extracted " << outPkt->GetSize ( ) << " bytes, bufsize=" << m_size
-                             << ", num pkts in buffer=" << m_data.size ());
+                             << ", num intervals in buffer=" << m_intervals.size ());
   return outPkt;
 }
 
+void
+DoTcpRxBuffer::AddSackBlocks (DoTcpHeader& tcph, SequenceNumber32 recent) const
+{
+  std::vector<Interval>::const_iterator it = m_intervals.begin ();
+  // The interval at the head, if any, is acknowledged cumulatively
+  if (it != m_intervals.end () && it->start <= m_nextRxSeq)
+    {
+      ++it;
+    }
+  std::vector<Interval>::const_iterator first = m_intervals.end ();
+  for (std::vector<Interval>::const_iterator i = it; i != m_intervals.end (); ++i)
+    {
+      if (i->start <= recent && recent < i->end)
+        {
+          first = i;
+          tcph.AddSackBlock (i->start, i->end);
+          break;
+        }
+    }
+  for (; it != m_intervals.end () && tcph.GetSackBlocks ().size () < DoTcpHeader::MAX_SACK_BLOCKS; ++it)
+    {
+      if (it != first)
+        {
+          tcph.AddSackBlock (it->start, it->end);
+        }
+    }
+}
+
 } //namepsace ns3
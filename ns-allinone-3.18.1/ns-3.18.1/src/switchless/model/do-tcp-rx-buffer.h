@@ -2,7 +2,7 @@
 #ifndef DO_TCP_RX_BUFFER_H
 #define DO_TCP_RX_BUFFER_H
 
-#include <map>
+#include <vector>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/sequence-number.h"
@@ -17,6 +17,11 @@ class Packet;
  *
  * \brief class for the reordering buffer that keeps the data from lower layer, i.e.
  *        DoTcpL4Protocol, sent to the application
+ *
+ * The bytes are copied into a ring that starts at the first byte the
+ * application has not read yet, and a short sorted vector of disjoint
+ * sequence intervals records which parts of it have arrived. The ring is
+ * released whenever the application has read everything.
  */
 class DoTcpRxBuffer : public Object
 {
@@ -53,16 +58,38 @@ public:
    * The extracted data is going to be forwarded to the application.
    */
   Ptr<Packet> Extract (uint32_t maxSize);
-public:
-  typedef std::map<SequenceNumber32, Ptr<Packet> >::iterator BufIterator;
+
+  /**
+   * Report the data received out of order in the SACK option of an ACK.
+   * The block holding the sequence number recent, the last one received,
+   * goes first and the others follow in order (RFC 2018 sec.4).
+   */
+  void AddSackBlocks (DoTcpHeader& tcph, SequenceNumber32 recent) const;
+private:
+  // Received bytes [start, end)
+  struct Interval
+  {
+    SequenceNumber32 start;
+    SequenceNumber32 end;
+  };
+
+  // Make room for this many bytes from the head, keeping them in place
+  // relative to it
+  void Reserve (uint32_t n);
+  // Free the ring of an empty buffer, so idle connections keep no memory
+  void Release (void);
+
   TracedValue<SequenceNumber32> m_nextRxSeq; //< Seqnum of the first missing byte in data (RCV.NXT)
   SequenceNumber32 m_finSeq;                 //< Seqnum of the FIN packet
   bool m_gotFin;                             //< Did I received FIN packet?
   uint32_t m_size;                           //< Number of total data bytes in the buffer, not necessarily contiguous
   uint32_t m_maxBuffer;                      //< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //< Number of bytes available to read, i.e. contiguous block at head
-  std::map<SequenceNumber32, Ptr<Packet> > m_data;
-  //< Corresponding data (may be null)
+  SequenceNumber32 m_headSeq;                //< Seqnum of the first byte not extracted yet
+  std::vector<uint8_t> m_data;               //< Ring of the data bytes from m_headSeq
+  uint32_t m_head;                           //< Offset of m_headSeq in the ring
+  std::vector<Interval> m_intervals;         //< Received data, sorted, disjoint and not adjacent
+  std::vector<uint8_t> m_scratch;            //< Data wrapping around the end of the ring
 };
 
 } //namepsace ns3
@@ -14,7 +14,9 @@
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "ns3/trace-source-accessor.h"
+#include "ns3/segmentation-offload-tag.h"
 #include "do-tcp-socket-base.h"
 #include "do-tcp-l4-protocol.h"
 #include "dim-ordered-end-point.h"
@@ -48,6 +50,22 @@ DoTcpSocketBase::GetTypeId (void)
                    UintegerValue (65535),
                    MakeUintegerAccessor (&DoTcpSocketBase::m_maxWinSize),
                    MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("Sack", "Offer and use selective acknowledgements (RFC2018)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DoTcpSocketBase::m_sackEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Ecn", "Offer and use explicit congestion notification (RFC3168), "
+                   "which DoTcpNewReno and DoTcpDctcp react to",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DoTcpSocketBase::m_ecnEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("SegmentationOffload",
+                   "Experimental: largest super-segment in bytes handed to DimensionOrderedL3Protocol at once; "
+                   "the devices send it as segments of SegmentSize. Without window scaling the window, and so "
+                   "the super-segments, stay below 64 KB. 0 sends every segment on its own",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&DoTcpSocketBase::m_offloadSize),
+                   MakeUintegerChecker<uint32_t> (0, 65535 - 60))
     .AddTraceSource ("RTO",
                      "Retransmission timeout",
                      MakeTraceSourceAccessor (&DoTcpSocketBase::m_rto))
@@ -91,7 +109,14 @@ DoTcpSocketBase::DoTcpSocketBase (void)
     m_connected (false),
     m_segmentSize (0),
     // For attribute initialization consistency (quiet valgrind)
-    m_rWnd (0)
+    m_rWnd (0),
+    m_offloadSize (0),
+    m_sackEnabled (false),
+    m_sackOk (false),
+    m_ecnEnabled (false),
+    m_ecnOk (false),
+    m_ceState (false),
+    m_cwrPending (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -125,7 +150,14 @@ DoTcpSocketBase::DoTcpSocketBase (const DoTcpSocketBase& sock)
     m_msl (sock.m_msl),
     m_segmentSize (sock.m_segmentSize),
     m_maxWinSize (sock.m_maxWinSize),
-    m_rWnd (sock.m_rWnd)
+    m_rWnd (sock.m_rWnd),
+    m_offloadSize (sock.m_offloadSize),
+    m_sackEnabled (sock.m_sackEnabled),
+    m_sackOk (sock.m_sackOk),
+    m_ecnEnabled (sock.m_ecnEnabled),
+    m_ecnOk (sock.m_ecnOk),
+    m_ceState (false),
+    m_cwrPending (false)
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_LOGIC ("Invoked the copy constructor");
@@ -703,6 +735,7 @@ DoTcpSocketBase::DoForwardUp (Ptr<Packet> packet, DimensionOrderedHeader header,
       EstimateRtt (tcpHeader);
     }
   ReadOptions (tcpHeader);
+  ReadEcn (packet, header, tcpHeader);
 
   // Update Rx window size, i.e. the flow control window
   if (m_rWnd.Get () == 0 && tcpHeader.GetWindowSize () != 0)
@@ -740,11 +773,16 @@ DoTcpSocketBase::DoForwardUp (Ptr<Packet> packet, DimensionOrderedHeader header,
       ProcessListen (packet, tcpHeader, fromAddress, toAddress);
       break;
     case TIME_WAIT:
-      // Do nothing
+      // Only a retransmitted FIN can arrive, our ACK of it was lost: ACK it
+      // again (RFC793, p.73)
+      if (tcpHeader.GetFlags () & DoTcpHeader::FIN)
+        {
+          SendEmptyPacket (DoTcpHeader::ACK);
+        }
       break;
     case CLOSED:
       // Send RST if the incoming packet is not a RST
-      if ((tcpHeader.GetFlags () & ~(DoTcpHeader::PSH | DoTcpHeader::URG)) != DoTcpHeader::RST)
+      if ((tcpHeader.GetFlags () & ~(DoTcpHeader::PSH | DoTcpHeader::URG | DoTcpHeader::ECE | DoTcpHeader::CWR)) != DoTcpHeader::RST)
         { // Since m_endPoint is not configured yet, we cannot use SendRST here
           DoTcpHeader h;
           h.SetFlags (DoTcpHeader::RST);
@@ -786,8 +824,8 @@ DoTcpSocketBase::ProcessEstablished (Ptr<Packet> packet, const DoTcpHeader& tcpH
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(DoTcpHeader::PSH | DoTcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are read apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(DoTcpHeader::PSH | DoTcpHeader::URG | DoTcpHeader::ECE | DoTcpHeader::CWR);
 
   // Different flags are different events
   if (tcpflags == DoTcpHeader::ACK)
@@ -831,6 +869,12 @@ DoTcpSocketBase::ReceivedAck (Ptr<Packet> packet, const DoTcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
+  if (m_ecnOk && (tcpHeader.GetFlags () & DoTcpHeader::ACK)
+      && tcpHeader.GetAckNumber () >= m_txBuffer.HeadSequence ())
+    { // Before the ACK moves the head, so that the bytes it acknowledges are known
+      EcnEcho (tcpHeader);
+    }
+
   // Received ACK. Compare the ACK number against highest unacked seqno
   if (0 == (tcpHeader.GetFlags () & DoTcpHeader::ACK))
     { // Ignore if no ACK flag
@@ -869,8 +913,8 @@ DoTcpSocketBase::ProcessListen (Ptr<Packet> packet, const DoTcpHeader& tcpHeader
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(DoTcpHeader::PSH | DoTcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are read apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(DoTcpHeader::PSH | DoTcpHeader::URG | DoTcpHeader::ECE | DoTcpHeader::CWR);
 
   // Fork a socket if received a SYN. Do nothing otherwise.
   // C.f.: the LISTEN part in tcp_v4_do_rcv() in tcp_ipv4.c in Linux kernel
@@ -898,8 +942,8 @@ DoTcpSocketBase::ProcessSynSent (Ptr<Packet> packet, const DoTcpHeader& tcpHeade
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(DoTcpHeader::PSH | DoTcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are read apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(DoTcpHeader::PSH | DoTcpHeader::URG | DoTcpHeader::ECE | DoTcpHeader::CWR);
 
   if (tcpflags == 0)
     { // Bare data, accept it and move to ESTABLISHED state. This is not a normal behaviour. Remove this?
@@ -957,8 +1001,8 @@ DoTcpSocketBase::ProcessSynRcvd (Ptr<Packet> packet, const DoTcpHeader& tcpHeade
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(DoTcpHeader::PSH | DoTcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are read apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(DoTcpHeader::PSH | DoTcpHeader::URG | DoTcpHeader::ECE | DoTcpHeader::CWR);
 
   if (tcpflags == 0
       || (tcpflags == DoTcpHeader::ACK
@@ -1031,8 +1075,8 @@ DoTcpSocketBase::ProcessWait (Ptr<Packet> packet, const DoTcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(DoTcpHeader::PSH | DoTcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are read apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(DoTcpHeader::PSH | DoTcpHeader::URG | DoTcpHeader::ECE | DoTcpHeader::CWR);
 
   if (packet->GetSize () > 0 && tcpflags != DoTcpHeader::ACK)
     { // Bare data, accept it
@@ -1102,8 +1146,8 @@ DoTcpSocketBase::ProcessClosing (Ptr<Packet> packet, const DoTcpHeader& tcpHeade
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(DoTcpHeader::PSH | DoTcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are read apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(DoTcpHeader::PSH | DoTcpHeader::URG | DoTcpHeader::ECE | DoTcpHeader::CWR);
 
   if (tcpflags == DoTcpHeader::ACK)
     {
@@ -1134,8 +1178,8 @@ DoTcpSocketBase::ProcessLastAck (Ptr<Packet> packet, const DoTcpHeader& tcpHeade
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(DoTcpHeader::PSH | DoTcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are read apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(DoTcpHeader::PSH | DoTcpHeader::URG | DoTcpHeader::ECE | DoTcpHeader::CWR);
 
   if (tcpflags == 0)
     {
@@ -1313,6 +1357,7 @@ DoTcpSocketBase::SendEmptyPacket (uint8_t flags)
     }
   header.SetWindowSize (AdvertisedWindowSize ());
   AddOptions (header);
+  AddEcn (header);
   m_rto = m_rtt->RetransmitTimeout ();
   bool hasSyn = flags & DoTcpHeader::SYN;
   bool hasFin = flags & DoTcpHeader::FIN;
@@ -1348,6 +1393,10 @@ DoTcpSocketBase::SendEmptyPacket (uint8_t flags)
                     << Simulator::Now ().GetSeconds () << " to expire at time "
                     << (Simulator::Now () + m_rto.Get ()).GetSeconds ());
       m_retxEvent = Simulator::Schedule (m_rto, &DoTcpSocketBase::SendEmptyPacket, this, flags);
+      if (hasFin)
+        { // Back off FIN retransmissions like data ones (RFC6298 sec.5.5)
+          m_rtt->IncreaseMultiplier ();
+        }
     }
 }
 
@@ -1509,6 +1558,23 @@ DoTcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool wi
     }
   header.SetWindowSize (AdvertisedWindowSize ());
   AddOptions (header);
+  AddEcn (header);
+  if (sz > m_segmentSize)
+    { // Segmentation offload: every segment on the wire repeats the header
+      SegmentationOffloadTag offloadTag ((sz + m_segmentSize - 1) / m_segmentSize, header.GetSerializedSize ());
+      p->AddPacketTag (offloadTag);
+    }
+  if (m_ecnOk && sz > 0)
+    { // Data is ECN-capable, and the first after a window reduction says so (RFC3168 sec.6.1.2)
+      SocketIpTosTag ipTosTag;
+      ipTosTag.SetTos (((IsManualIpTos () ? GetIpTos () : 0) & ~0x3) | DimensionOrderedHeader::ECN_ECT0);
+      p->ReplacePacketTag (ipTosTag);
+      if (m_cwrPending)
+        {
+          header.SetFlags (header.GetFlags () | DoTcpHeader::CWR);
+          m_cwrPending = false;
+        }
+    }
   if (m_retxEvent.IsExpired () )
     { // Schedule retransmit
       m_rto = m_rtt->RetransmitTimeout ();
@@ -1577,6 +1643,16 @@ DoTcpSocketBase::SendPendingData (bool withAck)
           break;
         }
       uint32_t s = std::min (w, m_segmentSize);  // Send no more than window
+      if (m_offloadSize > m_segmentSize && w > m_segmentSize)
+        { // Whole segments up to the offload size, or the rest of the data. The
+          // ACK of a super-segment only comes once all of it has arrived, so
+          // it takes at most a quarter of the window to keep the ACKs flowing
+          s = std::min (std::min (w, m_offloadSize), std::max (Window () / 4, m_segmentSize));
+          if (s < m_txBuffer.SizeFromSequence (m_nextTxSequence))
+            {
+              s -= s % m_segmentSize;
+            }
+        }
       uint32_t sz = SendDataPacket (m_nextTxSequence, s, withAck);
       nPacketsSent++;                             // Count sent this loop
       m_nextTxSequence += sz;                     // Advance next tx sequence
@@ -1616,6 +1692,20 @@ DoTcpSocketBase::AvailableWindow ()
   return (win < unack) ? 0 : (win - unack);
 }
 
+/* The receiver counts the segments of a super-segment for its delayed ACKs,
+ * so it acknowledges all of them at once. Window growth counted per ACK
+ * uses this to grow as fast as with the ACKs of the separate segments. */
+uint32_t
+DoTcpSocketBase::OffloadedAcks (uint32_t bytes) const
+{
+  if (m_offloadSize <= m_segmentSize || bytes <= m_segmentSize)
+    {
+      return 1;
+    }
+  uint32_t segments = (bytes + m_segmentSize - 1) / m_segmentSize;
+  return std::max<uint32_t> (1, segments / std::max<uint32_t> (1, m_delAckMaxCount));
+}
+
 uint16_t
 DoTcpSocketBase::AdvertisedWindowSize ()
 {
@@ -1633,6 +1723,7 @@ DoTcpSocketBase::ReceivedData (Ptr<Packet> p, const DoTcpHeader& tcpHeader)
 
   // Put into Rx buffer
   SequenceNumber32 expectedSeq = m_rxBuffer.NextRxSequence ();
+  m_lastRxSeq = tcpHeader.GetSequenceNumber ();
   if (!m_rxBuffer.Add (p, tcpHeader))
     { // Insert failed: No data or RX buffer full
       SendEmptyPacket (DoTcpHeader::ACK);
@@ -1644,8 +1735,11 @@ DoTcpSocketBase::ReceivedData (Ptr<Packet> p, const DoTcpHeader& tcpHeader)
       SendEmptyPacket (DoTcpHeader::ACK);
     }
   else
-    { // In-sequence packet: ACK if delayed ack count allows
-      if (++m_delAckCount >= m_delAckMaxCount)
+    { // In-sequence packet: ACK if delayed ack count allows, counting every
+      // segment of an offloaded packet
+      SegmentationOffloadTag offloadTag;
+      m_delAckCount += p->PeekPacketTag (offloadTag) ? offloadTag.GetSegments () : 1;
+      if (m_delAckCount >= m_delAckMaxCount)
         {
           m_delAckEvent.Cancel ();
           m_delAckCount = 0;
@@ -1769,6 +1863,8 @@ DoTcpSocketBase::ReTxTimeout ()
       return;
     }
 
+  // The receiver may have dropped SACKed data (RFC2018 sec.8)
+  m_scoreboard.clear ();
   Retransmit ();
 }
 
@@ -2016,16 +2112,236 @@ DoTcpSocketBase::GetAllowBroadcast (void) const
   return false;
 }
 
-/** Placeholder function for future extension that reads more from the TCP header */
+/** Agree on SACK from the SYN or SYN+ACK of the peer and record its SACK blocks */
+void
+DoTcpSocketBase::ReadOptions (const DoTcpHeader& tcpHeader)
+{
+  if (tcpHeader.GetFlags () & DoTcpHeader::SYN)
+    {
+      m_sackOk = m_sackEnabled && tcpHeader.GetSackPermitted ();
+    }
+  else if (m_sackOk && (tcpHeader.GetFlags () & DoTcpHeader::ACK))
+    {
+      UpdateScoreboard (tcpHeader);
+    }
+}
+
+/** Offer SACK on a SYN, or accept it on a SYN+ACK, and report out of order data on ACKs */
+void
+DoTcpSocketBase::AddOptions (DoTcpHeader& tcpHeader)
+{
+  if (tcpHeader.GetFlags () & DoTcpHeader::SYN)
+    {
+      tcpHeader.SetSackPermitted ((tcpHeader.GetFlags () & DoTcpHeader::ACK) ? m_sackOk : m_sackEnabled);
+    }
+  else if (m_sackOk && (tcpHeader.GetFlags () & DoTcpHeader::ACK))
+    {
+      m_rxBuffer.AddSackBlocks (tcpHeader, m_lastRxSeq);
+    }
+}
+
+/** Agree on ECN from the SYN or SYN+ACK of the peer and follow the CE marks of its data */
+void
+DoTcpSocketBase::ReadEcn (Ptr<Packet> packet, const DimensionOrderedHeader& header, const DoTcpHeader& tcpHeader)
+{
+  uint8_t ecnFlags = tcpHeader.GetFlags () & (DoTcpHeader::ECE | DoTcpHeader::CWR);
+  if (tcpHeader.GetFlags () & DoTcpHeader::SYN)
+    { // An ECN-setup SYN carries ECE and CWR, its SYN+ACK only ECE (RFC3168 sec.6.1.1)
+      uint8_t setup = (tcpHeader.GetFlags () & DoTcpHeader::ACK) ? DoTcpHeader::ECE
+        : DoTcpHeader::ECE | DoTcpHeader::CWR;
+      m_ecnOk = m_ecnEnabled && ecnFlags == setup;
+      m_ceState = false;
+    }
+  else if (m_ecnOk && packet->GetSize () > 0)
+    { // ECE follows every CE mark instead of staying set until CWR, so the
+      // sender learns how much of its data was marked. When the marks change,
+      // the data held for a delayed ACK is acknowledged with the old state
+      // (RFC8257 sec.3.2), and this segment with the new one without delay,
+      // or a sender cut down to two segments waits for the delayed ACK
+      bool ce = header.GetEcn () == DimensionOrderedHeader::ECN_CE;
+      if (ce != m_ceState)
+        {
+          if (m_delAckCount > 0)
+            {
+              SendEmptyPacket (DoTcpHeader::ACK);
+            }
+          m_delAckCount = m_delAckMaxCount > 0 ? m_delAckMaxCount - 1 : 0;
+        }
+      m_ceState = ce;
+    }
+}
+
+/** Offer ECN on a SYN, or accept it on a SYN+ACK, and echo CE marks on ACKs */
+void
+DoTcpSocketBase::AddEcn (DoTcpHeader& tcpHeader)
+{
+  uint8_t flags = tcpHeader.GetFlags ();
+  if ((flags & DoTcpHeader::SYN) && (flags & DoTcpHeader::ACK))
+    {
+      if (m_ecnOk)
+        {
+          tcpHeader.SetFlags (flags | DoTcpHeader::ECE);
+        }
+    }
+  else if (flags & DoTcpHeader::SYN)
+    {
+      if (m_ecnEnabled)
+        {
+          tcpHeader.SetFlags (flags | DoTcpHeader::ECE | DoTcpHeader::CWR);
+        }
+    }
+  else if (m_ecnOk && m_ceState && (flags & DoTcpHeader::ACK))
+    {
+      tcpHeader.SetFlags (flags | DoTcpHeader::ECE);
+    }
+}
+
 void
-DoTcpSocketBase::ReadOptions (const DoTcpHeader&)
+DoTcpSocketBase::EcnEcho (const DoTcpHeader& tcpHeader)
 {
 }
 
-/** Placeholder function for future extension that changes the TCP header */
 void
-DoTcpSocketBase::AddOptions (DoTcpHeader&)
+DoTcpSocketBase::UpdateScoreboard (const DoTcpHeader& tcpHeader)
+{
+  // Forget what the cumulative ACK covers
+  SequenceNumber32 head = std::max (m_txBuffer.HeadSequence (), tcpHeader.GetAckNumber ());
+  DoTcpHeader::SackList::iterator it = m_scoreboard.begin ();
+  while (it != m_scoreboard.end () && it->second <= head)
+    {
+      ++it;
+    }
+  m_scoreboard.erase (m_scoreboard.begin (), it);
+  if (!m_scoreboard.empty () && m_scoreboard.front ().first < head)
+    {
+      m_scoreboard.front ().first = head;
+    }
+
+  // Merge the blocks in, ignoring data that was never sent or is acknowledged
+  const DoTcpHeader::SackList& blocks = tcpHeader.GetSackBlocks ();
+  for (DoTcpHeader::SackList::const_iterator block = blocks.begin (); block != blocks.end (); ++block)
+    {
+      SequenceNumber32 start = std::max (block->first, head);
+      SequenceNumber32 end = std::min (block->second, m_highTxMark.Get ());
+      if (start >= end)
+        {
+          continue;
+        }
+      DoTcpHeader::SackList::iterator first = m_scoreboard.begin ();
+      while (first != m_scoreboard.end () && first->second < start)
+        {
+          ++first;
+        }
+      DoTcpHeader::SackList::iterator last = first;
+      for (; last != m_scoreboard.end () && last->first <= end; ++last)
+        {
+          start = std::min (start, last->first);
+          end = std::max (end, last->second);
+        }
+      first = m_scoreboard.erase (first, last);
+      m_scoreboard.insert (first, DoTcpHeader::SackBlock (start, end));
+    }
+}
+
+uint32_t
+DoTcpSocketBase::SackedBytes (SequenceNumber32 from, SequenceNumber32 to) const
+{
+  uint32_t bytes = 0;
+  for (DoTcpHeader::SackList::const_iterator it = m_scoreboard.begin ();
+       it != m_scoreboard.end () && it->first < to; ++it)
+    {
+      SequenceNumber32 start = std::max (it->first, from);
+      SequenceNumber32 end = std::min (it->second, to);
+      if (start < end)
+        {
+          bytes += end - start;
+        }
+    }
+  return bytes;
+}
+
+/** IsLost() of RFC6675 for every sequence number at once: data is lost once
+    dupThresh blocks or more than dupThresh - 1 segments above it are SACKed */
+SequenceNumber32
+DoTcpSocketBase::LostBoundary (uint32_t dupThresh) const
 {
+  uint32_t bytes = 0;
+  uint32_t blocks = 0;
+  for (DoTcpHeader::SackList::const_reverse_iterator it = m_scoreboard.rbegin ();
+       it != m_scoreboard.rend (); ++it)
+    {
+      bytes += it->second - it->first;
+      if (++blocks >= dupThresh || bytes > (dupThresh - 1) * m_segmentSize)
+        {
+          return it->first;
+        }
+    }
+  return m_txBuffer.HeadSequence ();
+}
+
+/** SetPipe() of RFC6675 in bytes: data not SACKed counts once unless it is
+    lost, and once more if it was retransmitted */
+uint32_t
+DoTcpSocketBase::Pipe (SequenceNumber32 lost) const
+{
+  SequenceNumber32 head = m_txBuffer.HeadSequence ();
+  SequenceNumber32 highData = std::max (m_highTxMark.Get (), head);
+  lost = std::min (std::max (lost, head), highData);
+  SequenceNumber32 highRxt = std::min (std::max (m_highRxt, head), highData);
+  uint32_t outstanding = (highData - head) - SackedBytes (head, highData);
+  uint32_t lostBytes = (lost - head) - SackedBytes (head, lost);
+  uint32_t retransmitted = (highRxt - head) - SackedBytes (head, highRxt);
+  return outstanding - lostBytes + retransmitted;
+}
+
+/** NextSeg() of RFC6675, sec.4: retransmit lost data first, then send new
+    data, then retransmit holes below SACKed data, while a segment fits in
+    cwnd - pipe */
+void
+DoTcpSocketBase::SendSackRecoveryData (uint32_t cwnd, uint32_t dupThresh)
+{
+  NS_LOG_FUNCTION (this << cwnd);
+  while (m_endPoint != 0)
+    {
+      SequenceNumber32 lost = LostBoundary (dupThresh);
+      uint32_t pipe = Pipe (lost);
+      if (pipe + m_segmentSize > cwnd)
+        {
+          break;
+        }
+      // First hole after the last retransmission
+      SequenceNumber32 head = m_txBuffer.HeadSequence ();
+      SequenceNumber32 seq = std::max (m_highRxt, head);
+      SequenceNumber32 holeEnd = m_highTxMark;
+      for (DoTcpHeader::SackList::const_iterator it = m_scoreboard.begin (); it != m_scoreboard.end (); ++it)
+        {
+          if (it->first > seq)
+            {
+              holeEnd = it->first;
+              break;
+            }
+          seq = std::max (seq, it->second);
+        }
+      SequenceNumber32 highSacked = m_scoreboard.empty () ? head : m_scoreboard.back ().second;
+      uint32_t unAck = UnAckDataCount ();
+      uint32_t rWnd = m_rWnd.Get () > unAck ? m_rWnd.Get () - unAck : 0;
+      uint32_t newData = std::min (m_txBuffer.SizeFromSequence (m_nextTxSequence), m_segmentSize);
+      if (seq < lost || (seq < highSacked && (newData == 0 || rWnd < newData)))
+        {
+          NS_LOG_LOGIC ("SACK recovery retransmits " << seq << " pipe " << pipe << " cwnd " << cwnd);
+          uint32_t sz = SendDataPacket (seq, std::min<uint32_t> (m_segmentSize, holeEnd - seq), true);
+          m_highRxt = seq + SequenceNumber32 (sz);
+        }
+      else if (newData > 0 && rWnd >= newData)
+        {
+          uint32_t sz = SendDataPacket (m_nextTxSequence, newData, true);
+          m_nextTxSequence += sz;
+        }
+      else
+        {
+          break;
+        }
+    }
 }
 
 } // namespace ns3
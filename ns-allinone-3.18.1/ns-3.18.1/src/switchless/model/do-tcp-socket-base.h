@@ -146,6 +146,7 @@ protected:
   virtual uint32_t Window (void);               // Return the max possible number of unacked bytes
   virtual uint32_t AvailableWindow (void);      // Return unfilled portion of window
   virtual uint16_t AdvertisedWindowSize (void); // The amount of Rx window announced to the peer
+  uint32_t OffloadedAcks (uint32_t bytes) const; // ACKs the wire segments of bytes would have drawn, 1 without offload
 
   // Manage data tx/rx
   virtual Ptr<DoTcpSocketBase> Fork (void) = 0; // Call CopyObject<> to clone me
@@ -163,6 +164,18 @@ protected:
   virtual void ReadOptions (const DoTcpHeader&); // Read option from incoming packets
   virtual void AddOptions (DoTcpHeader&); // Add option to outgoing packets
 
+  // Selective acknowledgements: scoreboard and loss recovery (RFC2018, RFC6675)
+  void UpdateScoreboard (const DoTcpHeader&); // Record the SACK blocks of an incoming ACK
+  uint32_t SackedBytes (SequenceNumber32 from, SequenceNumber32 to) const; // SACKed bytes in [from, to)
+  SequenceNumber32 LostBoundary (uint32_t dupThresh) const; // Data below this that is not SACKed is lost
+  uint32_t Pipe (SequenceNumber32 lost) const; // Estimate of the bytes still in the network
+  void SendSackRecoveryData (uint32_t cwnd, uint32_t dupThresh); // Send lost data, new data, then holes while pipe < cwnd
+
+  // Explicit congestion notification (RFC3168)
+  void ReadEcn (Ptr<Packet>, const DimensionOrderedHeader&, const DoTcpHeader&); // Agree on ECN, follow CE marks of data
+  void AddEcn (DoTcpHeader&); // Offer or accept ECN on a SYN, echo CE marks on ACKs
+  virtual void EcnEcho (const DoTcpHeader&); // React to an ACK of an ECN connection, ignored by default
+
 protected:
   // Counters and events
   EventId           m_retxEvent;       //< Retransmission event
@@ -210,6 +223,20 @@ protected:
   uint32_t              m_segmentSize; //< Segment size
   uint16_t              m_maxWinSize;  //< Maximum window size to advertise
   TracedValue<uint32_t> m_rWnd;        //< Flow control window at remote side
+  uint32_t              m_offloadSize; //< Largest super-segment handed to L3 (segmentation offload), 0 for none
+
+  // Selective acknowledgements (RFC2018, RFC6675)
+  bool                  m_sackEnabled; //< Offer SACK when connecting
+  bool                  m_sackOk;      //< Both sides agreed on SACK
+  DoTcpHeader::SackList m_scoreboard;  //< SACKed data above the head, sorted and disjoint
+  SequenceNumber32      m_highRxt;     //< End of the highest retransmission in this recovery
+  SequenceNumber32      m_lastRxSeq;   //< Seqnum of the last data received, its block is reported first
+
+  // Explicit congestion notification (RFC3168)
+  bool                  m_ecnEnabled;  //< Offer ECN when connecting
+  bool                  m_ecnOk;       //< Both sides agreed on ECN
+  bool                  m_ceState;     //< The last data received was marked, echoed as ECE
+  bool                  m_cwrPending;  //< Set CWR on the next data sent, after a window reduction
 };
 
 } // namespace ns3
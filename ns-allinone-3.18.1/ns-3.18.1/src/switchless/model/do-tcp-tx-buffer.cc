@@ -34,7 +34,7 @@ DoTcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 DoTcpTxBuffer::DoTcpTxBuffer (uint32_t n)
-  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_data (0)
+  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_head (0)
 {
 }
 
@@ -78,18 +78,58 @@ DoTcpTxBuffer::Available (void) const
   return m_maxBuffer - m_size;
 }
 
+void
+DoTcpTxBuffer::Reserve (uint32_t n)
+{
+  if (n <= m_data.size ())
+    {
+      return;
+    }
+  uint32_t capacity = std::max<uint32_t> (n, 2 * m_data.size ());
+  NS_LOG_LOGIC ("Growing ring from " << m_data.size () << " to " << capacity << " bytes");
+  std::vector<uint8_t> data (capacity);
+  uint32_t first = std::min<uint32_t> (m_size, m_data.size () - m_head);
+  std::copy (m_data.begin () + m_head, m_data.begin () + m_head + first, data.begin ());
+  std::copy (m_data.begin (), m_data.begin () + (m_size - first), data.begin () + first);
+  m_data.swap (data);
+  m_head = 0;
+}
+
+void
+DoTcpTxBuffer::Release (void)
+{
+  NS_LOG_LOGIC ("Releasing ring of " << m_data.size () << " bytes");
+  std::vector<uint8_t> ().swap (m_data);
+  std::vector<uint8_t> ().swap (m_scratch);
+  m_head = 0;
+}
+
 bool
 DoTcpTxBuffer::Add (Ptr<Packet> p)
 {
   NS_LOG_FUNCTION (this << p);
   NS_LOG_LOGIC ("Packet of size " << p->GetSize () << " appending to window starting at "
                                   << m_firstByteSeq << ", availSize="<< Available ());
-  if (p->GetSize () <= Available ())
+  uint32_t n = p->GetSize ();
+  if (n <= Available ())
     {
-      if (p->GetSize () > 0)
+      if (n > 0)
         {
-          m_data.push_back (p);
-          m_size += p->GetSize ();
+          Reserve (m_size + n);
+          uint32_t tail = (m_head + m_size) % m_data.size ();
+          if (tail + n <= m_data.size ())
+            {
+              p->CopyData (&m_data[tail], n);
+            }
+          else
+            { // Wraps around the end of the ring
+              m_scratch.resize (n);
+              p->CopyData (&m_scratch[0], n);
+              uint32_t first = m_data.size () - tail;
+              std::memcpy (&m_data[tail], &m_scratch[0], first);
+              std::memcpy (&m_data[0], &m_scratch[first], n - first);
+            }
+          m_size += n;
           NS_LOG_LOGIC ("Updated size=" << m_size << ", lastSeq=" << m_firstByteSeq + SequenceNumber32 (m_size));
         }
       return true;
@@ -119,63 +159,24 @@ DoTcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
     {
       return Create<Packet> (); // Empty packet returned
     }
-  if (m_data.size () == 0)
+  if (m_size == 0)
     { // No actual data, just return dummy-data packet of correct size
       return Create<Packet> (s);
     }
 
-  // Extract data from the buffer and return
+  // Copy the data out of the ring in one packet
   uint32_t offset = seq - m_firstByteSeq.Get ();
-  uint32_t count = 0;      // Offset of the first byte of a packet in the buffer
-  uint32_t pktSize = 0;
-  bool beginFound = false;
-  int pktCount = 0;
-  Ptr<Packet> outPacket;
-  NS_LOG_LOGIC ("There are " << m_data.size () << " number of packets in buffer");
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  NS_ASSERT (offset + s <= m_size);
+  uint32_t start = (m_head + offset) % m_data.size ();
+  if (start + s <= m_data.size ())
     {
-      pktCount++;
-      pktSize = (*i)->GetSize ();
-      if (!beginFound)
-        { // Look for first fragment
-          if (count + pktSize > offset)
-            {
-              NS_LOG_LOGIC ("First byte found in packet #" << pktCount << " at buffer offset " << count
-                                                           << ", packet len=" << pktSize);
-              beginFound = true;
-              uint32_t packetOffset = offset - count;
-              uint32_t fragmentLength = count + pktSize - offset;
-              if (fragmentLength >= s)
-                { // Data to be copied falls entirely in this packet
-                  return (*i)->CreateFragment (packetOffset, s);
-                }
-              else
-                { // This packet only fulfills part of the request
-                  outPacket = (*i)->CreateFragment (packetOffset, fragmentLength);
-                }
-              NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-            }
-        }
-      else if (count + pktSize >= offset + s)
-        { // Last packet fragment found
-          NS_LOG_LOGIC ("Last byte found in packet #" << pktCount << " at buffer offset " << count
-                                                      << ", packet len=" << pktSize);
-          uint32_t fragmentLength = offset + s - count;
-          Ptr<Packet> endFragment = (*i)->CreateFragment (0, fragmentLength);
-          outPacket->AddAtEnd (endFragment);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-          break;
-        }
-      else
-        {
-          NS_LOG_LOGIC ("Appending to output the packet #" << pktCount << " of offset " << count << " len=" << pktSize);
-          outPacket->AddAtEnd (*i);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-        }
-      count += pktSize;
+      return Create<Packet> (&m_data[start], s);
     }
-  NS_ASSERT (outPacket->GetSize () == s);
-  return outPacket;
+  uint32_t first = m_data.size () - start;
+  m_scratch.resize (s);
+  std::memcpy (&m_scratch[0], &m_data[start], first);
+  std::memcpy (&m_scratch[first], &m_data[0], s - first);
+  return Create<Packet> (&m_scratch[0], s);
 }
 
 void
@@ -189,45 +190,23 @@ void
 DoTcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
 {
   NS_LOG_FUNCTION (this << seq);
-  NS_LOG_LOGIC ("current data size=" << m_size << ", headSeq=" << m_firstByteSeq << ", maxBuffer=" << m_maxBuffer
-                                     << ", numPkts=" << m_data.size ());
+  NS_LOG_LOGIC ("current data size=" << m_size << ", headSeq=" << m_firstByteSeq << ", maxBuffer=" << m_maxBuffer);
   // Cases do not need to scan the buffer
   if (m_firstByteSeq >= seq) return;
 
-  // Scan the buffer and discard packets
-  uint32_t offset = seq - m_firstByteSeq.Get ();  // Number of bytes to remove
-  uint32_t pktSize;
-  NS_LOG_LOGIC ("Offset=" << offset);
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end ())
+  uint32_t offset = std::min<uint32_t> (seq - m_firstByteSeq.Get (), m_size);  // Number of bytes to remove
+  if (offset > 0)
     {
-      if (offset > (*i)->GetSize ())
-        { // This packet is behind the seqnum. Remove this packet from the buffer
-          pktSize = (*i)->GetSize ();
-          m_size -= pktSize;
-          offset -= pktSize;
-          m_firstByteSeq += pktSize;
-          i = m_data.erase (i);
-          NS_LOG_LOGIC ("Removed one packet of size " << pktSize << ", offset=" << offset);
-        }
-      else if (offset > 0)
-        { // Part of the packet is behind the seqnum. Fragment
-          pktSize = (*i)->GetSize () - offset;
-          *i = (*i)->CreateFragment (offset, pktSize);
-          m_size -= offset;
-          m_firstByteSeq += offset;
-          NS_LOG_LOGIC ("Fragmented one packet by size " << offset << ", new size=" << pktSize);
-          break;
+      m_head = (m_head + offset) % m_data.size ();
+      m_size -= offset;
+      if (m_size == 0)
+        {
+          Release ();
         }
     }
   // Catching the case of ACKing a FIN
-  if (m_size == 0)
-    {
-      m_firstByteSeq = seq;
-    }
-  NS_LOG_LOGIC ("size=" << m_size << " headSeq=" << m_firstByteSeq << " maxBuffer=" << m_maxBuffer
-                        <<" numPkts="<< m_data.size ());
-  NS_ASSERT (m_firstByteSeq == seq);
+  m_firstByteSeq = seq;
+  NS_LOG_LOGIC ("size=" << m_size << " headSeq=" << m_firstByteSeq << " maxBuffer=" << m_maxBuffer);
 }
 
 } // namepsace ns3
@@ -2,7 +2,7 @@
 #ifndef DO_TCP_TX_BUFFER_H
 #define DO_TCP_TX_BUFFER_H
 
-#include <list>
+#include <vector>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/object.h"
@@ -17,6 +17,11 @@ class Packet;
  *
  * \brief class for keeping the data sent by the application to the TCP socket, i.e.
  *        the sending buffer.
+ *
+ * The bytes are copied into a ring that grows to the largest amount of data
+ * buffered, so segments are cut from it without walking the written packets.
+ * The ring is released whenever all the data is acknowledged. Only the
+ * payload bytes are kept, not the tags of the written packets.
  */
 class DoTcpTxBuffer : public Object
 {
@@ -89,12 +94,17 @@ public:
   void DiscardUpTo (const SequenceNumber32& seq);
 
 private:
-  typedef std::list<Ptr<Packet> >::iterator BufIterator;
+  // Make room for this many bytes from the head, keeping them in order
+  void Reserve (uint32_t n);
+  // Free the ring of an empty buffer, so idle connections keep no memory
+  void Release (void);
 
   TracedValue<SequenceNumber32> m_firstByteSeq; //< Sequence number of the first byte in data (SND.UNA)
   uint32_t m_size;                              //< Number of data bytes
   uint32_t m_maxBuffer;                         //< Max number of data bytes in buffer (SND.WND)
-  std::list<Ptr<Packet> > m_data;               //< Corresponding data (may be null)
+  std::vector<uint8_t> m_data;                  //< Ring of the data bytes
+  uint32_t m_head;                              //< Offset of the first byte in the ring
+  std::vector<uint8_t> m_scratch;               //< Data wrapping around the end of the ring
 };
 
 } // namepsace ns3
@@ -79,14 +79,13 @@ DoUdpHeader::CalculateHeaderChecksum (uint16_t size) const
 
   WriteTo (it, m_source);
   WriteTo (it, m_destination);
-  // TODO: This could be wrong for dimension ordered
   if (DimensionOrderedAddress::IsMatchingType(m_source))
     {
       it.WriteU8 (0); /* protocol */
       it.WriteU8 (m_protocol); /* protocol */
       it.WriteU8 (size >> 8); /* length */
       it.WriteU8 (size & 0xff); /* length */
-      hdrSize = 12;
+      hdrSize = m_source.GetLength () + m_destination.GetLength () + 4;
     }
 
   it = buf.Begin ();
@@ -0,0 +1,116 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/dim-ordered-header.h"
+#include "ns3/do-tcp-header.h"
+
+using namespace ns3;
+
+/*
+ * The ECN codepoint shares the top bits of compact 3D coordinates, or the
+ * address format byte of other addresses, and every codepoint survives
+ * serialization without changing the addresses or the header size.
+ */
+class DimensionOrderedEcnHeaderTestCase : public TestCase
+{
+public:
+  DimensionOrderedEcnHeaderTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+DimensionOrderedEcnHeaderTestCase::DimensionOrderedEcnHeaderTestCase ()
+  : TestCase ("DimensionOrderedHeader carries the ECN codepoint")
+{
+}
+
+void
+DimensionOrderedEcnHeaderTestCase::DoRun (void)
+{
+  std::vector<uint16_t> wide (DimensionOrderedAddress::MAX_DIMS, 300);
+  DimensionOrderedAddress sources[4] = { DimensionOrderedAddress (1, 2, 3), DimensionOrderedAddress (126, 0, 9),
+                                         DimensionOrderedAddress (1, 127, 3), DimensionOrderedAddress (wide) };
+  DimensionOrderedAddress destinations[4] = { DimensionOrderedAddress (7, 0, 5), DimensionOrderedAddress::GetBroadcast (),
+                                              DimensionOrderedAddress (254, 0, 5), DimensionOrderedAddress (wide) };
+  uint32_t sizes[4] = { 9, 9, 10, 4 + 4 * DimensionOrderedAddress::MAX_DIMS };
+  for (uint32_t a = 0; a < 4; a++)
+    {
+      for (uint32_t ecn = 0; ecn < 4; ecn++)
+        {
+          DimensionOrderedHeader header;
+          header.SetSource (sources[a]);
+          header.SetDestination (destinations[a]);
+          header.SetProtocol (7);
+          header.SetPayloadSize (100);
+          uint32_t size = header.GetSerializedSize ();
+          NS_TEST_ASSERT_MSG_EQ (size, sizes[a], "Header size of address pair " << a);
+          header.SetEcn (static_cast<DimensionOrderedHeader::EcnType> (ecn));
+          NS_TEST_ASSERT_MSG_EQ (header.GetSerializedSize (), size, "ECN changed the header size");
+
+          Ptr<Packet> p = Create<Packet> (100);
+          p->AddHeader (header);
+          DimensionOrderedHeader received;
+          p->RemoveHeader (received);
+          NS_TEST_ASSERT_MSG_EQ (received.GetEcn (), ecn, "ECN codepoint lost");
+          NS_TEST_ASSERT_MSG_EQ (received.GetSource (), sources[a], "Source changed");
+          NS_TEST_ASSERT_MSG_EQ (received.GetDestination (), destinations[a], "Destination changed");
+          NS_TEST_ASSERT_MSG_EQ (received.GetProtocol (), 7, "Protocol changed");
+          NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 100, "Header size changed");
+        }
+    }
+}
+
+/*
+ * ECE and CWR are the two flag bits above the six of RFC793, and reach the
+ * receiver next to them.
+ */
+class DoTcpEcnFlagsTestCase : public TestCase
+{
+public:
+  DoTcpEcnFlagsTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+DoTcpEcnFlagsTestCase::DoTcpEcnFlagsTestCase ()
+  : TestCase ("DoTcpHeader carries the ECE and CWR flags")
+{
+}
+
+void
+DoTcpEcnFlagsTestCase::DoRun (void)
+{
+  uint8_t flags[3] = { DoTcpHeader::SYN | DoTcpHeader::ECE | DoTcpHeader::CWR,
+                       DoTcpHeader::SYN | DoTcpHeader::ACK | DoTcpHeader::ECE,
+                       DoTcpHeader::ACK | DoTcpHeader::CWR };
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      DoTcpHeader header;
+      header.SetFlags (flags[i]);
+      header.SetWindowSize (1000);
+      Ptr<Packet> p = Create<Packet> (10);
+      p->AddHeader (header);
+      DoTcpHeader received;
+      p->RemoveHeader (received);
+      NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (received.GetFlags ()), static_cast<uint32_t> (flags[i]),
+                             "Flags changed");
+      NS_TEST_ASSERT_MSG_EQ (received.GetLength (), 5, "Flags leaked into the header length");
+      NS_TEST_ASSERT_MSG_EQ (received.GetWindowSize (), 1000, "Window changed");
+    }
+}
+
+class DimensionOrderedEcnTestSuite : public TestSuite
+{
+public:
+  DimensionOrderedEcnTestSuite ();
+};
+
+DimensionOrderedEcnTestSuite::DimensionOrderedEcnTestSuite ()
+  : TestSuite ("dim-ordered-ecn", UNIT)
+{
+  AddTestCase (new DimensionOrderedEcnHeaderTestCase, TestCase::QUICK);
+  AddTestCase (new DoTcpEcnFlagsTestCase, TestCase::QUICK);
+}
+
+static DimensionOrderedEcnTestSuite dimOrderedEcnTestSuite;
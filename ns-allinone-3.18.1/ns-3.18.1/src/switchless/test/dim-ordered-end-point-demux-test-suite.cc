@@ -0,0 +1,229 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/dim-ordered-end-point-demux.h"
+
+using namespace ns3;
+
+static const uint16_t LISTEN_PORT = 8080;
+
+// Peer address of the i-th connected endpoint, spread over a 3D torus
+static DimensionOrderedAddress
+PeerAddress (uint32_t i)
+{
+  return DimensionOrderedAddress (1 + i % 16, 1 + (i / 16) % 16, 1 + i / 256);
+}
+
+/*
+ * Wildcard semantics of the hashed demux: the most specific endpoint wins,
+ * and endpoints that change their peer after allocation are found under
+ * the new peer.
+ */
+class DimensionOrderedEndPointDemuxLookupTestCase : public TestCase
+{
+public:
+  DimensionOrderedEndPointDemuxLookupTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+DimensionOrderedEndPointDemuxLookupTestCase::DimensionOrderedEndPointDemuxLookupTestCase ()
+  : TestCase ("DimensionOrderedEndPointDemux lookups honour wildcards")
+{
+}
+
+void
+DimensionOrderedEndPointDemuxLookupTestCase::DoRun (void)
+{
+  DimensionOrderedEndPointDemux demux;
+  DimensionOrderedAddress local (1, 1, 1);
+  DimensionOrderedAddress peer (2, 3, 4);
+
+  DimensionOrderedEndPoint *listener = demux.Allocate (LISTEN_PORT);
+  NS_TEST_ASSERT_MSG_NE (listener, 0, "Could not allocate listening endpoint");
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupPortLocal (LISTEN_PORT), true, "Port not found");
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupLocal (DimensionOrderedAddress::GetAny (), LISTEN_PORT), true,
+                         "Local address/port not found");
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupLocal (local, LISTEN_PORT), false, "Unexpected local match");
+  NS_TEST_ASSERT_MSG_EQ (demux.Allocate (LISTEN_PORT), 0, "Duplicate bind was allowed");
+
+  // Unknown peer falls back to the listener
+  DimensionOrderedEndPointDemux::EndPoints endPoints = demux.Lookup (local, LISTEN_PORT, peer, 1000, 0);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Expected the listening endpoint");
+  NS_TEST_ASSERT_MSG_EQ (endPoints.front (), listener, "Expected the listening endpoint");
+
+  // A connected endpoint is preferred over the listener
+  DimensionOrderedEndPoint *accepted = demux.Allocate (local, LISTEN_PORT, peer, 1000);
+  NS_TEST_ASSERT_MSG_NE (accepted, 0, "Could not allocate connected endpoint");
+  NS_TEST_ASSERT_MSG_EQ (demux.Allocate (local, LISTEN_PORT, peer, 1000), 0, "Duplicate four-tuple was allowed");
+  endPoints = demux.Lookup (local, LISTEN_PORT, peer, 1000, 0);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Expected the connected endpoint");
+  NS_TEST_ASSERT_MSG_EQ (endPoints.front (), accepted, "Expected the connected endpoint");
+  NS_TEST_ASSERT_MSG_EQ (demux.SimpleLookup (local, LISTEN_PORT, peer, 1000), accepted,
+                         "SimpleLookup missed the exact match");
+
+  // Other source ports of the same peer still reach the listener
+  endPoints = demux.Lookup (local, LISTEN_PORT, peer, 1001, 0);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.front (), listener, "Expected the listening endpoint");
+
+  // Endpoints re-hash when their peer is set after allocation
+  DimensionOrderedEndPoint *client = demux.Allocate (local);
+  NS_TEST_ASSERT_MSG_NE (client, 0, "Could not allocate ephemeral endpoint");
+  client->SetPeer (peer, LISTEN_PORT);
+  endPoints = demux.Lookup (local, client->GetLocalPort (), peer, LISTEN_PORT, 0);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Expected the client endpoint");
+  NS_TEST_ASSERT_MSG_EQ (endPoints.front (), client, "Expected the client endpoint");
+  endPoints = demux.Lookup (local, client->GetLocalPort (), DimensionOrderedAddress (5, 5, 5), LISTEN_PORT, 0);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.empty (), true, "Stale wildcard entry for the client endpoint");
+
+  // Removing the connected endpoint reveals the listener again
+  demux.DeAllocate (accepted);
+  endPoints = demux.Lookup (local, LISTEN_PORT, peer, 1000, 0);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.front (), listener, "Expected the listening endpoint");
+
+  demux.DeAllocate (listener);
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupPortLocal (LISTEN_PORT), false, "Port still in use");
+  endPoints = demux.Lookup (local, LISTEN_PORT, peer, 1000, 0);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.empty (), true, "Lookup matched a removed endpoint");
+}
+
+/*
+ * Peers whose addresses only differ in a fourth dimension or above the
+ * first byte of a coordinate must get their own endpoints.
+ */
+class DimensionOrderedEndPointDemuxWideAddressTestCase : public TestCase
+{
+public:
+  DimensionOrderedEndPointDemuxWideAddressTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+DimensionOrderedEndPointDemuxWideAddressTestCase::DimensionOrderedEndPointDemuxWideAddressTestCase ()
+  : TestCase ("DimensionOrderedEndPointDemux keeps N-dimensional addresses apart")
+{
+}
+
+void
+DimensionOrderedEndPointDemuxWideAddressTestCase::DoRun (void)
+{
+  DimensionOrderedEndPointDemux demux;
+  std::vector<uint16_t> coordinates (4, 1);
+  DimensionOrderedAddress local (coordinates);
+  coordinates[3] = 2;
+  DimensionOrderedAddress peer (coordinates);
+  coordinates[3] = 2 + 256;
+  DimensionOrderedAddress widePeer (coordinates);
+
+  NS_TEST_ASSERT_MSG_EQ (DimensionOrderedAddress::ConvertFrom (widePeer), widePeer,
+                         "Address conversion lost coordinates");
+  NS_TEST_ASSERT_MSG_EQ ((DimensionOrderedAddress ("(1, 1, 1, 258)")), widePeer, "Parsing lost coordinates");
+  NS_TEST_ASSERT_MSG_EQ ((peer == DimensionOrderedAddress (1, 1, 1)), false,
+                         "Addresses of different dimensions compare equal");
+
+  DimensionOrderedEndPoint *first = demux.Allocate (local, LISTEN_PORT, peer, 1000);
+  DimensionOrderedEndPoint *second = demux.Allocate (local, LISTEN_PORT, widePeer, 1000);
+  NS_TEST_ASSERT_MSG_NE (second, 0, "Wide peer collided with the narrow one");
+  NS_TEST_ASSERT_MSG_EQ (demux.Lookup (local, LISTEN_PORT, peer, 1000, 0).front (), first,
+                         "Expected the endpoint of the narrow peer");
+  NS_TEST_ASSERT_MSG_EQ (demux.Lookup (local, LISTEN_PORT, widePeer, 1000, 0).front (), second,
+                         "Expected the endpoint of the wide peer");
+}
+
+/*
+ * Per-packet lookup cost with an all-to-all style population: one listener,
+ * one accepted endpoint per peer on the same port and one connected
+ * ephemeral endpoint per peer. The endpoints a lookup compares must not
+ * grow with the number of endpoints, and removing them in any order keeps
+ * the rest reachable.
+ */
+class DimensionOrderedEndPointDemuxScalingTestCase : public TestCase
+{
+public:
+  DimensionOrderedEndPointDemuxScalingTestCase ();
+private:
+  virtual void DoRun (void);
+  double MeasureLookup (uint32_t nPeers);
+};
+
+DimensionOrderedEndPointDemuxScalingTestCase::DimensionOrderedEndPointDemuxScalingTestCase ()
+  : TestCase ("DimensionOrderedEndPointDemux lookup cost is independent of endpoint count")
+{
+}
+
+double
+DimensionOrderedEndPointDemuxScalingTestCase::MeasureLookup (uint32_t nPeers)
+{
+  static const uint32_t LOOKUPS = 10000;
+  DimensionOrderedEndPointDemux demux;
+  DimensionOrderedAddress local (1, 1, 1);
+
+  demux.Allocate (LISTEN_PORT);
+  std::vector<DimensionOrderedEndPoint *> accepted;
+  for (uint32_t i = 0; i < nPeers; i++)
+    {
+      accepted.push_back (demux.Allocate (local, LISTEN_PORT, PeerAddress (i), 49153 + i));
+      DimensionOrderedEndPoint *client = demux.Allocate (local);
+      client->SetPeer (PeerAddress (i), LISTEN_PORT);
+    }
+
+  uint32_t found = 0;
+  uint64_t probes = demux.GetLookupProbes ();
+  for (uint32_t i = 0; i < LOOKUPS; i++)
+    {
+      uint32_t peer = (i * 2654435761u) % nPeers;
+      found += demux.Lookup (local, LISTEN_PORT, PeerAddress (peer), 49153 + peer, 0).size ();
+    }
+  probes = demux.GetLookupProbes () - probes;
+  NS_TEST_EXPECT_MSG_EQ (found, LOOKUPS, "Every lookup must find exactly one endpoint");
+
+  // Every other accepted endpoint goes, the others keep their packets
+  for (uint32_t i = 0; i < nPeers; i += 2)
+    {
+      demux.DeAllocate (accepted[i]);
+    }
+  NS_TEST_EXPECT_MSG_EQ (demux.GetAllEndPoints ().size (), 1 + nPeers + nPeers / 2, "Wrong endpoints left");
+  for (uint32_t i = 0; i < nPeers; i++)
+    {
+      DimensionOrderedEndPointDemux::EndPoints endPoints =
+        demux.Lookup (local, LISTEN_PORT, PeerAddress (i), 49153 + i, 0);
+      NS_TEST_EXPECT_MSG_EQ (endPoints.size (), 1, "Expected one endpoint");
+      if (i % 2 == 1)
+        {
+          NS_TEST_EXPECT_MSG_EQ (endPoints.front (), accepted[i], "Expected the accepted endpoint");
+        }
+      else
+        {
+          NS_TEST_EXPECT_MSG_EQ (endPoints.front ()->GetPeerPort (), 0, "Expected the listening endpoint");
+        }
+    }
+
+  return static_cast<double> (probes) / LOOKUPS;
+}
+
+void
+DimensionOrderedEndPointDemuxScalingTestCase::DoRun (void)
+{
+  double small = MeasureLookup (64);
+  double large = MeasureLookup (4096);
+
+  // The accepted endpoint and the listener, whatever the population
+  NS_TEST_ASSERT_MSG_EQ (small, 2, "Lookup compared " << small << " endpoints with 64 peers");
+  NS_TEST_ASSERT_MSG_EQ (large, 2, "Lookup compared " << large << " endpoints with 4096 peers");
+}
+
+class DimensionOrderedEndPointDemuxTestSuite : public TestSuite
+{
+public:
+  DimensionOrderedEndPointDemuxTestSuite ();
+};
+
+DimensionOrderedEndPointDemuxTestSuite::DimensionOrderedEndPointDemuxTestSuite ()
+  : TestSuite ("dim-ordered-end-point-demux", UNIT)
+{
+  AddTestCase (new DimensionOrderedEndPointDemuxLookupTestCase, TestCase::QUICK);
+  AddTestCase (new DimensionOrderedEndPointDemuxWideAddressTestCase, TestCase::QUICK);
+  AddTestCase (new DimensionOrderedEndPointDemuxScalingTestCase, TestCase::QUICK);
+}
+
+static DimensionOrderedEndPointDemuxTestSuite dimOrderedEndPointDemuxTestSuite;
@@ -0,0 +1,216 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/object-vector.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/boolean.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/error-model.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/simulator.h"
+#include "ns3/dim-ordered-l3-protocol.h"
+#include "ns3/dim-ordered-stack-helper.h"
+#include "ns3/dim-ordered-address-helper.h"
+
+using namespace ns3;
+
+/*
+ * A device with the VirtualChannelQueues and VirtualChannels attributes the
+ * routing policies read from point-to-point devices.
+ */
+class RoutingTestNetDevice : public SimpleNetDevice
+{
+public:
+  static TypeId GetTypeId (void);
+  std::vector<Ptr<Queue> > m_queues;
+  uint32_t m_virtualChannels;
+};
+
+TypeId
+RoutingTestNetDevice::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DimensionOrderedRoutingTestNetDevice")
+    .SetParent<SimpleNetDevice> ()
+    .AddConstructor<RoutingTestNetDevice> ()
+    .AddAttribute ("VirtualChannelQueues", "The transmit queues of the virtual channels",
+                   ObjectVectorValue (),
+                   MakeObjectVectorAccessor (&RoutingTestNetDevice::m_queues),
+                   MakeObjectVectorChecker<Queue> ())
+    .AddAttribute ("VirtualChannels", "The number of virtual channels",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&RoutingTestNetDevice::m_virtualChannels),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+/*
+ * The NegativeFirst policy takes every productive NEG direction before
+ * the POS ones, the one with the emptier queue within each group and the
+ * dimension order on ties; DimensionOrdered ignores the queues.
+ */
+class DimensionOrderedRoutingTestCase : public TestCase
+{
+public:
+  DimensionOrderedRoutingTestCase ();
+private:
+  virtual void DoRun (void);
+  // A node with a device in every direction, at address in the cube
+  // from (1, 1, ...) to (3, 3, ...) with as many dimensions
+  void CreateNode (DimensionOrderedAddress address, uint32_t virtualChannels);
+  void Load (DimensionOrdered::InterfaceDirection dir, uint32_t packets, uint32_t vc = 0);
+  DimensionOrdered::InterfaceDirection Route (DimensionOrderedAddress destination);
+
+  Ptr<DimensionOrderedL3Protocol> m_l3;
+  Ptr<RoutingTestNetDevice> m_devices[DimensionOrdered::LOOPBACK];
+};
+
+DimensionOrderedRoutingTestCase::DimensionOrderedRoutingTestCase ()
+  : TestCase ("DimensionOrderedL3Protocol routing policies choose the expected next hops")
+{
+}
+
+void
+DimensionOrderedRoutingTestCase::CreateNode (DimensionOrderedAddress address, uint32_t virtualChannels)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  DimensionOrderedStackHelper stack;
+  std::vector<uint16_t> origin (address.GetNDimensions (), 1);
+  std::vector<uint16_t> dimsMax (address.GetNDimensions (), 3);
+  stack.Install (node, DimensionOrderedAddress (origin), DimensionOrderedAddress (dimsMax));
+  DimensionOrderedAddressHelper::AddressAssignmentList assignments;
+  for (uint32_t dir = 0; dir < DimensionOrdered::LOOPBACK; dir++)
+    {
+      m_devices[dir] = CreateObject<RoutingTestNetDevice> ();
+      for (uint32_t vc = 0; vc < virtualChannels; vc++)
+        {
+          m_devices[dir]->m_queues.push_back (CreateObject<DropTailQueue> ());
+        }
+      m_devices[dir]->m_virtualChannels = virtualChannels;
+      m_devices[dir]->SetAddress (Mac48Address::Allocate ());
+      node->AddDevice (m_devices[dir]);
+      assignments.push_back (std::make_tuple (m_devices[dir], address,
+                                              static_cast<DimensionOrdered::InterfaceDirection> (dir)));
+    }
+  DimensionOrderedAddressHelper::Assign (assignments);
+  m_l3 = node->GetObject<DimensionOrderedL3Protocol> ();
+  m_l3->SetAttribute ("RoutingPolicy", EnumValue (DimensionOrderedL3Protocol::ROUTING_NEGATIVE_FIRST));
+}
+
+void
+DimensionOrderedRoutingTestCase::Load (DimensionOrdered::InterfaceDirection dir, uint32_t packets, uint32_t vc)
+{
+  for (uint32_t i = 0; i < packets; i++)
+    {
+      m_devices[dir]->m_queues[vc]->Enqueue (Create<Packet> (1000));
+    }
+}
+
+DimensionOrdered::InterfaceDirection
+DimensionOrderedRoutingTestCase::Route (DimensionOrderedAddress destination)
+{
+  return m_l3->FindRoute (destination);
+}
+
+void
+DimensionOrderedRoutingTestCase::DoRun (void)
+{
+  // In the middle of the cube all six directions exist
+  CreateNode (DimensionOrderedAddress (2, 2, 2), 1);
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (2, 2, 2)), DimensionOrdered::LOOPBACK, "Not delivered locally");
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (3, 3, 2)), DimensionOrdered::X_POS,
+                         "Tie not broken in dimension order");
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (3, 3, 3)), DimensionOrdered::X_POS,
+                         "Tie not broken in dimension order");
+
+  // The emptier of the POS queues
+  Load (DimensionOrdered::X_POS, 2);
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (3, 3, 2)), DimensionOrdered::Y_POS,
+                         "Loaded POS direction taken");
+  Load (DimensionOrdered::Y_POS, 3);
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (3, 3, 3)), DimensionOrdered::Z_POS,
+                         "Loaded POS direction taken");
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (3, 3, 2)), DimensionOrdered::X_POS,
+                         "Fuller POS direction taken");
+
+  // NEG first however full its queue, then the emptier NEG queue
+  Load (DimensionOrdered::X_NEG, 10);
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (1, 3, 3)), DimensionOrdered::X_NEG,
+                         "POS direction taken before the NEG one");
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (3, 1, 3)), DimensionOrdered::Y_NEG,
+                         "POS direction taken before the NEG one");
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (1, 1, 3)), DimensionOrdered::Y_NEG,
+                         "Loaded NEG direction taken");
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (2, 2, 1)), DimensionOrdered::Z_NEG,
+                         "Unproductive direction taken");
+
+  // Dimension ordered routing does not look at the queues
+  m_l3->SetAttribute ("RoutingPolicy", EnumValue (DimensionOrderedL3Protocol::ROUTING_DIMENSION_ORDERED));
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (3, 3, 2)), DimensionOrdered::X_POS, "Not routed in X first");
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (1, 1, 3)), DimensionOrdered::X_NEG, "Not routed in X first");
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (2, 3, 1)), DimensionOrdered::Y_POS, "Not routed in Y first");
+
+  // At the edge of a torus with the dateline virtual channels, the
+  // wraparound link is the shortest way
+  CreateNode (DimensionOrderedAddress (1, 2, 2), 2);
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (3, 2, 2)), DimensionOrdered::X_NEG,
+                         "Wraparound link not taken");
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (3, 3, 2)), DimensionOrdered::X_NEG,
+                         "POS direction taken before the NEG one");
+  Load (DimensionOrdered::Y_NEG, 1);
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (3, 1, 2)), DimensionOrdered::X_NEG,
+                         "Loaded NEG direction taken");
+
+  // The packets of every virtual channel count
+  Load (DimensionOrdered::X_NEG, 2, 1);
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (3, 1, 2)), DimensionOrdered::Y_NEG,
+                         "Virtual channel 1 not counted");
+
+  // A 4D node: every policy routes in the fourth dimension, with and
+  // without the route cache
+  std::vector<uint16_t> coordinates (4, 2);
+  CreateNode (DimensionOrderedAddress (coordinates), 1);
+  NS_TEST_ASSERT_MSG_EQ (Route (DimensionOrderedAddress (coordinates)), DimensionOrdered::LOOPBACK,
+                         "Not delivered locally in 4D");
+  coordinates[3] = 3;
+  DimensionOrderedAddress wPos (coordinates);
+  coordinates[3] = 1;
+  DimensionOrderedAddress wNeg (coordinates);
+  NS_TEST_ASSERT_MSG_EQ (Route (wPos), DimensionOrdered::GetDirection (3, false), "Not routed in W in 4D");
+  NS_TEST_ASSERT_MSG_EQ (Route (wNeg), DimensionOrdered::GetDirection (3, true), "Not routed in W in 4D");
+  m_l3->SetAttribute ("RoutingPolicy", EnumValue (DimensionOrderedL3Protocol::ROUTING_DIMENSION_ORDERED));
+  NS_TEST_ASSERT_MSG_EQ (Route (wPos), DimensionOrdered::GetDirection (3, false), "Not routed in W in 4D");
+  m_l3->SetAttribute ("EnableRouteCache", BooleanValue (false));
+  NS_TEST_ASSERT_MSG_EQ (Route (wNeg), DimensionOrdered::GetDirection (3, true), "Not routed in W without the cache");
+  // An uncached first lookup, before anything has set the node address
+  coordinates[3] = 2;
+  CreateNode (DimensionOrderedAddress (coordinates), 1);
+  m_l3->SetAttribute ("RoutingPolicy", EnumValue (DimensionOrderedL3Protocol::ROUTING_DIMENSION_ORDERED));
+  m_l3->SetAttribute ("EnableRouteCache", BooleanValue (false));
+  NS_TEST_ASSERT_MSG_EQ (Route (wPos), DimensionOrdered::GetDirection (3, false), "Not routed in W without the cache");
+
+  m_l3 = 0;
+  for (uint32_t dir = 0; dir < DimensionOrdered::LOOPBACK; dir++)
+    {
+      m_devices[dir] = 0;
+    }
+  Simulator::Destroy ();
+}
+
+class DimensionOrderedRoutingTestSuite : public TestSuite
+{
+public:
+  DimensionOrderedRoutingTestSuite ();
+};
+
+DimensionOrderedRoutingTestSuite::DimensionOrderedRoutingTestSuite ()
+  : TestSuite ("dim-ordered-routing", UNIT)
+{
+  AddTestCase (new DimensionOrderedRoutingTestCase, TestCase::QUICK);
+}
+
+static DimensionOrderedRoutingTestSuite dimOrderedRoutingTestSuite;
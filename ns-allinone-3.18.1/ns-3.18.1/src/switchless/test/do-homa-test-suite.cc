@@ -0,0 +1,287 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/do-homa-header.h"
+#include "ns3/do-homa-l4-protocol.h"
+
+using namespace ns3;
+
+/*
+ * All fields of the Homa header survive serialization.
+ */
+class DoHomaHeaderTestCase : public TestCase
+{
+public:
+  DoHomaHeaderTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+DoHomaHeaderTestCase::DoHomaHeaderTestCase ()
+  : TestCase ("DoHomaHeader serializes all fields")
+{
+}
+
+void
+DoHomaHeaderTestCase::DoRun (void)
+{
+  DoHomaHeader header;
+  header.SetSourcePort (49153);
+  header.SetDestinationPort (8080);
+  header.SetType (DoHomaHeader::GRANT);
+  header.SetPriority (3);
+  header.SetMessageId (0x12345678);
+  header.SetMessageLength (1048576);
+  header.SetOffset (70000);
+  header.SetLength (1460);
+  Ptr<Packet> p = Create<Packet> (100);
+  p->AddHeader (header);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 100 + header.GetSerializedSize (), "Wrong header size");
+
+  DoHomaHeader received;
+  p->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.GetSourcePort (), 49153, "Wrong source port");
+  NS_TEST_ASSERT_MSG_EQ (received.GetDestinationPort (), 8080, "Wrong destination port");
+  NS_TEST_ASSERT_MSG_EQ (received.GetType (), DoHomaHeader::GRANT, "Wrong type");
+  NS_TEST_ASSERT_MSG_EQ (received.GetPriority (), 3, "Wrong priority");
+  NS_TEST_ASSERT_MSG_EQ (received.GetMessageId (), 0x12345678, "Wrong message ID");
+  NS_TEST_ASSERT_MSG_EQ (received.GetMessageLength (), 1048576, "Wrong message length");
+  NS_TEST_ASSERT_MSG_EQ (received.GetOffset (), 70000, "Wrong offset");
+  NS_TEST_ASSERT_MSG_EQ (received.GetLength (), 1460, "Wrong length");
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 100, "Header left in the payload");
+}
+
+/*
+ * Two protocols wired back to back deliver whole messages through lost
+ * packets, grant the shorter of two messages first and forget the
+ * messages once they are acknowledged.
+ */
+class DoHomaMessageTestCase : public TestCase
+{
+public:
+  DoHomaMessageTestCase ();
+protected:
+  DoHomaMessageTestCase (std::string name);
+  void Setup (void);
+  void Teardown (void);
+private:
+  virtual void DoRun (void);
+protected:
+  Ptr<DoHomaL4Protocol> CreateProtocol (void);
+  // Down target of both protocols, a link with a fixed delay
+  void Transmit (Ptr<Packet> p, DimensionOrderedAddress saddr, DimensionOrderedAddress daddr, uint8_t protocol);
+  void Deliver (Ptr<DoHomaL4Protocol> homa, Ptr<Packet> p, DimensionOrderedHeader header);
+  void Receive (Ptr<Packet> p, DimensionOrderedHeader header, uint16_t port,
+                Ptr<DimensionOrderedInterface> incomingInterface);
+  static Ptr<Packet> Message (uint32_t size, uint8_t seed);
+
+  DimensionOrderedAddress m_clientAddress;
+  DimensionOrderedAddress m_serverAddress;
+  Ptr<DoHomaL4Protocol> m_client;
+  Ptr<DoHomaL4Protocol> m_server;
+  uint32_t m_nData;
+  uint32_t m_nGrants;
+  std::set<uint32_t> m_drop;    // DATA packets to lose, by number
+  std::set<uint32_t> m_dropGrants;
+  std::vector<Ptr<Packet> > m_received;
+  std::vector<Time> m_receivedTimes;
+};
+
+DoHomaMessageTestCase::DoHomaMessageTestCase ()
+  : TestCase ("DoHomaL4Protocol delivers whole messages, shortest first, through losses")
+{
+}
+
+DoHomaMessageTestCase::DoHomaMessageTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+Ptr<Packet>
+DoHomaMessageTestCase::Message (uint32_t size, uint8_t seed)
+{
+  std::vector<uint8_t> data (size + 1);
+  for (uint32_t i = 0; i < size; i++)
+    {
+      data[i] = static_cast<uint8_t> (seed + i * 13 + (i >> 8));
+    }
+  return Create<Packet> (&data[0], size);
+}
+
+Ptr<DoHomaL4Protocol>
+DoHomaMessageTestCase::CreateProtocol (void)
+{
+  Ptr<DoHomaL4Protocol> homa = CreateObject<DoHomaL4Protocol> ();
+  homa->SetAttribute ("MaxPayloadSize", UintegerValue (1000));
+  homa->SetAttribute ("RttBytes", UintegerValue (3000));
+  homa->SetAttribute ("Overcommit", UintegerValue (1));
+  homa->SetAttribute ("ResendTimeout", TimeValue (MicroSeconds (10)));
+  homa->SetDownTarget (MakeCallback (&DoHomaMessageTestCase::Transmit, this));
+  return homa;
+}
+
+void
+DoHomaMessageTestCase::Transmit (Ptr<Packet> p, DimensionOrderedAddress saddr, DimensionOrderedAddress daddr,
+                                 uint8_t protocol)
+{
+  DoHomaHeader homaHeader;
+  p->PeekHeader (homaHeader);
+  if (homaHeader.GetType () == DoHomaHeader::DATA && m_drop.count (m_nData++))
+    {
+      return;
+    }
+  if (homaHeader.GetType () == DoHomaHeader::GRANT && m_dropGrants.count (m_nGrants++))
+    {
+      return;
+    }
+  DimensionOrderedHeader header;
+  header.SetSource (saddr);
+  header.SetDestination (daddr);
+  header.SetProtocol (protocol);
+  Simulator::Schedule (MicroSeconds (1), &DoHomaMessageTestCase::Deliver, this,
+                       daddr == m_serverAddress ? m_server : m_client, p, header);
+}
+
+void
+DoHomaMessageTestCase::Deliver (Ptr<DoHomaL4Protocol> homa, Ptr<Packet> p, DimensionOrderedHeader header)
+{
+  homa->Receive (p, header, 0);
+}
+
+void
+DoHomaMessageTestCase::Receive (Ptr<Packet> p, DimensionOrderedHeader header, uint16_t port,
+                                Ptr<DimensionOrderedInterface> incomingInterface)
+{
+  m_received.push_back (p);
+  m_receivedTimes.push_back (Simulator::Now ());
+}
+
+void
+DoHomaMessageTestCase::Setup (void)
+{
+  m_clientAddress = DimensionOrderedAddress (1, 1, 1);
+  m_serverAddress = DimensionOrderedAddress (2, 1, 1);
+  m_client = CreateProtocol ();
+  m_server = CreateProtocol ();
+  m_nData = 0;
+  m_nGrants = 0;
+  DimensionOrderedEndPoint *endPoint = m_server->Allocate (9);
+  endPoint->SetRxCallback (MakeCallback (&DoHomaMessageTestCase::Receive, this));
+}
+
+void
+DoHomaMessageTestCase::Teardown (void)
+{
+  m_client->Dispose ();
+  m_server->Dispose ();
+  m_client = 0;
+  m_server = 0;
+  m_received.clear ();
+  m_receivedTimes.clear ();
+  Simulator::Destroy ();
+}
+
+void
+DoHomaMessageTestCase::DoRun (void)
+{
+  Setup ();
+
+  // The long message goes first, the short one is granted first. Of the
+  // three unscheduled packets of each the second of the long one is lost,
+  // and so is a scheduled packet of the long one
+  m_drop.insert (1);
+  m_drop.insert (8);
+  Ptr<Packet> longMessage = Message (12000, 1);
+  Ptr<Packet> shortMessage = Message (6500, 2);
+  m_client->Send (longMessage, m_clientAddress, m_serverAddress, 1000, 9);
+  m_client->Send (shortMessage, m_clientAddress, m_serverAddress, 1000, 9);
+  m_client->Send (Create<Packet> (), m_clientAddress, m_serverAddress, 1000, 9);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_received.size (), 3, "Messages not delivered");
+  NS_TEST_ASSERT_MSG_EQ (m_received[0]->GetSize (), 0, "Empty message not delivered at once");
+  NS_TEST_ASSERT_MSG_EQ (m_received[1]->GetSize (), 6500, "Shorter message not delivered first");
+  NS_TEST_ASSERT_MSG_EQ (m_received[2]->GetSize (), 12000, "Longer message not delivered last");
+  std::vector<uint8_t> expected (12000);
+  std::vector<uint8_t> data (12000);
+  longMessage->CopyData (&expected[0], 12000);
+  m_received[2]->CopyData (&data[0], 12000);
+  NS_TEST_ASSERT_MSG_EQ ((data == expected), true, "Message corrupted by the resends");
+  shortMessage->CopyData (&expected[0], 6500);
+  m_received[1]->CopyData (&data[0], 6500);
+  NS_TEST_ASSERT_MSG_EQ (std::equal (data.begin (), data.begin () + 6500, expected.begin ()), true,
+                         "Message corrupted");
+
+  const DoHomaL4Protocol::Statistics &server = m_server->GetStatistics ();
+  const DoHomaL4Protocol::Statistics &client = m_client->GetStatistics ();
+  NS_TEST_ASSERT_MSG_EQ (server.messagesDelivered, 3, "Wrong delivered count");
+  NS_TEST_ASSERT_MSG_EQ (server.resends, 2, "Each loss takes one resend request");
+  NS_TEST_ASSERT_MSG_EQ (client.bytesRetransmitted, 2000, "Only the lost packets are sent again");
+  NS_TEST_ASSERT_MSG_EQ (server.abandoned + client.abandoned, 0, "Message given up");
+  NS_TEST_ASSERT_MSG_EQ (m_client->GetNOutbound (), 0, "Acknowledged messages kept by the sender");
+  NS_TEST_ASSERT_MSG_EQ (m_server->GetNInbound (), 0, "Delivered messages kept by the receiver");
+
+  Teardown ();
+}
+
+/*
+ * A RESEND for bytes whose GRANT was lost grants them, the message is
+ * completed at the first resend instead of being given up.
+ */
+class DoHomaLostGrantTestCase : public DoHomaMessageTestCase
+{
+public:
+  DoHomaLostGrantTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+DoHomaLostGrantTestCase::DoHomaLostGrantTestCase ()
+  : DoHomaMessageTestCase ("DoHomaL4Protocol takes a RESEND past the grant as a grant")
+{
+}
+
+void
+DoHomaLostGrantTestCase::DoRun (void)
+{
+  Setup ();
+
+  // Three unscheduled packets, each answered by a grant of one more, the
+  // last grant is lost
+  m_dropGrants.insert (2);
+  Ptr<Packet> message = Message (6000, 3);
+  m_client->Send (message, m_clientAddress, m_serverAddress, 1000, 9);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_received.size (), 1, "Message not delivered");
+  NS_TEST_ASSERT_MSG_EQ (m_received[0]->GetSize (), 6000, "Wrong message size");
+  NS_TEST_ASSERT_MSG_LT (m_receivedTimes[0], MicroSeconds (30), "Message not completed at the first resend");
+  const DoHomaL4Protocol::Statistics &server = m_server->GetStatistics ();
+  const DoHomaL4Protocol::Statistics &client = m_client->GetStatistics ();
+  NS_TEST_ASSERT_MSG_EQ (m_nGrants, 3, "Wrong number of grants");
+  NS_TEST_ASSERT_MSG_EQ (server.resends, 1, "One resend request for the ungranted bytes");
+  NS_TEST_ASSERT_MSG_EQ (client.bytesRetransmitted, 0, "Bytes never sent counted as sent again");
+  NS_TEST_ASSERT_MSG_EQ (server.abandoned + client.abandoned, 0, "Message given up");
+  NS_TEST_ASSERT_MSG_EQ (m_client->GetNOutbound (), 0, "Acknowledged message kept by the sender");
+
+  Teardown ();
+}
+
+class DoHomaTestSuite : public TestSuite
+{
+public:
+  DoHomaTestSuite ();
+};
+
+DoHomaTestSuite::DoHomaTestSuite ()
+  : TestSuite ("do-homa", UNIT)
+{
+  AddTestCase (new DoHomaHeaderTestCase, TestCase::QUICK);
+  AddTestCase (new DoHomaMessageTestCase, TestCase::QUICK);
+  AddTestCase (new DoHomaLostGrantTestCase, TestCase::QUICK);
+}
+
+static DoHomaTestSuite doHomaTestSuite;
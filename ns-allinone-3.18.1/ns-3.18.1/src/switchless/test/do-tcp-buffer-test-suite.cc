@@ -0,0 +1,211 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/do-tcp-tx-buffer.h"
+#include "ns3/do-tcp-rx-buffer.h"
+
+using namespace ns3;
+
+// Byte of the stream at a sequence number
+static uint8_t
+StreamByte (uint32_t seq)
+{
+  return static_cast<uint8_t> (seq * 7 + (seq >> 8));
+}
+
+static Ptr<Packet>
+StreamPacket (uint32_t seq, uint32_t size)
+{
+  std::vector<uint8_t> data (size);
+  for (uint32_t i = 0; i < size; i++)
+    {
+      data[i] = StreamByte (seq + i);
+    }
+  return Create<Packet> (&data[0], size);
+}
+
+// Whether a packet holds the stream bytes from seq on
+static bool
+IsStream (Ptr<Packet> p, uint32_t seq)
+{
+  std::vector<uint8_t> data (p->GetSize ());
+  p->CopyData (&data[0], data.size ());
+  for (uint32_t i = 0; i < data.size (); i++)
+    {
+      if (data[i] != StreamByte (seq + i))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+/*
+ * Segments cut from the ring of the Tx buffer, also across its end, hold
+ * the bytes written, and acknowledging up to a FIN empties the buffer.
+ */
+class DoTcpTxBufferTestCase : public TestCase
+{
+public:
+  DoTcpTxBufferTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+DoTcpTxBufferTestCase::DoTcpTxBufferTestCase ()
+  : TestCase ("DoTcpTxBuffer segments hold the written bytes across the end of the ring")
+{
+}
+
+void
+DoTcpTxBufferTestCase::DoRun (void)
+{
+  DoTcpTxBuffer buffer (1000);
+  buffer.SetMaxBufferSize (2800);
+  uint32_t tail = 1000;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (buffer.Add (StreamPacket (tail, 700)), true, "Write within the buffer size failed");
+      tail += 700;
+    }
+  NS_TEST_ASSERT_MSG_EQ (buffer.Add (StreamPacket (tail, 1000)), false, "Write beyond the buffer size accepted");
+  NS_TEST_ASSERT_MSG_EQ (buffer.Size (), 2100, "Wrong size");
+  NS_TEST_ASSERT_MSG_EQ (buffer.TailSequence (), SequenceNumber32 (3100), "Wrong tail");
+
+  Ptr<Packet> segment = buffer.CopyFromSequence (1000, SequenceNumber32 (1500));
+  NS_TEST_ASSERT_MSG_EQ (segment->GetSize (), 1000, "Segment of the wrong size");
+  NS_TEST_ASSERT_MSG_EQ (IsStream (segment, 1500), true, "Segment across two writes is corrupt");
+
+  // Freeing the head lets the next write wrap around the 2800 byte ring
+  buffer.DiscardUpTo (SequenceNumber32 (2400));
+  NS_TEST_ASSERT_MSG_EQ (buffer.HeadSequence (), SequenceNumber32 (2400), "Wrong head");
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (buffer.Add (StreamPacket (tail, 1000)), true, "Write after discarding failed");
+      tail += 1000;
+    }
+  NS_TEST_ASSERT_MSG_EQ (buffer.Available (), 100, "Wrong available bytes");
+  for (uint32_t seq = 2400; seq < tail; seq += 536)
+    {
+      segment = buffer.CopyFromSequence (536, SequenceNumber32 (seq));
+      NS_TEST_ASSERT_MSG_EQ (segment->GetSize (), std::min<uint32_t> (536, tail - seq), "Segment of the wrong size");
+      NS_TEST_ASSERT_MSG_EQ (IsStream (segment, seq), true, "Segment at " << seq << " is corrupt");
+    }
+  NS_TEST_ASSERT_MSG_EQ (buffer.CopyFromSequence (100, SequenceNumber32 (tail))->GetSize (), 0,
+                         "Data beyond the tail");
+
+  // Growing the ring keeps the data in order
+  buffer.SetMaxBufferSize (10000);
+  NS_TEST_ASSERT_MSG_EQ (buffer.Add (StreamPacket (tail, 5000)), true, "Write after growing failed");
+  tail += 5000;
+  segment = buffer.CopyFromSequence (10000, SequenceNumber32 (2400));
+  NS_TEST_ASSERT_MSG_EQ (segment->GetSize (), 7700, "Segment of the wrong size");
+  NS_TEST_ASSERT_MSG_EQ (IsStream (segment, 2400), true, "Data moved by growing the ring is corrupt");
+
+  // The emptied ring is released and takes more data
+  buffer.DiscardUpTo (SequenceNumber32 (tail));
+  NS_TEST_ASSERT_MSG_EQ (buffer.Size (), 0, "Buffer should be empty");
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (buffer.Add (StreamPacket (tail + 3000 * i, 3000)), true, "Write after releasing failed");
+    }
+  segment = buffer.CopyFromSequence (10000, SequenceNumber32 (tail));
+  NS_TEST_ASSERT_MSG_EQ (segment->GetSize (), 6000, "Segment of the wrong size");
+  NS_TEST_ASSERT_MSG_EQ (IsStream (segment, tail), true, "Data written after releasing is corrupt");
+  tail += 6000;
+
+  // The FIN takes one sequence number but no data
+  buffer.DiscardUpTo (SequenceNumber32 (tail + 1));
+  NS_TEST_ASSERT_MSG_EQ (buffer.Size (), 0, "Buffer should be empty");
+  NS_TEST_ASSERT_MSG_EQ (buffer.HeadSequence (), SequenceNumber32 (tail + 1), "Wrong head after the FIN");
+}
+
+/*
+ * Out of order, overlapping and duplicate segments are reassembled into
+ * the stream, and the bytes read across the end of the ring are intact.
+ */
+class DoTcpRxBufferTestCase : public TestCase
+{
+public:
+  DoTcpRxBufferTestCase ();
+private:
+  virtual void DoRun (void);
+  bool Add (DoTcpRxBuffer &buffer, uint32_t seq, uint32_t size);
+};
+
+DoTcpRxBufferTestCase::DoTcpRxBufferTestCase ()
+  : TestCase ("DoTcpRxBuffer reassembles out of order and overlapping segments")
+{
+}
+
+bool
+DoTcpRxBufferTestCase::Add (DoTcpRxBuffer &buffer, uint32_t seq, uint32_t size)
+{
+  DoTcpHeader header;
+  header.SetSequenceNumber (SequenceNumber32 (seq));
+  return buffer.Add (StreamPacket (seq, size), header);
+}
+
+void
+DoTcpRxBufferTestCase::DoRun (void)
+{
+  DoTcpRxBuffer buffer (1000);
+  buffer.SetMaxBufferSize (4000);
+
+  NS_TEST_ASSERT_MSG_EQ (Add (buffer, 2000, 500), true, "Out of order segment rejected");
+  NS_TEST_ASSERT_MSG_EQ (Add (buffer, 3000, 500), true, "Out of order segment rejected");
+  NS_TEST_ASSERT_MSG_EQ (buffer.Available (), 0, "Nothing is in order yet");
+  NS_TEST_ASSERT_MSG_EQ (buffer.Size (), 1000, "Wrong size");
+  NS_TEST_ASSERT_MSG_EQ (Add (buffer, 2100, 300), false, "Duplicate segment accepted");
+
+  // Overlaps both buffered intervals and the gap between them
+  NS_TEST_ASSERT_MSG_EQ (Add (buffer, 2200, 1000), true, "Overlapping segment rejected");
+  NS_TEST_ASSERT_MSG_EQ (buffer.Size (), 1500, "Overlap counted twice");
+  NS_TEST_ASSERT_MSG_EQ (Add (buffer, 1000, 1000), true, "In order segment rejected");
+  NS_TEST_ASSERT_MSG_EQ (buffer.NextRxSequence (), SequenceNumber32 (3500), "Gaps not closed");
+  NS_TEST_ASSERT_MSG_EQ (buffer.Available (), 2500, "Wrong available bytes");
+
+  Ptr<Packet> data = buffer.Extract (1800);
+  NS_TEST_ASSERT_MSG_EQ (data->GetSize (), 1800, "Extracted the wrong size");
+  NS_TEST_ASSERT_MSG_EQ (IsStream (data, 1000), true, "Extracted data is corrupt");
+  NS_TEST_ASSERT_MSG_EQ (buffer.MaxRxSequence (), SequenceNumber32 (2800 + 4000), "Window not moved");
+
+  // The window ends 4000 bytes after the first unread byte
+  NS_TEST_ASSERT_MSG_EQ (Add (buffer, 6000, 1500), true, "Segment at the window edge rejected");
+  NS_TEST_ASSERT_MSG_EQ (buffer.Size (), 700 + 800, "Segment not trimmed to the window");
+  NS_TEST_ASSERT_MSG_EQ (Add (buffer, 3500, 2500), true, "Segment filling the gap rejected");
+  data = buffer.Extract (10000);
+  NS_TEST_ASSERT_MSG_EQ (data->GetSize (), 4000, "Extracted the wrong size");
+  NS_TEST_ASSERT_MSG_EQ (IsStream (data, 2800), true, "Extracted data is corrupt");
+  NS_TEST_ASSERT_MSG_EQ (buffer.Size (), 0, "Buffer should be empty");
+  NS_TEST_ASSERT_MSG_EQ (buffer.Extract (100), 0, "Extracted from an empty buffer");
+
+  // The emptied ring was released, the next one holds 1500 bytes and the
+  // next byte goes at 0 once 1000 of them are read
+  NS_TEST_ASSERT_MSG_EQ (Add (buffer, 6800, 1500), true, "In order segment rejected");
+  data = buffer.Extract (1000);
+  NS_TEST_ASSERT_MSG_EQ (IsStream (data, 6800), true, "Extracted data is corrupt");
+  NS_TEST_ASSERT_MSG_EQ (Add (buffer, 8300, 1000), true, "In order segment rejected");
+  data = buffer.Extract (10000);
+  NS_TEST_ASSERT_MSG_EQ (data->GetSize (), 1500, "Extracted the wrong size");
+  NS_TEST_ASSERT_MSG_EQ (IsStream (data, 7800), true, "Data across the end of the ring is corrupt");
+
+  buffer.SetFinSequence (SequenceNumber32 (9300));
+  NS_TEST_ASSERT_MSG_EQ (buffer.Finished (), true, "FIN not accounted");
+}
+
+class DoTcpBufferTestSuite : public TestSuite
+{
+public:
+  DoTcpBufferTestSuite ();
+};
+
+DoTcpBufferTestSuite::DoTcpBufferTestSuite ()
+  : TestSuite ("do-tcp-buffer", UNIT)
+{
+  AddTestCase (new DoTcpTxBufferTestCase, TestCase::QUICK);
+  AddTestCase (new DoTcpRxBufferTestCase, TestCase::QUICK);
+}
+
+static DoTcpBufferTestSuite doTcpBufferTestSuite;
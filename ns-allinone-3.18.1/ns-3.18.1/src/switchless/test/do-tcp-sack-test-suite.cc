@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/do-tcp-header.h"
+#include "ns3/do-tcp-rx-buffer.h"
+
+using namespace ns3;
+
+/*
+ * The SACK-permitted and SACK options survive serialization, and the
+ * header length follows them.
+ */
+class DoTcpSackHeaderTestCase : public TestCase
+{
+public:
+  DoTcpSackHeaderTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+DoTcpSackHeaderTestCase::DoTcpSackHeaderTestCase ()
+  : TestCase ("DoTcpHeader serializes the SACK options")
+{
+}
+
+void
+DoTcpSackHeaderTestCase::DoRun (void)
+{
+  DoTcpHeader syn;
+  syn.SetFlags (DoTcpHeader::SYN);
+  syn.SetSackPermitted (true);
+  NS_TEST_ASSERT_MSG_EQ (syn.GetSerializedSize (), 24, "SACK-permitted takes one padded word");
+  Ptr<Packet> p = Create<Packet> (100);
+  p->AddHeader (syn);
+  DoTcpHeader received;
+  p->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.GetSackPermitted (), true, "SACK-permitted lost");
+  NS_TEST_ASSERT_MSG_EQ (received.GetSackBlocks ().size (), 0, "SACK blocks out of nowhere");
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 100, "Options left in the payload");
+
+  DoTcpHeader ack;
+  ack.SetFlags (DoTcpHeader::ACK);
+  ack.SetAckNumber (SequenceNumber32 (1000));
+  for (uint32_t i = 0; i < DoTcpHeader::MAX_SACK_BLOCKS + 1; i++)
+    {
+      ack.AddSackBlock (SequenceNumber32 (2000 + 1000 * i), SequenceNumber32 (2500 + 1000 * i));
+    }
+  NS_TEST_ASSERT_MSG_EQ (ack.GetSackBlocks ().size (), DoTcpHeader::MAX_SACK_BLOCKS, "Too many SACK blocks");
+  NS_TEST_ASSERT_MSG_EQ (ack.GetSerializedSize (), 20 + 36, "Wrong length with four SACK blocks");
+  p = Create<Packet> ();
+  p->AddHeader (ack);
+  p->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.GetSackPermitted (), false, "SACK-permitted out of nowhere");
+  NS_TEST_ASSERT_MSG_EQ (received.GetSackBlocks ().size (), DoTcpHeader::MAX_SACK_BLOCKS, "SACK blocks lost");
+  for (uint32_t i = 0; i < DoTcpHeader::MAX_SACK_BLOCKS; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (received.GetSackBlocks ()[i].first, SequenceNumber32 (2000 + 1000 * i),
+                             "Wrong start of SACK block " << i);
+      NS_TEST_ASSERT_MSG_EQ (received.GetSackBlocks ()[i].second, SequenceNumber32 (2500 + 1000 * i),
+                             "Wrong end of SACK block " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (received.GetAckNumber (), SequenceNumber32 (1000), "Wrong ACK number");
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 0, "Options left in the payload");
+}
+
+/*
+ * The Rx buffer reports the data after the first gap, the block of the
+ * last segment received first.
+ */
+class DoTcpSackRxBufferTestCase : public TestCase
+{
+public:
+  DoTcpSackRxBufferTestCase ();
+private:
+  virtual void DoRun (void);
+  void Add (DoTcpRxBuffer &buffer, uint32_t seq, uint32_t size);
+};
+
+DoTcpSackRxBufferTestCase::DoTcpSackRxBufferTestCase ()
+  : TestCase ("DoTcpRxBuffer reports the out of order data in SACK blocks")
+{
+}
+
+void
+DoTcpSackRxBufferTestCase::Add (DoTcpRxBuffer &buffer, uint32_t seq, uint32_t size)
+{
+  DoTcpHeader header;
+  header.SetSequenceNumber (SequenceNumber32 (seq));
+  buffer.Add (Create<Packet> (size), header);
+}
+
+void
+DoTcpSackRxBufferTestCase::DoRun (void)
+{
+  DoTcpRxBuffer buffer (1000);
+  buffer.SetMaxBufferSize (100000);
+  Add (buffer, 1000, 500);
+  DoTcpHeader header;
+  buffer.AddSackBlocks (header, SequenceNumber32 (1000));
+  NS_TEST_ASSERT_MSG_EQ (header.GetSackBlocks ().size (), 0, "In order data reported");
+
+  Add (buffer, 2000, 500);
+  Add (buffer, 3000, 500);
+  Add (buffer, 4000, 500);
+  header = DoTcpHeader ();
+  buffer.AddSackBlocks (header, SequenceNumber32 (3000));
+  const DoTcpHeader::SackList &blocks = header.GetSackBlocks ();
+  NS_TEST_ASSERT_MSG_EQ (blocks.size (), 3, "Wrong number of SACK blocks");
+  NS_TEST_ASSERT_MSG_EQ (blocks[0].first, SequenceNumber32 (3000), "Last received block not first");
+  NS_TEST_ASSERT_MSG_EQ (blocks[1].first, SequenceNumber32 (2000), "Other blocks not in order");
+  NS_TEST_ASSERT_MSG_EQ (blocks[2].first, SequenceNumber32 (4000), "Other blocks not in order");
+  NS_TEST_ASSERT_MSG_EQ (blocks[2].second, SequenceNumber32 (4500), "Wrong end of a SACK block");
+
+  // Filling the first gap merges its block into the cumulative ACK
+  Add (buffer, 1500, 500);
+  header = DoTcpHeader ();
+  buffer.AddSackBlocks (header, SequenceNumber32 (1500));
+  NS_TEST_ASSERT_MSG_EQ (buffer.NextRxSequence (), SequenceNumber32 (2500), "Gap not closed");
+  NS_TEST_ASSERT_MSG_EQ (header.GetSackBlocks ().size (), 2, "Acknowledged data still reported");
+  NS_TEST_ASSERT_MSG_EQ (header.GetSackBlocks ()[0].first, SequenceNumber32 (3000), "Wrong SACK block");
+}
+
+class DoTcpSackTestSuite : public TestSuite
+{
+public:
+  DoTcpSackTestSuite ();
+};
+
+DoTcpSackTestSuite::DoTcpSackTestSuite ()
+  : TestSuite ("do-tcp-sack", UNIT)
+{
+  AddTestCase (new DoTcpSackHeaderTestCase, TestCase::QUICK);
+  AddTestCase (new DoTcpSackRxBufferTestCase, TestCase::QUICK);
+}
+
+static DoTcpSackTestSuite doTcpSackTestSuite;